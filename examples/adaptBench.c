@@ -0,0 +1,111 @@
+//======================================================================
+//
+// Speed-adaptive sensor sampling (initio_cache.h): drives a speed profile
+// (parked, duty 30, 60, 100, parked again) twice, first with the cache
+// refreshing at fixed rates high enough for full speed, then with rates
+// that grow with the commanded duty between the rest and the max rates.
+// Printed per phase are the effective refresh and ping rates and the CPU
+// time of the refresher, and at the end the CPU time of both runs and
+// the saving estimated by the cache itself.
+//
+// Against the wiringPi stub (see ../stub) an object is simulated at
+// 80 cm. Lift the robot's wheels off the ground when running it there.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o adaptBench -Wall -Werror adaptBench.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: adaptBench [-t seconds] [-r hz] [-R hz] [-s hz] [-S hz]
+//   -t  duration of each phase in s (default 1.5)
+//   -r  refresh rate of IR and line sensors at rest (default 20)
+//   -R  ... at duty 100 (default 1000)
+//   -s  ping rate at rest (default 2)
+//   -S  ... at duty 100 (default 25)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <initio.h>
+#include <initio_cache.h>
+
+// only present in the wiringPi stub
+extern void wiringPiStub_SetSonar (int pin, unsigned int distance) __attribute__((weak)) ;
+
+static const int profile[] = { 0, 30, 60, 100, 0 } ;
+#define PHASES (sizeof(profile) / sizeof(profile[0]))
+
+// run(): drives the profile with a cache of params; returns the CPU time
+// of the refresher in ms
+static double run (const char *name, const initio_cacheParams *params, double seconds)
+{
+    initio_cacheStats s0, s1 ;
+    initio_cache *cache ;
+    int i ;
+
+    cache = initio_CacheStart (NULL, params) ;
+    if (cache == NULL)
+        return -1 ;
+    printf ("%s\n duty  refreshes/s  pings/s  CPU [ms]\n", name) ;
+    initio_CacheGetStats (cache, &s0) ;
+    for (i = 0; i < PHASES; i++)
+    {
+        initio_DriveForward (profile[i]) ;
+        usleep (seconds * 1e6) ;
+        initio_CacheGetStats (cache, &s1) ;
+        printf ("%5d %12.0f %8.1f %9.2f\n", profile[i], (s1.refreshes - s0.refreshes) / seconds,
+                (s1.pings - s0.pings) / seconds, (s1.cpuUs - s0.cpuUs) * 1e-3) ;
+        s0 = s1 ;
+    }
+    initio_Stop () ;
+    initio_CacheStop (cache, &s1) ;
+    printf (" average %.0f refreshes/s, refresher CPU %.1f ms, estimated saving %.1f ms\n\n",
+            s1.rate.rateHz, s1.cpuUs * 1e-3, s1.savedCpuUs * 1e-3) ;
+    return s1.cpuUs * 1e-3 ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_cacheParams fixed, adaptive ;
+    double seconds = 1.5, fixedMs, adaptiveMs ;
+    int opt ;
+
+    initio_CacheDefaultParams (&adaptive) ;
+    adaptive.hz = 20 ;
+    adaptive.maxHz = 1000 ;
+    adaptive.sonarHz = 2 ;
+    adaptive.sonarMaxHz = 25 ;
+    while ((opt = getopt (argc, argv, "t:r:R:s:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': seconds = atof (optarg) ; break ;
+        case 'r': adaptive.hz = atof (optarg) ; break ;
+        case 'R': adaptive.maxHz = atof (optarg) ; break ;
+        case 's': adaptive.sonarHz = atof (optarg) ; break ;
+        case 'S': adaptive.sonarMaxHz = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    initio_CacheDefaultParams (&fixed) ;
+    fixed.hz = adaptive.maxHz ;
+    fixed.sonarHz = adaptive.sonarMaxHz ;
+
+    initio_InitEx (INITIO_MOTORS | INITIO_SENSORS | INITIO_SONAR) ;
+    initio_UsSetMaxRange (200) ;
+    if (wiringPiStub_SetSonar != NULL)
+        wiringPiStub_SetSonar ((initio_ctxBoard (initio_DefaultCtx ()) == ROBOHAT) ? sonar_RoboHAT : sonar_PiRoCon, 80) ;
+
+    fixedMs = run ("fixed rates", &fixed, seconds) ;
+    adaptiveMs = run ("speed-adaptive rates", &adaptive, seconds) ;
+    if (fixedMs > 0)
+        printf ("CPU time of the refresher: fixed %.1f ms, adaptive %.1f ms (%.0f%% less)\n",
+                fixedMs, adaptiveMs, 100 * (1 - adaptiveMs / fixedMs)) ;
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
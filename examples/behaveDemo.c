@@ -0,0 +1,197 @@
+//======================================================================
+//
+// Behaviour engine (initio_behave.h) with four behaviours, from low to
+// high priority:
+//   wander  (5 Hz)   drives forward, now and then with a turn
+//   scan    (10 Hz)  sweeps the sonar head between pan -40 and 80
+//   follow  (100 Hz) steers back onto a line seen by a line sensor
+//   avoid   (50 Hz)  backs off and spins away from an obstacle seen by
+//                    an IR sensor or the sonar (closer than 15 cm)
+// It prints every change of the behaviour holding the motors and at the
+// end the run count, execution time, deadline misses and wins of each.
+//
+// Against the wiringPi stub (see ../stub) a script sets the sensors: a
+// line from 1.5 s to 2.5 s, an obstacle on the left at 3 s, an object in
+// front of the sonar from 4.5 s to 5 s.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o behaveDemo -Wall -Werror behaveDemo.c -linitio -lwiringPi -lpthread
+//
+// Usage: behaveDemo [-t seconds] [-r hz] [-p priority]
+//   -t  run time in s (default 7)
+//   -r  engine rate (default 200)
+//   -p  SCHED_FIFO priority of the engine thread (default: none)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_behave.h>
+
+// only present in the wiringPi stub
+extern void wiringPiStub_SetInput (int pin, int value) __attribute__((weak)) ;
+extern void wiringPiStub_SetSonar (int pin, unsigned int distance) __attribute__((weak)) ;
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+static void wander (void *arg, const initio_behaveInputs *in, initio_behaveOutput *out)
+{
+    long tick = (long)(in->time * 5) ;
+
+    out->claim = INITIO_BEHAVE_MOTORS ;
+    out->left = 40 ;
+    out->right = (tick % 15 < 3) ? 15 : 40 ;  // a turn every 3 s
+}
+
+static void scan (void *arg, const initio_behaveInputs *in, initio_behaveOutput *out)
+{
+    static int step = 10 ;
+
+    out->claim = INITIO_BEHAVE_SERVO(servoPan) ;
+    if (out->servo[servoPan] + step > 80 || out->servo[servoPan] + step < -40)
+        step = -step ;
+    out->servo[servoPan] += step ;
+}
+
+static void follow (void *arg, const initio_behaveInputs *in, initio_behaveOutput *out)
+{
+    BOOL left = (in->sense & INITIO_SENSE_LINELEFT) != 0 ;
+    BOOL right = (in->sense & INITIO_SENSE_LINERIGHT) != 0 ;
+
+    out->claim = (left != right) ? INITIO_BEHAVE_MOTORS : 0 ;
+    out->left = left ? 10 : 50 ;
+    out->right = left ? 50 : 10 ;
+}
+
+typedef struct {
+    double until ;   // end of the escape manoeuvre
+    int spin ;       // duty of the left wheel while spinning
+} avoid_t ;
+
+static void avoid (void *arg, const initio_behaveInputs *in, initio_behaveOutput *out)
+{
+    avoid_t *a = arg ;
+    BOOL near = in->cm > 0 && in->cm < 15 ;
+
+    if ((in->sense & (INITIO_SENSE_IRLEFT | INITIO_SENSE_IRRIGHT)) || near)
+    {
+        if (in->time >= a->until)
+            a->spin = (in->sense & INITIO_SENSE_IRLEFT) ? 60 : -60 ;  // away from the obstacle
+        a->until = in->time + 0.6 ;
+    }
+    if (in->time >= a->until)
+        out->claim = 0 ;
+    else
+    {
+        out->claim = INITIO_BEHAVE_MOTORS ;
+        if (a->until - in->time > 0.4)  // back off, then spin
+            out->left = out->right = -40 ;
+        else
+        {
+            out->left = a->spin ;
+            out->right = -a->spin ;
+        }
+    }
+}
+
+// script(): sensor events against the stub, at time t since the start
+static void script (double t, int lineLeftPin, int sonarPin)
+{
+    if (wiringPiStub_SetInput == NULL)
+        return ;
+    wiringPiStub_SetInput (lineLeftPin, !(t >= 1.5 && t < 2.5)) ;
+    wiringPiStub_SetInput (irFL, !(t >= 3.0 && t < 3.1)) ;
+    wiringPiStub_SetSonar (sonarPin, (t >= 4.5 && t < 5.0) ? 10 : 100) ;
+}
+
+int main (int argc, char *argv[])
+{
+    avoid_t avoidState = { 0 } ;
+    initio_behaviour behaviours[] = {
+        { "wander", 0, 5, 0, wander, NULL },
+        { "scan", 0, 10, 0, scan, NULL },
+        { "follow", 1, 100, INITIO_SENSE_LINELEFT | INITIO_SENSE_LINERIGHT, follow, NULL },
+        { "avoid", 2, 50, INITIO_SENSE_IRLEFT | INITIO_SENSE_IRRIGHT | INITIO_BEHAVE_SONAR, avoid, &avoidState },
+    } ;
+    const int n = sizeof(behaviours) / sizeof(behaviours[0]) ;
+    initio_behaveStats s[sizeof(behaviours) / sizeof(behaviours[0])] ;
+    initio_behaveEngineStats es ;
+    initio_behaveParams params ;
+    initio_behave *engine ;
+    double seconds = 7, start, t ;
+    int opt, i, winner, last = -2, lineLeftPin, sonarPin ;
+
+    initio_BehaveDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "t:r:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': seconds = atof (optarg) ; break ;
+        case 'r': params.hz = atof (optarg) ; break ;
+        case 'p': params.rtPriority = atoi (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    initio_Init () ;
+    if (initio_ctxBoard (initio_DefaultCtx ()) == ROBOHAT)
+    {
+        lineLeftPin = lineLeft_RoboHat ;
+        sonarPin = sonar_RoboHAT ;
+    }
+    else
+    {
+        lineLeftPin = lineLeft_PiRoCon ;
+        sonarPin = sonar_PiRoCon ;
+    }
+    if (wiringPiStub_SetInput != NULL)  // sensors clear (active low)
+    {
+        wiringPiStub_SetInput (irFR, 1) ;
+        wiringPiStub_SetInput (lineRight, 1) ;
+        script (0, lineLeftPin, sonarPin) ;
+    }
+
+    engine = initio_BehaveStart (NULL, &params, behaviours, n) ;
+    if (engine == NULL)
+    {
+        fprintf (stderr, "cannot start the behaviour engine\n") ;
+        return EXIT_FAILURE ;
+    }
+    start = now () ;
+    while ((t = now () - start) < seconds)
+    {
+        script (t, lineLeftPin, sonarPin) ;
+        winner = initio_BehaveWinner (engine) ;
+        if (winner != last)
+        {
+            printf ("%6.3f s  motors: %s\n", t, (winner >= 0) ? behaviours[winner].name : "none") ;
+            last = winner ;
+        }
+        usleep (5000) ;
+    }
+    initio_BehaveStop (engine, s, &es) ;
+
+    printf ("\nbehaviour  prio   rate   runs  misses   wins  exec avg/max [us]\n") ;
+    for (i = 0; i < n; i++)
+        printf ("%-9s %5d %6.0f %6lu %7lu %6lu  %7.1f %7.1f\n", behaviours[i].name, behaviours[i].priority,
+                behaviours[i].hz, s[i].runs, s[i].misses, s[i].wins, s[i].execAvgUs, s[i].execMaxUs) ;
+    printf ("engine: %.1f Hz, %lu overruns, jitter max %.0f us, %lu motor and %lu servo writes, %lu switches%s\n",
+            es.rate.rateHz, es.rate.overruns, es.rate.jitterMaxUs, es.motorWrites, es.servoWrites, es.switches,
+            params.rtPriority > 0 ? (es.realtime ? ", SCHED_FIFO" : ", SCHED_FIFO refused") : "") ;
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,203 @@
+//======================================================================
+//
+// Stopping distance and time of the initio robot car: drives straight
+// at several duties and stops once by letting the motors coast
+// (initio_Stop) and once by active braking (initio_Brake), then
+// measures how far and how long the robot still moves from the stop
+// command on.
+//
+// In the simulation (default) distance and time are taken from the
+// simulated wheels and, as on the robot, from the wheel sensor pulses.
+// On the robot (-R) only the wheel pulses are available: the stop ends
+// with the last pulse. Give it a few metres of room.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o brakeBench -Wall -Werror brakeBench.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: brakeBench [-R] [-H ms] [-C s] [-c cm]
+//   -R  measure on the robot instead of the simulation
+//   -H  brake hold time before coasting in ms (default 300)
+//   -C  coasting time constant of the simulated wheels in s (default 0.08)
+//   -c  wheel travel per pulse of the robot in cm (default 1)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <initio.h>
+#include <initio_sim.h>
+
+#define STEP 0.001    // simulation step in s
+
+static const int duties[] = { 40, 70, 100 } ;
+static const int strengths[] = { 0, 100 } ;   // 0: coast (initio_Stop)
+
+typedef struct {
+    double cm, s ;             // true stopping distance and time (simulation)
+    double pulseCm, pulseS ;   // from the wheel pulses
+    double speed ;             // speed before the stop in cm/s
+} stop_t ;
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+// stopCommand(): coasts (strength 0) or brakes
+static void stopCommand (initio_ctx *ctx, int strength)
+{
+    if (strength == 0)
+        initio_ctxStop (ctx) ;
+    else
+        initio_ctxBrake (ctx, strength) ;
+}
+
+// simStop(): one stop in the simulation; the brake hold is timed in
+// simulated time, so the library holds until the next command
+static stop_t simStop (const initio_simParams *params, int duty, int strength, unsigned int holdMs)
+{
+    initio_sim sim ;
+    initio_ctx *ctx ;
+    stop_t r = { 0 } ;
+    unsigned long pulses0, pulses ;
+    double d0, t0, lastPulse ;
+    BOOL released = (strength == 0) ;
+    int i ;
+
+    initio_SimInit (&sim, params, NULL) ;
+    ctx = initio_Open (ROBOHAT, &initio_simHw, &sim, INITIO_MOTORS | INITIO_SENSORS) ;
+    initio_ctxSetBrakeHold (ctx, 0) ;
+    initio_ctxWheelCountStart (ctx) ;
+    initio_ctxDriveForward (ctx, duty) ;
+    for (i = 0; i < 2000; i++)
+        initio_SimStep (&sim, STEP) ;
+
+    r.speed = (sim.vLeft + sim.vRight) / 2 ;
+    d0 = (sim.distLeft + sim.distRight) / 2 ;
+    t0 = lastPulse = sim.time ;
+    pulses0 = pulses = initio_ctxWheelCountLeft (ctx) + initio_ctxWheelCountRight (ctx) ;
+    stopCommand (ctx, strength) ;
+    while (sim.time - t0 < 5 && (fabs (sim.vLeft) + fabs (sim.vRight)) / 2 > 0.1)
+    {
+        initio_SimStep (&sim, STEP) ;
+        if (!released && sim.time - t0 >= holdMs * 1e-3)
+        {
+            initio_ctxStop (ctx) ;
+            released = TRUE ;
+        }
+        if (initio_ctxWheelCountLeft (ctx) + initio_ctxWheelCountRight (ctx) != pulses)
+        {
+            pulses = initio_ctxWheelCountLeft (ctx) + initio_ctxWheelCountRight (ctx) ;
+            lastPulse = sim.time ;
+        }
+    }
+    r.cm = (sim.distLeft + sim.distRight) / 2 - d0 ;
+    r.s = sim.time - t0 ;
+    r.pulseCm = (pulses - pulses0) / 2.0 * params->cmPerTick ;
+    r.pulseS = lastPulse - t0 ;
+    initio_Close (ctx) ;
+    return r ;
+}
+
+// robotStop(): one stop on the robot, ended by 300 ms without a pulse
+static stop_t robotStop (int duty, int strength, double cmPerPulse)
+{
+    stop_t r = { 0 } ;
+    unsigned long pulses0, pulses, p ;
+    double t0, t, lastPulse ;
+
+    initio_DriveForward (duty) ;
+    usleep (1000000) ;
+    pulses0 = initio_WheelCountLeft () + initio_WheelCountRight () ;
+    usleep (500000) ;
+    pulses = initio_WheelCountLeft () + initio_WheelCountRight () ;
+    r.speed = (pulses - pulses0) / 2.0 * cmPerPulse / 0.5 ;
+
+    t0 = lastPulse = now () ;
+    pulses0 = pulses ;
+    stopCommand (initio_DefaultCtx (), strength) ;
+    while ((t = now ()) - lastPulse < 0.3)
+    {
+        p = initio_WheelCountLeft () + initio_WheelCountRight () ;
+        if (p != pulses)
+        {
+            pulses = p ;
+            lastPulse = t ;
+        }
+        usleep (1000) ;
+    }
+    initio_Stop () ;
+    r.pulseCm = (pulses - pulses0) / 2.0 * cmPerPulse ;
+    r.pulseS = lastPulse - t0 ;
+    sleep (1) ;
+    return r ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_simParams params ;
+    unsigned int holdMs = INITIO_BRAKE_HOLDMS ;
+    double cmPerPulse = 1 ;
+    int opt, i, j, robot = FALSE ;
+    stop_t r ;
+
+    initio_SimDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "RH:C:c:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'R': robot = TRUE ; break ;
+        case 'H': holdMs = atoi (optarg) ; break ;
+        case 'C': params.tauCoast = atof (optarg) ; break ;
+        case 'c': cmPerPulse = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    if (robot)
+    {
+        initio_InitEx (INITIO_MOTORS | INITIO_SENSORS) ;
+        initio_SetBrakeHold (holdMs) ;
+        initio_WheelCountStart () ;
+        printf ("duty  stop      speed [cm/s]  pulses: distance [cm]  time [ms]\n") ;
+    }
+    else
+        printf ("duty  stop      speed [cm/s]  distance [cm]  time [ms]   pulses: distance [cm]  time [ms]\n") ;
+
+    for (i = 0; i < sizeof(duties) / sizeof(duties[0]); i++)
+        for (j = 0; j < sizeof(strengths) / sizeof(strengths[0]); j++)
+        {
+            char mode[16] ;
+
+            if (strengths[j] == 0)
+                snprintf (mode, sizeof(mode), "coast") ;
+            else
+                snprintf (mode, sizeof(mode), "brake") ;
+            if (robot)
+            {
+                r = robotStop (duties[i], strengths[j], cmPerPulse) ;
+                printf ("%4d  %-9s %8.1f %16.1f %16.0f\n", duties[i], mode, r.speed, r.pulseCm, r.pulseS * 1e3) ;
+            }
+            else
+            {
+                r = simStop (&params, duties[i], strengths[j], holdMs) ;
+                printf ("%4d  %-9s %8.1f %16.1f %10.0f %18.1f %16.0f\n", duties[i], mode, r.speed,
+                        r.cm, r.s * 1e3, r.pulseCm, r.pulseS * 1e3) ;
+            }
+        }
+
+    if (robot)
+        initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,189 @@
+//======================================================================
+//
+// Sensor cache (initio_cache.h) against direct sensor reads: several
+// threads poll the IR obstacle and line sensors and the sonar, as
+// independent parts of a program would, first with the initio_Ir*() and
+// initio_UsGetDistance() calls and then through the cache with a
+// staleness budget. Reported are the calls served, the pin reads and
+// pings caused, the time per call and the cache hits and misses.
+//
+// Against the wiringPi stub (see ../stub) the pin reads are counted
+// and an object is simulated at 80 cm.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o cacheBench -Wall -Werror cacheBench.c -linitio -lwiringPi -lpthread
+//
+// Usage: cacheBench [-n threads] [-t seconds] [-a ms] [-s ms]
+//   -n  polling threads (default 4)
+//   -t  duration of each run in s (default 2)
+//   -a  acceptable age of the IR and line sensors in ms (default 10)
+//   -s  acceptable age of the sonar range in ms (default 100)
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <initio.h>
+#include <initio_cache.h>
+
+// only present in the wiringPi stub
+typedef int (*readHook_t)(int pin) ;
+extern void wiringPiStub_SetSonar (int pin, unsigned int distance) __attribute__((weak)) ;
+extern void wiringPiStub_SetReadHook (readHook_t hook) __attribute__((weak)) ;
+
+#define MAX_THREADS 64
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+static unsigned long pinReads ;  // reads of the IR and line sensor pins
+static int sonarPin ;
+
+static int countReads (int pin)
+{
+    if (pin != sonarPin)
+        __atomic_add_fetch (&pinReads, 1, __ATOMIC_RELAXED) ;
+    return -1 ;  // level as set in the stub
+}
+
+typedef struct {
+    initio_cache *cache ;      // NULL: direct reads
+    double maxAge, sonarMaxAge ;
+    double until ;
+    unsigned long calls ;
+    unsigned long sonarCalls ;
+    double sonarSeconds ;
+    int hits ;                 // triggered sensors seen
+} poller_t ;
+
+// pollSensors(): one part of the program: reads the sensors every 1 ms, the
+// sonar every 20 ms
+static void *pollSensors (void *arg)
+{
+    poller_t *p = arg ;
+    double t, nextSonar = 0 ;
+    int hits = 0 ;
+
+    while ((t = now ()) < p->until)
+    {
+        if (p->cache == NULL)
+            hits += initio_IrLeft () + initio_IrRight () + initio_IrLineLeft () + initio_IrLineRight () ;
+        else
+            hits += initio_CacheIrLeft (p->cache, p->maxAge) + initio_CacheIrRight (p->cache, p->maxAge)
+                  + initio_CacheIrLineLeft (p->cache, p->maxAge) + initio_CacheIrLineRight (p->cache, p->maxAge) ;
+        p->calls += 4 ;
+        if (t >= nextSonar)
+        {
+            if (p->cache == NULL)
+                initio_UsGetDistance () ;
+            else
+                initio_CacheUsGetDistance (p->cache, p->sonarMaxAge) ;
+            p->sonarCalls++ ;
+            p->sonarSeconds += now () - t ;
+            nextSonar = t + 0.02 ;
+        }
+        usleep (1000) ;
+    }
+    p->hits = hits ;
+    return NULL ;
+}
+
+static void run (const char *name, initio_cache *cache, int n, double seconds, double maxAge, double sonarMaxAge)
+{
+    pthread_t threads[MAX_THREADS] ;
+    poller_t p[MAX_THREADS] ;
+    unsigned long calls = 0, sonarCalls = 0, reads ;
+    double sonarSeconds = 0 ;
+    int i ;
+
+    __atomic_store_n (&pinReads, 0, __ATOMIC_RELAXED) ;
+    for (i = 0; i < n; i++)
+    {
+        p[i] = (poller_t) { cache, maxAge, sonarMaxAge, now () + seconds } ;
+        pthread_create (&threads[i], NULL, pollSensors, &p[i]) ;
+    }
+    for (i = 0; i < n; i++)
+    {
+        pthread_join (threads[i], NULL) ;
+        calls += p[i].calls ;
+        sonarCalls += p[i].sonarCalls ;
+        sonarSeconds += p[i].sonarSeconds ;
+    }
+    reads = __atomic_load_n (&pinReads, __ATOMIC_RELAXED) ;
+    printf ("%-7s sensor calls %7lu, pin reads %7lu (%5.2f per call), sonar calls %5lu, %7.3f ms per sonar call\n",
+            name, calls, reads, (double)reads / calls, sonarCalls, sonarSeconds * 1e3 / sonarCalls) ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_cacheParams params ;
+    initio_cacheStats s ;
+    initio_cache *cache ;
+    double seconds = 2, maxAge = 0.010, sonarMaxAge = 0.100 ;
+    int n = 4, opt ;
+
+    initio_CacheDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "n:t:a:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': n = atoi (optarg) ; break ;
+        case 't': seconds = atof (optarg) ; break ;
+        case 'a': maxAge = atof (optarg) * 1e-3 ; break ;
+        case 's': sonarMaxAge = atof (optarg) * 1e-3 ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (n < 1 || n > MAX_THREADS)
+        return EXIT_FAILURE ;
+
+    initio_InitEx (INITIO_SENSORS | INITIO_SONAR) ;
+    initio_UsSetMaxRange (200) ;
+    sonarPin = (initio_ctxBoard (initio_DefaultCtx ()) == ROBOHAT) ? sonar_RoboHAT : sonar_PiRoCon ;
+    if (wiringPiStub_SetSonar != NULL)
+        wiringPiStub_SetSonar (sonarPin, 80) ;
+    if (wiringPiStub_SetReadHook != NULL)
+        wiringPiStub_SetReadHook (countReads) ;
+
+    run ("direct", NULL, n, seconds, maxAge, sonarMaxAge) ;
+
+    // the refresher keeps the values within half the budgets
+    params.hz = 2 / maxAge ;
+    params.sonarHz = 2 / sonarMaxAge ;
+    cache = initio_CacheStart (NULL, &params) ;
+    if (cache == NULL)
+        return EXIT_FAILURE ;
+    run ("cached", cache, n, seconds, maxAge, sonarMaxAge) ;
+    initio_CacheStop (cache, &s) ;
+    printf ("        hits %lu misses %lu, sonar hits %lu misses %lu, refreshes %lu, pings %lu, refresher %.1f Hz\n",
+            s.hits, s.misses, s.sonarHits, s.sonarMisses, s.refreshes, s.pings, s.rate.rateHz) ;
+
+    // on demand only: the first reader after the budget refreshes
+    params.hz = 0 ;
+    params.sonarHz = 0 ;
+    cache = initio_CacheStart (NULL, &params) ;
+    run ("demand", cache, n, seconds, maxAge, sonarMaxAge) ;
+    initio_CacheStop (cache, &s) ;
+    printf ("        hits %lu misses %lu, sonar hits %lu misses %lu, refreshes %lu, pings %lu\n",
+            s.hits, s.misses, s.sonarHits, s.sonarMisses, s.refreshes, s.pings) ;
+
+    if (wiringPiStub_SetReadHook != NULL)
+        wiringPiStub_SetReadHook (NULL) ;
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,131 @@
+//======================================================================
+//
+// Example for the C++20 coroutine layer (initio_co.hpp) of the 4tronix
+// initio robot car: several behaviours run concurrently on a single
+// thread - obstacle avoidance on IR edges, a sonar monitor, a servo scan,
+// odometry on wheel ticks and a configurable number of periodic tasks
+// to show that behaviours cost no extra threads.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// g++ -std=c++20 -o coBehaviours -Wall -Werror coBehaviours.cpp -linitio -lwiringPi -lpthread
+//
+// Usage: coBehaviours [seconds] [number of periodic tasks]
+//
+//======================================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <initio_co.hpp>
+
+using namespace std::chrono_literals ;
+using initio::Task ;
+using initio::Robot ;
+
+static unsigned long periodicRuns = 0 ;
+
+// avoid(): stop and turn away while an IR obstacle sensor is triggered
+Task<> avoid (Robot &robot, initio::Side side)
+{
+    for (;;)
+    {
+        bool triggered = co_await robot.ir_edge (side) ;
+        if (triggered)
+        {
+            robot.stop () ;
+            (side == initio::Left) ? robot.spin_right (40) : robot.spin_left (40) ;
+            co_await robot.sleep (300ms) ;
+            robot.stop () ;
+        }
+    }
+}
+
+// sonarMonitor(): report the distance five times per second
+Task<> sonarMonitor (Robot &robot)
+{
+    for (;;)
+    {
+        unsigned int distance = co_await robot.distance () ;
+        std::printf ("distance: %u cm\n", distance) ;
+        co_await robot.sleep (200ms) ;
+    }
+}
+
+// servoScan(): sweep the pan servo back and forth
+Task<> servoScan (Robot &robot)
+{
+    for (;;)
+    {
+        for (int deg = -40; deg <= 80; deg += 10)
+        {
+            robot.set_servo (servoPan, deg) ;
+            co_await robot.sleep (100ms) ;
+        }
+        for (int deg = 80; deg >= -40; deg -= 10)
+        {
+            robot.set_servo (servoPan, deg) ;
+            co_await robot.sleep (100ms) ;
+        }
+    }
+}
+
+// odometry(): print a message every 40 wheel sensor pulses
+Task<> odometry (Robot &robot)
+{
+    for (;;)
+    {
+        co_await robot.ticks (40) ;
+        std::printf ("40 ticks, total %llu\n", (unsigned long long)robot.tickCount (initio::Both)) ;
+    }
+}
+
+// periodic(): trivial periodic behaviour with individual period
+Task<> periodic (Robot &robot, int id)
+{
+    auto next = initio::Clock::now () ;
+    for (;;)
+    {
+        next += std::chrono::milliseconds (10 + id % 40) ;
+        co_await robot.sleep_until (next) ;
+        periodicRuns++ ;
+    }
+}
+
+// timeout(): stop the executor after the given time
+Task<> timeout (Robot &robot, std::chrono::seconds duration)
+{
+    co_await robot.sleep (duration) ;
+    robot.stop () ;
+    robot.executor ().stop () ;
+}
+
+int main (int argc, char *argv[])
+{
+    int seconds = (argc > 1) ? std::atoi (argv[1]) : 5 ;
+    int numPeriodic = (argc > 2) ? std::atoi (argv[2]) : 200 ;
+
+    initio_Init () ;
+    {
+        initio::Executor ex ;
+        Robot robot (ex) ;
+
+        ex.spawn (avoid (robot, initio::Left)) ;
+        ex.spawn (avoid (robot, initio::Right)) ;
+        ex.spawn (sonarMonitor (robot)) ;
+        ex.spawn (servoScan (robot)) ;
+        ex.spawn (odometry (robot)) ;
+        for (int i = 0; i < numPeriodic; i++)
+            ex.spawn (periodic (robot, i)) ;
+        ex.spawn (timeout (robot, std::chrono::seconds (seconds))) ;
+
+        robot.drive_forward (30) ;
+        ex.run () ;
+        std::printf ("%zu behaviours, %lu periodic runs in %d s on one thread\n",
+                     ex.tasks (), periodicRuns, seconds) ;
+    }
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
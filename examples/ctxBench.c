@@ -0,0 +1,164 @@
+//======================================================================
+//
+// Multi-threaded contention benchmark of the initio contexts.
+// A number of threads run a mix of sensor reads and motor commands:
+//   shared   all threads use the default context (one robot)
+//   locked   as shared, but every call wrapped in one global mutex,
+//            i.e. what a library-wide lock would cost
+//   private  every thread drives its own simulated robot (initio_simHw)
+// For 1, 2, 4, ... threads the total throughput and the average time
+// per call are reported.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o ctxBench -Wall -Werror ctxBench.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: ctxBench [-t maxThreads] [-n callsPerThread] [-w writeEvery]
+//   -t  largest number of threads (default: number of CPUs)
+//   -n  calls per thread and run (default 200000)
+//   -w  every n-th call is a motor command, the others are reads (default 16)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <initio.h>
+#include <initio_sim.h>
+
+#define SHARED  0
+#define LOCKED  1
+#define PRIVATE 2
+
+static const char *modeNames[] = { "shared", "locked", "private" } ;
+
+typedef struct {
+    int mode ;
+    long calls ;
+    int writeEvery ;
+    pthread_barrier_t *start ;
+    long reads, writes ;
+    double seconds ;
+} worker_t ;
+
+static pthread_mutex_t globalMutex = PTHREAD_MUTEX_INITIALIZER ;
+
+static double now (void)
+{
+    struct timespec ts ;
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+static void *worker (void *arg)
+{
+    worker_t *w = arg ;
+    initio_sim sim ;
+    initio_ctx *ctx = initio_DefaultCtx () ;
+    volatile int sink = 0 ;
+    int left, right ;
+    double t0 ;
+    long i ;
+
+    if (w->mode == PRIVATE)
+    {
+        initio_SimInit (&sim, NULL, NULL) ;
+        ctx = initio_Open (ROBOHAT, &initio_simHw, &sim, INITIO_MOTORS | INITIO_SENSORS) ;
+        if (ctx == NULL)
+        {
+            fprintf (stderr, "cannot open simulated robot\n") ;
+            exit (EXIT_FAILURE) ;
+        }
+    }
+
+    pthread_barrier_wait (w->start) ;
+    t0 = now () ;
+    for (i = 0; i < w->calls; i++)
+    {
+        if (w->mode == LOCKED)
+            pthread_mutex_lock (&globalMutex) ;
+        if (i % w->writeEvery == 0)
+        {
+            initio_ctxTurnForward (ctx, i & 63, 63 - (i & 63)) ;
+            w->writes++ ;
+        }
+        else switch (i % 3)
+        {
+        case 0: sink += initio_ctxIrAll (ctx) ; w->reads++ ; break ;
+        case 1: sink += initio_ctxIrLineLeft (ctx) ; w->reads++ ; break ;
+        case 2: initio_ctxGetMotors (ctx, &left, &right) ; sink += left + right ; w->reads++ ; break ;
+        }
+        if (w->mode == LOCKED)
+            pthread_mutex_unlock (&globalMutex) ;
+    }
+    w->seconds = now () - t0 ;
+
+    if (w->mode == PRIVATE)
+        initio_Close (ctx) ;
+    return NULL ;
+}
+
+static void bench (int mode, int threads, long calls, int writeEvery)
+{
+    pthread_t tid[threads] ;
+    worker_t w[threads] ;
+    pthread_barrier_t start ;
+    double seconds = 0 ;
+    long reads = 0, writes = 0 ;
+    int i ;
+
+    pthread_barrier_init (&start, NULL, threads) ;
+    for (i = 0; i < threads; i++)
+    {
+        w[i] = (worker_t){ mode, calls, writeEvery, &start, 0, 0, 0 } ;
+        pthread_create (&tid[i], NULL, worker, &w[i]) ;
+    }
+    for (i = 0; i < threads; i++)
+    {
+        pthread_join (tid[i], NULL) ;
+        reads += w[i].reads ;
+        writes += w[i].writes ;
+        if (w[i].seconds > seconds) seconds = w[i].seconds ;
+    }
+    pthread_barrier_destroy (&start) ;
+
+    printf ("%-8s %3d threads  %8.2f Mcalls/s  %8.1f ns/call  (%ld reads, %ld writes)\n",
+            modeNames[mode], threads, (reads + writes) / seconds * 1e-6,
+            seconds * threads / (reads + writes) * 1e9, reads, writes) ;
+}
+
+int main (int argc, char *argv[])
+{
+    int maxThreads = sysconf (_SC_NPROCESSORS_ONLN) ;
+    long calls = 200000 ;
+    int writeEvery = 16 ;
+    int opt, mode, threads ;
+
+    while ((opt = getopt (argc, argv, "t:n:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': maxThreads = atoi (optarg) ; break ;
+        case 'n': calls = atol (optarg) ; break ;
+        case 'w': writeEvery = atoi (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (maxThreads < 1) maxThreads = 1 ;
+    if (writeEvery < 1) writeEvery = 1 ;
+
+    initio_InitEx (INITIO_MOTORS | INITIO_SENSORS) ; // initio: default context for 'shared'
+
+    for (mode = SHARED; mode <= PRIVATE; mode++)
+        for (threads = 1; threads <= maxThreads; threads *= 2)
+            bench (mode, threads, calls, writeEvery) ;
+
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
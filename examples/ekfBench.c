@@ -0,0 +1,164 @@
+//======================================================================
+//
+// Benchmark of the EKF pose estimator (initio_ekf.h) on a simulated
+// robot: the chassis of initio_sim.h is driven through a context with
+// the simulated hardware access (initio_simHw), wandering in a walled
+// room. The estimator model deliberately differs from the simulated
+// chassis (wheel base and travel per tick), as a real robot would.
+//
+// Compared are dead reckoning from the wheel pulses alone and the
+// filter fusing sonar ranges against the walls; reported are the
+// position and heading errors against the true pose and the
+// computation time per filter step.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o ekfBench -Wall -Werror ekfBench.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: ekfBench [-t seconds] [-r hz] [-p hz]
+//   -t  simulated time in s (default 120)
+//   -r  filter rate in Hz (default 50)
+//   -p  sonar ping rate in Hz (default 10)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <initio.h>
+#include <initio_sim.h>
+#include <initio_ekf.h>
+
+#define ROOM_W 300.0
+#define ROOM_H 200.0
+#define SIM_DT 0.001
+
+static const initio_wall walls[] = {
+    { 0, 0, ROOM_W, 0 }, { ROOM_W, 0, ROOM_W, ROOM_H },
+    { ROOM_W, ROOM_H, 0, ROOM_H }, { 0, ROOM_H, 0, 0 }
+} ;
+
+// wallDistance(): true distance from the sonar (8 cm ahead) to the room walls
+static double wallDistance (const initio_pose *p)
+{
+    double c = cos (p->theta), s = sin (p->theta) ;
+    double sx = p->x + 8 * c, sy = p->y + 8 * s ;
+    double tx = (c > 1e-9) ? (ROOM_W - sx) / c : (c < -1e-9) ? -sx / c : INFINITY ;
+    double ty = (s > 1e-9) ? (ROOM_H - sy) / s : (s < -1e-9) ? -sy / s : INFINITY ;
+    return fmax (fmin (tx, ty), 0) ;
+}
+
+typedef struct {
+    const char *name ;
+    initio_ekf *ekf ;
+    double posSq, thSq, posMax ;
+    unsigned long samples ;
+} run_t ;
+
+static void sample (run_t *run, const initio_pose *truth)
+{
+    initio_ekfEstimate e ;
+    double dp, dth ;
+
+    initio_EkfGet (run->ekf, &e) ;
+    dp = hypot (e.pose.x - truth->x, e.pose.y - truth->y) ;
+    dth = remainder (e.pose.theta - truth->theta, 2 * M_PI) ;
+    run->posSq += dp * dp ;
+    run->thSq += dth * dth ;
+    if (dp > run->posMax) run->posMax = dp ;
+    run->samples++ ;
+}
+
+int main (int argc, char *argv[])
+{
+    double duration = 120, hz = 50, pingHz = 10 ;
+    initio_simParams simParams ;
+    initio_ekfParams params ;
+    initio_sim sim ;
+    initio_ctx *ctx ;
+    initio_pose start = { 50, 100, 0 } ;
+    run_t runs[2] = { { "wheel pulses only" }, { "pulses + sonar" } } ;
+    double t, nextFilter = 0, nextPing = 0, turnUntil = 0 ;
+    int opt, i ;
+
+    while ((opt = getopt (argc, argv, "t:r:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': duration = atof (optarg) ; break ;
+        case 'r': hz = atof (optarg) ; break ;
+        case 'p': pingHz = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (duration <= 0 || hz <= 0 || pingHz <= 0)
+        return EXIT_FAILURE ;
+
+    // the true chassis differs from the model of the estimator
+    initio_SimDefaultParams (&simParams) ;
+    simParams.wheelBase = 14.8 ;
+    simParams.cmPerTick = 1.03 ;
+    initio_SimInit (&sim, &simParams, &start) ;
+    ctx = initio_Open (ROBOHAT, &initio_simHw, &sim, INITIO_MOTORS | INITIO_SENSORS | INITIO_SONAR) ;
+    if (ctx == NULL)
+        return EXIT_FAILURE ;
+
+    initio_EkfDefaultParams (&params) ;
+    runs[0].ekf = initio_EkfCreate (ctx, &params, &start, walls, 4) ;
+    runs[1].ekf = initio_EkfCreate (ctx, &params, &start, walls, 4) ;
+
+    for (t = 0; t < duration; t += SIM_DT)
+    {
+        // wander: drive forward, turn away from the walls for a while
+        if (t >= turnUntil)
+        {
+            if (wallDistance (&sim.pose) < 40)
+            {
+                initio_ctxSpinRight (ctx, 60) ;
+                turnUntil = t + 0.4 + 0.6 * ((int)(t * 7) % 5) / 5.0 ;
+            }
+            else
+                initio_ctxTurnForward (ctx, 70, 62 + (int)(t / 10) % 3 * 4) ;
+        }
+        initio_SimStep (&sim, SIM_DT) ;
+
+        if (t >= nextPing)
+        {
+            sim.sonarCm = (unsigned int)lround (wallDistance (&sim.pose)) ;
+            initio_EkfAddRange (runs[1].ekf, initio_ctxUsGetDistance (ctx)) ;
+            nextPing += 1 / pingHz ;
+        }
+        if (t >= nextFilter)
+        {
+            for (i = 0; i < 2; i++)
+            {
+                initio_EkfStep (runs[i].ekf, 1 / hz) ;
+                sample (&runs[i], &sim.pose) ;
+            }
+            nextFilter += 1 / hz ;
+        }
+    }
+
+    printf ("%.0f s simulated, filter %.0f Hz, sonar %.0f Hz\n", duration, hz, pingHz) ;
+    for (i = 0; i < 2; i++)
+    {
+        initio_ekfStats s ;
+        initio_ekfEstimate e ;
+
+        initio_EkfGetStats (runs[i].ekf, &s) ;
+        initio_EkfGet (runs[i].ekf, &e) ;
+        printf ("%-18s position rms %6.2f cm (max %6.2f)  heading rms %5.2f deg  sd %5.2f cm  "
+                "step %5.2f us (max %6.2f)  sonar update %5.2f us  ranges used %lu rejected %lu unmapped %lu\n",
+                runs[i].name, sqrt (runs[i].posSq / runs[i].samples), runs[i].posMax,
+                sqrt (runs[i].thSq / runs[i].samples) * 180 / M_PI, sqrt (e.cov[0][0] + e.cov[1][1]),
+                s.costAvgUs, s.costMaxUs, s.rangeCostAvgUs, s.ranges, s.rejected, s.unmapped) ;
+        initio_EkfFree (runs[i].ekf) ;
+    }
+    initio_Close (ctx) ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,203 @@
+//======================================================================
+//
+// Debounce and glitch filter (initio_filter.h): measures the time per
+// filter step of all six inputs, then filters synthetic inputs with
+// contact bounce after each edge and random glitches, and counts the
+// edges and the delay after filtering. Finally the sampling thread runs
+// on the real inputs for some seconds; against the wiringPi stub (see
+// ../stub) the IR obstacle sensors glitch now and then.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o filterBench -Wall -Werror filterBench.c -linitio -lwiringPi -lpthread
+//
+// Usage: filterBench [-r hz] [-d us] [-m window] [-t seconds]
+//   -r  sampling rate (default 20000)
+//   -d  debounce time of all inputs in us (default: per input defaults)
+//   -m  majority window of all inputs: 1, 3, 5 or 7 (default 3)
+//   -t  duration of the sampling thread run in s (default 2)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_filter.h>
+
+// only present in the wiringPi stub
+typedef int (*readHook_t)(int pin) ;
+extern void wiringPiStub_SetReadHook (readHook_t hook) __attribute__((weak)) ;
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+static unsigned int seed = 12345 ;
+
+static unsigned int nextRandom (void)
+{
+    seed ^= seed << 13 ;
+    seed ^= seed >> 17 ;
+    seed ^= seed << 5 ;
+    return seed ;
+}
+
+static const char *names[INITIO_FILTER_INPUTS] = {
+    "IR left", "IR right", "line left", "line right", "wheel left", "wheel right" } ;
+
+// stepTime(): ns per initio_FilterStep
+static double stepTime (const initio_filterParams *params)
+{
+    initio_filterCore core ;
+    unsigned int x = 0 ;
+    long i, n = 10000000 ;
+    double t ;
+
+    initio_FilterInit (&core, params, 0) ;
+    t = now () ;
+    for (i = 0; i < n; i++)
+        x ^= initio_FilterStep (&core, nextRandom () & 0x3f) ;
+    t = now () - t ;
+    if (x == 0x100)  // keeps the loop
+        printf (" ") ;
+    return t * 1e9 / n ;
+}
+
+// synthetic(): one second of square waves (slower for the IR sensors),
+// with bounce after each edge (0.5 ms, 0.1 ms for the wheel sensors) and a 1-2 sample glitch about
+// every 10 ms per input; reports edges and filter delay
+static void synthetic (const initio_filterParams *params)
+{
+    const double periods[INITIO_FILTER_INPUTS] = { 0.2, 0.25, 0.1, 0.12, 0.016, 0.02 } ;
+    const double bounce[INITIO_FILTER_INPUTS] = { 0.0005, 0.0005, 0.0005, 0.0005, 0.0001, 0.0001 } ;
+    initio_filterCore core ;
+    unsigned int level = 0, raw, state = 0, prevRaw = 0, glitch = 0 ;
+    unsigned long edges[INITIO_FILTER_INPUTS] = { 0 }, rawEdges[INITIO_FILTER_INPUTS] = { 0 } ;
+    unsigned long outEdges[INITIO_FILTER_INPUTS] = { 0 } ;
+    double lastEdge[INITIO_FILTER_INPUTS] = { 0 }, delay[INITIO_FILTER_INPUTS] = { 0 } ;
+    long k, n = (long)params->hz ;
+    int i ;
+
+    initio_FilterInit (&core, params, 0) ;
+    for (k = 0; k < n; k++)
+    {
+        double t = k / params->hz ;
+        unsigned int old = state ;
+
+        raw = 0 ;
+        for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+        {
+            unsigned int bit = 1u << i, want = ((long)(2 * t / periods[i]) & 1) ? bit : 0 ;
+
+            if (want != (level & bit))
+            {
+                level ^= bit ;
+                lastEdge[i] = t ;
+                edges[i]++ ;
+            }
+            raw |= want ;
+            if (t - lastEdge[i] < bounce[i] && lastEdge[i] > 0 && (nextRandom () & 1))  // bounce
+                raw ^= bit ;
+            if (glitch & bit)
+                glitch &= ~bit ;
+            else if (nextRandom () % (unsigned)(params->hz / 100) == 0)
+                glitch |= bit ;
+            raw ^= glitch & bit ;
+        }
+        state = initio_FilterStep (&core, raw) ;
+        for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+        {
+            if ((raw ^ prevRaw) & (1u << i))
+                rawEdges[i]++ ;
+            if ((state ^ old) & (1u << i))
+            {
+                outEdges[i]++ ;
+                delay[i] += t - lastEdge[i] ;
+            }
+        }
+        prevRaw = raw ;
+    }
+    printf ("input        window debounce   edges  raw edges  filtered  delay [ms]\n") ;
+    for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+        printf ("%-12s %6d %6u us %7lu %10lu %9lu %11.2f\n", names[i], params->majority[i],
+                params->debounceUs[i], edges[i], rawEdges[i], outEdges[i],
+                outEdges[i] ? delay[i] * 1e3 / outEdges[i] : 0.0) ;
+}
+
+// glitchy(): stub read hook, the IR obstacle sensors glitch for one read
+// about every 1000 reads
+static int glitchy (int pin)
+{
+    int level ;
+
+    if ((pin == irFL || pin == irFR) && nextRandom () % 1000 == 0)
+    {
+        wiringPiStub_SetReadHook (NULL) ;
+        level = !digitalRead (pin) ;
+        wiringPiStub_SetReadHook (glitchy) ;
+        return level ;
+    }
+    return -1 ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_filterParams params ;
+    initio_filterStats s ;
+    initio_filter *filter ;
+    double ns ;
+    int opt, i, debounce = -1, window = 3, seconds = 2 ;
+
+    initio_FilterDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "r:d:m:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r': params.hz = atof (optarg) ; break ;
+        case 'd': debounce = atoi (optarg) ; break ;
+        case 'm': window = atoi (optarg) ; break ;
+        case 't': seconds = atoi (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (params.hz < 100)
+        return EXIT_FAILURE ;
+    for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+    {
+        params.majority[i] = window ;
+        if (debounce >= 0)
+            params.debounceUs[i] = debounce ;
+    }
+
+    ns = stepTime (&params) ;
+    printf ("filter step: %.1f ns for all inputs (%.3f%% of a %.0f Hz period)\n\n",
+            ns, ns * 1e-9 * params.hz * 100, params.hz) ;
+    synthetic (&params) ;
+
+    initio_InitEx (INITIO_SENSORS) ;
+    if (wiringPiStub_SetReadHook != NULL)
+        wiringPiStub_SetReadHook (glitchy) ;
+    filter = initio_FilterStart (NULL, &params) ;
+    if (filter == NULL)
+        return EXIT_FAILURE ;
+    sleep (seconds) ;
+    initio_FilterStop (filter, &s) ;
+    if (wiringPiStub_SetReadHook != NULL)
+        wiringPiStub_SetReadHook (NULL) ;
+    printf ("\nsampling thread: %lu samples, %.0f Hz, %lu overruns\n", s.samples, s.rate.rateHz, s.rate.overruns) ;
+    printf ("cycle %.1f us average, %.1f us max\n", s.rate.execAvgUs, s.rate.execMaxUs) ;
+    for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+        printf ("%-12s raw changes %6lu, filtered %6lu\n", names[i], s.rawChanges[i], s.changes[i]) ;
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
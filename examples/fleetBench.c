@@ -0,0 +1,141 @@
+//======================================================================
+//
+// Throughput benchmark of the fleet simulator (initio_fleet.h).
+// Runs a fleet of robots with a simple obstacle avoidance behaviour
+// (batch commands from the sensor bitmasks) for 1, 2, 4, ... threads and
+// reports the simulated robot-steps per second. The final poses are
+// compared between the runs: they must not depend on the thread count.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o fleetBench -Wall -Werror fleetBench.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: fleetBench [-n robots] [-s steps] [-t maxThreads] [-d dt]
+//   -n  number of robots (default 4096)
+//   -s  simulation steps per run (default 1000)
+//   -t  largest number of threads (default: number of CPUs)
+//   -d  time step in s (default 0.01)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_fleet.h>
+
+static const initio_circle obstacles[] = {
+    { 100, 100, 20 }, { 300, 80, 30 }, { 320, 220, 25 }, { 80, 230, 15 }, { 200, 40, 10 }
+} ;
+
+static double now (void)
+{
+    struct timespec ts ;
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+// avoid(): batch obstacle avoidance, like a simple initio program per robot
+static void avoid (initio_fleet *fleet, int count, uint8_t *bits, float *sonar, initio_fleetCmd *cmds)
+{
+    int i ;
+
+    initio_FleetGetSensors (fleet, bits) ;
+    initio_FleetGetSonar (fleet, sonar) ;
+    for (i = 0; i < count; i++)
+    {
+        if (bits[i] & INITIO_SENSE_IRLEFT)
+            cmds[i] = (initio_fleetCmd){ INITIO_FLEET_SPINRIGHT, 50, 0 } ;
+        else if (bits[i] & INITIO_SENSE_IRRIGHT)
+            cmds[i] = (initio_fleetCmd){ INITIO_FLEET_SPINLEFT, 50, 0 } ;
+        else if (sonar[i] > 0 && sonar[i] < 30)
+            cmds[i] = (initio_fleetCmd){ INITIO_FLEET_TURNFORWARD, 60, 30 } ;
+        else
+            cmds[i] = (initio_fleetCmd){ INITIO_FLEET_DRIVEFORWARD, 70, 0 } ;
+    }
+    initio_FleetCommand (fleet, cmds) ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_fleetWorld world = { 400, 300, obstacles, sizeof(obstacles) / sizeof(obstacles[0]),
+                                { 200, 150, 80 }, 2 } ;
+    int count = 4096, steps = 1000, maxThreads = sysconf (_SC_NPROCESSORS_ONLN) ;
+    double dt = 0.01, refSum = 0 ;
+    BOOL deterministic = TRUE ;
+    uint8_t *bits ;
+    float *sonar ;
+    initio_fleetCmd *cmds ;
+    int opt, threads, i ;
+
+    while ((opt = getopt (argc, argv, "n:s:t:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': count = atoi (optarg) ; break ;
+        case 's': steps = atoi (optarg) ; break ;
+        case 't': maxThreads = atoi (optarg) ; break ;
+        case 'd': dt = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (count < 1 || steps < 1 || maxThreads < 1)
+        return EXIT_FAILURE ;
+    bits = malloc (count) ;
+    sonar = malloc (count * sizeof(float)) ;
+    cmds = malloc (count * sizeof(initio_fleetCmd)) ;
+    if (bits == NULL || sonar == NULL || cmds == NULL)
+        return EXIT_FAILURE ;
+
+    printf ("fleet of %d robots, %d steps of %.3f s\n", count, steps, dt) ;
+    for (threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        initio_fleet *fleet = initio_FleetCreate (count, threads, NULL, &world, 42) ;
+        const initio_fleetState *s ;
+        double stepTime = 0, t0, t1, sum = 0 ;
+        unsigned long hits = 0 ;
+        int n ;
+
+        if (fleet == NULL)
+        {
+            fprintf (stderr, "%s: cannot create fleet\n", argv[0]) ;
+            return EXIT_FAILURE ;
+        }
+        t0 = now () ;
+        for (n = 0; n < steps; n++)
+        {
+            avoid (fleet, count, bits, sonar, cmds) ;
+            t1 = now () ;
+            initio_FleetStep (fleet, dt) ;
+            stepTime += now () - t1 ;
+        }
+        t1 = now () - t0 ;
+
+        s = initio_FleetState (fleet) ;
+        for (i = 0; i < count; i++)
+        {
+            sum += s->x[i] + s->y[i] + s->theta[i] ;
+            hits += (s->sensors[i] & (INITIO_SENSE_IRLEFT | INITIO_SENSE_IRRIGHT)) != 0 ;
+        }
+        if (threads == 1)
+            refSum = sum ;
+        else if (sum != refSum)
+            deterministic = FALSE ;
+
+        printf ("%3d threads  step %8.2f M robot-steps/s  (%6.1f ns/robot)   with controller %8.2f M/s   IR %lu   checksum %.6f\n",
+                threads, (double)count * steps / stepTime * 1e-6, stepTime / ((double)count * steps) * 1e9,
+                (double)count * steps / t1 * 1e-6, hits, sum) ;
+        initio_FleetFree (fleet) ;
+    }
+    printf ("results independent of thread count: %s\n", deterministic ? "yes" : "NO") ;
+
+    free (bits) ;
+    free (sonar) ;
+    free (cmds) ;
+    return deterministic ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
@@ -0,0 +1,117 @@
+//======================================================================
+//
+// Test program for the built-in line follower of the 4tronix initio
+// robot car. The follower samples the line sensors in its own thread;
+// this program only tunes speed and gains at runtime and shows the
+// achieved sampling rate and lap statistics.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o lineFollow -Wall -Werror lineFollow.c -lcurses -linitio -lwiringPi -lpthread -lm
+//
+// Usage: lineFollow [-e] [-c] [-r hz]
+//   -e  sample on sensor edges instead of periodically
+//   -c  line wider than the sensor spacing (INITIO_LINE_COVER)
+//   -r  sampling rate in Hz (default 1000)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <initio.h>
+#include <initio_line.h>
+#include <curses.h>
+
+//======================================================================
+// lineFollow():
+// Runs the line follower and handles the tuning keys.
+//======================================================================
+void lineFollow (int mode, initio_lineParams *params, char *name)
+{
+    initio_line *line = initio_LineStart (mode, params) ;
+    initio_lineStats s ;
+    int ch = 0 ;
+
+    if (line == NULL)
+    {
+        mvprintw (1, 1, "%s: cannot start line follower", name) ;
+        refresh () ;
+        delay (2000) ;
+        return ;
+    }
+    while (ch != 'q')
+    {
+        mvprintw (1, 1, "%s: 'q'.. exit, +/-.. speed, p/P.. kp, d/D.. kd, r/R.. rate", name) ;
+        ch = getch () ;
+        switch (ch)
+        {
+        case '+': params->speed = MIN (params->speed + 5, 100) ; break ;
+        case '-': params->speed = MAX (params->speed - 5, 0) ; break ;
+        case 'p': params->kp = MAX (params->kp - 5, 0) ; break ;
+        case 'P': params->kp += 5 ; break ;
+        case 'd': params->kd = MAX (params->kd - 0.5, 0) ; break ;
+        case 'D': params->kd += 0.5 ; break ;
+        case 'r': params->sampleHz = MAX (params->sampleHz / 2, 50) ; break ;
+        case 'R': params->sampleHz = MIN (params->sampleHz * 2, 20000) ; break ;
+        }
+        if (ch != ERR)
+            initio_LineSetParams (line, params) ;
+
+        initio_LineGetStats (line, &s) ;
+        mvprintw (3, 1, "mode: %s   speed: %3d   kp: %5.1f   kd: %4.1f   rate: %6.0f Hz   ",
+                  (mode == INITIO_LINE_EDGE) ? "edge" : "poll", params->speed, params->kp, params->kd, params->sampleHz) ;
+        mvprintw (5, 1, "samples: %10lu   achieved: %8.1f Hz   edges: %8lu   ", s.samples, s.sampleHz, s.edges) ;
+        mvprintw (6, 1, "error: %2d   motors: %4d %4d   %s   ", s.error, s.left, s.right, s.searching ? "SEARCHING" : "on line  ") ;
+        mvprintw (7, 1, "lost: %lu times, %.2f s   ", s.lostEvents, s.lostTime) ;
+        mvprintw (8, 1, "laps: %lu   last: %.2f s   best: %.2f s   avg: %.2f s   ", s.laps, s.lapLast, s.lapBest, s.lapAvg) ;
+        if (mode == INITIO_LINE_POLL)
+            mvprintw (9, 1, "loop: jitter max %.0f us, exec avg %.1f us, overruns %lu   ",
+                      s.rate.jitterMaxUs, s.rate.execAvgUs, s.rate.overruns) ;
+        refresh () ;
+        delay (100) ; // pause 100ms
+    }
+    initio_LineStop (line) ;
+}
+
+
+//======================================================================
+// main(): initialisation of libraries, etc
+//======================================================================
+int main (int argc, char *argv[])
+{
+    initio_lineParams params ;
+    int mode = INITIO_LINE_POLL ;
+    int opt ;
+    WINDOW *mainwin ;
+
+    initio_LineDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "ecr:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'e': mode = INITIO_LINE_EDGE ; break ;
+        case 'c': params.geometry = INITIO_LINE_COVER ; break ;
+        case 'r': params.sampleHz = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    mainwin = initscr () ;     // curses: init screen
+    noecho () ;                // curses: prevent the key being echoed
+    cbreak () ;                // curses: disable line buffering
+    nodelay (mainwin, TRUE) ;  // curses: set getch() as non-blocking
+    keypad (mainwin, TRUE) ;   // curses: enable detection of cursor and other keys
+
+    initio_Init () ; // initio: init the library
+
+    lineFollow (mode, &params, argv[0]) ;
+
+    initio_Cleanup () ;  // initio: cleanup the library (reset robot car)
+    endwin () ;          // curses: cleanup the library
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,130 @@
+//======================================================================
+//
+// Metrics exporter (initio_metrics.h): serves /metrics on a loopback
+// port while the program pings the sonar, drives a motor pattern and
+// moves the pan servo, then fetches /metrics itself like a Prometheus
+// scrape and prints it. With -t it keeps serving for that long, e.g. for
+//   curl http://127.0.0.1:9101/metrics
+//
+// Against the wiringPi stub (see ../stub) an object is simulated at 60 cm.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o metricsDemo -Wall -Werror metricsDemo.c -linitio -lwiringPi -lpthread
+//
+// Usage: metricsDemo [-p port] [-t seconds]
+//   -p  port on 127.0.0.1 (default 9101)
+//   -t  time to go on serving after the scrape in s (default 0)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <initio.h>
+#include <initio_metrics.h>
+
+// only present in the wiringPi stub
+extern void wiringPiStub_SetSonar (int pin, unsigned int distance) __attribute__((weak)) ;
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+// scrape(): GET /metrics from port, prints the response; returns the
+// time the request took in ms, negative on error
+static double scrape (unsigned short port)
+{
+    struct sockaddr_in addr ;
+    static const char request[] = "GET /metrics HTTP/1.0\r\nHost: localhost\r\n\r\n" ;
+    char buf[4096] ;
+    double t = now () ;
+    ssize_t n ;
+    int fd = socket (AF_INET, SOCK_STREAM, 0) ;
+
+    memset (&addr, 0, sizeof(addr)) ;
+    addr.sin_family = AF_INET ;
+    addr.sin_port = htons (port) ;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK) ;
+    if (fd < 0 || connect (fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || send (fd, request, sizeof(request) - 1, 0) < 0)
+        return -1 ;
+    while ((n = recv (fd, buf, sizeof(buf), 0)) > 0)
+        fwrite (buf, 1, n, stdout) ;
+    close (fd) ;
+    return (now () - t) * 1e3 ;
+}
+
+// activity(): one round of sonar, motor and servo calls
+static void activity (int i)
+{
+    static const int duties[] = { 0, 30, 60, 100, 60, 30 } ;
+
+    initio_UsGetDistance () ;
+    initio_TurnForward (duties[i % 6], duties[(i + 3) % 6]) ;
+    initio_SetServo (servoPan, (i % 12) * 10 - 40) ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_metricsParams params ;
+    initio_metricsStats s ;
+    initio_metrics *metrics ;
+    double ms, seconds = 0, until ;
+    int opt, i ;
+
+    initio_MetricsDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "p:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': params.port = atoi (optarg) ; break ;
+        case 't': seconds = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    initio_Init () ;
+    initio_UsSetMaxRange (200) ;
+    if (wiringPiStub_SetSonar != NULL)
+        wiringPiStub_SetSonar ((initio_ctxBoard (initio_DefaultCtx ()) == ROBOHAT) ? sonar_RoboHAT : sonar_PiRoCon, 60) ;
+    metrics = initio_MetricsStart (NULL, &params) ;
+    if (metrics == NULL)
+    {
+        fprintf (stderr, "cannot serve on 127.0.0.1:%u\n", params.port) ;
+        return EXIT_FAILURE ;
+    }
+
+    for (i = 0; i < 60; i++)
+    {
+        activity (i) ;
+        usleep (20000) ;
+    }
+    ms = scrape (params.port) ;
+    printf ("\nscrape took %.2f ms\n", ms) ;
+
+    until = now () + seconds ;
+    for (i = 0; now () < until; i++)
+    {
+        activity (i) ;
+        usleep (50000) ;
+    }
+    initio_Stop () ;
+    initio_MetricsStop (metrics, &s) ;
+    printf ("served %lu scrapes, %lu errors\n", s.scrapes, s.errors) ;
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
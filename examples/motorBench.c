@@ -0,0 +1,74 @@
+//======================================================================
+//
+// Benchmark of the motor commands: replays typical command streams of
+// a controller through initio_SetMotors() and the classic motor
+// functions, and reports the softPwmWrite() calls issued and saved by
+// the per-pin duty cache, and the time per command.
+// Without the cache every command issued four writes.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o motorBench -Wall -Werror motorBench.c -linitio -lwiringPi -lpthread
+//
+// Usage: motorBench [commands]
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <initio.h>
+
+#define CONSTANT  0  // cruise: the same command over and over
+#define LINE      1  // line follower: a few distinct commands, changing now and then
+#define SWEEP     2  // one wheel ramps: one pin changes per command
+#define CLASSIC   3  // obstacle avoidance with the classic functions
+
+static const char *names[] = { "constant", "line follower", "sweep", "classic functions" } ;
+
+static void command (int stream, long i)
+{
+    static const int line[3][2] = { { 40, 40 }, { 75, 5 }, { 5, 75 } } ;
+
+    switch (stream)
+    {
+    case CONSTANT: initio_SetMotors (60, 60) ; break ;
+    case LINE:     initio_SetMotors (line[(i / 10) % 3][0], line[(i / 10) % 3][1]) ; break ;
+    case SWEEP:    initio_SetMotors ((int)(i % 201) - 100, 50) ; break ;
+    case CLASSIC:
+        if ((i / 50) % 4 == 3)
+            initio_SpinRight (50) ;
+        else
+            initio_DriveForward (70) ;
+        break ;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    long n = (argc > 1) ? atol (argv[1]) : 100000 ;
+    initio_motorStats s ;
+    int stream ;
+    long i ;
+
+    if (n < 1) n = 1 ;
+    initio_InitEx (INITIO_MOTORS) ; // initio: motors only
+
+    printf ("%ld commands per stream\n", n) ;
+    for (stream = CONSTANT; stream <= CLASSIC; stream++)
+    {
+        initio_Stop () ;
+        initio_ResetMotorStats () ;
+        for (i = 0; i < n; i++)
+            command (stream, i) ;
+        initio_GetMotorStats (&s) ;
+        printf ("%-18s writes %8lu  saved %8lu (%5.1f%%)  latency avg %7.0f ns  max %8.0f ns\n",
+                names[stream], s.writes, s.skipped, 100.0 * s.skipped / (4.0 * s.calls),
+                s.latencyAvgNs, s.latencyMaxNs) ;
+    }
+
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,162 @@
+//======================================================================
+//
+// Motor characterisation (initio_ff.h): sweeps the duty of both motors,
+// measures the wheel pulse rates, prints and saves the feedforward
+// table. In the simulation (default) it then runs a PI wheel speed
+// controller to several target speeds, once starting from a duty
+// proportional to the speed and once from the table (initio_FfDuty),
+// and reports how long each takes to settle within 10%.
+//
+// On the robot (-R) the sweep takes about a minute with the default
+// step; lift the wheels off the ground or give it room to drive.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o motorCal -Wall -Werror motorCal.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: motorCal [-R] [-s step] [-o file]
+//   -R  calibrate the robot instead of the simulation
+//   -s  duty step of the sweep (default 5)
+//   -o  table file (default motor.ff)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <initio.h>
+#include <initio_sim.h>
+#include <initio_ff.h>
+
+#define STEP 0.001    // simulation step in s
+#define PERIOD 0.05   // control period in s
+#define WINDOW 20    // control periods of the rate measurement
+
+// simWait(): advances the simulation by seconds
+static void simWait (void *arg, double seconds)
+{
+    long i, n = lround (seconds / STEP) ;
+
+    for (i = 0; i < n; i++)
+        initio_SimStep ((initio_sim *)arg, STEP) ;
+}
+
+static void printTable (const initio_ffTable *t)
+{
+    int i, duty ;
+
+    printf ("duty   left fwd/rev   right fwd/rev  [pulses/s]\n") ;
+    for (i = 0; i < t->steps; i++)
+    {
+        duty = (i * t->step < 100) ? i * t->step : 100 ;
+        printf ("%4d  %6.1f %6.1f   %6.1f %6.1f\n", duty, t->rate[INITIO_FF_LEFT][0][i],
+                t->rate[INITIO_FF_LEFT][1][i], t->rate[INITIO_FF_RIGHT][0][i], t->rate[INITIO_FF_RIGHT][1][i]) ;
+    }
+    printf ("stall duty: left %d/%d, right %d/%d\n", t->stall[0][0], t->stall[0][1], t->stall[1][0], t->stall[1][1]) ;
+}
+
+// settle(): PI control of the left wheel speed to target pulses/s from
+// the initial duty; returns the time after which the measured rate stays
+// within 10% of the target, or a negative value if it never does
+static double settle (initio_sim *sim, initio_ctx *ctx, double target, double duty)
+{
+    unsigned long counts[WINDOW + 1] ;
+    double rate, ki = 0.1, t, settled = -1 ;
+    int i, k ;
+
+    initio_ctxStop (ctx) ;
+    simWait (sim, 1.0) ;
+    for (i = 0; i <= WINDOW; i++)
+        counts[i] = initio_ctxWheelCountLeft (ctx) ;
+    for (k = 0; k < 400; k++)  // 20 s
+    {
+        initio_ctxSetMotors (ctx, (int)lround (duty), 0) ;
+        simWait (sim, PERIOD) ;
+        for (i = 0; i < WINDOW; i++)
+            counts[i] = counts[i + 1] ;
+        counts[WINDOW] = initio_ctxWheelCountLeft (ctx) ;
+        rate = (counts[WINDOW] - counts[0]) / (WINDOW * PERIOD) ;
+        t = (k + 1) * PERIOD ;
+        if (k >= WINDOW)  // only with a full window
+        {
+            duty += ki * (target - rate) ;
+            duty = fmax (0, fmin (100, duty)) ;
+            if (fabs (rate - target) > 0.1 * target)
+                settled = -1 ;
+            else if (settled < 0)
+                settled = t ;
+        }
+    }
+    initio_ctxStop (ctx) ;
+    return settled ;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *path = "motor.ff" ;
+    const double targets[] = { 12, 20, 30, 45 } ;
+    initio_ffParams params ;
+    initio_ffTable table, loaded ;
+    initio_sim sim ;
+    initio_ctx *ctx ;
+    double rate100, naive, ff ;
+    int opt, i, robot = FALSE ;
+
+    initio_FfDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "Rs:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'R': robot = TRUE ; break ;
+        case 's': params.step = atoi (optarg) ; break ;
+        case 'o': path = optarg ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    if (robot)
+    {
+        initio_InitEx (INITIO_MOTORS | INITIO_SENSORS) ;
+        ctx = NULL ;
+    }
+    else
+    {
+        initio_SimInit (&sim, NULL, NULL) ;
+        ctx = initio_Open (ROBOHAT, &initio_simHw, &sim, INITIO_MOTORS | INITIO_SENSORS) ;
+    }
+    if (!initio_FfCalibrate (ctx, &params, &table, robot ? NULL : simWait, &sim))
+    {
+        fprintf (stderr, "calibration failed (no wheel pulses?)\n") ;
+        return EXIT_FAILURE ;
+    }
+    printTable (&table) ;
+    if (!initio_FfSave (&table, path) || !initio_FfLoad (&loaded, path))
+    {
+        fprintf (stderr, "cannot write %s\n", path) ;
+        return EXIT_FAILURE ;
+    }
+    printf ("table saved to %s\n", path) ;
+    if (robot)
+    {
+        initio_Cleanup () ;
+        return EXIT_SUCCESS ;
+    }
+
+    // speed control with and without feedforward
+    rate100 = initio_FfRate (&loaded, INITIO_FF_LEFT, 100) ;
+    printf ("\ntarget   proportional start      feedforward start\n") ;
+    for (i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+    {
+        naive = settle (&sim, ctx, targets[i], 100 * targets[i] / rate100) ;
+        ff = settle (&sim, ctx, targets[i], initio_FfDuty (&loaded, INITIO_FF_LEFT, targets[i])) ;
+        printf ("%4.0f/s   duty %3.0f settled %4.2f s   duty %3d settled %4.2f s\n", targets[i],
+                100 * targets[i] / rate100, naive, initio_FfDuty (&loaded, INITIO_FF_LEFT, targets[i]), ff) ;
+    }
+    initio_Close (ctx) ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,136 @@
+//======================================================================
+//
+// Test program for the pure-pursuit path follower of the 4tronix initio
+// robot car. The robot follows a polyline of waypoints, either
+//  o on the robot, with the pose from wheel odometry and the follower
+//    running in its fixed-rate thread, or
+//  o in a simulated chassis (option -s), stepped in virtual time to
+//    measure the cross-track error deterministically.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o pathFollow -Wall -Werror pathFollow.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: pathFollow [-s] [-r hz] [-v duty] [-l lookahead] [x,y ...]
+//        (default path: 100cm x 60cm rectangle)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <initio.h>
+#include <initio_path.h>
+#include <initio_sim.h>
+
+#define MAX_WAYPOINTS 64
+#define SIM_DT        0.001  // simulation step in s
+#define SIM_TIMEOUT   120.0  // give up after this simulated time in s
+
+static void printStats (const initio_pathStats *s)
+{
+    printf ("steps:          %lu\n", s->steps) ;
+    printf ("goal reached:   %s\n", s->done ? "yes" : "no") ;
+    if (s->noPose > 0)
+        printf ("without pose:   %lu steps (motors stopped)\n", s->noPose) ;
+    printf ("cross-track:    avg|e| %.2f cm, rms %.2f cm, max %.2f cm\n", s->xteAbsAvg, s->xteRms, s->xteMax) ;
+    if (s->rate.cycles > 0)
+    {
+        printf ("loop rate:      %.1f Hz (period avg %.0f us, min %.0f us, max %.0f us)\n",
+                s->rate.rateHz, s->rate.periodAvgUs, s->rate.periodMinUs, s->rate.periodMaxUs) ;
+        printf ("loop timing:    jitter max %.0f us, exec avg %.1f us, max %.1f us, overruns %lu\n",
+                s->rate.jitterMaxUs, s->rate.execAvgUs, s->rate.execMaxUs, s->rate.overruns) ;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    initio_point wp[MAX_WAYPOINTS] = { {0, 0}, {100, 0}, {100, 60}, {0, 60}, {0, 0} } ;
+    int count = 5 ;
+    initio_pathParams params ;
+    initio_pathStats stats ;
+    initio_path *path ;
+    BOOL simulate = FALSE ;
+    double hz = 50 ;
+    int opt ;
+
+    initio_PathDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "sr:v:l:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': simulate = TRUE ; break ;
+        case 'r': hz = atof (optarg) ; break ;
+        case 'v': params.speed = atoi (optarg) ; break ;
+        case 'l': params.lookahead = atof (optarg) ; break ;
+        default:
+            fprintf (stderr, "usage: %s [-s] [-r hz] [-v duty] [-l lookahead cm] [x,y ...]\n", argv[0]) ;
+            return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE ;
+        }
+    }
+    if (optind < argc)
+    {
+        for (count = 0; optind < argc && count < MAX_WAYPOINTS; optind++, count++)
+            if (sscanf (argv[optind], "%lf,%lf", &wp[count].x, &wp[count].y) != 2)
+            {
+                fprintf (stderr, "%s: invalid waypoint '%s'\n", argv[0], argv[optind]) ;
+                return EXIT_FAILURE ;
+            }
+    }
+
+    path = initio_PathCreate (wp, count, &params) ;
+    if (path == NULL)
+    {
+        fprintf (stderr, "%s: need at least two waypoints\n", argv[0]) ;
+        return EXIT_FAILURE ;
+    }
+
+    if (simulate)
+    {
+        // virtual time: the controller runs every 1/hz s of simulated time
+        initio_sim sim ;
+        int stepsPerControl = (int)(1.0 / (hz * SIM_DT) + 0.5) ;
+        long i ;
+        BOOL running = TRUE ;
+
+        initio_SimInit (&sim, NULL, NULL) ;
+        initio_PathSetPoseSource (path, initio_SimPose, &sim) ;
+        initio_PathSetMotorSink (path, initio_SimMotors, &sim) ;
+        if (stepsPerControl < 1) stepsPerControl = 1 ;
+        for (i = 0; running && sim.time < SIM_TIMEOUT; i++)
+        {
+            if (i % stepsPerControl == 0)
+                running = initio_PathStep (path) ;
+            initio_SimStep (&sim, SIM_DT) ;
+        }
+        initio_PathGetStats (path, &stats) ;
+        printf ("simulated time: %.2f s at %.0f Hz control rate\n", sim.time, hz) ;
+        printf ("final pose:     x %.1f cm, y %.1f cm, theta %.2f rad\n", sim.pose.x, sim.pose.y, sim.pose.theta) ;
+        printStats (&stats) ;
+    }
+    else
+    {
+        initio_odometry *odo ;
+
+        initio_Init () ;
+        odo = initio_OdometryCreate (1.0, params.wheelBase, NULL) ;
+        initio_PathSetPoseSource (path, initio_OdometryPose, odo) ;
+        initio_PathStart (path, hz) ;
+        while (!initio_PathDone (path))
+        {
+            initio_PathGetStats (path, &stats) ;
+            printf ("segment %d, xte %.1f cm, curvature %.4f 1/cm\n", stats.segment, stats.xte, stats.curvature) ;
+            delay (500) ;
+        }
+        initio_PathStop (path) ;
+        initio_PathGetStats (path, &stats) ;
+        printStats (&stats) ;
+        initio_OdometryFree (odo) ;
+        initio_Cleanup () ;
+    }
+    initio_PathFree (path) ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,228 @@
+//======================================================================
+//
+// Replanning latency of the D* Lite planner (initio_plan.h) on synthetic
+// maps. A square grid of 1 cm cells is filled with random rectangular
+// obstacles. The robot starts near one corner with the goal near the
+// opposite one. In every round it moves a few cells along its path and a
+// small obstacle of a few cells appears on the path ahead of it. Two
+// planners see the same changes: one repairs its search (incremental),
+// the other searches from scratch each time (full). Printed per map size
+// are the time and the expanded nodes of the first search, of the
+// incremental replans and of the full replans, the memory of a planner,
+// and whether both found paths of the same length in every round.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o planBench -Wall -Werror planBench.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: planBench [-n cells] [-r rounds] [-c cells] [-s cells] [-d density] [-S seed]
+//   -n  side of a single map in cells (default: 250, 500 and 1000)
+//   -r  rounds per map (default 30)
+//   -c  cells of each new obstacle (default 5)
+//   -s  cells moved per round (default 5)
+//   -d  share of the map covered by obstacles (default 0.2)
+//   -S  random seed (default 1)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <initio.h>
+#include <initio_plan.h>
+
+#define MAX_WAYPOINTS 4096
+
+typedef struct {
+    int rounds ;           // rounds with a path
+    double initialMs ;
+    unsigned long initialExpanded ;
+    double incAvgMs, incMaxMs, incExpanded ;
+    double fullAvgMs, fullExpanded ;
+    size_t bytes ;
+    BOOL equal ;           // both planners found paths of the same length
+} result_t ;
+
+// fillMap(): random rectangles up to the density, start and goal kept clear
+static void fillMap (initio_plan *a, initio_plan *b, int n, double density, int start, int goal)
+{
+    char *map = calloc (n * n, 1) ;
+    long filled = 0 ;
+    int x, y, w, h, i, j ;
+
+    while (filled < density * n * n)
+    {
+        w = 2 + rand () % (n / 20 + 1) ;
+        h = 2 + rand () % (n / 20 + 1) ;
+        x = rand () % (n - w) ;
+        y = rand () % (n - h) ;
+        for (j = y; j < y + h; j++)
+            for (i = x; i < x + w; i++)
+            {
+                if (abs (i - start) < 4 && abs (j - start) < 4)
+                    continue ;
+                if (abs (i - goal) < 4 && abs (j - goal) < 4)
+                    continue ;
+                if (!map[j * n + i])
+                {
+                    map[j * n + i] = 1 ;
+                    filled++ ;
+                    initio_PlanSetCell (a, i, j, TRUE) ;
+                    initio_PlanSetCell (b, i, j, TRUE) ;
+                }
+            }
+    }
+    free (map) ;
+}
+
+// along(): point at distance d along the polyline wp
+static initio_point along (const initio_point *wp, int count, double d)
+{
+    double len ;
+    int i ;
+
+    for (i = 1; i < count; i++)
+    {
+        len = hypot (wp[i].x - wp[i - 1].x, wp[i].y - wp[i - 1].y) ;
+        if (d <= len && len > 0)
+        {
+            initio_point p = { wp[i - 1].x + (wp[i].x - wp[i - 1].x) * d / len,
+                               wp[i - 1].y + (wp[i].y - wp[i - 1].y) * d / len } ;
+            return p ;
+        }
+        d -= len ;
+    }
+    return wp[count - 1] ;
+}
+
+static result_t bench (int n, int rounds, int cells, int step, double density)
+{
+    static initio_point wp[MAX_WAYPOINTS] ;
+    initio_planParams params ;
+    initio_planStats s ;
+    initio_plan *inc, *full ;
+    initio_pose pose = { 2.5, 2.5, 0 } ;
+    initio_point p ;
+    result_t r = { 0 } ;
+    int count, round, i, x, y, goal = n - 3 ;
+    double cost ;
+    BOOL found ;
+
+    initio_PlanDefaultParams (&params) ;
+    params.width = params.height = n ;
+    params.cellCm = 1 ;
+    params.originX = params.originY = 0 ;
+    params.robotRadius = 0 ;
+    inc = initio_PlanCreate (&params) ;
+    full = initio_PlanCreate (&params) ;
+    if (inc == NULL || full == NULL)
+    {
+        fprintf (stderr, "cannot create a %d x %d planner\n", n, n) ;
+        exit (EXIT_FAILURE) ;
+    }
+    fillMap (inc, full, n, density, 2, goal) ;
+    initio_PlanSetGoal (inc, goal + 0.5, goal + 0.5) ;
+    initio_PlanSetGoal (full, goal + 0.5, goal + 0.5) ;
+
+    found = initio_PlanReplan (inc, &pose) ;
+    initio_PlanGetStats (inc, &s) ;
+    r.initialMs = s.lastMs ;
+    r.initialExpanded = s.lastExpanded ;
+    r.equal = TRUE ;
+    for (round = 0; found && round < rounds; round++)
+    {
+        // move along the path, then an obstacle appears 10 to 40 cells ahead
+        count = initio_PlanGetWaypoints (inc, wp, MAX_WAYPOINTS) ;
+        if (count > MAX_WAYPOINTS)
+            count = MAX_WAYPOINTS ;
+        p = along (wp, count, step) ;
+        pose.x = p.x ;
+        pose.y = p.y ;
+        p = along (wp, count, step + 10 + rand () % 31) ;
+        x = (int)p.x ;
+        y = (int)p.y ;
+        for (i = 0; i < cells; i++)
+        {
+            if ((x != (int)pose.x || y != (int)pose.y) && (x != goal || y != goal))
+            {
+                initio_PlanSetCell (inc, x, y, TRUE) ;
+                initio_PlanSetCell (full, x, y, TRUE) ;
+            }
+            x += rand () % 3 - 1 ;
+            y += rand () % 3 - 1 ;
+        }
+
+        found = initio_PlanReplan (inc, &pose) ;
+        initio_PlanGetStats (inc, &s) ;
+        r.incAvgMs += s.lastMs ;
+        r.incExpanded += s.lastExpanded ;
+        if (s.lastMs > r.incMaxMs)
+            r.incMaxMs = s.lastMs ;
+        cost = s.cost ;
+
+        initio_PlanSetGoal (full, goal + 0.5, goal + 0.5) ;  // discards the search
+        if (initio_PlanReplan (full, &pose) != found)
+            r.equal = FALSE ;
+        initio_PlanGetStats (full, &s) ;
+        if (s.cost != cost)
+            r.equal = FALSE ;
+        r.fullAvgMs += s.lastMs ;
+        r.fullExpanded += s.lastExpanded ;
+        r.rounds++ ;
+    }
+    if (r.rounds > 0)
+    {
+        r.incAvgMs /= r.rounds ;
+        r.incExpanded /= r.rounds ;
+        r.fullAvgMs /= r.rounds ;
+        r.fullExpanded /= r.rounds ;
+    }
+    initio_PlanGetStats (inc, &s) ;
+    r.bytes = s.bytes ;
+    initio_PlanFree (inc) ;
+    initio_PlanFree (full) ;
+    return r ;
+}
+
+int main (int argc, char *argv[])
+{
+    int sizes[3] = { 250, 500, 1000 }, count = 3 ;
+    int rounds = 30, cells = 5, step = 5, opt, i ;
+    double density = 0.2 ;
+    unsigned int seed = 1 ;
+    result_t r ;
+
+    while ((opt = getopt (argc, argv, "n:r:c:s:d:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': sizes[0] = atoi (optarg) ; count = 1 ; break ;
+        case 'r': rounds = atoi (optarg) ; break ;
+        case 'c': cells = atoi (optarg) ; break ;
+        case 's': step = atoi (optarg) ; break ;
+        case 'd': density = atof (optarg) ; break ;
+        case 'S': seed = atoi (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (sizes[0] < 50 || density < 0 || density > 0.5)
+        return EXIT_FAILURE ;
+
+    printf ("                          first search        incremental replan        full replan\n") ;
+    printf ("  cells  memory [MB]   [ms]   expanded   avg [ms] max [ms] expanded   avg [ms] expanded  speedup  rounds  equal\n") ;
+    for (i = 0; i < count; i++)
+    {
+        srand (seed) ;
+        r = bench (sizes[i], rounds, cells, step, density) ;
+        printf ("%4dx%-4d %9.1f %8.2f %10lu %10.3f %8.3f %8.0f %10.2f %8.0f %8.0fx %7d  %s\n",
+                sizes[i], sizes[i], r.bytes / 1048576.0, r.initialMs, r.initialExpanded,
+                r.incAvgMs, r.incMaxMs, r.incExpanded, r.fullAvgMs, r.fullExpanded,
+                (r.incAvgMs > 0) ? r.fullAvgMs / r.incAvgMs : 0, r.rounds, r.equal ? "yes" : "no") ;
+    }
+    return EXIT_SUCCESS ;
+}
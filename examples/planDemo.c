@@ -0,0 +1,227 @@
+//======================================================================
+//
+// Navigation with the D* Lite planner (initio_plan.h). In the simulation
+// (default) the robot starts at the origin and drives to a goal 2.5 m
+// ahead (-x/-y) through a room it does not know: a wall across the
+// direct way and a box behind it. Twenty times a second the forward
+// sonar and the IR sensors are entered into the grid, and the planner
+// replans and steers with spin and turn motor commands. The pose is the
+// true pose of the simulation. Printed every second are pose, state and
+// the last replan, and at the end the time to the goal, the distance
+// driven, the replanning times and how close the robot came to an
+// obstacle, with a warning if that is closer than the robot radius (an
+// obstacle the sensors did not see in time: the sonar is a single ray
+// along the heading).
+//
+// With -R the planner drives the robot, with the pose from the wheel
+// odometry. Against the wiringPi stub (see ../stub) the wheel sensors do
+// not move, so the robot appears to stand still.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o planDemo -Wall -Werror planDemo.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: planDemo [-R] [-x cm] [-y cm] [-v duty] [-t seconds]
+//   -R  drive the robot
+//   -x  goal ahead of the start in cm (default 250)
+//   -y  goal to the left of the start in cm (default 0)
+//   -v  duty on straight segments (default 60)
+//   -t  give up after this time in s (default 60)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <initio.h>
+#include <initio_sim.h>
+#include <initio_plan.h>
+
+#define STEP     0.005   // simulation step in s
+#define PERIOD   10      // simulation steps per navigation step (20 Hz)
+
+typedef struct {
+    double x0, y0, x1, y1 ;
+} box_t ;
+
+// the room of the simulation, unknown to the planner
+static const box_t room[] = {
+    { -60, -120, 320, -110 }, { -60, 110, 320, 120 },   // side walls
+    { -60, -120, -50, 120 }, { 310, -120, 320, 120 },   // end walls
+    { 100, -70, 110, 60 },                               // wall across the way
+    { 170, -10, 200, 30 },                               // box behind it
+} ;
+#define BOXES (sizeof(room) / sizeof(room[0]))
+
+static BOOL inRoom (double x, double y)
+{
+    int i ;
+
+    for (i = 0; i < BOXES; i++)
+        if (x >= room[i].x0 && x <= room[i].x1 && y >= room[i].y0 && y <= room[i].y1)
+            return TRUE ;
+    return FALSE ;
+}
+
+// clearance(): distance from (x, y) to the nearest obstacle
+static double clearance (double x, double y)
+{
+    double best = INFINITY, dx, dy ;
+    int i ;
+
+    for (i = 0; i < BOXES; i++)
+    {
+        dx = fmax (fmax (room[i].x0 - x, x - room[i].x1), 0) ;
+        dy = fmax (fmax (room[i].y0 - y, y - room[i].y1), 0) ;
+        best = fmin (best, hypot (dx, dy)) ;
+    }
+    return best ;
+}
+
+// sonar(): range along the heading to the first obstacle, 0 beyond maxCm
+static unsigned int sonar (const initio_pose *pose, double maxCm)
+{
+    double d ;
+
+    for (d = 0; d <= maxCm; d += 0.5)
+        if (inRoom (pose->x + d * cos (pose->theta), pose->y + d * sin (pose->theta)))
+            return lround (d) ;
+    return 0 ;
+}
+
+static BOOL ir (const initio_pose *pose, double cm, double side)
+{
+    return inRoom (pose->x + cm * cos (pose->theta + side), pose->y + cm * sin (pose->theta + side)) ;
+}
+
+static const char *stateName (int state)
+{
+    static const char *names[] = { "driving", "arrived", "no path" } ;
+
+    return names[state] ;
+}
+
+static void simulate (const initio_planParams *params, double goalX, double goalY, double seconds)
+{
+    initio_sim sim ;
+    initio_ctx *ctx ;
+    initio_plan *plan ;
+    initio_planStats s ;
+    double minClearance = INFINITY, lastX = 0, lastY = 0, driven = 0 ;
+    int state = INITIO_PLAN_DRIVING ;
+    long i ;
+
+    plan = initio_PlanCreate (params) ;
+    if (plan == NULL || !initio_PlanSetGoal (plan, goalX, goalY))
+    {
+        fprintf (stderr, "cannot plan to %.0f, %.0f\n", goalX, goalY) ;
+        return ;
+    }
+    initio_SimInit (&sim, NULL, NULL) ;
+    ctx = initio_Open (ROBOHAT, &initio_simHw, &sim, INITIO_MOTORS) ;
+    printf ("  time      x      y  theta  state     replan [ms]  expanded\n") ;
+    for (i = 0; state == INITIO_PLAN_DRIVING && sim.time < seconds; i++)
+    {
+        if (i % PERIOD == 0)
+        {
+            initio_PlanSonar (plan, &sim.pose, 0, sonar (&sim.pose, params->sonarMaxCm)) ;
+            initio_PlanIr (plan, &sim.pose, ir (&sim.pose, params->irCm, 0.35), ir (&sim.pose, params->irCm, -0.35)) ;
+            state = initio_PlanDrive (plan, ctx, &sim.pose) ;
+            if (i % (20 * PERIOD) == 0 || state != INITIO_PLAN_DRIVING)
+            {
+                initio_PlanGetStats (plan, &s) ;
+                printf ("%6.2f %6.1f %6.1f %6.2f  %-9s %11.3f %9lu\n", sim.time, sim.pose.x, sim.pose.y,
+                        sim.pose.theta, stateName (state), s.lastMs, s.lastExpanded) ;
+            }
+        }
+        initio_SimStep (&sim, STEP) ;
+        driven += hypot (sim.pose.x - lastX, sim.pose.y - lastY) ;
+        lastX = sim.pose.x ;
+        lastY = sim.pose.y ;
+        minClearance = fmin (minClearance, clearance (sim.pose.x, sim.pose.y)) ;
+    }
+    initio_PlanGetStats (plan, &s) ;
+    printf ("\n%s after %.2f s, driven %.0f cm (straight line %.0f cm), closest obstacle %.1f cm from the centre\n",
+            stateName (state), sim.time, driven, hypot (goalX, goalY), minClearance) ;
+    printf ("%lu replans, avg %.3f ms, max %.3f ms, %lu nodes expanded, %lu cell changes, %.0f kB\n",
+            s.replans, s.replans ? s.totalMs / s.replans : 0, s.maxMs, s.expanded, s.changedCells, s.bytes / 1024.0) ;
+    if (minClearance < params->robotRadius)
+        printf ("WARNING: the robot came within %.1f cm of an obstacle, closer than its radius of %.0f cm\n",
+                minClearance, params->robotRadius) ;
+    initio_Close (ctx) ;
+    initio_PlanFree (plan) ;
+}
+
+static void robot (const initio_planParams *params, double goalX, double goalY, double seconds)
+{
+    initio_pathParams pathParams ;
+    initio_odometry *odo ;
+    initio_plan *plan ;
+    initio_planStats s ;
+    initio_pose pose ;
+    int state = INITIO_PLAN_DRIVING, i ;
+
+    plan = initio_PlanCreate (params) ;
+    if (plan == NULL || !initio_PlanSetGoal (plan, goalX, goalY))
+    {
+        fprintf (stderr, "cannot plan to %.0f, %.0f\n", goalX, goalY) ;
+        return ;
+    }
+    initio_Init () ;
+    initio_UsSetMaxRange (params->sonarMaxCm) ;
+    initio_PathDefaultParams (&pathParams) ;
+    odo = initio_OdometryCreate (1.0, pathParams.wheelBase, NULL) ;
+    for (i = 0; state == INITIO_PLAN_DRIVING && i < seconds * 20; i++)
+    {
+        initio_OdometryPose (odo, &pose) ;
+        initio_PlanSonar (plan, &pose, 0, initio_UsGetDistance ()) ;
+        initio_PlanIr (plan, &pose, initio_IrLeft (), initio_IrRight ()) ;
+        state = initio_PlanDrive (plan, NULL, &pose) ;
+        if (i % 20 == 0 || state != INITIO_PLAN_DRIVING)
+        {
+            initio_PlanGetStats (plan, &s) ;
+            printf ("%5.1f s  x %6.1f  y %6.1f  theta %5.2f  %-9s replan %.3f ms\n",
+                    i / 20.0, pose.x, pose.y, pose.theta, stateName (state), s.lastMs) ;
+        }
+        delay (50) ;
+    }
+    initio_Stop () ;
+    initio_PlanGetStats (plan, &s) ;
+    printf ("\n%lu replans, avg %.3f ms, max %.3f ms, %lu cell changes\n",
+            s.replans, s.replans ? s.totalMs / s.replans : 0, s.maxMs, s.changedCells) ;
+    initio_OdometryFree (odo) ;
+    initio_Cleanup () ;
+    initio_PlanFree (plan) ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_planParams params ;
+    double goalX = 250, goalY = 0, seconds = 60 ;
+    int opt, onRobot = FALSE ;
+
+    initio_PlanDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "Rx:y:v:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'R': onRobot = TRUE ; break ;
+        case 'x': goalX = atof (optarg) ; break ;
+        case 'y': goalY = atof (optarg) ; break ;
+        case 'v': params.speed = atoi (optarg) ; break ;
+        case 't': seconds = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    if (onRobot)
+        robot (&params, goalX, goalY, seconds) ;
+    else
+        simulate (&params, goalX, goalY, seconds) ;
+    return EXIT_SUCCESS ;
+}
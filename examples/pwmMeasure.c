@@ -0,0 +1,356 @@
+//======================================================================
+//
+// Measurement tool for the duty-cycle accuracy and timing jitter of the
+// softPwm motor channels of the 4tronix initio robot car.
+//
+// The tool sets the motors with initio_DriveForward(duty) for a list of
+// duties, captures the output edges of the motor pins and writes a JSON
+// report with the period and duty-cycle error distributions and the
+// worst-case jitter. Optional threads generate synthetic CPU load.
+//
+// Edges are captured either
+//  o from the wiringPi stub (see ../stub), which reports every level
+//    change written by the softPwm threads, or
+//  o on real hardware via a loopback wire from motor pin L1 to a free
+//    input pin (option -p), observed with wiringPiISR().
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o pwmMeasure -Wall -Werror pwmMeasure.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage (against the stub, without servos):
+// SERVOBLASTER=/dev/null ./pwmMeasure -d 10,50,90 -t 2000 -l 2 -u 80 -o report.json
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <initio.h>
+
+#define MAX_EDGES   400000  // per channel and run
+#define MAX_DUTIES  32
+#define PWM_RANGE   100     // range used by initio_Init() for softPwmCreate()
+#define PULSE_US    100     // softPwm pulse unit of wiringPi
+#define SETTLE_MS   50      // time to let the PWM threads pick up a new duty
+
+// Provided only by the wiringPi stub (see ../stub); NULL with the real wiringPi.
+extern void wiringPiStub_SetWriteHook (void (*hook)(int pin, int value, uint64_t ns)) __attribute__((weak)) ;
+
+typedef struct {
+    uint64_t ns ;
+    int value ;
+} edge_t ;
+
+typedef struct {
+    const char *name ;
+    int pin ;
+    edge_t *edges ;
+    volatile size_t count ;
+} channel_t ;
+
+typedef struct {
+    size_t n ;
+    double mean, std, min, p50, p95, p99, max ;
+} dist_t ;
+
+static channel_t channels[2] ;
+static int numChannels = 0 ;
+static volatile int recording = 0 ;
+static int loopbackPin = -1 ;
+
+static volatile int loadRunning = 0 ;
+static int loadPercent = 100 ;
+
+
+//======================================================================
+// Edge capture
+
+static uint64_t nowNs (void)
+{
+    struct timespec ts ;
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec ;
+}
+
+static void recordEdge (channel_t *ch, int value, uint64_t ns)
+{
+    // each channel is written by a single thread (its softPwm thread or ISR)
+    size_t i = ch->count ;
+    if (!recording || i >= MAX_EDGES) return ;
+    ch->edges[i].ns = ns ;
+    ch->edges[i].value = value ;
+    ch->count = i + 1 ;
+}
+
+// stubWriteHook(): called by the wiringPi stub for every output level change
+static void stubWriteHook (int pin, int value, uint64_t ns)
+{
+    int i ;
+    for (i = 0; i < numChannels; i++)
+        if (channels[i].pin == pin)
+            recordEdge (&channels[i], value, ns) ;
+}
+
+// loopbackIsr(): called by wiringPi on both edges of the loopback input pin
+static void loopbackIsr (void)
+{
+    uint64_t ns = nowNs () ;
+    recordEdge (&channels[0], digitalRead (loopbackPin), ns) ;
+}
+
+
+//======================================================================
+// Synthetic CPU load
+// Each load thread is busy for loadPercent of every 10ms window.
+
+static void *loadThread (void *arg)
+{
+    const uint64_t windowNs = 10000000ULL ;
+    volatile unsigned long sink = 0 ;
+
+    (void)arg ;
+    while (loadRunning)
+    {
+        uint64_t start = nowNs () ;
+        uint64_t busyEnd = start + windowNs * loadPercent / 100 ;
+        while (nowNs () < busyEnd)
+            sink++ ;
+        if (loadPercent < 100)
+        {
+            uint64_t rest = start + windowNs - nowNs () ;
+            struct timespec ts = { 0, (long)rest } ;
+            if (rest < windowNs) nanosleep (&ts, NULL) ;
+        }
+    }
+    return NULL ;
+}
+
+
+//======================================================================
+// Statistics
+
+static int cmpDouble (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b ;
+    return (x > y) - (x < y) ;
+}
+
+static dist_t distribution (double *v, size_t n)
+{
+    dist_t d ;
+    size_t i ;
+    double sum = 0, sq = 0 ;
+
+    memset (&d, 0, sizeof(d)) ;
+    d.n = n ;
+    if (n == 0) return d ;
+    for (i = 0; i < n; i++)
+        sum += v[i] ;
+    d.mean = sum / n ;
+    for (i = 0; i < n; i++)
+        sq += (v[i] - d.mean) * (v[i] - d.mean) ;
+    d.std = sqrt (sq / n) ;
+    qsort (v, n, sizeof(double), cmpDouble) ;
+    d.min = v[0] ;
+    d.max = v[n-1] ;
+    d.p50 = v[(n - 1) * 50 / 100] ;
+    d.p95 = v[(n - 1) * 95 / 100] ;
+    d.p99 = v[(n - 1) * 99 / 100] ;
+    return d ;
+}
+
+static void printDist (FILE *fp, const char *name, dist_t d)
+{
+    fprintf (fp, "\"%s\": {\"n\": %zu, \"mean\": %.3f, \"std\": %.3f, \"min\": %.3f, "
+                 "\"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+             name, d.n, d.mean, d.std, d.min, d.p50, d.p95, d.p99, d.max) ;
+}
+
+// analyseChannel(): derives periods and duty errors from the rising edges
+// and writes one JSON object for the channel.
+static void analyseChannel (FILE *fp, channel_t *ch, int duty)
+{
+    const double nominalUs = PWM_RANGE * PULSE_US ;
+    size_t n = ch->count, i, r, np = 0 ;
+    double *period = malloc (n * sizeof(double)) ;
+    double *dutyErr = malloc (n * sizeof(double)) ;
+    double *jitter = malloc (n * sizeof(double)) ;
+    size_t prevRise = (size_t)-1 ;
+    dist_t dp, dd, dj ;
+
+    for (i = 0; i < n; i++)
+    {
+        if (ch->edges[i].value != HIGH) continue ;
+        if (prevRise != (size_t)-1)
+        {
+            // find falling edge inside the previous period
+            double highUs = 0 ;
+            for (r = prevRise + 1; r < i; r++)
+                if (ch->edges[r].value == LOW)
+                {
+                    highUs = (ch->edges[r].ns - ch->edges[prevRise].ns) / 1000.0 ;
+                    break ;
+                }
+            period[np] = (ch->edges[i].ns - ch->edges[prevRise].ns) / 1000.0 ;
+            dutyErr[np] = 100.0 * highUs / period[np] - duty ;
+            jitter[np] = fabs (period[np] - nominalUs) ;
+            np++ ;
+        }
+        prevRise = i ;
+    }
+    dp = distribution (period, np) ;
+    dd = distribution (dutyErr, np) ;
+    dj = distribution (jitter, np) ;
+
+    fprintf (fp, "        {\"name\": \"%s\", \"pin\": %d, \"edges\": %zu, ", ch->name, ch->pin, n) ;
+    if (n >= MAX_EDGES)
+        fprintf (fp, "\"truncated\": true, ") ;
+    printDist (fp, "period_us", dp) ;
+    fprintf (fp, ", ") ;
+    printDist (fp, "duty_error_pct", dd) ;
+    fprintf (fp, ", ") ;
+    printDist (fp, "jitter_us", dj) ;
+    fprintf (fp, ", \"worst_jitter_us\": %.3f}", dj.max) ;
+
+    free (period) ;
+    free (dutyErr) ;
+    free (jitter) ;
+}
+
+
+//======================================================================
+// main(): parse options, run the duty sweep and print the JSON report
+//======================================================================
+int main (int argc, char *argv[])
+{
+    int duties[MAX_DUTIES] = { 10, 25, 50, 75, 90 } ;
+    int numDuties = 5 ;
+    unsigned int measureMs = 2000 ;
+    int loadThreads = 0 ;
+    const char *backend = NULL ;
+    const char *outFile = NULL ;
+    FILE *fp = stdout ;
+    pthread_t *loaders = NULL ;
+    int opt, i, d, board ;
+
+    while ((opt = getopt (argc, argv, "d:t:l:u:p:b:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+        {
+            char *tok = strtok (optarg, ",") ;
+            numDuties = 0 ;
+            while (tok != NULL && numDuties < MAX_DUTIES)
+            {
+                duties[numDuties++] = atoi (tok) ;
+                tok = strtok (NULL, ",") ;
+            }
+            break ;
+        }
+        case 't': measureMs = atoi (optarg) ; break ;
+        case 'l': loadThreads = atoi (optarg) ; break ;
+        case 'u': loadPercent = atoi (optarg) ; break ;
+        case 'p': loopbackPin = atoi (optarg) ; break ;
+        case 'b': backend = optarg ; break ;
+        case 'o': outFile = optarg ; break ;
+        default:
+            fprintf (stderr, "usage: %s [-d duty,...] [-t ms per duty] [-l load threads] [-u load %%]\n"
+                             "          [-p loopback input pin] [-b backend name] [-o report.json]\n", argv[0]) ;
+            return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE ;
+        }
+    }
+    if (loadPercent < 1) loadPercent = 1 ;
+    if (loadPercent > 100) loadPercent = 100 ;
+
+    if (loopbackPin < 0 && wiringPiStub_SetWriteHook == NULL)
+    {
+        fprintf (stderr, "%s: real wiringPi detected, please connect L1 to an input pin and use -p <pin>\n", argv[0]) ;
+        return EXIT_FAILURE ;
+    }
+
+    initio_InitEx (INITIO_MOTORS) ;  // no servod: its messages would corrupt the report on stdout
+    board = initio_identifyControlBoard () ;
+
+    // forward driving uses L1 and R1 as PWM outputs (L2 and R2 stay at 0)
+    if (loopbackPin >= 0)
+    {
+        channels[numChannels++] = (channel_t){ "loopback(L1)", loopbackPin, NULL, 0 } ;
+        pinMode (loopbackPin, INPUT) ;
+        wiringPiISR (loopbackPin, INT_EDGE_BOTH, loopbackIsr) ;
+        if (backend == NULL) backend = "wiringPi-softPwm" ;
+    }
+    else
+    {
+        channels[numChannels++] = (channel_t){ "L1", (board == PIROCON2) ? L1_PiRoCon : L1_RoboHAT, NULL, 0 } ;
+        channels[numChannels++] = (channel_t){ "R1", (board == PIROCON2) ? R1_PiRoCon : R1_RoboHAT, NULL, 0 } ;
+        wiringPiStub_SetWriteHook (stubWriteHook) ;
+        if (backend == NULL) backend = "stub-softPwm" ;
+    }
+    for (i = 0; i < numChannels; i++)
+        channels[i].edges = malloc (MAX_EDGES * sizeof(edge_t)) ;
+
+    if (loadThreads > 0)
+    {
+        loadRunning = 1 ;
+        loaders = malloc (loadThreads * sizeof(pthread_t)) ;
+        for (i = 0; i < loadThreads; i++)
+            pthread_create (&loaders[i], NULL, loadThread, NULL) ;
+    }
+
+    if (outFile != NULL && (fp = fopen (outFile, "w")) == NULL)
+    {
+        perror (outFile) ;
+        fp = stdout ;
+    }
+    fprintf (fp, "{\n  \"tool\": \"pwmMeasure\",\n  \"backend\": \"%s\",\n", backend) ;
+    fprintf (fp, "  \"board\": \"%s\",\n", (board == PIROCON2) ? "PIROCON2" : "ROBOHAT") ;
+    fprintf (fp, "  \"pwm_range\": %d,\n  \"pulse_us\": %d,\n  \"nominal_period_us\": %d,\n",
+             PWM_RANGE, PULSE_US, PWM_RANGE * PULSE_US) ;
+    fprintf (fp, "  \"measure_ms\": %u,\n  \"cpus\": %ld,\n", measureMs, sysconf (_SC_NPROCESSORS_ONLN)) ;
+    fprintf (fp, "  \"load\": {\"threads\": %d, \"percent\": %d},\n", loadThreads, loadPercent) ;
+    fprintf (fp, "  \"runs\": [\n") ;
+
+    for (d = 0; d < numDuties; d++)
+    {
+        initio_DriveForward (duties[d]) ;
+        delay (SETTLE_MS) ;
+        for (i = 0; i < numChannels; i++)
+            channels[i].count = 0 ;
+        recording = 1 ;
+        delay (measureMs) ;
+        recording = 0 ;
+
+        fprintf (fp, "    {\"duty\": %d, \"channels\": [\n", duties[d]) ;
+        for (i = 0; i < numChannels; i++)
+        {
+            analyseChannel (fp, &channels[i], duties[d]) ;
+            fprintf (fp, "%s\n", (i < numChannels - 1) ? "," : "") ;
+        }
+        fprintf (fp, "    ]}%s\n", (d < numDuties - 1) ? "," : "") ;
+    }
+    fprintf (fp, "  ]\n}\n") ;
+    if (fp != stdout) fclose (fp) ;
+
+    loadRunning = 0 ;
+    for (i = 0; i < loadThreads; i++)
+        pthread_join (loaders[i], NULL) ;
+    free (loaders) ;
+
+    if (loopbackPin < 0)
+        wiringPiStub_SetWriteHook (NULL) ;
+    initio_Cleanup () ;
+    for (i = 0; i < numChannels; i++)
+        free (channels[i].edges) ;
+    return EXIT_SUCCESS ;
+}
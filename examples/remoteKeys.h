@@ -0,0 +1,201 @@
+#ifndef _4TRONIX_REMOTEKEYS_H_
+#define _4TRONIX_REMOTEKEYS_H_
+//======================================================================
+//
+// Key bindings of the remote controls (remoteControl2, teleop): cursor
+// keys steer, b reverses, space stops, shift-cursor/aswd move the
+// pan/tilt servos, r centres them and y/n nod and shake the head.
+// The servos move through an animator (initio_anim.h) in the
+// background; the program writes the status line.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <sys/param.h>
+#include <curses.h>
+#include "initio.h"
+#include "initio_anim.h"
+
+#define KEY_ESCAPE 27
+#define KEY_SDOWN 336
+#define KEY_SUP 337
+
+#define ADD_MOTOR_SPEED(var, val) (MAX(0 , MIN( 100, (var)+(val) )))  // limit virtual motor speed to 0/100
+#define ADD_SERVO_TILT(var, val) (MAX(-80 , MIN( 80, (var)+(val) )))  // limit horizontal movement: -80/80 to avoid non-resting motors
+#define ADD_SERVO_PAN(var, val)  (MAX(-40 , MIN( 80, (var)+(val) )))  // limit vertical movement: -40 to fit size of ultrasoncic sensor, 80 to avoid non-resting motors
+
+enum driveMode { stop=0, forward, reverse, spinleft, spinright } ;
+static const char *driveModeNames[5] = {"Stop", "Forward", "Reverse", "SpinLeft", "SpinRight" } ;
+
+typedef struct {
+    enum driveMode driveMode ;
+    int speed, posTilt, posPan ;
+    void (*pMotionFunc)(int8_t) ;
+    unsigned int timeNext ;
+    initio_anim *anim ;          // moves the servos
+    void (*status) (const char *fmt, ...) ;  // writes the status line
+} remoteKeys ;
+
+static const unsigned int delayMS = 20 ; // delay in ms between updates on certain controls, e.g., acceleration
+static const unsigned int holdGestureMS = 150 ; // hold time in ms at the turning points of yes/no gestures
+
+// remoteKeysInit (keys, anim, status):
+// Starts stopped with speed 30 and the servos centred.
+static void remoteKeysInit (remoteKeys *keys, initio_anim *anim, void (*status) (const char *fmt, ...))
+{
+    keys->driveMode = stop ;
+    keys->speed = 30 ;
+    keys->posTilt = 0 ;
+    keys->posPan = 0 ;
+    keys->pMotionFunc = initio_DriveForward ;
+    keys->timeNext = 0 ;
+    keys->anim = anim ;
+    keys->status = status ;
+}
+
+// remoteKeysGesture(): pos +delta, -delta and back, holding at the turning points
+static void remoteKeysGesture (remoteKeys *keys, int servo, int pos, int delta)
+{
+    initio_animKey gesture[3] ;
+    int up = (servo == servoPan) ? ADD_SERVO_PAN (pos, delta) : ADD_SERVO_TILT (pos, delta) ;
+    int down = (servo == servoPan) ? ADD_SERVO_PAN (pos, -delta) : ADD_SERVO_TILT (pos, -delta) ;
+
+    gesture[0] = (initio_animKey) { up, holdGestureMS } ;
+    gesture[1] = (initio_animKey) { down, holdGestureMS } ;
+    gesture[2] = (initio_animKey) { pos, 0 } ;
+    initio_AnimPlay (keys->anim, servo, gesture, 3) ;
+}
+
+// remoteKeysHandle (keys, ch):
+// Acts on key ch (getch() code) and writes the status line. Returns
+// FALSE if no command was issued (ERR or a key without binding).
+static BOOL remoteKeysHandle (remoteKeys *keys, int ch)
+{
+    unsigned int timeCurrent = millis () ;
+
+    switch ( ch ) {
+    // Motor control keys
+    case KEY_LEFT:
+        if (keys->driveMode == stop ||  keys->driveMode == spinleft) {
+            keys->speed = ADD_MOTOR_SPEED (keys->speed, 10) ;
+        } else if (keys->driveMode == spinright) {
+            keys->speed = 0 ;
+        } // endif
+        keys->driveMode = spinleft;
+        keys->pMotionFunc = initio_SpinLeft ;
+        break;
+    case KEY_RIGHT:
+        if (keys->driveMode == spinright || keys->driveMode == stop) {
+            keys->speed = ADD_MOTOR_SPEED (keys->speed, 10) ;
+        } else if (keys->driveMode == spinleft) {
+            keys->speed = 0 ;
+        } ; // endif
+        keys->driveMode = spinright;
+        keys->pMotionFunc = initio_SpinRight ;
+        break;
+    case KEY_UP:
+        switch (keys->driveMode) {
+        case forward:
+             if (timeCurrent < keys->timeNext) break; // throttle acceleration
+             keys->timeNext = timeCurrent + delayMS;
+        case stop:
+             keys->driveMode = forward ;
+             keys->pMotionFunc = initio_DriveForward ;
+             keys->speed = ADD_MOTOR_SPEED (keys->speed, 10) ;
+             break;
+        case reverse:
+             keys->speed = ADD_MOTOR_SPEED (keys->speed, -10) ;
+             if (keys->speed == 0) {
+                 keys->driveMode = stop ;
+             } // endif
+             break ;
+        default:
+             keys->driveMode = forward ;
+             keys->pMotionFunc = initio_DriveForward ;
+        } // switch
+        break;
+    case KEY_DOWN:
+        keys->speed = 0 ;
+        break;
+    case 'b':
+        switch (keys->driveMode) {
+        case reverse:
+             //if (timeCurrent < keys->timeNext) break; // throttle acceleration
+             keys->timeNext = timeCurrent + delayMS;
+        case stop:
+             keys->driveMode = reverse ;
+             keys->pMotionFunc = initio_DriveReverse ;
+             keys->speed = ADD_MOTOR_SPEED (keys->speed, 10) ;
+             break;
+        case forward:
+             keys->speed = ADD_MOTOR_SPEED (keys->speed, -10) ;
+             if (keys->speed == 0) {
+                 keys->driveMode = stop ;
+             } // endif
+             break ;
+        default:
+             keys->driveMode = reverse ;
+             keys->pMotionFunc = initio_DriveReverse ;
+        } // switch
+        break;
+    case ' ':
+        keys->driveMode = stop ;
+        keys->speed = 0;
+        initio_Stop () ;
+        keys->status ("%s %d", driveModeNames[keys->driveMode], keys->speed) ;
+        return TRUE ;
+    // Servo control keys
+    case 'r':
+        keys->posTilt = 0;
+        keys->posPan = 0;
+        initio_AnimMoveTo (keys->anim, servoTilt, keys->posTilt) ;
+        initio_AnimMoveTo (keys->anim, servoPan, keys->posPan) ;
+        keys->status ("Servo Reset %d,%d", keys->posTilt, keys->posPan);
+        return TRUE ;
+    case KEY_SLEFT:
+    case 'a':
+        keys->posTilt = ADD_SERVO_TILT (keys->posTilt, -10);
+        initio_AnimMoveTo (keys->anim, servoTilt, keys->posTilt) ;
+        keys->status ("Servo Left %d", keys->posTilt);
+        return TRUE ;
+    case KEY_SRIGHT:
+    case 'd':
+        keys->posTilt = ADD_SERVO_TILT (keys->posTilt, 10);
+        initio_AnimMoveTo (keys->anim, servoTilt, keys->posTilt) ;
+        keys->status ("Servo Right %d", keys->posTilt);
+        return TRUE ;
+    case KEY_SUP:
+    case 'w':
+        keys->posPan = ADD_SERVO_PAN (keys->posPan, 10);
+        initio_AnimMoveTo (keys->anim, servoPan, keys->posPan) ;
+        keys->status ("Servo Up %d", keys->posPan);
+        return TRUE ;
+    case KEY_SDOWN:
+    case 's':
+        keys->posPan = ADD_SERVO_PAN (keys->posPan, -10);
+        initio_AnimMoveTo (keys->anim, servoPan, keys->posPan) ;
+        keys->status ("Servo Down %d", keys->posPan);
+        return TRUE ;
+    case 'y': // fun: display 'head nodding' movement (runs in the background)
+        remoteKeysGesture (keys, servoPan, keys->posPan, 40) ;
+        keys->status ("Yes") ;
+        return TRUE ;
+    case 'n': // fun: display 'head shake' movement (runs in the background)
+        remoteKeysGesture (keys, servoTilt, keys->posTilt, 40) ;
+        keys->status ("No") ;
+        return TRUE ;
+    default:
+        if (ch != ERR)
+            keys->status ("Key code: '%c' (%d) \"%s\"", ch, ch, keyname(ch) ) ;
+        return FALSE ;
+    } // switch
+    // motor keys: drive in the current mode
+    (*keys->pMotionFunc) (keys->speed) ;
+    keys->status ("%s %d", driveModeNames[keys->driveMode], keys->speed) ;
+    return TRUE ;
+}
+
+#endif /* _4TRONIX_REMOTEKEYS_H_ */
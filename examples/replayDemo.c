@@ -0,0 +1,171 @@
+//======================================================================
+//
+// Record/replay of a controller run (initio_replay.h): a simple
+// obstacle avoider drives a simulated robot (initio_sim.h) in a walled
+// room while all its hardware accesses are recorded; then the same
+// controller, or one with another stop distance (-c), is replayed from
+// the log at full CPU speed. Reported are the decisions and wheel
+// pulses of both runs, the replay time and the differences found.
+//
+// On the robot, record with initio_RecordStart (path, NULL, NULL) to
+// wrap initio_wiringPiHw instead of the simulation.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o replayDemo -Wall -Werror replayDemo.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: replayDemo [-t seconds] [-c cm] [-r] [-o file]
+//   -t  simulated time of the recorded run in s (default 60)
+//   -c  stop distance of the replayed controller in cm (default 30, as recorded)
+//   -r  record in real time (20 ms per step, as on the robot)
+//   -o  log file (default replay.log)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_sim.h>
+#include <initio_replay.h>
+
+#define ROOM_W 300.0
+#define ROOM_H 200.0
+#define STEP 0.02  // control period in s
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+// wallDistance(): true distance from the sonar (8 cm ahead) to the room walls
+static double wallDistance (const initio_pose *p)
+{
+    double c = cos (p->theta), s = sin (p->theta) ;
+    double sx = p->x + 8 * c, sy = p->y + 8 * s ;
+    double tx = (c > 1e-9) ? (ROOM_W - sx) / c : (c < -1e-9) ? -sx / c : INFINITY ;
+    double ty = (s > 1e-9) ? (ROOM_H - sy) / s : (s < -1e-9) ? -sy / s : INFINITY ;
+    return fmax (fmin (tx, ty), 0) ;
+}
+
+typedef struct {
+    int stopCm ;
+    int turning ;      // control steps left in the current spin
+    unsigned long spins ;
+    unsigned long checksum ;  // of all ranges seen
+} controller_t ;
+
+// control(): one step of the obstacle avoider
+static void control (initio_ctx *ctx, controller_t *c)
+{
+    unsigned int cm = initio_ctxUsGetDistance (ctx) ;
+
+    c->checksum = c->checksum * 31 + cm ;
+    if (c->turning > 0)
+        c->turning-- ;
+    else if (cm > 0 && cm < c->stopCm)
+    {
+        initio_ctxSpinRight (ctx, 60) ;
+        c->turning = 10 + c->spins % 7 ;
+        c->spins++ ;
+    }
+    else
+        initio_ctxDriveForward (ctx, 70) ;
+}
+
+static void report (const char *name, initio_ctx *ctx, const controller_t *c, double seconds)
+{
+    printf ("%-7s %7.3f s  spins %4lu  wheel pulses %5lu/%-5lu  ranges checksum %016lx\n",
+            name, seconds, c->spins, initio_ctxWheelCountLeft (ctx), initio_ctxWheelCountRight (ctx),
+            c->checksum) ;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *path = "replay.log" ;
+    double duration = 60, t0 ;
+    controller_t c ;
+    initio_pose start = { 50, 100, 0 } ;
+    initio_replayStats s ;
+    initio_recordStats rs ;
+    initio_recorder *rec ;
+    initio_replay *rp ;
+    initio_sim sim ;
+    initio_ctx *ctx ;
+    int stopCm = 30, realTime = FALSE ;
+    long steps, i ;
+    int opt ;
+
+    while ((opt = getopt (argc, argv, "t:c:ro:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': duration = atof (optarg) ; break ;
+        case 'c': stopCm = atoi (optarg) ; break ;
+        case 'r': realTime = TRUE ; break ;
+        case 'o': path = optarg ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    steps = (long)(duration / STEP) ;
+    if (steps < 1)
+        return EXIT_FAILURE ;
+
+    // record a run of the simulated robot
+    initio_SimInit (&sim, NULL, &start) ;
+    rec = initio_RecordStart (path, &initio_simHw, &sim) ;
+    if (rec == NULL)
+    {
+        fprintf (stderr, "cannot write %s\n", path) ;
+        return EXIT_FAILURE ;
+    }
+    ctx = initio_Open (ROBOHAT, initio_RecordHw (rec), rec, INITIO_MOTORS | INITIO_SENSORS | INITIO_SONAR) ;
+    initio_ctxUsSetMaxRange (ctx, 200) ;
+    initio_ctxWheelCountStart (ctx) ;
+    c = (controller_t) { .stopCm = 30 } ;
+    for (i = 0; i < steps; i++)
+    {
+        sim.sonarCm = (unsigned int)lround (wallDistance (&sim.pose)) ;
+        control (ctx, &c) ;
+        initio_SimStep (&sim, STEP) ;
+        if (realTime)
+            usleep ((useconds_t)(STEP * 1e6)) ;
+    }
+    report ("record", ctx, &c, steps * STEP) ;
+    initio_Close (ctx) ;
+    initio_RecordGetStats (rec, &rs) ;
+    printf ("        %lu accesses logged as %lu entries to %s\n", rs.operations, rs.entries, path) ;
+    if (!initio_RecordStop (rec))
+        return EXIT_FAILURE ;
+
+    // replay it, at full speed
+    rp = initio_ReplayOpen (path) ;
+    if (rp == NULL)
+        return EXIT_FAILURE ;
+    t0 = now () ;
+    ctx = initio_Open (ROBOHAT, &initio_replayHw, rp, INITIO_MOTORS | INITIO_SENSORS | INITIO_SONAR) ;
+    initio_ctxUsSetMaxRange (ctx, 200) ;
+    initio_ctxWheelCountStart (ctx) ;
+    c = (controller_t) { .stopCm = stopCm } ;
+    for (i = 0; i < steps; i++)
+        control (ctx, &c) ;
+    report ("replay", ctx, &c, now () - t0) ;
+    initio_Close (ctx) ;
+
+    initio_ReplayGetStats (rp, &s) ;
+    printf ("        %lu/%lu entries replayed%s, reads %lu (%lu off the log), commands %lu, "
+            "mismatches %lu (first at %ld), skipped %lu\n",
+            s.position, s.entries, s.done ? " (complete)" : "", s.reads, s.offLog, s.commands,
+            s.mismatches, s.firstMismatch, s.skipped) ;
+    initio_ReplayClose (rp) ;
+    return (s.mismatches == 0) ? EXIT_SUCCESS : 2 ;
+}
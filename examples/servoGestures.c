@@ -0,0 +1,148 @@
+//======================================================================
+//
+// Servo animation (initio_anim.h): plays the 'yes' gesture of
+// remoteControl2 (nodding by +-40 degrees) once as before, with jumps
+// and blocking delays, and once as a keyframe motion in the background
+// while the main loop keeps running; then cancels a motion half-way.
+// Reported are the largest jump of the servo between two writes, the
+// duration of the gesture and how often the main loop ran meanwhile.
+//
+// The servo writes are taken from the simulation (initio_sim.h), so
+// this runs without a robot.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o servoGestures -Wall -Werror servoGestures.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: servoGestures [-v deg/s] [-a deg/s^2] [-r hz] [-p]
+//   -v  velocity limit (default 180)
+//   -a  acceleration limit (default 720)
+//   -r  update rate (default 50)
+//   -p  print every servo write
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_sim.h>
+#include <initio_anim.h>
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+// servo writes of the pan servo
+static int printWrites = FALSE ;
+static int lastDeg ;
+static int maxJump ;
+static unsigned long writes ;
+static double t0 ;
+
+static void logServoWrite (void *arg, int servo, int position)
+{
+    int deg = 90 - (position - 50) * 180 / 200 ;  // inverse of initio_ctxSetServo
+
+    if (servo != servoPan)
+        return ;
+    if (abs (deg - lastDeg) > maxJump)
+        maxJump = abs (deg - lastDeg) ;
+    lastDeg = deg ;
+    writes++ ;
+    if (printWrites)
+        printf ("  %7.3f s  %4d deg\n", now () - t0, deg) ;
+}
+
+static void resetLog (void)
+{
+    maxJump = 0 ;
+    writes = 0 ;
+    t0 = now () ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_animParams params ;
+    initio_animStats s ;
+    initio_animKey yes[3] = { { 40, 150 }, { -40, 150 }, { 0, 0 } } ;
+    initio_sim sim ;
+    initio_hw hw = initio_simHw ;
+    initio_ctx *ctx ;
+    initio_anim *anim ;
+    unsigned long id, loops ;
+    double t ;
+    int opt, state ;
+
+    initio_AnimDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "v:a:r:p")) != -1)
+    {
+        switch (opt)
+        {
+        case 'v': params.servo[servoPan].maxVel = atof (optarg) ; break ;
+        case 'a': params.servo[servoPan].maxAcc = atof (optarg) ; break ;
+        case 'r': params.hz = atof (optarg) ; break ;
+        case 'p': printWrites = TRUE ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    initio_SimInit (&sim, NULL, NULL) ;
+    hw.servoWrite = logServoWrite ;
+    ctx = initio_Open (ROBOHAT, &hw, &sim, INITIO_SERVOS) ;
+
+    // as remoteControl2 did: jump, wait 0.5 s, jump, wait 0.5 s, jump back
+    resetLog () ;
+    loops = 0 ;
+    initio_ctxSetServo (ctx, servoPan, 40) ;
+    usleep (500000) ;
+    initio_ctxSetServo (ctx, servoPan, -40) ;
+    usleep (500000) ;
+    initio_ctxSetServo (ctx, servoPan, 0) ;
+    loops++ ;  // the main loop ran once, after the gesture
+    printf ("blocking:   %.3f s, %lu writes, largest jump %d deg, main loop ran %lu times\n",
+            now () - t0, writes, maxJump, loops) ;
+
+    // the same gesture as keyframe motion in the background
+    anim = initio_AnimStart (ctx, &params) ;
+    if (anim == NULL)
+        return EXIT_FAILURE ;
+    resetLog () ;
+    loops = 0 ;
+    id = initio_AnimPlay (anim, servoPan, yes, 3) ;
+    while (initio_AnimWait (anim, id, 0) == INITIO_ANIM_RUNNING)
+    {
+        usleep (20000) ;  // one main loop iteration, e.g. of remoteControl2
+        loops++ ;
+    }
+    printf ("animated:   %.3f s, %lu writes, largest jump %d deg, main loop ran %lu times\n",
+            now () - t0, writes, maxJump, loops) ;
+
+    // cancel a long move half-way: the servo brakes and stays there
+    resetLog () ;
+    id = initio_AnimMoveTo (anim, servoPan, 80) ;
+    usleep (250000) ;
+    initio_AnimCancel (anim, servoPan) ;
+    state = initio_AnimWait (anim, id, -1) ;
+    usleep (200000) ;  // let it brake
+    t = now () - t0 ;
+    printf ("cancelled:  state %s after %.3f s, stopped at %d deg (target 80)\n",
+            (state == INITIO_ANIM_CANCELLED) ? "CANCELLED" : "DONE", t, initio_AnimPosition (anim, servoPan)) ;
+    id = initio_AnimMoveTo (anim, servoPan, 0) ;
+    initio_AnimWait (anim, id, -1) ;
+
+    initio_AnimStop (anim, &s) ;
+    printf ("motions %lu done %lu cancelled %lu writes %lu, update rate %.1f Hz\n",
+            s.motions, s.done, s.cancelled, s.writes, s.rate.rateHz) ;
+    initio_Close (ctx) ;
+    return EXIT_SUCCESS ;
+}
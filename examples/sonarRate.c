@@ -0,0 +1,111 @@
+//======================================================================
+//
+// Ranging rate of the ultrasonic sensor: pings back-to-back without and
+// with a range limit (initio_UsSetMaxRange), then with the ping
+// scheduler of initio_sonar.h, and reports the pings per second and
+// the ranges seen.
+//
+// Against the wiringPi stub (see ../stub) the object distance is
+// simulated with option -d; on the robot the real surrounding counts.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o sonarRate -Wall -Werror sonarRate.c -linitio -lwiringPi -lpthread
+//
+// Usage: sonarRate [-r maxCm] [-q quietCm] [-t seconds] [-d cm]
+//   -r  range limit in cm (default 100)
+//   -q  distance beyond which echoes die away, in cm (default 500)
+//   -t  duration of each run in s (default 2)
+//   -d  object distance simulated by the stub in cm, 0 == none (default 80)
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_sonar.h>
+
+// only present in the wiringPi stub
+extern void wiringPiStub_SetSonar (int pin, unsigned int distance) __attribute__((weak)) ;
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+// blocking(): pings back-to-back for duration s
+static void blocking (const char *name, double duration)
+{
+    double t0 = now (), t ;
+    unsigned long pings = 0, echoes = 0, last = 0 ;
+
+    do
+    {
+        last = initio_UsGetDistance () ;
+        if (last > 0) echoes++ ;
+        pings++ ;
+        t = now () ;
+    } while (t - t0 < duration) ;
+    printf ("%-22s %7.1f pings/s  echoes %5lu/%-5lu  last %3lu cm\n",
+            name, pings / (t - t0), echoes, pings, last) ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_sonarParams params ;
+    initio_sonarStats s ;
+    initio_sonarReading r ;
+    initio_sonar *sonar ;
+    double duration = 2 ;
+    int distance = 80 ;
+    int opt ;
+
+    initio_SonarDefaultParams (&params) ;
+    params.maxCm = 100 ;
+    while ((opt = getopt (argc, argv, "r:q:t:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r': params.maxCm = atoi (optarg) ; break ;
+        case 'q': params.quietCm = atoi (optarg) ; break ;
+        case 't': duration = atof (optarg) ; break ;
+        case 'd': distance = atoi (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (duration <= 0 || distance < 0)
+        return EXIT_FAILURE ;
+
+    initio_InitEx (INITIO_SONAR) ; // initio: sonar only
+    if (wiringPiStub_SetSonar != NULL)
+        wiringPiStub_SetSonar ((initio_ctxBoard (initio_DefaultCtx ()) == ROBOHAT) ? sonar_RoboHAT : sonar_PiRoCon,
+                               distance) ;
+
+    blocking ("no range limit", duration) ;
+    initio_UsSetMaxRange (params.maxCm) ;
+    blocking ("range limit", duration) ;
+    initio_UsSetMaxRange (0) ;
+
+    sonar = initio_SonarStart (NULL, &params) ;
+    if (sonar == NULL)
+        return EXIT_FAILURE ;
+    usleep ((useconds_t)(duration * 1e6)) ;
+    initio_SonarGet (sonar, &r) ;
+    initio_SonarStop (sonar, &s) ;
+    printf ("%-22s %7.1f pings/s  echoes %5lu/%-5lu  last %3u cm  (allowed %.1f/s, ping avg %.0f us max %.0f us, overruns %lu)\n",
+            "scheduler", s.rate.rateHz, s.echoes, s.pings, r.cm, s.maxHz, s.pingAvgUs, s.pingMaxUs, s.rate.overruns) ;
+
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
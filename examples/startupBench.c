@@ -0,0 +1,105 @@
+//======================================================================
+//
+// Benchmark of the start-up time of the initio library: compares the
+// sequential full initialisation (GPIO, softPwm threads, then servod)
+// with initio_Init() launching servod in parallel, and with
+// initio_InitEx() bringing up only some subsystems.
+//
+// For every variant the time until initio_Init/InitEx returns, the time
+// until the requested subsystems are usable (first motor/servo command
+// issued) and the number of threads of the process are reported.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o startupBench -Wall -Werror startupBench.c -linitio -lwiringPi -lpthread
+//
+// Usage: startupBench [repetitions]
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <initio.h>
+
+#define SEQUENTIAL -1  // pseudo subsystem mask: GPIO setup followed by servod launch
+
+static double nowMs (void)
+{
+    struct timespec ts ;
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6 ;
+}
+
+// threadCount(): number of threads of this process
+static int threadCount (void)
+{
+    char line[128] ;
+    int threads = -1 ;
+    FILE *fp = fopen ("/proc/self/status", "r") ;
+
+    if (fp == NULL)
+        return -1 ;
+    while (fgets (line, sizeof(line), fp) != NULL)
+        if (sscanf (line, "Threads: %d", &threads) == 1)
+            break ;
+    fclose (fp) ;
+    return threads ;
+}
+
+static void bench (const char *name, int subsystems, int reps)
+{
+    double initSum = 0, readySum = 0, initMax = 0, readyMax = 0 ;
+    int threads = 0, i ;
+
+    for (i = 0; i < reps; i++)
+    {
+        double t0 = nowMs (), t1, t2 ;
+
+        if (subsystems == SEQUENTIAL)
+        {
+            // what initio_Init() did before: everything, one step after the other
+            initio_InitEx (INITIO_MOTORS | INITIO_SONAR | INITIO_SENSORS) ;
+            initio_StartServos () ;
+        }
+        else
+            initio_InitEx (subsystems) ;
+        t1 = nowMs () ;
+        threads = threadCount () ;
+
+        // first use of the requested subsystems
+        if (subsystems == SEQUENTIAL || (subsystems & INITIO_MOTORS))
+            initio_Stop () ;
+        if (subsystems == SEQUENTIAL || (subsystems & INITIO_SERVOS))
+            initio_SetServo (servoPan, 0) ;
+        if (subsystems == SEQUENTIAL || (subsystems & INITIO_SENSORS))
+            initio_IrAll () ;
+        t2 = nowMs () ;
+
+        initSum += t1 - t0 ;
+        readySum += t2 - t0 ;
+        if (t1 - t0 > initMax) initMax = t1 - t0 ;
+        if (t2 - t0 > readyMax) readyMax = t2 - t0 ;
+        initio_Cleanup () ;
+    }
+    fprintf (stderr, "%-28s init avg %8.2f ms (max %8.2f)   ready avg %8.2f ms (max %8.2f)   threads %d\n",
+             name, initSum / reps, initMax, readySum / reps, readyMax, threads) ;
+}
+
+int main (int argc, char *argv[])
+{
+    int reps = (argc > 1) ? atoi (argv[1]) : 5 ;
+
+    if (reps < 1) reps = 1 ;
+    fprintf (stderr, "start-up benchmark, %d repetitions, %d threads before init\n", reps, threadCount ()) ;
+    bench ("sequential (old Init)", SEQUENTIAL, reps) ;
+    bench ("initio_Init (parallel)", INITIO_ALL, reps) ;
+    bench ("motors+sensors", INITIO_MOTORS | INITIO_SENSORS, reps) ;
+    bench ("sensors only", INITIO_SENSORS, reps) ;
+    bench ("sonar only", INITIO_SONAR, reps) ;
+    return EXIT_SUCCESS ;
+}
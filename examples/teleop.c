@@ -0,0 +1,317 @@
+//======================================================================
+//
+// Event-driven remote control of the 4tronix initio robot car, with the
+// key bindings of remoteControl2. Keys and sensors are separate event
+// sources: the main loop sleeps in epoll on the terminal and on an
+// eventfd, a background thread samples the IR, line and wheel sensors
+// and the ping scheduler (initio_sonar.h) the ultrasonic sensor, and
+// the thread signals the main loop only when a value has changed. So a
+// key is acted upon as soon as it arrives, never after a sonar ping,
+// and the screen is only written where a field has changed.
+// Shown is the key-to-command latency: from the wakeup by the key (or,
+// with several keys per wakeup, from reading the key) to the return of
+// the motor or servo command. The key bindings are shared with
+// remoteControl2 (remoteKeys.h).
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o teleop -Wall -Werror teleop.c -linitio -lwiringPi -lcurses -lpthread -lm
+//
+// Usage: teleop [-r hz]
+//   -r  sampling rate of the IR, line and wheel sensors (default 100)
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <curses.h>
+#include <initio.h>
+#include <initio_rate.h>
+#include <initio_seqlock.h>
+#include <initio_sonar.h>
+#include <initio_anim.h>
+#include "remoteKeys.h"
+
+#define POSXS  10 // column and line of extra status print
+#define POSYS  11
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+
+//======================================================================
+// Sensor Thread
+
+typedef struct {
+    unsigned int sense ;  // INITIO_SENSE_* bits
+    unsigned int cm ;     // latest sonar range, 0 == no object
+} sensors_t ;
+
+static initio_seqlock sensorLock ;
+static sensors_t sensorShared ;
+static initio_sonar *sonar ;
+static int eventFd ;
+
+static BOOL sensorCycle (void *arg)
+{
+    static sensors_t last = { ~0u, ~0u } ;  // only this thread
+    initio_sonarReading r ;
+    sensors_t s ;
+    uint64_t one = 1 ;
+
+    s.sense = (initio_IrLeft () ? INITIO_SENSE_IRLEFT : 0)
+            | (initio_IrRight () ? INITIO_SENSE_IRRIGHT : 0)
+            | (initio_IrLineLeft () ? INITIO_SENSE_LINELEFT : 0)
+            | (initio_IrLineRight () ? INITIO_SENSE_LINERIGHT : 0)
+            | (initio_wheelSensorLeft () ? INITIO_SENSE_WHEELLEFT : 0)
+            | (initio_wheelSensorRight () ? INITIO_SENSE_WHEELRIGHT : 0) ;
+    s.cm = (initio_SonarGet (sonar, &r) > 0) ? r.cm : 0 ;
+    if (s.sense != last.sense || s.cm != last.cm)
+    {
+        last = s ;
+        initio_SeqWrite (&sensorLock, &sensorShared, &s, sizeof(s)) ;
+        if (write (eventFd, &one, sizeof(one)) != sizeof(one))
+            return FALSE ;
+    }
+    return TRUE ;
+}
+
+// End of Sensor Thread
+//======================================================================
+
+
+
+//======================================================================
+// Screen Fields
+
+// Each field keeps its text on the screen; it is only written when the
+// new text differs.
+enum { F_BOARD, F_IRLEFT, F_IRRIGHT, F_LINELEFT, F_LINERIGHT, F_DISTANCE,
+       F_WHEELLEFT, F_WHEELRIGHT, F_MODE, F_PWM, F_LATENCY, F_FIELDS } ;
+
+static char fieldText[F_FIELDS][80] ;
+static BOOL dirty ;
+static unsigned long fieldWrites ;
+
+static void field (int f, int y, int x, const char *fmt, ...)
+{
+    char text[80] ;
+    va_list ap ;
+
+    va_start (ap, fmt) ;
+    vsnprintf (text, sizeof(text), fmt, ap) ;
+    va_end (ap) ;
+    if (strcmp (text, fieldText[f]) == 0)
+        return ;
+    strcpy (fieldText[f], text) ;
+    mvprintw (y, x, "%s", text) ;
+    dirty = TRUE ;
+    fieldWrites++ ;
+}
+
+static void showSensors (const sensors_t *s)
+{
+    BOOL b ;
+
+    b = (s->sense & INITIO_SENSE_IRLEFT) != 0 ;
+    field (F_IRLEFT, 5, 10, "IrLeft:    %c (%d)", b ? 'T' : '_', b) ;
+    b = (s->sense & INITIO_SENSE_IRRIGHT) != 0 ;
+    field (F_IRRIGHT, 5, 35, "IrRight:    %c (%d)", b ? 'T' : '_', b) ;
+    b = (s->sense & INITIO_SENSE_LINELEFT) != 0 ;
+    field (F_LINELEFT, 6, 10, "LineLeft:  %c (%d)", b ? 'T' : '_', b) ;
+    b = (s->sense & INITIO_SENSE_LINERIGHT) != 0 ;
+    field (F_LINERIGHT, 6, 35, "LineRight : %c (%d)", b ? 'T' : '_', b) ;
+    field (F_DISTANCE, 7, 10, "Distance:  %d cm  ", s->cm) ;
+    field (F_WHEELLEFT, 8, 10, "WheelLeft: %d", (s->sense & INITIO_SENSE_WHEELLEFT) != 0) ;
+    field (F_WHEELRIGHT, 8, 35, "WheelRight: %d", (s->sense & INITIO_SENSE_WHEELRIGHT) != 0) ;
+}
+
+// End of Screen Fields
+//======================================================================
+
+
+
+//======================================================================
+// Key Handling (remoteKeys.h, as remoteControl2)
+
+static remoteKeys keys ;
+
+static void status (const char *fmt, ...)
+{
+    va_list ap ;
+
+    move (POSYS, POSXS) ;
+    clrtoeol () ;
+    va_start (ap, fmt) ;
+    vw_printw (stdscr, fmt, ap) ;
+    va_end (ap) ;
+    dirty = TRUE ;
+}
+
+// handleKey(): acts on key ch; returns FALSE if no command was issued
+static BOOL handleKey (int ch)
+{
+    if (!remoteKeysHandle (&keys, ch))
+        return FALSE ;
+    field (F_MODE, 9, 10, "DriveMode: %s    ", driveModeNames[keys.driveMode]) ;
+    field (F_PWM, 9, 35, "PWM:        %d  ", keys.speed) ;
+    return TRUE ;
+}
+
+// End of Key Handling
+//======================================================================
+
+
+
+int main (int argc, char **argv)
+{
+    struct epoll_event ev, events[2] ;
+    initio_sonarParams sp ;
+    initio_animParams ap ;
+    initio_anim *anim ;
+    initio_rate *sampler ;
+    sensors_t s ;
+    double hz = 100, t, lat, latSum = 0, latMax = 0 ;
+    unsigned long commands = 0, wakeups = 0 ;
+    uint64_t count ;
+    int epfd, ch = 0, opt, i, n ;
+
+    while ((opt = getopt (argc, argv, "r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r': hz = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+
+    initio_Init () ; // initio: init the library
+
+    // background sensing: ping scheduler plus sampler of the digital sensors
+    initio_SonarDefaultParams (&sp) ;
+    sp.maxCm = 200 ;
+    sonar = initio_SonarStart (NULL, &sp) ;
+    initio_AnimDefaultParams (&ap) ;
+    ap.servo[servoTilt].minDeg = -80 ;
+    ap.servo[servoTilt].maxDeg = 80 ;
+    ap.servo[servoPan].minDeg = -40 ;
+    ap.servo[servoPan].maxDeg = 80 ;
+    anim = initio_AnimStart (NULL, &ap) ;
+    eventFd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC) ;
+    epfd = epoll_create1 (EPOLL_CLOEXEC) ;
+    sampler = (sonar != NULL && eventFd >= 0) ? initio_RateStart (hz, sensorCycle, NULL) : NULL ;
+    if (sonar == NULL || anim == NULL || eventFd < 0 || epfd < 0 || sampler == NULL)
+    {
+        fprintf (stderr, "teleop: cannot start\n") ;
+        if (sampler != NULL)
+            initio_RateStop (sampler, NULL) ;
+        if (sonar != NULL)
+            initio_SonarStop (sonar, NULL) ;
+        if (anim != NULL)
+            initio_AnimStop (anim, NULL) ;
+        if (eventFd >= 0)
+            close (eventFd) ;
+        if (epfd >= 0)
+            close (epfd) ;
+        initio_Cleanup () ;
+        return EXIT_FAILURE ;
+    }
+    initio_AnimJump (anim, servoTilt, 0) ;
+    initio_AnimJump (anim, servoPan, 0) ;
+    remoteKeysInit (&keys, anim, status) ;
+
+    WINDOW *mainwin = initscr ();   // curses: init screen
+    noecho ();                      // curses: prevent the key being echoed
+    cbreak ();                      // curses: disable line buffering
+    nodelay (mainwin, TRUE);        // curses: getch() only drains what epoll reported
+    keypad (mainwin, TRUE);         // curses: enable the cursor and other keys to be detected
+    set_escdelay (25);              // curses: do not hold a lone ESC back for long
+
+    ev.events = EPOLLIN ;
+    ev.data.fd = STDIN_FILENO ;
+    epoll_ctl (epfd, EPOLL_CTL_ADD, STDIN_FILENO, &ev) ;
+    ev.data.fd = eventFd ;
+    epoll_ctl (epfd, EPOLL_CTL_ADD, eventFd, &ev) ;  // changes signalled before are still pending
+
+    mvprintw(1, 1, "teleop: q..quit, cursor..steer, b..reverse, space/cursor-down..stop, shift-cursor/aswd..servo, r..centre servo, y/n..say yes/no");
+    switch (initio_identifyControlBoard ())
+    {
+    case PIROCON2: field (F_BOARD, 2, 10, "board: PIROCON2   ") ; break ;
+    case ROBOHAT:  field (F_BOARD, 2, 10, "board: ROBOHAT  ") ; break ;
+    default:       field (F_BOARD, 2, 10, "board: unknown   ") ;
+    }
+    field (F_MODE, 9, 10, "DriveMode: %s    ", driveModeNames[keys.driveMode]) ;
+    field (F_PWM, 9, 35, "PWM:        %d  ", keys.speed) ;
+    refresh () ;
+
+    while (ch != KEY_ESCAPE && ch != 'q')
+    {
+        n = epoll_wait (epfd, events, 2, -1) ;
+        t = now () ;  // wakeup: the key or the sensor change has arrived
+        wakeups++ ;
+        for (i = 0; i < n; i++)
+        {
+            if (events[i].data.fd == eventFd)
+            {
+                if (read (eventFd, &count, sizeof(count)) == sizeof(count))
+                {
+                    initio_SeqRead (&sensorLock, &s, &sensorShared, sizeof(s)) ;
+                    showSensors (&s) ;
+                }
+                continue ;
+            }
+            // the first key is timed from the wakeup, each further key from
+            // its read: it waited only for the handling of the keys before it
+            for (; (ch = getch ()) != ERR; t = now ())
+            {
+                if (ch == KEY_ESCAPE || ch == 'q')
+                    break ;
+                if (!handleKey (ch))
+                    continue ;
+                lat = (now () - t) * 1e3 ;
+                commands++ ;
+                latSum += lat ;
+                if (lat > latMax) latMax = lat ;
+                field (F_LATENCY, 10, 10, "Latency:   %.3f ms (avg %.3f, max %.3f, %lu commands)  ",
+                       lat, latSum / commands, latMax, commands) ;
+            }
+        }
+        if (dirty)
+        {
+            move (POSYS, POSXS) ;
+            refresh () ; // update screen, only the fields written
+            dirty = FALSE ;
+        }
+    }
+
+    initio_RateStop (sampler, NULL) ;
+    initio_SonarStop (sonar, NULL) ;
+    initio_AnimStop (anim, NULL) ;
+    close (eventFd) ;
+    close (epfd) ;
+    // resource cleanup for ncurses
+    delwin(mainwin) ;
+    endwin() ;
+    initio_Cleanup() ;
+    printf ("%lu wakeups, %lu field writes, %lu commands, key-to-command latency avg %.3f ms max %.3f ms\n",
+            wakeups, fieldWrites, commands, commands ? latSum / commands : 0, latMax) ;
+    return (EXIT_SUCCESS) ;
+}
@@ -60,7 +60,7 @@ int main (int argc, char *argv[])
   nodelay(mainwin, TRUE);       // curses: set getch() as non-blocking 
   keypad (mainwin, TRUE);       // curses: enable detection of cursor and other keys
 
-  initio_Init (); // initio: init the library
+  initio_InitEx (INITIO_MOTORS | INITIO_SENSORS); // initio: init the library (no servos needed)
 
   testIR(argc, argv);
 
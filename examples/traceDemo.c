@@ -0,0 +1,120 @@
+//======================================================================
+//
+// Demonstration and overhead measurement of the event tracing
+// (initio_trace.h): runs a small control loop (IR sensors, sonar and
+// motor commands) with tracing off and on, reports the time per loop
+// iteration of both, and writes the trace as Chrome trace-event JSON
+// (open it in chrome://tracing or ui.perfetto.dev).
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o traceDemo -Wall -Werror traceDemo.c -linitio -lwiringPi -lpthread
+//
+// Usage: traceDemo [-n iterations] [-o trace.json]
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_trace.h>
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+#define CHUNK 2000  // iterations recorded without filling the trace buffer
+
+// loop(): n iterations of a bang-bang obstacle avoider
+static void loop (long n)
+{
+    long i ;
+
+    for (i = 0; i < n; i++)
+    {
+        if (initio_IrLeft ())
+            initio_SetMotors (50, -50) ;
+        else if (initio_IrRight ())
+            initio_SetMotors (-50, 50) ;
+        else
+            initio_SetMotors (60, (i & 64) ? 60 : 55) ;
+    }
+}
+
+// measure(): us per iteration of n iterations; the trace is discarded
+// between chunks, outside the measured time
+static double measure (long n)
+{
+    double t, sum = 0 ;
+    long i ;
+
+    for (i = 0; i < n; i += CHUNK)
+    {
+        t = now () ;
+        loop ((n - i < CHUNK) ? n - i : CHUNK) ;
+        sum += now () - t ;
+        if (initio_TraceEnabled ())
+            initio_TraceWrite ("/dev/null") ;
+    }
+    return sum * 1e6 / n ;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *path = "trace.json" ;
+    long n = 200000 ;
+    initio_traceStats s ;
+    double off, on ;
+    int opt, i ;
+
+    while ((opt = getopt (argc, argv, "n:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': n = atol (optarg) ; break ;
+        case 'o': path = optarg ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (n < 1)
+        return EXIT_FAILURE ;
+
+    initio_InitEx (INITIO_MOTORS | INITIO_SENSORS | INITIO_SONAR) ; // no servos
+    initio_UsSetMaxRange (200) ;
+
+    off = measure (n) ;
+    initio_TraceEnable (TRUE) ;
+    on = measure (n) ;
+
+    // a short timeline for the viewer
+    for (i = 0; i < 10; i++)
+    {
+        initio_TraceBegin ("demo", "iteration") ;
+        loop (20) ;
+        initio_UsGetDistance () ;
+        initio_TraceEnd ("demo", "iteration") ;
+        usleep (2000) ;
+    }
+    initio_Stop () ;
+    initio_TraceEnable (FALSE) ;
+
+    initio_TraceGetStats (&s) ;
+    printf ("loop iteration: %.3f us tracing off, %.3f us tracing on (+%.3f us)\n", off, on, on - off) ;
+    printf ("events %lu dropped %lu threads %d, %ld written to %s\n",
+            s.events, s.dropped, s.threads, initio_TraceWrite (path), path) ;
+
+    initio_Cleanup () ;
+    return EXIT_SUCCESS ;
+}
@@ -0,0 +1,168 @@
+//======================================================================
+//
+// Sonar head target tracking (initio_track.h). By default the tracking
+// controller runs against a simulated scene: a target 50 cm away moves
+// from side to side (+-40 degrees, 8 s period) in front of an object at
+// 100 cm, then at 8 s, as if the robot had turned away, the object is
+// gone and the target jumps to -60 degrees. The sonar sees the nearest
+// object within its beam; the servo reaches each aim before the next
+// ping. Printed are true and tracked bearing, the range and the tracking
+// error, and how long it took to find the target again after the jump.
+//
+// With -R the tracker runs on the robot (or against the wiringPi stub,
+// which simulates an object at 60 cm everywhere) and the published
+// bearing and range are printed five times a second.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o trackDemo -Wall -Werror trackDemo.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: trackDemo [-R] [-t seconds] [-z hz] [-d degrees] [-r rate] [-b degrees]
+//   -R  track with the sonar head of the robot
+//   -t  run time in s (default 14)
+//   -z  pings per s (default 20)
+//   -d  half width of the dither in degrees (default 6)
+//   -r  steering rate in degrees/s (default 40)
+//   -b  half width of the simulated sonar beam in degrees (default 12)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <initio.h>
+#include <initio_track.h>
+
+// only present in the wiringPi stub
+extern void wiringPiStub_SetSonar (int pin, unsigned int distance) __attribute__((weak)) ;
+
+#define JUMP 8.0   // time of the jump of the target in s
+
+// target(): true bearing of the target at time t
+static double target (double t)
+{
+    return (t < JUMP) ? 40 * sin (2 * M_PI * t / 8) : -60 ;
+}
+
+// sonar(): range seen with the head at aim; the nearest object within the
+// beam, farther off-axis
+static unsigned int sonar (double t, int aim, double beam)
+{
+    const struct { double bearing, cm ; } objects[] = { { target (t), 50 }, { 30, 100 } } ;
+    double off, cm, best = 0 ;
+    int i ;
+
+    for (i = 0; i < ((t < JUMP) ? 2 : 1); i++)
+    {
+        off = fabs (aim - objects[i].bearing) ;
+        if (off > beam)
+            continue ;
+        cm = objects[i].cm / cos (off * M_PI / 180) ;
+        if (best == 0 || cm < best)
+            best = cm ;
+    }
+    return lround (best) ;
+}
+
+static void simulate (const initio_trackParams *params, double seconds, double beam)
+{
+    initio_trackCore core ;
+    double t, err, errSum = 0, errMax = 0, found = -1 ;
+    unsigned long cycles = 0, locked = 0, n = 0 ;
+    int aim ;
+
+    initio_TrackInit (&core, params, 0) ;
+    printf ("  time   target  tracked  range  locked\n") ;
+    for (t = 0; t < seconds; t += 1 / params->hz)
+    {
+        aim = initio_TrackAim (&core) ;
+        if (!initio_TrackStep (&core, sonar (t, aim, beam)))
+            continue ;
+        cycles++ ;
+        if (core.locked)
+        {
+            locked++ ;
+            err = fabs (core.bearing - target (t)) ;
+            if (t >= JUMP && found < 0 && err < params->dither + beam)
+                found = t - JUMP ;
+            if (t < JUMP || found >= 0)
+            {
+                errSum += err ;
+                if (err > errMax) errMax = err ;
+                n++ ;
+            }
+        }
+        if (cycles % lround (params->hz / 4) == 0)  // every 0.5 s
+            printf ("%6.2f %8.1f %8.1f %6u  %s\n", t, target (t), core.bearing, core.range, core.locked ? "yes" : "no") ;
+    }
+    printf ("\nlocked %.0f%% of %lu dither cycles, error while on target avg %.1f max %.1f degrees\n",
+            100.0 * locked / cycles, cycles, n ? errSum / n : 0, errMax) ;
+    if (found >= 0)
+        printf ("target found again %.2f s after the jump\n", found) ;
+    else
+        printf ("target not found again after the jump\n") ;
+}
+
+static void robot (const initio_trackParams *params, double seconds)
+{
+    initio_trackReading r ;
+    initio_trackStats s ;
+    initio_track *track ;
+    int i ;
+
+    initio_Init () ;
+    if (wiringPiStub_SetSonar != NULL)
+        wiringPiStub_SetSonar ((initio_ctxBoard (initio_DefaultCtx ()) == ROBOHAT) ? sonar_RoboHAT : sonar_PiRoCon, 60) ;
+    track = initio_TrackStart (NULL, params, 0) ;
+    if (track == NULL)
+    {
+        fprintf (stderr, "cannot start tracking\n") ;
+        return ;
+    }
+    printf ("  time  bearing  range  locked\n") ;
+    for (i = 0; i < seconds * 5; i++)
+    {
+        usleep (200000) ;
+        if (initio_TrackGet (track, &r) > 0)
+            printf ("%6.1f %8.1f %6u  %s\n", (i + 1) * 0.2, r.bearing, r.cm, r.locked ? "yes" : "no") ;
+    }
+    initio_TrackStop (track, &s) ;
+    printf ("\n%lu pings at %.1f Hz, %lu dither cycles, %lu locked, %lu steps, %lu losses\n",
+            s.pings, s.rate.rateHz, s.cycles, s.lockedCycles, s.steps, s.losses) ;
+    initio_Cleanup () ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_trackParams params ;
+    double seconds = 14, beam = 12 ;
+    int opt, onRobot = FALSE ;
+
+    initio_TrackDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "Rt:z:d:r:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'R': onRobot = TRUE ; break ;
+        case 't': seconds = atof (optarg) ; break ;
+        case 'z': params.hz = atof (optarg) ; break ;
+        case 'd': params.dither = atoi (optarg) ; break ;
+        case 'r': params.rate = atof (optarg) ; break ;
+        case 'b': beam = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (params.hz < 4)
+        params.hz = 4 ;
+
+    if (onRobot)
+        robot (&params, seconds) ;
+    else
+        simulate (&params, seconds, beam) ;
+    return EXIT_SUCCESS ;
+}
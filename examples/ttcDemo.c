@@ -0,0 +1,204 @@
+//======================================================================
+//
+// Time-to-collision governor (initio_ttc.h). In the simulation (default)
+// the robot drives straight at an obstacle 2 m ahead, once a wall and
+// once an object that comes towards it at 15 cm/s for 3 s, and either
+// stops when its IR sensors trip (8 cm) or is slowed down by the
+// governor. The estimator and governor run in the loop of the
+// simulation (200 Hz, a ping every 30 ms). Printed are the smallest gap,
+// whether the robot hit the obstacle, when it came to a standstill, the
+// smallest true TTC and the error of the estimated closing speed.
+//
+// With -R the governor runs on the robot: it drives forward until an IR
+// sensor trips or the time is up, printing the governor events. Give it
+// room and an obstacle ahead. Against the wiringPi stub (see ../stub) an
+// object stays at 60 cm.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Compilation:
+// gcc -o ttcDemo -Wall -Werror ttcDemo.c -linitio -lwiringPi -lpthread -lm
+//
+// Usage: ttcDemo [-R] [-d duty] [-H s] [-S s] [-t seconds]
+//   -R  run on the robot
+//   -d  forward duty (default 90)
+//   -H  horizon of the governor in s (default 1.5)
+//   -S  TTC at which the governor stops in s (default 0.3)
+//   -t  run time on the robot in s (default 10)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <initio.h>
+#include <initio_sim.h>
+#include <initio_ttc.h>
+
+#define STEP   0.005   // simulation step and governor period in s
+#define PING   0.030   // time between pings in s
+#define IRCM   8       // range of the IR obstacle sensors in cm
+
+// only present in the wiringPi stub
+extern void wiringPiStub_SetInput (int pin, int value) __attribute__((weak)) ;
+extern void wiringPiStub_SetSonar (int pin, unsigned int distance) __attribute__((weak)) ;
+
+static double now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+typedef struct {
+    double minGap ;        // smallest gap in cm
+    BOOL hit ;
+    double stopTime ;      // time of the standstill in s, < 0: none
+    double minTtc ;        // smallest true TTC in s
+    double closingErr ;    // mean abs error of the estimated closing speed in cm/s
+} result_t ;
+
+// simRun(): drives at duty towards an obstacle at 200 cm that approaches
+// at objectSpeed for 3 s; governed by the TTC governor or stopped by IR
+static result_t simRun (const initio_ttcParams *params, int duty, double objectSpeed, BOOL governed)
+{
+    initio_sim sim ;
+    initio_ctx *ctx ;
+    initio_ttcCore core ;
+    result_t r = { INFINITY, FALSE, -1, INFINITY, 0 } ;
+    double t, nextPing = 0, obstacle = 200, gap, v, vObject, closing, errSum = 0 ;
+    int left, right, reqLeft, reqRight, n = 0 ;
+
+    initio_SimInit (&sim, NULL, NULL) ;
+    ctx = initio_Open (ROBOHAT, &initio_simHw, &sim, INITIO_MOTORS) ;
+    initio_TtcInit (&core, params) ;
+    initio_ctxDriveForward (ctx, duty) ;
+    for (t = 0; t < 20; t += STEP)
+    {
+        initio_SimStep (&sim, STEP) ;
+        vObject = (t < 3) ? objectSpeed : 0 ;
+        obstacle -= vObject * STEP ;
+        gap = obstacle - sim.pose.x ;
+        v = (sim.vLeft + sim.vRight) / 2 ;
+        closing = v + vObject ;
+        if (gap < r.minGap) r.minGap = gap ;
+        if (gap <= 0)
+        {
+            r.hit = TRUE ;
+            break ;
+        }
+        if (closing > 0 && gap / closing < r.minTtc) r.minTtc = gap / closing ;
+        if (r.stopTime < 0 && t > 0.5 && fabs (v) < 0.1)
+            r.stopTime = t ;
+
+        if (governed)
+        {
+            if (t >= nextPing)
+            {
+                initio_TtcPing (&core, (gap <= params->sonar.maxCm) ? lround (gap) : 0, t) ;
+                nextPing += PING ;
+            }
+            initio_ctxGetMotors (ctx, &left, &right) ;
+            initio_ctxGetMotorRequest (ctx, &reqLeft, &reqRight) ;
+            initio_ctxSetForwardScale (ctx, initio_TtcUpdate (&core, t, left, right, reqLeft, reqRight)) ;
+            if (core.cm > 0 && t > 0.5)
+            {
+                errSum += fabs (core.closing - closing) ;
+                n++ ;
+            }
+        }
+        else if (gap < IRCM)
+            initio_ctxStop (ctx) ;  // as on initio_IrAll ()
+    }
+    r.closingErr = (n > 0) ? errSum / n : 0 ;
+    initio_Close (ctx) ;
+    return r ;
+}
+
+static void robotRun (const initio_ttcParams *params, int duty, double seconds)
+{
+    static const char *types[] = { "", "limit", "stop", "release" } ;
+    initio_ttcEvent e ;
+    initio_ttcStats s ;
+    initio_ttc *ttc ;
+    double start ;
+
+    initio_Init () ;
+    if (wiringPiStub_SetInput != NULL)  // IR sensors clear (active low), an object at 60 cm
+    {
+        wiringPiStub_SetInput (irFL, 1) ;
+        wiringPiStub_SetInput (irFR, 1) ;
+        wiringPiStub_SetSonar ((initio_ctxBoard (initio_DefaultCtx ()) == ROBOHAT) ? sonar_RoboHAT : sonar_PiRoCon, 60) ;
+    }
+    ttc = initio_TtcStart (NULL, params) ;
+    if (ttc == NULL)
+    {
+        fprintf (stderr, "cannot start the governor\n") ;
+        return ;
+    }
+    initio_DriveForward (duty) ;
+    start = now () ;
+    while (now () - start < seconds && !initio_IrAll ())
+    {
+        while (initio_TtcNextEvent (ttc, &e))
+        {
+            printf ("%6.2f s  %-8s range %5.1f cm  closing %5.1f cm/s  TTC %5.2f s  scale %.2f\n",
+                    e.time - start, types[e.type], e.cm, e.closing, e.ttc, e.scale) ;
+        }
+        usleep (10000) ;
+    }
+    initio_Stop () ;
+    initio_TtcStop (ttc, &s) ;
+    printf ("\n%lu cycles at %.1f Hz, %lu pings, %lu limits, %lu stops, %lu releases, %lu limited cycles, min TTC %.2f s\n",
+            s.cycles, s.rate.rateHz, s.pings, s.limits, s.stops, s.releases, s.limitedCycles, s.minTtc) ;
+    initio_Cleanup () ;
+}
+
+int main (int argc, char *argv[])
+{
+    initio_ttcParams params ;
+    double seconds = 10 ;
+    int opt, duty = 90, i, onRobot = FALSE ;
+
+    initio_TtcDefaultParams (&params) ;
+    while ((opt = getopt (argc, argv, "Rd:H:S:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'R': onRobot = TRUE ; break ;
+        case 'd': duty = atoi (optarg) ; break ;
+        case 'H': params.horizon = atof (optarg) ; break ;
+        case 'S': params.stopTtc = atof (optarg) ; break ;
+        case 't': seconds = atof (optarg) ; break ;
+        default:
+            return EXIT_FAILURE ;
+        }
+    }
+    if (params.horizon <= params.stopTtc)
+        return EXIT_FAILURE ;
+
+    if (onRobot)
+    {
+        robotRun (&params, duty, seconds) ;
+        return EXIT_SUCCESS ;
+    }
+    printf ("obstacle     control   min gap [cm]  hit  standstill [s]  min TTC [s]  closing error [cm/s]\n") ;
+    for (i = 0; i < 4; i++)
+    {
+        double objectSpeed = (i < 2) ? 0 : 15 ;
+        BOOL governed = i % 2 ;
+        result_t r = simRun (&params, duty, objectSpeed, governed) ;
+
+        printf ("%-12s %-9s %12.1f  %-4s %14.2f %12.2f", (i < 2) ? "wall" : "approaching",
+                governed ? "governor" : "IR stop", r.minGap, r.hit ? "yes" : "no", r.stopTime, r.minTtc) ;
+        if (governed)
+            printf (" %21.1f", r.closingErr) ;
+        printf ("\n") ;
+    }
+    return EXIT_SUCCESS ;
+}
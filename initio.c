@@ -19,10 +19,13 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <time.h>
+#include <pthread.h>
 
 #include <wiringPi.h>
 #include <softPwm.h>
 #include "initio.h"
+#include "initio_trace.h"
+#include "initio_time.h"
 
 // When compiling you must include the libraries pthread, wiringPi:
 // cc -o myprog myprog.c -lwiringPi -lpthread
@@ -46,12 +49,185 @@ static char* MergeStrings(int num_args, char* str1, ...);
 //======================================================================
 
 
-// File pointer to Servo Demon interface (ServoBlaster)
-static FILE *fpServoBlaster = NULL;
+// State of one robot. The board, pin numbers and hardware access are set
+// by initio_Open() and never change afterwards, so they are read without locks.
+struct initio_ctx {
+    int board ;           // identifier of Initio control board
+    int L1, L2, R1, R2 ;  // board specific pin numbers of left/right motor
+    int lineLeft ;        // board specific pin number of left IR line sensor
+    int sonar ;           // board specific pin number of ultrasonic sensor
+    const initio_hw *hw ; // hardware access
+    void *arg ;           // argument of the hardware access functions
+
+    // Subsystems brought up by initio_Open() or on first use
+    int subsystemsUp ;
+    pthread_mutex_t upMutex ;
+
+    pthread_mutex_t motorMutex ;  // serialises motor commands
+    pthread_mutex_t sonarMutex ;  // serialises ultrasonic pings
+    int sonarMode ;               // direction of the sonar pin (under sonarMutex)
+    unsigned int sonarMaxCm ;     // range limit of the sonar, 0 == none
+
+    // File pointer to Servo Demon interface (ServoBlaster)
+    FILE *fpServoBlaster ;
+    pthread_mutex_t servoMutex ;  // servod launch, start/stop and writes
+    pthread_t servoLauncher ;
+    BOOL servoLaunching ;
+
+    uint32_t motors ;  // last commanded signed duties, left in the low half
+    uint32_t request ; // duties asked for before the forward scale, packed alike
+    unsigned int forwardScale ;  // per mille of forward duties passed on (under motorMutex)
+    int pwm[4] ;       // duties last written to L1, L2, R1, R2 (under motorMutex)
+    initio_motorStats motorStats ;
+    double motorNsSum ;
+    unsigned int brakeHoldMs ;   // brake time before coasting, 0: until the next command
+    double brakeReleaseNs ;      // time to release the brake, 0: none (under motorMutex)
+    pthread_cond_t brakeCond ;   // wakes the brake release thread
+    pthread_t brakeThread ;
+    BOOL brakeThreadUp, brakeQuit ;  // (under motorMutex)
+    unsigned long wheelCountLeft, wheelCountRight ;  // wheel sensor pulses
+
+    // call metrics, atomic
+    unsigned long callBuckets[INITIO_CALLS][INITIO_CALL_BUCKETS + 1] ;
+    uint64_t callNs[INITIO_CALLS] ;
+    unsigned int lastCm ;  // last sonar range
+    int servod ;           // INITIO_SERVOD_STOPPED or INITIO_SERVOD_RUNNING
+} ;
+
+// Default context of the functions without ctx argument (set up by initio_Init)
+static initio_ctx defaultCtx = {
+    .hw = &initio_wiringPiHw,
+    .upMutex = PTHREAD_MUTEX_INITIALIZER,
+    .motorMutex = PTHREAD_MUTEX_INITIALIZER,
+    .sonarMutex = PTHREAD_MUTEX_INITIALIZER,
+    .servoMutex = PTHREAD_MUTEX_INITIALIZER,
+    .brakeHoldMs = INITIO_BRAKE_HOLDMS,
+    .forwardScale = 1000,
+} ;
+
+static void startServos (initio_ctx *ctx);
+static void stopServos (initio_ctx *ctx);
+static void stopBrakeThread (initio_ctx *ctx);
+
+
+//======================================================================
+// Hardware Access via wiringPi
+
+static void wpSetup (void *arg)
+{
+    INITIO_TRACE_SCOPE ("hw", "wiringPiSetupPhys") ;
+    // Set GPIO bit numbering to use the physical pin numbers on the P1 connector only
+    wiringPiSetupPhys () ;
+}
+
+static void wpPinMode (void *arg, int pin, int mode)
+{
+    INITIO_TRACE_SCOPE ("hw", "pinMode") ;
+    pinMode (pin, mode) ;
+}
+
+static void wpPullUpDnControl (void *arg, int pin, int pud)
+{
+    INITIO_TRACE_SCOPE ("hw", "pullUpDnControl") ;
+    pullUpDnControl (pin, pud) ;
+}
+
+static int wpDigitalRead (void *arg, int pin)
+{
+    return digitalRead (pin) ;
+}
+
+static void wpDigitalWrite (void *arg, int pin, int value)
+{
+    INITIO_TRACE_SCOPE ("hw", "digitalWrite") ;
+    digitalWrite (pin, value) ;
+}
+
+static int wpSoftPwmCreate (void *arg, int pin, int value, int range)
+{
+    INITIO_TRACE_SCOPE ("hw", "softPwmCreate") ;
+    return softPwmCreate (pin, value, range) ;
+}
+
+static void wpSoftPwmWrite (void *arg, int pin, int value)
+{
+    INITIO_TRACE_SCOPE ("hw", "softPwmWrite") ;
+    softPwmWrite (pin, value) ;
+}
+
+static void wpSoftPwmStop (void *arg, int pin)
+{
+    INITIO_TRACE_SCOPE ("hw", "softPwmStop") ;
+    softPwmStop (pin) ;
+}
+
+static unsigned int wpMicros (void *arg)
+{
+    return micros () ;
+}
+
+static void wpDelayMicroseconds (void *arg, unsigned int us)
+{
+    INITIO_TRACE_SCOPE ("hw", "delayMicroseconds") ;
+    delayMicroseconds (us) ;
+}
+
+// wiringPi interrupt handlers have no argument: one trampoline per physical pin
+#define WP_ISR_PINS 41
+static struct { void (*func) (void *) ; void *arg ; } wpIsrTable[WP_ISR_PINS] ;
+
+static void wpIsrDispatch (int pin)
+{
+    void (*func) (void *) = __atomic_load_n (&wpIsrTable[pin].func, __ATOMIC_ACQUIRE) ;
+    if (func != NULL)
+        func (wpIsrTable[pin].arg) ;
+}
+
+#define WP_ISR(n) static void wpIsr##n (void) { wpIsrDispatch (n) ; }
+WP_ISR(0)  WP_ISR(1)  WP_ISR(2)  WP_ISR(3)  WP_ISR(4)  WP_ISR(5)  WP_ISR(6)  WP_ISR(7)
+WP_ISR(8)  WP_ISR(9)  WP_ISR(10) WP_ISR(11) WP_ISR(12) WP_ISR(13) WP_ISR(14) WP_ISR(15)
+WP_ISR(16) WP_ISR(17) WP_ISR(18) WP_ISR(19) WP_ISR(20) WP_ISR(21) WP_ISR(22) WP_ISR(23)
+WP_ISR(24) WP_ISR(25) WP_ISR(26) WP_ISR(27) WP_ISR(28) WP_ISR(29) WP_ISR(30) WP_ISR(31)
+WP_ISR(32) WP_ISR(33) WP_ISR(34) WP_ISR(35) WP_ISR(36) WP_ISR(37) WP_ISR(38) WP_ISR(39)
+WP_ISR(40)
+
+static void (*const wpIsrs[WP_ISR_PINS]) (void) = {
+    wpIsr0,  wpIsr1,  wpIsr2,  wpIsr3,  wpIsr4,  wpIsr5,  wpIsr6,  wpIsr7,
+    wpIsr8,  wpIsr9,  wpIsr10, wpIsr11, wpIsr12, wpIsr13, wpIsr14, wpIsr15,
+    wpIsr16, wpIsr17, wpIsr18, wpIsr19, wpIsr20, wpIsr21, wpIsr22, wpIsr23,
+    wpIsr24, wpIsr25, wpIsr26, wpIsr27, wpIsr28, wpIsr29, wpIsr30, wpIsr31,
+    wpIsr32, wpIsr33, wpIsr34, wpIsr35, wpIsr36, wpIsr37, wpIsr38, wpIsr39,
+    wpIsr40
+} ;
+
+static int wpIsr (void *arg, int pin, int edge, void (*func) (void *), void *funcArg)
+{
+    INITIO_TRACE_SCOPE ("hw", "wiringPiISR") ;
+    if (pin < 0 || pin >= WP_ISR_PINS)
+        return -1 ;
+    wpIsrTable[pin].arg = funcArg ;
+    __atomic_store_n (&wpIsrTable[pin].func, func, __ATOMIC_RELEASE) ;
+    return wiringPiISR (pin, edge, wpIsrs[pin]) ;
+}
+
+const initio_hw initio_wiringPiHw = {
+    .setup = wpSetup,
+    .pinMode = wpPinMode,
+    .pullUpDnControl = wpPullUpDnControl,
+    .digitalRead = wpDigitalRead,
+    .digitalWrite = wpDigitalWrite,
+    .softPwmCreate = wpSoftPwmCreate,
+    .softPwmWrite = wpSoftPwmWrite,
+    .softPwmStop = wpSoftPwmStop,
+    .micros = wpMicros,
+    .delayMicroseconds = wpDelayMicroseconds,
+    .isr = wpIsr,
+    .servoWrite = NULL,  // servod via /dev/servoblaster
+} ;
+
+// End of Hardware Access via wiringPi
+//======================================================================
 
-int L1, L2, R1, R2;  // board specific pin numbers of left/right motor
-int lineLeft;        // board specific pin number of left IR line sensor
-int sonar;           // board specific pin number of ultrasonic sensor
 
 
 //======================================================================
@@ -90,84 +266,193 @@ int initio_identifyControlBoard()
 // initio_init():
 // Initialises GPIO pins, switches motors off, etc
 void initio_Init()
+{
+    initio_InitEx (INITIO_ALL) ;
+}
+
+// Servo demon launch running in parallel to the GPIO setup
+static void *servoLaunchThread (void *arg)
+{
+    startServos ((initio_ctx *)arg) ;
+    return NULL ;
+}
+
+// waitServoLaunch(ctx):
+// Waits for a servo demon launch started by initio_Open() to complete.
+static void waitServoLaunch (initio_ctx *ctx)
+{
+    if (!__atomic_load_n (&ctx->servoLaunching, __ATOMIC_ACQUIRE))
+        return ;
+    pthread_mutex_lock (&ctx->servoMutex) ;
+    if (ctx->servoLaunching)
+    {
+        pthread_join (ctx->servoLauncher, NULL) ;
+        __atomic_store_n (&ctx->servoLaunching, FALSE, __ATOMIC_RELEASE) ;
+    }
+    pthread_mutex_unlock (&ctx->servoMutex) ;
+}
+
+// bringUp(ctx, subsystems):
+// Sets up the pins of all requested subsystems that are not up yet.
+static void bringUp (initio_ctx *ctx, int subsystems)
+{
+    const initio_hw *hw = ctx->hw ;
+
+    pthread_mutex_lock (&ctx->upMutex) ;
+    subsystems &= ~ctx->subsystemsUp ;
+    if (subsystems & INITIO_SENSORS)
+    {
+        // set up digital wheel sensors as inputs
+        hw->pinMode (ctx->arg, wheelLeft,  INPUT) ; // Left wheel sensor 1
+        hw->pinMode (ctx->arg, wheelRight, INPUT) ; // Right wheel sensor 1
+
+        // set up digital line detectors as inputs
+        hw->pinMode (ctx->arg, lineRight, INPUT) ;     // Right line sensor
+        hw->pinMode (ctx->arg, ctx->lineLeft, INPUT) ; // Left line sensor
+
+        // Set up IR obstacle sensors as inputs
+        hw->pinMode (ctx->arg, irFL, INPUT) ; // Left obstacle sensor
+        hw->pinMode (ctx->arg, irFR, INPUT) ; // Right obstacle sensor
+    }
+    if (subsystems & INITIO_SONAR)
+    {
+        pthread_mutex_lock (&ctx->sonarMutex) ;
+        hw->pinMode (ctx->arg, ctx->sonar, INPUT) ; // switched to output only for the trigger pulse
+        ctx->sonarMode = INPUT ;
+        pthread_mutex_unlock (&ctx->sonarMutex) ;
+    }
+    if (subsystems & INITIO_MOTORS)
+    {
+        // use pwm on inputs so motors don't go too fast
+        hw->softPwmCreate (ctx->arg, ctx->L1, 0, 100) ;
+        hw->softPwmCreate (ctx->arg, ctx->L2, 0, 100) ;
+        hw->softPwmCreate (ctx->arg, ctx->R1, 0, 100) ;
+        hw->softPwmCreate (ctx->arg, ctx->R2, 0, 100) ;
+        memset (ctx->pwm, 0, sizeof(ctx->pwm)) ;
+    }
+    __atomic_or_fetch (&ctx->subsystemsUp, subsystems, __ATOMIC_RELEASE) ;
+    pthread_mutex_unlock (&ctx->upMutex) ;
+}
+
+// ensureUp(ctx, subsystem):
+// Brings up a subsystem on first use; a single load once it is up.
+static inline void ensureUp (initio_ctx *ctx, int subsystem)
+{
+    if (!(__atomic_load_n (&ctx->subsystemsUp, __ATOMIC_ACQUIRE) & subsystem))
+        bringUp (ctx, subsystem) ;
+}
+
+// setupCtx(ctx, board, subsystems):
+// Sets the board specific pin numbers and brings up the requested subsystems.
+// The servo demon is launched in a background thread while the GPIO pins are set up.
+static int setupCtx (initio_ctx *ctx, int board, int subsystems)
 {
     // set robot board specific pin numbers
-    switch ( initio_identifyControlBoard() )
+    switch ( board )
     {
     case PIROCON2:
-         L1 = L1_PiRoCon;
-         L2 = L2_PiRoCon;
-         R1 = R1_PiRoCon;
-         R2 = R2_PiRoCon;
-         lineLeft = lineLeft_PiRoCon;
-         sonar = sonar_PiRoCon;
+         ctx->L1 = L1_PiRoCon;
+         ctx->L2 = L2_PiRoCon;
+         ctx->R1 = R1_PiRoCon;
+         ctx->R2 = R2_PiRoCon;
+         ctx->lineLeft = lineLeft_PiRoCon;
+         ctx->sonar = sonar_PiRoCon;
          break;
     case ROBOHAT:
-         L1 = L1_RoboHAT;
-         L2 = L2_RoboHAT;
-         R1 = R1_RoboHAT;
-         R2 = R2_RoboHAT;
-         lineLeft = lineLeft_RoboHat;
-         sonar = sonar_RoboHAT;
+         ctx->L1 = L1_RoboHAT;
+         ctx->L2 = L2_RoboHAT;
+         ctx->R1 = R1_RoboHAT;
+         ctx->R2 = R2_RoboHAT;
+         ctx->lineLeft = lineLeft_RoboHat;
+         ctx->sonar = sonar_RoboHAT;
          break;
     default: // unknown board idetified
-         fprintf(stderr,"initio_lib: Error: cannot identify robot control board.\n");
-         exit(EXIT_FAILURE);
+         return -1;
     };
+    ctx->board = board;
 
-    // Set GPIO bit numbering to use the physical pin numbers on the P1 connector only
-    wiringPiSetupPhys () ;
-
-    // set up digital wheel sensors as inputs
-    pinMode (wheelLeft,  INPUT) ; // Left wheel sensor 1
-    pinMode (wheelRight, INPUT) ; // Right wheel sensor 1
-
-    // set up digital line detectors as inputs
-    pinMode (lineRight, INPUT) ; // Right line sensor
-    pinMode (lineLeft,  INPUT) ; // Left line sensor
+    // Initialise the servo background process, in parallel to the GPIO setup
+    if ((subsystems & INITIO_SERVOS) && ctx->hw->servoWrite == NULL &&
+        ctx->fpServoBlaster == NULL && !ctx->servoLaunching)
+    {
+        if (pthread_create (&ctx->servoLauncher, NULL, servoLaunchThread, ctx) == 0)
+            __atomic_store_n (&ctx->servoLaunching, TRUE, __ATOMIC_RELEASE) ;
+        else
+            startServos (ctx) ;
+    }
 
-    // Set up IR obstacle sensors as inputs
-    pinMode (irFL, INPUT) ; // Left obstacle sensor
-    pinMode (irFR, INPUT) ; // Right obstacle sensor
+    if (ctx->hw->setup != NULL)
+        ctx->hw->setup (ctx->arg) ;
 
-    // use pwm on inputs so motors don't go too fast
-    softPwmCreate (L1, 0, 100) ;
-    softPwmCreate (L2, 0, 100) ;
-    softPwmCreate (R1, 0, 100) ;
-    softPwmCreate (R2, 0, 100) ;
+    bringUp (ctx, subsystems & (INITIO_MOTORS | INITIO_SONAR | INITIO_SENSORS)) ;
+    return 0;
+}
 
-    // Initialise the servo background process
-    initio_StartServos() ;
+// initio_InitEx (subsystems):
+// Initialises the requested subsystems (INITIO_MOTORS, INITIO_SERVOS, ...)
+// of the default context. Subsystems not requested are brought up on first use.
+void initio_InitEx (int subsystems)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    if (setupCtx (&defaultCtx, initio_identifyControlBoard (), subsystems) != 0)
+    {
+        fprintf(stderr,"initio_lib: Error: cannot identify robot control board.\n");
+        exit(EXIT_FAILURE);
+    }
 }
 
-// initio_Cleanup():
+// cleanupCtx(ctx):
 // Sets all motors off, stops the PWM threads and servos demon,
-// and sets GPIO to standard values.
-void initio_Cleanup()
+// and sets GPIO to standard values. Only subsystems that are up are touched.
+static void cleanupCtx (initio_ctx *ctx)
 {
-    int usedPins[13] = { L1, L2, R1, R2, wheelLeft, wheelRight, 
-                         irFL, irFR, lineLeft, lineRight,
-                         sonar, servoPanPin, servoTiltPin  };
+    int usedPins[13] = { ctx->L1, ctx->L2, ctx->R1, ctx->R2, wheelLeft, wheelRight, 
+                         irFL, irFR, ctx->lineLeft, lineRight,
+                         ctx->sonar, servoPanPin, servoTiltPin  };
+    int subsystemOfPin[13] = { INITIO_MOTORS, INITIO_MOTORS, INITIO_MOTORS, INITIO_MOTORS,
+                      INITIO_SENSORS, INITIO_SENSORS, INITIO_SENSORS, INITIO_SENSORS,
+                      INITIO_SENSORS, INITIO_SENSORS, INITIO_SONAR, INITIO_SERVOS, INITIO_SERVOS };
+    const initio_hw *hw = ctx->hw ;
+    int up;
     int pin;
 
-    // Stop all motors
-    initio_Stop () ;
+    waitServoLaunch (ctx) ;
+    up = ctx->subsystemsUp | ((ctx->fpServoBlaster != NULL) ? INITIO_SERVOS : 0) ;
 
-    // Stop the PWM threads
-    softPwmStop (L1) ;
-    softPwmStop (L2) ;
-    softPwmStop (R1) ;
-    softPwmStop (R2) ;
+    stopBrakeThread (ctx) ;
+    if (up & INITIO_MOTORS)
+    {
+        // Stop all motors
+        initio_ctxStop (ctx) ;
+
+        // Stop the PWM threads
+        hw->softPwmStop (ctx->arg, ctx->L1) ;
+        hw->softPwmStop (ctx->arg, ctx->L2) ;
+        hw->softPwmStop (ctx->arg, ctx->R1) ;
+        hw->softPwmStop (ctx->arg, ctx->R2) ;
+    }
 
     // Stop the sevos demon
-    initio_StopServos () ;
+    if (up & INITIO_SERVOS)
+        initio_ctxStopServos (ctx) ;
 
     // Set GPIO to standard values (Input, no Pull-Up/Down)
     for (pin = sizeof(usedPins)/sizeof(int)-1; pin >= 0; pin--)
     {
-        pullUpDnControl (usedPins[pin], PUD_OFF);
-        pinMode (usedPins[pin], INPUT) ;
+        if (!(up & subsystemOfPin[pin]))
+            continue;
+        hw->pullUpDnControl (ctx->arg, usedPins[pin], PUD_OFF);
+        hw->pinMode (ctx->arg, usedPins[pin], INPUT) ;
     }
+    __atomic_store_n (&ctx->subsystemsUp, 0, __ATOMIC_RELEASE) ;
+}
+
+// initio_Cleanup():
+// Cleans up the default context.
+void initio_Cleanup()
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    cleanupCtx (&defaultCtx) ;
 }
 
 // initio_Version():
@@ -181,79 +466,518 @@ float initio_Version()
 
 
 
+//======================================================================
+// Context Functions
+
+// initio_Open (board, hw, arg, subsystems):
+// Creates a context for a robot with the given board, accessed via hw.
+initio_ctx *initio_Open (int board, const initio_hw *hw, void *arg, int subsystems)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctx *ctx = calloc (1, sizeof(initio_ctx)) ;
+
+    if (ctx == NULL)
+        return NULL ;
+    ctx->hw = (hw != NULL) ? hw : &initio_wiringPiHw ;
+    ctx->arg = arg ;
+    pthread_mutex_init (&ctx->upMutex, NULL) ;
+    pthread_mutex_init (&ctx->motorMutex, NULL) ;
+    pthread_mutex_init (&ctx->sonarMutex, NULL) ;
+    pthread_mutex_init (&ctx->servoMutex, NULL) ;
+    ctx->brakeHoldMs = INITIO_BRAKE_HOLDMS ;
+    ctx->forwardScale = 1000 ;
+    if (setupCtx (ctx, (board == UNKNOWN_HAT) ? initio_identifyControlBoard () : board, subsystems) != 0)
+    {
+        initio_Close (ctx) ;
+        return NULL ;
+    }
+    return ctx ;
+}
+
+// initio_Close (ctx):
+// Cleans up the robot of ctx and frees ctx.
+void initio_Close (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    if (ctx == NULL || ctx == &defaultCtx)
+        return ;
+    if (ctx->board != UNKNOWN_HAT)
+        cleanupCtx (ctx) ;
+    pthread_mutex_destroy (&ctx->upMutex) ;
+    pthread_mutex_destroy (&ctx->motorMutex) ;
+    pthread_mutex_destroy (&ctx->sonarMutex) ;
+    pthread_mutex_destroy (&ctx->servoMutex) ;
+    free (ctx) ;
+}
+
+// initio_DefaultCtx ():
+// Returns the context used by the functions without ctx argument.
+initio_ctx *initio_DefaultCtx (void)
+{
+    return &defaultCtx ;
+}
+
+// initio_ctxBoard (ctx):
+// Returns the control board of ctx.
+int initio_ctxBoard (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    return ctx->board ;
+}
+
+// End of Context Functions
+//======================================================================
+
+
+
 //======================================================================
 // Motor Functions
 
 /*** Python PWM: p=L1, q=L2, a=R1, b=R2 ***/
 
-// initio_Stop ():
+const double initio_callBoundsUs[INITIO_CALL_BUCKETS] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000 } ;
+
+// recordCall (ctx, call, ns):
+// Counts a call of ctx that took ns in its latency bucket (lock-free).
+static void recordCall (initio_ctx *ctx, int call, double ns)
+{
+    int b = 0 ;
+
+    while (b < INITIO_CALL_BUCKETS && ns > initio_callBoundsUs[b] * 1e3)
+        b++ ;
+    __atomic_add_fetch (&ctx->callNs[call], (uint64_t)ns, __ATOMIC_RELAXED) ;
+    __atomic_add_fetch (&ctx->callBuckets[call][b], 1, __ATOMIC_RELAXED) ;
+}
+
+// writeMotorPins (ctx, duty):
+// Writes the duties of L1, L2, R1, R2 that differ from the last written
+// ones (under motorMutex); returns the number of writes.
+static int writeMotorPins (initio_ctx *ctx, const int duty[4])
+{
+    const int pins[4] = { ctx->L1, ctx->L2, ctx->R1, ctx->R2 } ;
+    int i, writes = 0 ;
+
+    for (i = 0; i < 4; i++)
+    {
+        if (duty[i] == ctx->pwm[i])
+            continue ;
+        ctx->hw->softPwmWrite (ctx->arg, pins[i], duty[i]) ;
+        ctx->pwm[i] = duty[i] ;
+        writes++ ;
+    }
+    return writes ;
+}
+
+static inline uint32_t packDuties (int left, int right)
+{
+    return (uint32_t)(uint16_t)left | ((uint32_t)(uint16_t)right << 16) ;
+}
+
+// applyMotors (ctx, left, right):
+// Writes the signed duties, forward ones (both >= 0) scaled by the
+// forward scale (under motorMutex); returns the number of pin writes.
+static int applyMotors (initio_ctx *ctx, int left, int right)
+{
+    int duty[4], writes ;
+
+    if (left >= 0 && right >= 0 && ctx->forwardScale < 1000)
+    {
+        left = left * ctx->forwardScale / 1000 ;
+        right = right * ctx->forwardScale / 1000 ;
+    }
+    duty[0] = (left > 0) ? left : 0 ;    // L1
+    duty[1] = (left < 0) ? -left : 0 ;   // L2
+    duty[2] = (right > 0) ? right : 0 ;  // R1
+    duty[3] = (right < 0) ? -right : 0 ; // R2
+    writes = writeMotorPins (ctx, duty) ;
+    __atomic_store_n (&ctx->motors, packDuties (left, right), __ATOMIC_RELEASE) ;
+    return writes ;
+}
+
+// initio_ctxSetMotors (ctx, left, right):
+// Sets the signed duties of both motors, -100 <= left,right <= 100, negative == reverse.
+// Only the motor pins whose duty changes are written.
+void initio_ctxSetMotors (initio_ctx *ctx, int left, int right)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    double t0 = initio_NowNs (), ns ;
+    int writes ;
+
+    if (left < -100) left = -100 ;
+    if (left > 100) left = 100 ;
+    if (right < -100) right = -100 ;
+    if (right > 100) right = 100 ;
+
+    ensureUp (ctx, INITIO_MOTORS) ;
+    pthread_mutex_lock (&ctx->motorMutex) ;
+    __atomic_store_n (&ctx->request, packDuties (left, right), __ATOMIC_RELEASE) ;
+    writes = applyMotors (ctx, left, right) ;
+    ctx->brakeReleaseNs = 0 ;  // a pending brake release is overridden
+
+    ns = initio_NowNs () - t0 ;
+    ctx->motorStats.calls++ ;
+    ctx->motorStats.writes += writes ;
+    ctx->motorStats.skipped += 4 - writes ;
+    ctx->motorNsSum += ns ;
+    ctx->motorStats.latencyAvgNs = ctx->motorNsSum / ctx->motorStats.calls ;
+    if (ns > ctx->motorStats.latencyMaxNs)
+        ctx->motorStats.latencyMaxNs = ns ;
+    pthread_mutex_unlock (&ctx->motorMutex) ;
+    recordCall (ctx, INITIO_CALL_MOTORS, ns) ;
+}
+
+// initio_ctxSetForwardScale (ctx, scale):
+// Scales forward duties (both motors >= 0, e.g. DriveForward, TurnForward)
+// by 0 <= scale <= 1, also the ones in effect; reverse and spins are kept.
+void initio_ctxSetForwardScale (initio_ctx *ctx, double scale)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    unsigned int permille = (scale <= 0) ? 0 : (scale >= 1) ? 1000 : (unsigned int)(scale * 1000 + 0.5) ;
+    uint32_t request ;
+    int left, right ;
+
+    pthread_mutex_lock (&ctx->motorMutex) ;
+    if (permille != ctx->forwardScale)
+    {
+        __atomic_store_n (&ctx->forwardScale, permille, __ATOMIC_RELAXED) ;
+        request = __atomic_load_n (&ctx->request, __ATOMIC_RELAXED) ;
+        left = (int16_t)(request & 0xffff) ;
+        right = (int16_t)(request >> 16) ;
+        if (left >= 0 && right >= 0 && (left > 0 || right > 0))  // not while stopped or braking
+            applyMotors (ctx, left, right) ;
+    }
+    pthread_mutex_unlock (&ctx->motorMutex) ;
+}
+
+// initio_ctxGetForwardScale (ctx):
+// Returns the scale of forward duties.
+double initio_ctxGetForwardScale (initio_ctx *ctx)
+{
+    return __atomic_load_n (&ctx->forwardScale, __ATOMIC_RELAXED) / 1000.0 ;
+}
+
+// speed(s): the functions below take speeds 0..100 (softPwm writes negative values as 0)
+static inline int speed (int8_t s)
+{
+    return (s < 0) ? 0 : s ;
+}
+
+// initio_ctxStop (ctx):
 // Stops both motors
-void initio_Stop ()
+void initio_ctxStop (initio_ctx *ctx)
 {
-    softPwmWrite (L1, 0) ;
-    softPwmWrite (L2, 0) ;
-    softPwmWrite (R1, 0) ;
-    softPwmWrite (R2, 0) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctxSetMotors (ctx, 0, 0) ;
 }
 
-// initio_DriveForward (speed):
+// initio_ctxDriveForward (ctx, speed):
 // Sets both motors to move forward at speed. 0 <= speed <= 100
-void initio_DriveForward (int8_t speed)
+void initio_ctxDriveForward (initio_ctx *ctx, int8_t s)
 {
-    softPwmWrite (L1, speed) ;
-    softPwmWrite (L2, 0) ;
-    softPwmWrite (R1, speed) ;
-    softPwmWrite (R2, 0) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctxSetMotors (ctx, speed (s), speed (s)) ;
 }
 
-// initio_DriveReverse (speed):
+// initio_ctxDriveReverse (ctx, speed):
 // Sets both motors to reverse at speed. 0 <= speed <= 100
-void initio_DriveReverse (int8_t speed)
+void initio_ctxDriveReverse (initio_ctx *ctx, int8_t s)
 {
-    softPwmWrite (L1, 0) ;
-    softPwmWrite (L2, speed) ;
-    softPwmWrite (R1, 0) ;
-    softPwmWrite (R2, speed) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctxSetMotors (ctx, -speed (s), -speed (s)) ;
 }
 
-// initio_SpinLeft (speed):
+// initio_ctxSpinLeft (ctx, speed):
 // Sets motors to turn opposite directions at speed. 0 <= speed <= 100
-void initio_SpinLeft (int8_t speed)
+void initio_ctxSpinLeft (initio_ctx *ctx, int8_t s)
 {
-    softPwmWrite (L1, 0) ;
-    softPwmWrite (L2, speed) ;
-    softPwmWrite (R1, speed) ;
-    softPwmWrite (R2, 0) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctxSetMotors (ctx, -speed (s), speed (s)) ;
 }
 
-// initio_SpinRight(speed):
+// initio_ctxSpinRight (ctx, speed):
 // Sets motors to turn opposite directions at speed. 0 <= speed <= 100
-void initio_SpinRight(int8_t speed)
+void initio_ctxSpinRight (initio_ctx *ctx, int8_t s)
 {
-    softPwmWrite (L1, speed) ;
-    softPwmWrite (L2, 0) ;
-    softPwmWrite (R1, 0) ;
-    softPwmWrite (R2, speed) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctxSetMotors (ctx, speed (s), -speed (s)) ;
 }
 
-// initio_TurnForward (leftSpeed, rightSpeed):
+// initio_ctxTurnForward (ctx, leftSpeed, rightSpeed):
 // Moves forwards in an arc by setting different speeds. 0 <= leftSpeed,rightSpeed <= 100
-void initio_TurnForward (int8_t leftSpeed, int8_t rightSpeed)
+void initio_ctxTurnForward (initio_ctx *ctx, int8_t leftSpeed, int8_t rightSpeed)
 {
-    softPwmWrite (L1, leftSpeed) ;
-    softPwmWrite (L2, 0) ;
-    softPwmWrite (R1, rightSpeed) ;
-    softPwmWrite (R2, 0) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctxSetMotors (ctx, speed (leftSpeed), speed (rightSpeed)) ;
 }
 
-// initio_TurnReverse (leftSpeed, rightSpeed):
+// initio_ctxTurnReverse (ctx, leftSpeed, rightSpeed):
 // Moves backwards in an arc by setting different speeds. 0 <= leftSpeed,rightSpeed <= 100
+void initio_ctxTurnReverse (initio_ctx *ctx, int8_t leftSpeed, int8_t rightSpeed)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    initio_ctxSetMotors (ctx, -speed (leftSpeed), -speed (rightSpeed)) ;
+}
+
+// brakeThread (ctx):
+// Releases the brake to coast when its hold time has passed, unless a
+// motor command came first.
+static void *brakeThread (void *arg)
+{
+    static const int coast[4] = { 0, 0, 0, 0 } ;
+    initio_ctx *ctx = arg ;
+    struct timespec ts ;
+    long long ns ;
+
+    pthread_mutex_lock (&ctx->motorMutex) ;
+    while (!ctx->brakeQuit)
+    {
+        if (ctx->brakeReleaseNs == 0)
+            pthread_cond_wait (&ctx->brakeCond, &ctx->motorMutex) ;
+        else if (initio_NowNs () < ctx->brakeReleaseNs)
+        {
+            ns = (long long)ctx->brakeReleaseNs ;
+            ts.tv_sec = ns / 1000000000LL ;
+            ts.tv_nsec = ns % 1000000000LL ;
+            pthread_cond_timedwait (&ctx->brakeCond, &ctx->motorMutex, &ts) ;
+        }
+        else
+        {
+            INITIO_TRACE_SCOPE ("initio", "brake release") ;
+            writeMotorPins (ctx, coast) ;
+            ctx->brakeReleaseNs = 0 ;
+        }
+    }
+    pthread_mutex_unlock (&ctx->motorMutex) ;
+    return NULL ;
+}
+
+// startBrakeThread (ctx):
+// Starts the brake release thread of ctx (under motorMutex); returns FALSE on error.
+static BOOL startBrakeThread (initio_ctx *ctx)
+{
+    pthread_condattr_t attr ;
+
+    pthread_condattr_init (&attr) ;
+    pthread_condattr_setclock (&attr, CLOCK_MONOTONIC) ;
+    pthread_cond_init (&ctx->brakeCond, &attr) ;
+    pthread_condattr_destroy (&attr) ;
+    ctx->brakeQuit = FALSE ;
+    if (pthread_create (&ctx->brakeThread, NULL, brakeThread, ctx) != 0)
+    {
+        pthread_cond_destroy (&ctx->brakeCond) ;
+        return FALSE ;
+    }
+    ctx->brakeThreadUp = TRUE ;
+    return TRUE ;
+}
+
+// stopBrakeThread (ctx):
+// Ends the brake release thread of ctx, if running.
+static void stopBrakeThread (initio_ctx *ctx)
+{
+    BOOL up ;
+
+    pthread_mutex_lock (&ctx->motorMutex) ;
+    up = ctx->brakeThreadUp ;
+    ctx->brakeQuit = TRUE ;
+    ctx->brakeReleaseNs = 0 ;
+    if (up)
+        pthread_cond_signal (&ctx->brakeCond) ;
+    pthread_mutex_unlock (&ctx->motorMutex) ;
+    if (!up)
+        return ;
+    pthread_join (ctx->brakeThread, NULL) ;
+    pthread_cond_destroy (&ctx->brakeCond) ;
+    ctx->brakeThreadUp = FALSE ;
+}
+
+// initio_ctxBrake (ctx, strength):
+// Brakes both motors by driving both inputs of each H-bridge fully on,
+// then releases them to coast after the hold time. The softPwm periods of
+// the two inputs are not aligned, so a partial duty would not keep them
+// on together: any strength > 0 brakes fully, 0 coasts.
+void initio_ctxBrake (initio_ctx *ctx, int8_t strength)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    int s = (strength > 0) ? 100 : 0 ;
+    int duty[4] = { s, s, s, s } ;
+    double t0 = initio_NowNs () ;
+
+    ensureUp (ctx, INITIO_MOTORS) ;
+    pthread_mutex_lock (&ctx->motorMutex) ;
+    writeMotorPins (ctx, duty) ;
+    __atomic_store_n (&ctx->motors, 0, __ATOMIC_RELEASE) ;
+    __atomic_store_n (&ctx->request, 0, __ATOMIC_RELEASE) ;
+    ctx->brakeReleaseNs = 0 ;
+    if (s > 0 && ctx->brakeHoldMs > 0 && (ctx->brakeThreadUp || startBrakeThread (ctx)))
+    {
+        ctx->brakeReleaseNs = t0 + ctx->brakeHoldMs * 1e6 ;
+        pthread_cond_signal (&ctx->brakeCond) ;
+    }
+    pthread_mutex_unlock (&ctx->motorMutex) ;
+    recordCall (ctx, INITIO_CALL_MOTORS, initio_NowNs () - t0) ;
+}
+
+// initio_ctxSetBrakeHold (ctx, ms):
+// Sets the time initio_ctxBrake holds the brake, 0: until the next motor command.
+void initio_ctxSetBrakeHold (initio_ctx *ctx, unsigned int ms)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    __atomic_store_n (&ctx->brakeHoldMs, ms, __ATOMIC_RELAXED) ;
+}
+
+// initio_ctxGetMotorStats (ctx, stats):
+// Returns the number of motor commands and pin writes, and the time per command.
+void initio_ctxGetMotorStats (initio_ctx *ctx, initio_motorStats *stats)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    pthread_mutex_lock (&ctx->motorMutex) ;
+    *stats = ctx->motorStats ;
+    pthread_mutex_unlock (&ctx->motorMutex) ;
+}
+
+// initio_ctxResetMotorStats (ctx):
+// Sets the motor statistics to zero.
+void initio_ctxResetMotorStats (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    pthread_mutex_lock (&ctx->motorMutex) ;
+    memset (&ctx->motorStats, 0, sizeof(initio_motorStats)) ;
+    ctx->motorNsSum = 0 ;
+    pthread_mutex_unlock (&ctx->motorMutex) ;
+}
+
+// initio_ctxGetCallMetrics (ctx, metrics):
+// Returns the call counts and latency histograms, duties, last sonar range
+// and servod state of ctx without taking any of its locks.
+void initio_ctxGetCallMetrics (initio_ctx *ctx, initio_callMetrics *metrics)
+{
+    int c, b ;
+
+    for (c = 0; c < INITIO_CALLS; c++)
+    {
+        metrics->call[c].count = 0 ;
+        for (b = 0; b <= INITIO_CALL_BUCKETS; b++)
+        {
+            metrics->call[c].buckets[b] = __atomic_load_n (&ctx->callBuckets[c][b], __ATOMIC_RELAXED) ;
+            metrics->call[c].count += metrics->call[c].buckets[b] ;
+        }
+        metrics->call[c].sumUs = __atomic_load_n (&ctx->callNs[c], __ATOMIC_RELAXED) * 1e-3 ;
+    }
+    initio_ctxGetMotors (ctx, &metrics->left, &metrics->right) ;
+    metrics->cm = __atomic_load_n (&ctx->lastCm, __ATOMIC_RELAXED) ;
+    if (ctx->hw->servoWrite != NULL)
+        metrics->servod = INITIO_SERVOD_NONE ;
+    else if (__atomic_load_n (&ctx->servoLaunching, __ATOMIC_ACQUIRE))
+        metrics->servod = INITIO_SERVOD_LAUNCHING ;
+    else
+        metrics->servod = __atomic_load_n (&ctx->servod, __ATOMIC_RELAXED) ;
+}
+
+// initio_ctxGetMotors (ctx, left, right):
+// Returns the signed duties last commanded by the motor functions (lock-free, consistent pair).
+void initio_ctxGetMotors (initio_ctx *ctx, int *left, int *right)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    uint32_t motors = __atomic_load_n (&ctx->motors, __ATOMIC_ACQUIRE) ;
+    *left = (int16_t)(motors & 0xffff) ;
+    *right = (int16_t)(motors >> 16) ;
+}
+
+// initio_ctxGetMotorRequest (ctx, left, right):
+// Returns the signed duties last asked for, before the forward scale.
+void initio_ctxGetMotorRequest (initio_ctx *ctx, int *left, int *right)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    uint32_t request = __atomic_load_n (&ctx->request, __ATOMIC_ACQUIRE) ;
+    *left = (int16_t)(request & 0xffff) ;
+    *right = (int16_t)(request >> 16) ;
+}
+
+void initio_Stop ()
+{
+    initio_ctxStop (&defaultCtx) ;
+}
+
+void initio_DriveForward (int8_t speed)
+{
+    initio_ctxDriveForward (&defaultCtx, speed) ;
+}
+
+void initio_DriveReverse (int8_t speed)
+{
+    initio_ctxDriveReverse (&defaultCtx, speed) ;
+}
+
+void initio_SpinLeft (int8_t speed)
+{
+    initio_ctxSpinLeft (&defaultCtx, speed) ;
+}
+
+void initio_SpinRight(int8_t speed)
+{
+    initio_ctxSpinRight (&defaultCtx, speed) ;
+}
+
+void initio_TurnForward (int8_t leftSpeed, int8_t rightSpeed)
+{
+    initio_ctxTurnForward (&defaultCtx, leftSpeed, rightSpeed) ;
+}
+
 void initio_TurnReverse (int8_t leftSpeed, int8_t rightSpeed)
 {
-    softPwmWrite (L1, 0) ;
-    softPwmWrite (L2, leftSpeed) ;
-    softPwmWrite (R1, 0) ;
-    softPwmWrite (R2, rightSpeed) ;
+    initio_ctxTurnReverse (&defaultCtx, leftSpeed, rightSpeed) ;
+}
+
+void initio_Brake (int8_t strength)
+{
+    initio_ctxBrake (&defaultCtx, strength) ;
+}
+
+void initio_SetBrakeHold (unsigned int ms)
+{
+    initio_ctxSetBrakeHold (&defaultCtx, ms) ;
+}
+
+void initio_SetForwardScale (double scale)
+{
+    initio_ctxSetForwardScale (&defaultCtx, scale) ;
+}
+
+double initio_GetForwardScale (void)
+{
+    return initio_ctxGetForwardScale (&defaultCtx) ;
+}
+
+void initio_GetMotors (int *left, int *right)
+{
+    initio_ctxGetMotors (&defaultCtx, left, right) ;
+}
+
+void initio_GetMotorRequest (int *left, int *right)
+{
+    initio_ctxGetMotorRequest (&defaultCtx, left, right) ;
+}
+
+void initio_SetMotors (int left, int right)
+{
+    initio_ctxSetMotors (&defaultCtx, left, right) ;
+}
+
+void initio_GetMotorStats (initio_motorStats *stats)
+{
+    initio_ctxGetMotorStats (&defaultCtx, stats) ;
+}
+
+void initio_GetCallMetrics (initio_callMetrics *metrics)
+{
+    initio_ctxGetCallMetrics (&defaultCtx, metrics) ;
+}
+
+void initio_ResetMotorStats (void)
+{
+    initio_ctxResetMotorStats (&defaultCtx) ;
 }
 
 // End of Motor Functions
@@ -267,18 +991,86 @@ void initio_TurnReverse (int8_t leftSpeed, int8_t rightSpeed)
 // bot exact position indication. This is because the implementation assumes
 // only one of the two phase-shifted signals per wheel to be connected.
 
-// initio_wheelSensorLeft ():
+// initio_ctxWheelSensorLeft (ctx):
 // Returns the status of the left wheel position sensor connected to pin(wheelLeft).
-BOOL initio_wheelSensorLeft (void)
+BOOL initio_ctxWheelSensorLeft (initio_ctx *ctx)
 {
-    return (digitalRead (wheelLeft)) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    return (ctx->hw->digitalRead (ctx->arg, wheelLeft)) ;
 }
 
-// initio_wheelSensorRight ():
+// initio_ctxWheelSensorRight (ctx):
 // Returns the status of the right wheel position sensor connected to pin(wheelRight).
+BOOL initio_ctxWheelSensorRight (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    return (ctx->hw->digitalRead (ctx->arg, wheelRight)) ;
+}
+
+// Interrupt handlers counting the wheel sensor pulses
+static void wheelIsrLeft (void *arg)
+{
+    __atomic_fetch_add (&((initio_ctx *)arg)->wheelCountLeft, 1, __ATOMIC_RELAXED) ;
+}
+
+static void wheelIsrRight (void *arg)
+{
+    __atomic_fetch_add (&((initio_ctx *)arg)->wheelCountRight, 1, __ATOMIC_RELAXED) ;
+}
+
+// initio_ctxWheelCountStart (ctx):
+// Starts counting the pulses (rising edges) of both wheel sensors using interrupts.
+void initio_ctxWheelCountStart (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    __atomic_store_n (&ctx->wheelCountLeft, 0, __ATOMIC_RELAXED) ;
+    __atomic_store_n (&ctx->wheelCountRight, 0, __ATOMIC_RELAXED) ;
+    ctx->hw->isr (ctx->arg, wheelLeft,  INT_EDGE_RISING, wheelIsrLeft, ctx) ;
+    ctx->hw->isr (ctx->arg, wheelRight, INT_EDGE_RISING, wheelIsrRight, ctx) ;
+}
+
+// initio_ctxWheelCountLeft (ctx):
+// Returns the number of left wheel sensor pulses since initio_ctxWheelCountStart().
+unsigned long initio_ctxWheelCountLeft (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    return __atomic_load_n (&ctx->wheelCountLeft, __ATOMIC_RELAXED) ;
+}
+
+// initio_ctxWheelCountRight (ctx):
+// Returns the number of right wheel sensor pulses since initio_ctxWheelCountStart().
+unsigned long initio_ctxWheelCountRight (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    return __atomic_load_n (&ctx->wheelCountRight, __ATOMIC_RELAXED) ;
+}
+
+BOOL initio_wheelSensorLeft (void)
+{
+    return initio_ctxWheelSensorLeft (&defaultCtx) ;
+}
+
 BOOL initio_wheelSensorRight (void)
 {
-    return (digitalRead (wheelRight)) ;
+    return initio_ctxWheelSensorRight (&defaultCtx) ;
+}
+
+void initio_WheelCountStart (void)
+{
+    initio_ctxWheelCountStart (&defaultCtx) ;
+}
+
+unsigned long initio_WheelCountLeft (void)
+{
+    return initio_ctxWheelCountLeft (&defaultCtx) ;
+}
+
+unsigned long initio_WheelCountRight (void)
+{
+    return initio_ctxWheelCountRight (&defaultCtx) ;
 }
 
 // End of Wheel Sensor Functions
@@ -289,39 +1081,74 @@ BOOL initio_wheelSensorRight (void)
 //======================================================================
 // IR Sensor Functions
 
-// initio_IrLeft():
+// initio_ctxIrLeft (ctx):
 // Returns whether Left IR Obstacle sensor is triggered
-BOOL initio_IrLeft (void)
+BOOL initio_ctxIrLeft (initio_ctx *ctx)
 {
-    return (digitalRead (irFL) == 0) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    return (ctx->hw->digitalRead (ctx->arg, irFL) == 0) ;
 }
 
-// initio_IrRight():
+// initio_ctxIrRight (ctx):
 // Returns whether Right IR Obstacle sensor is triggered
-BOOL initio_IrRight (void)
+BOOL initio_ctxIrRight (initio_ctx *ctx)
 {
-    return (digitalRead (irFR) == 0) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    return (ctx->hw->digitalRead (ctx->arg, irFR) == 0) ;
 }
 
-// initio_IrAll():
+// initio_ctxIrAll (ctx):
 // Returns TRUE if at least one of the Obstacle sensors is triggered
-BOOL initio_IrAll (void)
+BOOL initio_ctxIrAll (initio_ctx *ctx)
 {
-    return ((digitalRead (irFL) == 0) || (digitalRead (irFR) == 0)) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    return ((ctx->hw->digitalRead (ctx->arg, irFL) == 0) || (ctx->hw->digitalRead (ctx->arg, irFR) == 0)) ;
 }
 
-// initio_IrLineLeft():
+// initio_ctxIrLineLeft (ctx):
 // Returns whether Left IR Line sensor is triggered
-BOOL initio_IrLineLeft (void)
+BOOL initio_ctxIrLineLeft (initio_ctx *ctx)
 {
-    return (digitalRead (lineLeft) == 0) ;
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    return (ctx->hw->digitalRead (ctx->arg, ctx->lineLeft) == 0) ;
 }
 
-// initio_IrLineRight():
+// initio_ctxIrLineRight (ctx):
 // Returns whether Right IR Line sensor is triggered
+BOOL initio_ctxIrLineRight (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    ensureUp (ctx, INITIO_SENSORS) ;
+    return (ctx->hw->digitalRead (ctx->arg, lineRight) == 0) ;
+}
+
+BOOL initio_IrLeft (void)
+{
+    return initio_ctxIrLeft (&defaultCtx) ;
+}
+
+BOOL initio_IrRight (void)
+{
+    return initio_ctxIrRight (&defaultCtx) ;
+}
+
+BOOL initio_IrAll (void)
+{
+    return initio_ctxIrAll (&defaultCtx) ;
+}
+
+BOOL initio_IrLineLeft (void)
+{
+    return initio_ctxIrLineLeft (&defaultCtx) ;
+}
+
 BOOL initio_IrLineRight (void)
 {
-    return (digitalRead (lineRight) == 0) ;
+    return initio_ctxIrLineRight (&defaultCtx) ;
 }
 
 // End of IR Sensor Functions
@@ -332,7 +1159,38 @@ BOOL initio_IrLineRight (void)
 //======================================================================
 // UltraSonic Functions
 
-// initio_UsGetDistance():
+// Timeouts of a ping in us without range limit (initio_ctxUsSetMaxRange)
+#define US_TIMEOUT 100000
+// Time from the trigger pulse to the start of the echo pulse, at most.
+// The HC-SR04 first sends a burst of 8 cycles at 40kHz.
+#define US_LATENCY 3000
+
+// setSonarMode (ctx, mode):
+// Switches the direction of the sonar pin, unless it already is.
+static void setSonarMode (initio_ctx *ctx, int mode)
+{
+    if (ctx->sonarMode != mode)
+    {
+        ctx->hw->pinMode (ctx->arg, ctx->sonar, mode) ;
+        ctx->sonarMode = mode ;
+    }
+}
+
+// initio_ctxUsSetMaxRange (ctx, cm):
+// Limits the range of the sonar to cm, 0 == no limit.
+void initio_ctxUsSetMaxRange (initio_ctx *ctx, unsigned int cm)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    __atomic_store_n (&ctx->sonarMaxCm, cm, __ATOMIC_RELAXED) ;
+}
+
+unsigned int initio_ctxUsGetMaxRange (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    return __atomic_load_n (&ctx->sonarMaxCm, __ATOMIC_RELAXED) ;
+}
+
+// usGetDistance (ctx):
 // Returns the distance in cm to the nearest reflecting object. 0 == no object
 //
 // The inito uses the HC-SR04 ultrasonic sensor, which provides distance measurement
@@ -341,37 +1199,66 @@ BOOL initio_IrLineRight (void)
 // and returns on output a HIGH pulse with length proportional to distance (the time
 // the pulse travelled to the object and back). On the initio the trigger and output
 // pins of the HC-SR04 are mapped to one I/O pin (sonar).
-unsigned int initio_UsGetDistance (void)
+// Concurrent calls on the same ctx are serialised, they would disturb each other's echo.
+//
+// With a range limit the echo is only awaited as long as it takes from an object
+// at the limit, and objects beyond count as no object. An echo cut short this way
+// keeps the sensor busy; the next call waits until it has ended.
+static unsigned int usGetDistance (initio_ctx *ctx)
 {
+    const initio_hw *hw = ctx->hw ;
+    void *arg = ctx->arg ;
+    int sonar = ctx->sonar ;
+    unsigned int maxCm = __atomic_load_n (&ctx->sonarMaxCm, __ATOMIC_RELAXED) ;
+    unsigned long startTimeout = US_TIMEOUT, stopTimeout = US_TIMEOUT ;
     unsigned long start, count, stop, elapsed, distance;
+    BOOL echo ;
 
-    pinMode (sonar, OUTPUT) ; // set sonar as output
+    if (maxCm > 0)
+    {
+        // the echo pulse lasts the time the sound needs to the object and back
+        stopTimeout = INITIO_US_ECHOTIME (maxCm) + 1 ;
+        startTimeout = US_LATENCY ;
+    }
+
+    ensureUp (ctx, INITIO_SONAR) ;
+    pthread_mutex_lock (&ctx->sonarMutex) ;
+    setSonarMode (ctx, INPUT) ;
+    // The HC-SR04 ignores a trigger while the echo of the previous ping is running
+    count = hw->micros (arg) ;
+    stop = count ;
+    while ((hw->digitalRead (arg, sonar) == 1) && ((stop - count) < US_TIMEOUT))
+        stop = hw->micros (arg) ;
+
+    setSonarMode (ctx, OUTPUT) ; // set sonar as output
     // Send 10us HIGH pulse to trigger
-    digitalWrite (sonar, TRUE) ;
-    delayMicroseconds (10) ;
-    digitalWrite (sonar, FALSE) ;
+    hw->digitalWrite (arg, sonar, TRUE) ;
+    hw->delayMicroseconds (arg, 10) ;
+    hw->digitalWrite (arg, sonar, FALSE) ;
+    setSonarMode (ctx, INPUT) ; // set sonar as input
 
     // Measure the length of returning HIGH pulse
-    count =  micros () ;
+    count =  hw->micros (arg) ;
     start =  count ;
-    pinMode (sonar, INPUT) ; // set sonar as input
-    // 1. Wait till returning HIGH pulse begins and remember time (with 100ms timeout)
-    while ((digitalRead (sonar) == 0) && ((start - count) < 100000))
-        start = micros () ;
+    // 1. Wait till returning HIGH pulse begins and remember time (with timeout)
+    while ((hw->digitalRead (arg, sonar) == 0) && ((start - count) < startTimeout))
+        start = hw->micros (arg) ;
+    echo = ((start - count) < startTimeout) ;
 
-    count = micros () ;
+    count = hw->micros (arg) ;
     stop = count;
-    // 2. Wait till returning HIGH pulse ends and remember time (with 100ms timeout)
-    while ((digitalRead (sonar) == 1) && ((stop - count) < 100000))
-        stop = micros () ;
+    // 2. Wait till returning HIGH pulse ends and remember time (with timeout)
+    while ((hw->digitalRead (arg, sonar) == 1) && ((stop - count) < stopTimeout))
+        stop = hw->micros (arg) ;
+    pthread_mutex_unlock (&ctx->sonarMutex) ;
 
     elapsed = stop - start ; // Calculate pulse length (us)
-    if (elapsed >= 100000)
+    if (!echo || elapsed >= stopTimeout)
     {
         // Pulse took too long - so we assume no object, although
         // in practice a response will get received bouncing back from 
         // something in the vacinity.
-        // It's best to assume anything over 100 ms is out of range.
+        // It's best to assume anything over 100 ms (or the range limit) is out of range.
         return 0; 
     }
 
@@ -380,10 +1267,40 @@ unsigned int initio_UsGetDistance (void)
     // by the speed of sound (34.4 cm/ms at 21c), therefore scaled from us to ms,
     // and halved (as pulse had travelled the distance twice)
     distance = (elapsed * 344) / 20000 ;
+    if (maxCm > 0 && distance > maxCm)
+        return 0 ;
 
     return distance;
 }
 
+// initio_ctxUsGetDistance (ctx):
+// Pings (usGetDistance) and keeps range and latency in the call metrics.
+unsigned int initio_ctxUsGetDistance (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    double t0 = initio_NowNs () ;
+    unsigned int cm = usGetDistance (ctx) ;
+
+    __atomic_store_n (&ctx->lastCm, cm, __ATOMIC_RELAXED) ;
+    recordCall (ctx, INITIO_CALL_SONAR, initio_NowNs () - t0) ;
+    return cm ;
+}
+
+unsigned int initio_UsGetDistance (void)
+{
+    return initio_ctxUsGetDistance (&defaultCtx) ;
+}
+
+void initio_UsSetMaxRange (unsigned int cm)
+{
+    initio_ctxUsSetMaxRange (&defaultCtx, cm) ;
+}
+
+unsigned int initio_UsGetMaxRange (void)
+{
+    return initio_ctxUsGetMaxRange (&defaultCtx) ;
+}
+
 
 // End of UltraSonic Functions
 //======================================================================
@@ -393,17 +1310,21 @@ unsigned int initio_UsGetDistance (void)
 //======================================================================
 // Servo Functions
 
-// initio_StartServos ():
-// Initialises the servo background process
-void initio_StartServos (void)
+// startServos (ctx):
+// Launches servod and opens its interface (also run by the launch thread of initio_Open)
+static void startServos (initio_ctx *ctx)
 {
     char *pstrServoPrg = NULL;
     char *pstrInitCmd = NULL;
+    char *pstrServoDev = NULL;
 
+    if (ctx->hw->servoWrite != NULL)
+        return; // servos driven by the hardware access functions
+    INITIO_TRACE_SCOPE ("hw", "servod start") ;
     fprintf (stdout, "Starting servod\n") ;
     // TODO: check for secure_getenv, http://www.gnu.org/software/libc/manual/html_node/Environment-Access.html
-    fprintf(stdout, "Starting servod. ServosActive: %s\n", (fpServoBlaster!=NULL) ? "TRUE" : "FALSE") ;
-    initio_StopServos () ; // make sure no previous instance of 'servod' is running
+    fprintf(stdout, "Starting servod. ServosActive: %s\n", (ctx->fpServoBlaster!=NULL) ? "TRUE" : "FALSE") ;
+    stopServos (ctx) ; // make sure no previous instance of 'servod' is running
     pstrServoPrg = getenv("SERVOD") ; // Try to find 'servod' via environment variable
     if (pstrServoPrg == NULL) {
         pstrServoPrg = "servod";
@@ -412,39 +1333,108 @@ void initio_StartServos (void)
     pstrInitCmd = MergeStrings (3, "sudo ", pstrServoPrg, " --pcm --idle-timeout=20000 --p1pins=\"18,22\" > /dev/null\n") ;
     system(pstrInitCmd) ;
     free (pstrInitCmd) ; // free mem allocated by MergeString
-    // open interface of servo demon
-    fpServoBlaster = fopen("/dev/servoblaster","w") ;
-    if (fpServoBlaster == NULL) {
-        fprintf(stderr,"Opening /dev/servoblaster failed \n") ;
+    // open interface of servo demon (device can be redirected via environment variable)
+    pstrServoDev = getenv("SERVOBLASTER") ;
+    if (pstrServoDev == NULL) {
+        pstrServoDev = "/dev/servoblaster";
+    }
+    ctx->fpServoBlaster = fopen(pstrServoDev,"w") ;
+    if (ctx->fpServoBlaster == NULL) {
+        fprintf(stderr,"Opening %s failed \n", pstrServoDev) ;
         exit(EXIT_FAILURE) ;
     } // endif
+    __atomic_store_n (&ctx->servod, INITIO_SERVOD_RUNNING, __ATOMIC_RELAXED) ;
 }
 
-// initio_stopServos ():
-// Terminates the servo background process
-void initio_StopServos (void)
+// stopServos (ctx):
+// Terminates servod and closes its interface
+static void stopServos (initio_ctx *ctx)
 {
+    if (ctx->hw->servoWrite != NULL)
+        return;
+    INITIO_TRACE_SCOPE ("hw", "servod stop") ;
     fprintf(stdout,"Stopping servo\n") ;
     system("sudo pkill -f servod") ;
-    if (fpServoBlaster != NULL) {
-        fclose (fpServoBlaster) ;
-        fpServoBlaster = NULL;
+    if (ctx->fpServoBlaster != NULL) {
+        fclose (ctx->fpServoBlaster) ;
+        ctx->fpServoBlaster = NULL;
     } // endif
+    __atomic_store_n (&ctx->servod, INITIO_SERVOD_STOPPED, __ATOMIC_RELAXED) ;
 }
 
+// initio_ctxStartServos (ctx):
+// Initialises the servo background process
+void initio_ctxStartServos (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    waitServoLaunch (ctx) ;
+    pthread_mutex_lock (&ctx->servoMutex) ;
+    startServos (ctx) ;
+    pthread_mutex_unlock (&ctx->servoMutex) ;
+}
+
+// initio_ctxStopServos (ctx):
+// Terminates the servo background process
+void initio_ctxStopServos (initio_ctx *ctx)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    waitServoLaunch (ctx) ;
+    pthread_mutex_lock (&ctx->servoMutex) ;
+    stopServos (ctx) ;
+    pthread_mutex_unlock (&ctx->servoMutex) ;
+}
 
-// initio_SetServo (servo, degrees):
+// setServo (ctx, servo, degrees):
 // Sets the servo to position in degrees -90 to +90
-void initio_SetServo (int8_t servo, int8_t degrees)
+static void setServo (initio_ctx *ctx, int8_t servo, int8_t degrees)
 {
+    // <servo-position> is the pulse width in units of 10us
+    int position = 50 + ((90 - degrees) * 200 / 180) ;
+
+    if (ctx->hw->servoWrite != NULL)
+    {
+        ctx->hw->servoWrite (ctx->arg, servo, position) ;
+        return ;
+    }
     //fprintf (stdout, "ServosActive: %s\n", (fpServoBlaster!=NULL) ? "TRUE" : "FALSE") ;
     //fprintf(stdout,"pin = %d, Setting servo: degrees = %d\n", pin, degrees) ;
-    if (fpServoBlaster == NULL)
-         initio_StartServos() ;  // start servo demon if not already running
+    waitServoLaunch (ctx) ;  // servod may still be starting in the background
+    pthread_mutex_lock (&ctx->servoMutex) ;
+    if (ctx->fpServoBlaster == NULL)
+         startServos(ctx) ;  // start servo demon if not already running
     // Write <pin> = <servo-position> to /dev/servoblaster.
-    // By default <servo-position> is the pulse width in units of 10us
-    fprintf (fpServoBlaster, "%d=%d\n", servo, 50 + ((90 - degrees) * 200 / 180) ) ;
-    fflush (fpServoBlaster) ;
+    {
+        INITIO_TRACE_SCOPE ("hw", "servoblaster") ;
+        fprintf (ctx->fpServoBlaster, "%d=%d\n", servo, position ) ;
+        fflush (ctx->fpServoBlaster) ;
+    }
+    pthread_mutex_unlock (&ctx->servoMutex) ;
+}
+
+// initio_ctxSetServo (ctx, servo, degrees):
+// Sets the servo (setServo) and keeps the latency in the call metrics.
+void initio_ctxSetServo (initio_ctx *ctx, int8_t servo, int8_t degrees)
+{
+    INITIO_TRACE_SCOPE ("initio", __func__) ;
+    double t0 = initio_NowNs () ;
+
+    setServo (ctx, servo, degrees) ;
+    recordCall (ctx, INITIO_CALL_SERVO, initio_NowNs () - t0) ;
+}
+
+void initio_StartServos (void)
+{
+    initio_ctxStartServos (&defaultCtx) ;
+}
+
+void initio_StopServos (void)
+{
+    initio_ctxStopServos (&defaultCtx) ;
+}
+
+void initio_SetServo (int8_t servo, int8_t degrees)
+{
+    initio_ctxSetServo (&defaultCtx, servo, degrees) ;
 }
 
 // End of Servo Functions
@@ -22,6 +22,10 @@
 
 // All pin numbers refer to the physical pin numbers on the P1 connector
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Define a boolean data type
 #ifndef BOOL
 #define BOOL int8_t
@@ -72,6 +76,177 @@
 #define servoTiltPin 22
 
 
+// Subsystems for initio_InitEx()
+#define INITIO_MOTORS  0x01 // motor pins and softPwm threads
+#define INITIO_SERVOS  0x02 // servo demon (servod)
+#define INITIO_SONAR   0x04 // ultrasonic sensor
+#define INITIO_SENSORS 0x08 // IR obstacle, IR line and wheel sensor inputs
+#define INITIO_ALL     (INITIO_MOTORS | INITIO_SERVOS | INITIO_SONAR | INITIO_SENSORS)
+
+// Bits of the digital sensors in sensor bitmasks (1 == triggered / high)
+#define INITIO_SENSE_IRLEFT     0x01 // Left IR obstacle sensor triggered
+#define INITIO_SENSE_IRRIGHT    0x02 // Right IR obstacle sensor triggered
+#define INITIO_SENSE_LINELEFT   0x04 // Left IR line sensor triggered
+#define INITIO_SENSE_LINERIGHT  0x08 // Right IR line sensor triggered
+#define INITIO_SENSE_WHEELLEFT  0x10 // Left wheel sensor level
+#define INITIO_SENSE_WHEELRIGHT 0x20 // Right wheel sensor level
+
+
+//======================================================================
+// Robot Contexts
+//
+// All state of a robot (pin numbers of its board, hardware access,
+// servo demon interface, last motor duties, wheel counts) is kept in an
+// initio_ctx. Every function below has a variant initio_ctxXxx (ctx, ...)
+// acting on the given context; the functions without ctx argument act on
+// a default context that is set up by initio_Init()/initio_InitEx().
+// Several contexts with their own hardware access (e.g. initio_simHw of
+// initio_sim.h) can be used in one process.
+//
+// Thread safety:
+// - Sensor reads (IR, line, wheel sensors, wheel counts, GetMotors) are
+//   lock-free once the sensor subsystem is up and may be called from any
+//   thread at any time. After initio_InitEx() without INITIO_SENSORS the
+//   first sensor read brings the subsystem up and takes a mutex to do so.
+// - Motor commands of one context are serialised; initio_ctxGetMotors()
+//   always returns the left/right pair of one complete command.
+// - Ultrasonic pings of one context are serialised; different contexts
+//   ping independently. A ping first waits up to 100 ms for the echo of the
+//   previous one to end, then for the echo: up to 200 ms without a range
+//   limit, up to 3 ms + INITIO_US_ECHOTIME(limit) with one (see
+//   initio_UsSetMaxRange), plus the pings of other threads queued before it.
+// - Servo commands of one context are serialised, also with a servod
+//   launch still running in the background.
+// - initio_Open/Close, initio_Init/InitEx/Cleanup must not run concurrently
+//   with other calls on the same context.
+// The hardware access functions must tolerate concurrent calls for
+// different pins (wiringPi does).
+
+typedef struct initio_ctx initio_ctx ;
+
+// Statistics of the motor commands (initio_GetMotorStats)
+typedef struct {
+    unsigned long calls ;     // motor commands
+    unsigned long writes ;    // softPwmWrite() calls issued
+    unsigned long skipped ;   // softPwmWrite() calls saved, duty of the pin unchanged
+    double latencyAvgNs ;     // time per motor command, including waiting for the lock
+    double latencyMaxNs ;
+} initio_motorStats ;
+
+#define INITIO_BRAKE_HOLDMS 300  // default brake time of initio_Brake before coasting
+
+// Call metrics of a context (initio_ctxGetCallMetrics): counts and latency
+// histograms of the sonar, motor and servo calls, kept in atomic counters
+// so that they are read without taking any lock of the context.
+#define INITIO_CALL_SONAR   0   // initio_ctxUsGetDistance
+#define INITIO_CALL_MOTORS  1   // initio_ctxSetMotors and the motor functions on it
+#define INITIO_CALL_SERVO   2   // initio_ctxSetServo
+#define INITIO_CALLS        3
+#define INITIO_CALL_BUCKETS 16  // latency buckets, see initio_callBoundsUs
+
+// Upper bounds of the latency buckets in us
+extern const double initio_callBoundsUs[INITIO_CALL_BUCKETS] ;
+
+// States of the servo demon (initio_callMetrics.servod)
+#define INITIO_SERVOD_STOPPED   0
+#define INITIO_SERVOD_LAUNCHING 1  // started in the background by initio_Open()
+#define INITIO_SERVOD_RUNNING   2
+#define INITIO_SERVOD_NONE      3  // servos driven by the hardware access
+
+typedef struct {
+    unsigned long count ;                            // calls
+    double sumUs ;                                   // their total latency
+    unsigned long buckets[INITIO_CALL_BUCKETS + 1] ; // calls per bucket (latency <= bound,
+                                                     // not cumulative), last: above all bounds
+} initio_callMetric ;
+
+typedef struct {
+    initio_callMetric call[INITIO_CALLS] ;
+    int left, right ;          // commanded signed duties
+    unsigned int cm ;          // last sonar range, 0 == no object
+    int servod ;               // INITIO_SERVOD_*
+} initio_callMetrics ;
+
+// Hardware access of a context; all functions get the arg of initio_Open().
+typedef struct {
+    void (*setup) (void *arg) ;  // called once by initio_Open(), may be NULL
+    void (*pinMode) (void *arg, int pin, int mode) ;
+    void (*pullUpDnControl) (void *arg, int pin, int pud) ;
+    int  (*digitalRead) (void *arg, int pin) ;
+    void (*digitalWrite) (void *arg, int pin, int value) ;
+    int  (*softPwmCreate) (void *arg, int pin, int value, int range) ;
+    void (*softPwmWrite) (void *arg, int pin, int value) ;
+    void (*softPwmStop) (void *arg, int pin) ;
+    unsigned int (*micros) (void *arg) ;
+    void (*delayMicroseconds) (void *arg, unsigned int us) ;
+    // registers func(funcArg) as interrupt handler for edge (INT_EDGE_*) of pin
+    int  (*isr) (void *arg, int pin, int edge, void (*func) (void *), void *funcArg) ;
+    // sets servo to position in units of 10us; NULL: ServoBlaster (servod)
+    void (*servoWrite) (void *arg, int servo, int position) ;
+} initio_hw ;
+
+// Hardware access via wiringPi (physical pin numbering) and servod
+extern const initio_hw initio_wiringPiHw ;
+
+// initio_Open (board, hw, arg, subsystems):
+// Creates a context for a robot with control board PIROCON2 or ROBOHAT
+// (UNKNOWN_HAT: initio_identifyControlBoard()), accessed via hw with
+// argument arg (hw == NULL: initio_wiringPiHw). Brings up the given
+// subsystems like initio_InitEx(). Returns NULL on error.
+initio_ctx *initio_Open (int board, const initio_hw *hw, void *arg, int subsystems) ;
+
+// initio_Close (ctx):
+// Sets all motors off, sets the pins to standard values and frees ctx.
+void initio_Close (initio_ctx *ctx) ;
+
+// initio_DefaultCtx ():
+// Returns the context used by the functions without ctx argument.
+initio_ctx *initio_DefaultCtx (void) ;
+
+// initio_ctxBoard (ctx):
+// Returns the control board of ctx.
+int initio_ctxBoard (initio_ctx *ctx) ;
+
+// Context variants of the functions below
+void initio_ctxStop (initio_ctx *ctx) ;
+void initio_ctxDriveForward (initio_ctx *ctx, int8_t speed) ;
+void initio_ctxDriveReverse (initio_ctx *ctx, int8_t speed) ;
+void initio_ctxSpinLeft (initio_ctx *ctx, int8_t speed) ;
+void initio_ctxSpinRight (initio_ctx *ctx, int8_t speed) ;
+void initio_ctxTurnForward (initio_ctx *ctx, int8_t leftSpeed, int8_t rightSpeed) ;
+void initio_ctxTurnReverse (initio_ctx *ctx, int8_t leftSpeed, int8_t rightSpeed) ;
+void initio_ctxBrake (initio_ctx *ctx, int8_t strength) ;
+void initio_ctxSetBrakeHold (initio_ctx *ctx, unsigned int ms) ;
+void initio_ctxSetForwardScale (initio_ctx *ctx, double scale) ;
+double initio_ctxGetForwardScale (initio_ctx *ctx) ;
+void initio_ctxGetMotors (initio_ctx *ctx, int *left, int *right) ;
+void initio_ctxGetMotorRequest (initio_ctx *ctx, int *left, int *right) ;
+void initio_ctxSetMotors (initio_ctx *ctx, int left, int right) ;
+void initio_ctxGetMotorStats (initio_ctx *ctx, initio_motorStats *stats) ;
+void initio_ctxGetCallMetrics (initio_ctx *ctx, initio_callMetrics *metrics) ;
+void initio_ctxResetMotorStats (initio_ctx *ctx) ;
+BOOL initio_ctxWheelSensorLeft (initio_ctx *ctx) ;
+BOOL initio_ctxWheelSensorRight (initio_ctx *ctx) ;
+void initio_ctxWheelCountStart (initio_ctx *ctx) ;
+unsigned long initio_ctxWheelCountLeft (initio_ctx *ctx) ;
+unsigned long initio_ctxWheelCountRight (initio_ctx *ctx) ;
+BOOL initio_ctxIrLeft (initio_ctx *ctx) ;
+BOOL initio_ctxIrRight (initio_ctx *ctx) ;
+BOOL initio_ctxIrAll (initio_ctx *ctx) ;
+BOOL initio_ctxIrLineLeft (initio_ctx *ctx) ;
+BOOL initio_ctxIrLineRight (initio_ctx *ctx) ;
+unsigned int initio_ctxUsGetDistance (initio_ctx *ctx) ;
+void initio_ctxUsSetMaxRange (initio_ctx *ctx, unsigned int cm) ;
+unsigned int initio_ctxUsGetMaxRange (initio_ctx *ctx) ;
+void initio_ctxStartServos (initio_ctx *ctx) ;
+void initio_ctxStopServos (initio_ctx *ctx) ;
+void initio_ctxSetServo (initio_ctx *ctx, int8_t servo, int8_t degrees) ;
+
+// End of Robot Contexts
+//======================================================================
+
+
+
 //======================================================================
 // General Functions
 
@@ -83,6 +258,13 @@ int initio_identifyControlBoard() ;
 // Initialises GPIO pins, set physical pin numbering, switches motors off, etc
 void initio_Init() ;
 
+// initio_InitEx (subsystems):
+// Like initio_Init(), but only brings up the given subsystems (INITIO_MOTORS,
+// INITIO_SERVOS, INITIO_SONAR, INITIO_SENSORS, or INITIO_ALL) of the default
+// context. The others are brought up on first use. servod is launched in
+// parallel to the GPIO setup.
+void initio_InitEx (int subsystems) ;
+
 // initio_Cleanup():
 // Sets all motors off and sets GPIO pins to standard values
 void initio_Cleanup() ;
@@ -127,6 +309,62 @@ void initio_TurnForward (int8_t leftSpeed, int8_t rightSpeed) ;
 // Moves backwards in an arc by setting different speeds. 0 <= leftSpeed,rightSpeed <= 100
 void initio_TurnReverse (int8_t leftSpeed, int8_t rightSpeed) ;
 
+// initio_Brake (strength):
+// Brakes actively: drives both inputs of each motor (L1 and L2, R1 and R2)
+// fully on, which shorts the motors, and releases them to coast after the
+// hold time (initio_SetBrakeHold). Stops in a shorter distance than
+// initio_Stop(), which lets the motors coast. There is no partial brake:
+// the softPwm periods of both inputs are not aligned, so any strength > 0
+// brakes fully and 0 coasts. Any motor command ends the brake.
+void initio_Brake (int8_t strength) ;
+
+// initio_SetBrakeHold (ms):
+// Sets the time initio_Brake() holds the brake before coasting (default
+// INITIO_BRAKE_HOLDMS), 0: until the next motor command.
+void initio_SetBrakeHold (unsigned int ms) ;
+
+// initio_SetMotors (left, right):
+// Sets the signed duties of both motors, -100 <= left,right <= 100, negative
+// values mean reverse. All motor functions above are built on it; only pins
+// whose duty changes are written.
+void initio_SetMotors (int left, int right) ;
+
+// initio_SetForwardScale (scale):
+// Scales the duties of forward motion (both motors forward or stopped,
+// e.g. initio_DriveForward, initio_TurnForward) by 0 <= scale <= 1 before
+// they are written, also those in effect; reverse and spins are kept.
+// For speed governors (e.g. initio_ttc.h); default 1.
+void initio_SetForwardScale (double scale) ;
+
+// initio_GetForwardScale ():
+// Returns the scale of forward duties.
+double initio_GetForwardScale (void) ;
+
+// initio_GetMotors (left, right):
+// Returns the signed duties last commanded by the motor functions above,
+// as written (after the forward scale).
+// -100 <= left,right <= 100, negative values mean reverse.
+void initio_GetMotors (int *left, int *right) ;
+
+// initio_GetMotorRequest (left, right):
+// Returns the signed duties last asked for, before the forward scale.
+void initio_GetMotorRequest (int *left, int *right) ;
+
+// initio_GetMotorStats (stats):
+// Returns the number of motor commands, of softPwmWrite() calls issued and
+// saved, and the time per command.
+void initio_GetMotorStats (initio_motorStats *stats) ;
+
+// initio_ResetMotorStats ():
+// Sets the motor statistics to zero.
+void initio_ResetMotorStats (void) ;
+
+// initio_GetCallMetrics (metrics):
+// Returns the counts and latency histograms of the sonar, motor and servo
+// calls, the commanded duties, the last sonar range and the servod state;
+// lock-free, callable from any thread (e.g. a metrics exporter).
+void initio_GetCallMetrics (initio_callMetrics *metrics) ;
+
 // End of Motor Functions
 //======================================================================
 
@@ -146,6 +384,18 @@ BOOL initio_wheelSensorLeft (void) ;
 // Returns the status of the right wheel position sensor connected to pin(wheelRight).
 BOOL initio_wheelSensorRight (void) ;
 
+// initio_WheelCountStart ():
+// Starts counting the pulses (rising edges) of both wheel sensors using interrupts.
+void initio_WheelCountStart (void) ;
+
+// initio_WheelCountLeft ():
+// Returns the number of left wheel sensor pulses since initio_WheelCountStart().
+unsigned long initio_WheelCountLeft (void) ;
+
+// initio_WheelCountRight ():
+// Returns the number of right wheel sensor pulses since initio_WheelCountStart().
+unsigned long initio_WheelCountRight (void) ;
+
 // End of Wheel Sensor Functions
 //======================================================================
 
@@ -182,10 +432,25 @@ BOOL initio_IrLineRight (void) ;
 //======================================================================
 // UltraSonic Functions
 
+// INITIO_US_ECHOTIME(cm):
+// Length in us of the echo pulse from an object at cm (sound travels 34.4 cm/ms,
+// there and back); the inverse of the conversion of initio_UsGetDistance().
+#define INITIO_US_ECHOTIME(cm) (((unsigned long)(cm) * 20000 + 343) / 344)
+
 // initio_UsGetDistance():
 // Returns the distance in cm to the nearest reflecting object. 0 == no object
 unsigned int initio_UsGetDistance (void) ;
 
+// initio_UsSetMaxRange(cm):
+// Limits the range of initio_UsGetDistance() to cm, 0 == no limit (default).
+// The echo is then awaited only INITIO_US_ECHOTIME(cm) instead of 100 ms, and
+// objects beyond cm count as no object.
+void initio_UsSetMaxRange (unsigned int cm) ;
+
+// initio_UsGetMaxRange():
+// Returns the range limit set by initio_UsSetMaxRange().
+unsigned int initio_UsGetMaxRange (void) ;
+
 // End of UltraSonic Functions
 //======================================================================
 
@@ -211,4 +476,8 @@ void initio_SetServo (int8_t servo, int8_t degrees) ;
 
 
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _4TRONIX_INITIO_H_ */
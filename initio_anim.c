@@ -0,0 +1,366 @@
+//======================================================================
+//
+// Servo animation of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "initio_anim.h"
+
+#define HISTORY 64      // motions per servo whose final state is kept
+#define UNWRITTEN INT_MIN
+
+typedef struct {
+    double pos, vel ;          // profile state in deg and deg/s
+    int written ;              // degrees last written, UNWRITTEN: write next
+    initio_animKey *keys ;     // current motion, NULL: none
+    int n, k ;                 // keyframes, keyframe in progress
+    double holdLeft ;          // s to hold keyframe k, < 0: still moving to it
+    BOOL braking ;             // cancelled while moving
+    unsigned long seq ;        // motions started on this servo
+    unsigned long doneSeq ;    // motions ended
+    uint64_t cancelled ;       // per motion (seq % HISTORY): ended cancelled
+} channel ;
+
+struct initio_anim {
+    initio_ctx *ctx ;
+    initio_animParams params ;
+    double dt ;                // update period in s
+    initio_rate *rate ;
+
+    pthread_mutex_t mutex ;    // protects the channels and stats
+    pthread_cond_t ended ;     // a motion ended
+    channel ch[INITIO_ANIM_SERVOS] ;
+    initio_animStats stats ;
+} ;
+
+void initio_AnimDefaultParams (initio_animParams *params)
+{
+    int i ;
+
+    params->hz = 50 ;
+    for (i = 0; i < INITIO_ANIM_SERVOS; i++)
+    {
+        params->servo[i].maxVel = 180 ;
+        params->servo[i].maxAcc = 720 ;
+        params->servo[i].minDeg = -90 ;
+        params->servo[i].maxDeg = 90 ;
+    }
+}
+
+// finish(): ends the current motion of c; caller holds the mutex
+static void finish (initio_anim *anim, channel *c, BOOL cancelled)
+{
+    uint64_t bit = (uint64_t)1 << (c->seq % HISTORY) ;
+
+    if (c->keys == NULL)
+        return ;
+    free (c->keys) ;
+    c->keys = NULL ;
+    c->doneSeq = c->seq ;
+    if (cancelled)
+    {
+        c->cancelled |= bit ;
+        c->braking = (c->vel != 0) ;
+        anim->stats.cancelled++ ;
+    }
+    else
+    {
+        c->cancelled &= ~bit ;
+        anim->stats.done++ ;
+    }
+    pthread_cond_broadcast (&anim->ended) ;
+}
+
+// approach(): one update of the profile of c towards target, within the
+// limits; returns TRUE when the target is reached at rest
+static BOOL approach (channel *c, const initio_animLimits *lim, double target, double dt)
+{
+    double d = target - c->pos, v, dv, step ;
+
+    if (lim->maxVel <= 0 || lim->maxAcc <= 0)  // no limits: jump
+    {
+        c->pos = target ;
+        c->vel = 0 ;
+        return TRUE ;
+    }
+    // fastest velocity from which the servo can still brake at the target
+    v = fmin (lim->maxVel, sqrt (2 * lim->maxAcc * fabs (d))) ;
+    v = (d < 0) ? -v : v ;
+    dv = v - c->vel ;
+    dv = fmax (-lim->maxAcc * dt, fmin (lim->maxAcc * dt, dv)) ;
+    c->vel += dv ;
+    step = c->vel * dt ;
+    if (d == 0 || (step * d > 0 && fabs (step) >= fabs (d)))
+    {
+        c->pos = target ;
+        c->vel = 0 ;
+        return TRUE ;
+    }
+    c->pos += step ;
+    return FALSE ;
+}
+
+// brake(): one update of a servo stopping within its acceleration limit
+static void brake (channel *c, const initio_animLimits *lim, double dt)
+{
+    double dv = lim->maxAcc * dt ;
+
+    if (lim->maxAcc <= 0 || fabs (c->vel) <= dv)
+    {
+        c->vel = 0 ;
+        c->braking = FALSE ;
+        return ;
+    }
+    c->vel -= (c->vel > 0) ? dv : -dv ;
+    c->pos += c->vel * dt ;
+}
+
+static double clip (const initio_animLimits *lim, int degrees)
+{
+    int lo = (lim->minDeg > -90) ? lim->minDeg : -90 ;
+    int hi = (lim->maxDeg < 90) ? lim->maxDeg : 90 ;
+
+    return (degrees < lo) ? lo : (degrees > hi) ? hi : degrees ;
+}
+
+// animCycle(): one update of all servos; the positions are written
+// after releasing the mutex, servod writes may take a while
+static BOOL animCycle (void *arg)
+{
+    initio_anim *anim = arg ;
+    int pos[INITIO_ANIM_SERVOS] ;
+    int i, writes = 0 ;
+
+    pthread_mutex_lock (&anim->mutex) ;
+    for (i = 0; i < INITIO_ANIM_SERVOS; i++)
+    {
+        channel *c = &anim->ch[i] ;
+        const initio_animLimits *lim = &anim->params.servo[i] ;
+        int deg ;
+
+        if (c->keys != NULL)
+        {
+            if (c->holdLeft < 0
+                && approach (c, lim, clip (lim, c->keys[c->k].degrees), anim->dt))
+                c->holdLeft = c->keys[c->k].holdMs * 1e-3 + anim->dt ;  // the arrival does not count
+            if (c->holdLeft >= 0 && (c->holdLeft -= anim->dt) <= 1e-9)
+            {
+                c->holdLeft = -1 ;
+                if (++c->k == c->n)
+                    finish (anim, c, FALSE) ;
+            }
+        }
+        else if (c->braking)
+            brake (c, lim, anim->dt) ;
+
+        deg = (int)lround (c->pos) ;
+        if (deg != c->written)
+        {
+            c->written = deg ;
+            writes |= 1 << i ;
+        }
+        pos[i] = deg ;
+    }
+    pthread_mutex_unlock (&anim->mutex) ;
+
+    for (i = 0; i < INITIO_ANIM_SERVOS; i++)
+        if (writes & (1 << i))
+        {
+            initio_ctxSetServo (anim->ctx, i, pos[i]) ;
+            __atomic_add_fetch (&anim->stats.writes, 1, __ATOMIC_RELAXED) ;
+        }
+    return TRUE ;
+}
+
+initio_anim *initio_AnimStart (initio_ctx *ctx, const initio_animParams *params)
+{
+    initio_anim *anim = calloc (1, sizeof(initio_anim)) ;
+    pthread_condattr_t attr ;
+
+    if (anim == NULL)
+        return NULL ;
+    anim->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    if (params != NULL)
+        anim->params = *params ;
+    else
+        initio_AnimDefaultParams (&anim->params) ;
+    if (anim->params.hz <= 0)
+    {
+        free (anim) ;
+        return NULL ;
+    }
+    anim->dt = 1.0 / anim->params.hz ;
+    pthread_mutex_init (&anim->mutex, NULL) ;
+    pthread_condattr_init (&attr) ;
+    pthread_condattr_setclock (&attr, CLOCK_MONOTONIC) ;
+    pthread_cond_init (&anim->ended, &attr) ;
+    pthread_condattr_destroy (&attr) ;
+
+    anim->rate = initio_RateStart (anim->params.hz, animCycle, anim) ;
+    if (anim->rate == NULL)
+    {
+        pthread_cond_destroy (&anim->ended) ;
+        pthread_mutex_destroy (&anim->mutex) ;
+        free (anim) ;
+        return NULL ;
+    }
+    return anim ;
+}
+
+void initio_AnimStop (initio_anim *anim, initio_animStats *stats)
+{
+    initio_rateStats rs ;
+    int i ;
+
+    initio_RateStop (anim->rate, &rs) ;
+    pthread_mutex_lock (&anim->mutex) ;
+    for (i = 0; i < INITIO_ANIM_SERVOS; i++)
+        finish (anim, &anim->ch[i], TRUE) ;
+    pthread_mutex_unlock (&anim->mutex) ;
+    if (stats != NULL)
+    {
+        *stats = anim->stats ;
+        stats->rate = rs ;
+    }
+    pthread_cond_destroy (&anim->ended) ;
+    pthread_mutex_destroy (&anim->mutex) ;
+    free (anim) ;
+}
+
+unsigned long initio_AnimPlay (initio_anim *anim, int8_t servo, const initio_animKey *keys, int n)
+{
+    initio_animKey *copy ;
+    channel *c ;
+    unsigned long id ;
+
+    if (servo < 0 || servo >= INITIO_ANIM_SERVOS || n < 1)
+        return 0 ;
+    copy = malloc (n * sizeof(initio_animKey)) ;
+    if (copy == NULL)
+        return 0 ;
+    memcpy (copy, keys, n * sizeof(initio_animKey)) ;
+
+    pthread_mutex_lock (&anim->mutex) ;
+    c = &anim->ch[servo] ;
+    finish (anim, c, TRUE) ;
+    c->keys = copy ;
+    c->n = n ;
+    c->k = 0 ;
+    c->holdLeft = -1 ;
+    c->braking = FALSE ;
+    c->seq++ ;
+    id = c->seq * INITIO_ANIM_SERVOS + servo ;
+    anim->stats.motions++ ;
+    pthread_mutex_unlock (&anim->mutex) ;
+    return id ;
+}
+
+unsigned long initio_AnimMoveTo (initio_anim *anim, int8_t servo, int8_t degrees)
+{
+    initio_animKey key = { degrees, 0 } ;
+
+    return initio_AnimPlay (anim, servo, &key, 1) ;
+}
+
+void initio_AnimJump (initio_anim *anim, int8_t servo, int8_t degrees)
+{
+    channel *c ;
+
+    if (servo < 0 || servo >= INITIO_ANIM_SERVOS)
+        return ;
+    pthread_mutex_lock (&anim->mutex) ;
+    c = &anim->ch[servo] ;
+    finish (anim, c, TRUE) ;
+    c->pos = clip (&anim->params.servo[servo], degrees) ;
+    c->vel = 0 ;
+    c->braking = FALSE ;
+    c->written = UNWRITTEN ;  // written by the next update
+    pthread_mutex_unlock (&anim->mutex) ;
+}
+
+void initio_AnimCancel (initio_anim *anim, int8_t servo)
+{
+    if (servo < 0 || servo >= INITIO_ANIM_SERVOS)
+        return ;
+    pthread_mutex_lock (&anim->mutex) ;
+    finish (anim, &anim->ch[servo], TRUE) ;
+    pthread_mutex_unlock (&anim->mutex) ;
+}
+
+// state(): state of motion seq of c; caller holds the mutex
+static int state (const channel *c, unsigned long seq)
+{
+    if (seq == 0 || seq > c->seq)
+        return INITIO_ANIM_INVALID ;
+    if (seq > c->doneSeq)
+        return INITIO_ANIM_RUNNING ;
+    if (c->seq - seq >= HISTORY)
+        return INITIO_ANIM_DONE ;
+    return (c->cancelled & ((uint64_t)1 << (seq % HISTORY))) ? INITIO_ANIM_CANCELLED : INITIO_ANIM_DONE ;
+}
+
+int initio_AnimWait (initio_anim *anim, unsigned long id, int timeoutMs)
+{
+    unsigned long servo = id % INITIO_ANIM_SERVOS, seq = id / INITIO_ANIM_SERVOS ;
+    channel *c = &anim->ch[servo] ;
+    struct timespec deadline ;
+    int s ;
+
+    clock_gettime (CLOCK_MONOTONIC, &deadline) ;
+    if (timeoutMs > 0)
+    {
+        deadline.tv_sec += timeoutMs / 1000 ;
+        deadline.tv_nsec += (timeoutMs % 1000) * 1000000L ;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++ ;
+            deadline.tv_nsec -= 1000000000L ;
+        }
+    }
+    pthread_mutex_lock (&anim->mutex) ;
+    while ((s = state (c, seq)) == INITIO_ANIM_RUNNING && timeoutMs != 0)
+    {
+        if (timeoutMs < 0)
+            pthread_cond_wait (&anim->ended, &anim->mutex) ;
+        else if (pthread_cond_timedwait (&anim->ended, &anim->mutex, &deadline) != 0)
+        {
+            s = state (c, seq) ;
+            break ;
+        }
+    }
+    pthread_mutex_unlock (&anim->mutex) ;
+    return s ;
+}
+
+int initio_AnimPosition (initio_anim *anim, int8_t servo)
+{
+    int deg ;
+
+    if (servo < 0 || servo >= INITIO_ANIM_SERVOS)
+        return 0 ;
+    pthread_mutex_lock (&anim->mutex) ;
+    deg = (int)lround (anim->ch[servo].pos) ;
+    pthread_mutex_unlock (&anim->mutex) ;
+    return deg ;
+}
+
+void initio_AnimGetStats (initio_anim *anim, initio_animStats *stats)
+{
+    pthread_mutex_lock (&anim->mutex) ;
+    *stats = anim->stats ;
+    pthread_mutex_unlock (&anim->mutex) ;
+    stats->writes = __atomic_load_n (&anim->stats.writes, __ATOMIC_RELAXED) ;
+    initio_RateGetStats (anim->rate, &stats->rate) ;
+}
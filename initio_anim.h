@@ -0,0 +1,122 @@
+#ifndef _4TRONIX_INITIO_ANIM_H_
+#define _4TRONIX_INITIO_ANIM_H_
+//======================================================================
+//
+// Servo animation of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Moves servos smoothly instead of letting them jump to a new angle:
+// a fixed-rate thread (initio_rate.h) drives each servo along a profile
+// limited in velocity and acceleration (accelerate, cruise, brake) and
+// writes the positions to the servo backend of the context
+// (initio_ctxSetServo) at that rate, only when they change.
+//
+// A motion is a sequence of keyframes per servo: move to an angle, then
+// hold it for a time. The calls return at once with an id of the motion,
+// which can be polled or waited for (initio_AnimWait). A new motion of a
+// servo replaces its current one, which then ends as cancelled;
+// initio_AnimCancel brakes a servo where it is. Servos of the animation
+// should not be set with initio_SetServo meanwhile.
+//
+// The library does not know where the servos are at the start: they are
+// assumed centred (0 degrees), like after initio_SetServo (servo, 0);
+// initio_AnimJump sets a known position without a profile.
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INITIO_ANIM_SERVOS 8     // logical servos 0..7 (servoPan, servoTilt, ...)
+
+// States of a motion (initio_AnimWait)
+#define INITIO_ANIM_RUNNING   0  // still moving or holding, or timeout
+#define INITIO_ANIM_DONE      1  // all keyframes reached and held
+#define INITIO_ANIM_CANCELLED 2  // cancelled or replaced by another motion
+#define INITIO_ANIM_INVALID  -1  // no such motion
+
+typedef struct {
+    double maxVel ;            // deg/s
+    double maxAcc ;            // deg/s^2
+    int8_t minDeg, maxDeg ;    // targets are clipped to this range
+} initio_animLimits ;
+
+typedef struct {
+    double hz ;                // update rate of the servo positions
+    initio_animLimits servo[INITIO_ANIM_SERVOS] ;
+} initio_animParams ;
+
+typedef struct {
+    int8_t degrees ;           // angle to move to
+    unsigned int holdMs ;      // time to stay there before the next keyframe
+} initio_animKey ;
+
+typedef struct {
+    unsigned long motions ;    // motions started
+    unsigned long done ;       // motions completed
+    unsigned long cancelled ;  // motions cancelled or replaced
+    unsigned long writes ;     // servo positions written
+    initio_rateStats rate ;    // timing of the update thread
+} initio_animStats ;
+
+typedef struct initio_anim initio_anim ;
+
+// initio_AnimDefaultParams (params):
+// Fills params with 50 updates/s, 180 deg/s, 720 deg/s^2 and the full
+// range -90..90 for all servos.
+void initio_AnimDefaultParams (initio_animParams *params) ;
+
+// initio_AnimStart (ctx, params):
+// Starts animating the servos of ctx (NULL: default context); params ==
+// NULL selects the defaults. Returns NULL on error.
+initio_anim *initio_AnimStart (initio_ctx *ctx, const initio_animParams *params) ;
+
+// initio_AnimStop (anim, stats):
+// Cancels all motions, leaves the servos where they are and frees anim.
+// If stats != NULL the final statistics are copied to it.
+void initio_AnimStop (initio_anim *anim, initio_animStats *stats) ;
+
+// initio_AnimPlay (anim, servo, keys, n):
+// Starts the n keyframes keys (copied) on servo, replacing its current
+// motion. Returns the id of the motion, 0 on error.
+unsigned long initio_AnimPlay (initio_anim *anim, int8_t servo, const initio_animKey *keys, int n) ;
+
+// initio_AnimMoveTo (anim, servo, degrees):
+// Starts a motion of servo to degrees; a single keyframe without hold.
+unsigned long initio_AnimMoveTo (initio_anim *anim, int8_t servo, int8_t degrees) ;
+
+// initio_AnimJump (anim, servo, degrees):
+// Cancels the motion of servo and sets it to degrees at once.
+void initio_AnimJump (initio_anim *anim, int8_t servo, int8_t degrees) ;
+
+// initio_AnimCancel (anim, servo):
+// Cancels the motion of servo; it brakes within its acceleration limit
+// and stays where it stopped.
+void initio_AnimCancel (initio_anim *anim, int8_t servo) ;
+
+// initio_AnimWait (anim, id, timeoutMs):
+// Waits up to timeoutMs (< 0: no timeout, 0: just poll) for the end of
+// motion id and returns its state (INITIO_ANIM_*). The state of motions
+// more than 64 motions of the same servo ago is reported as DONE.
+int initio_AnimWait (initio_anim *anim, unsigned long id, int timeoutMs) ;
+
+// initio_AnimPosition (anim, servo):
+// Returns the current position of servo in degrees.
+int initio_AnimPosition (initio_anim *anim, int8_t servo) ;
+
+// initio_AnimGetStats (anim, stats):
+// Copies counters and the timing of the update thread.
+void initio_AnimGetStats (initio_anim *anim, initio_animStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_ANIM_H_ */
@@ -0,0 +1,342 @@
+//======================================================================
+//
+// Behaviour engine (subsumption) of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "initio_behave.h"
+#include "initio_time.h"
+
+typedef struct {
+    initio_behaviour b ;
+    initio_behaveOutput out ;   // current output
+    double period ;             // in s
+    double release ;            // time the next run is due
+    double execSumUs ;
+    initio_behaveStats stats ;  // under statsMutex
+} behaviour_t ;
+
+struct initio_behave {
+    initio_ctx *ctx ;
+    initio_behaveParams params ;
+    behaviour_t behaviours[INITIO_BEHAVE_MAX] ;
+    int n ;
+    int order[INITIO_BEHAVE_MAX] ;  // indices by descending priority
+    unsigned int inputs ;           // inputs of all behaviours
+    initio_sonar *ownSonar ;        // started by the engine
+    unsigned long countLeft0, countRight0 ;
+    BOOL started ;                  // engine thread set up
+
+    // applied outputs, engine thread only
+    int winner ;                    // behaviour holding the motors, atomic
+    BOOL motorsKnown ;              // left/right have been written
+    int left, right ;
+    unsigned int servoKnown ;       // bits of the servos written
+    int8_t servo[INITIO_BEHAVE_SERVOS] ;
+
+    pthread_mutex_t statsMutex ;
+    initio_behaveEngineStats stats ;  // rate excluded, under statsMutex
+    initio_rate *rate ;
+} ;
+
+void initio_BehaveDefaultParams (initio_behaveParams *params)
+{
+    params->hz = 200 ;
+    params->rtPriority = 0 ;
+    params->sonar = NULL ;
+}
+
+// readInputs(): reads the inputs in mask
+static void readInputs (initio_behave *e, unsigned int mask, initio_behaveInputs *in)
+{
+    initio_ctx *ctx = e->ctx ;
+    initio_sonarReading r ;
+
+    in->sense = 0 ;
+    if ((mask & INITIO_SENSE_IRLEFT) && initio_ctxIrLeft (ctx))
+        in->sense |= INITIO_SENSE_IRLEFT ;
+    if ((mask & INITIO_SENSE_IRRIGHT) && initio_ctxIrRight (ctx))
+        in->sense |= INITIO_SENSE_IRRIGHT ;
+    if ((mask & INITIO_SENSE_LINELEFT) && initio_ctxIrLineLeft (ctx))
+        in->sense |= INITIO_SENSE_LINELEFT ;
+    if ((mask & INITIO_SENSE_LINERIGHT) && initio_ctxIrLineRight (ctx))
+        in->sense |= INITIO_SENSE_LINERIGHT ;
+    if ((mask & INITIO_SENSE_WHEELLEFT) && initio_ctxWheelSensorLeft (ctx))
+        in->sense |= INITIO_SENSE_WHEELLEFT ;
+    if ((mask & INITIO_SENSE_WHEELRIGHT) && initio_ctxWheelSensorRight (ctx))
+        in->sense |= INITIO_SENSE_WHEELRIGHT ;
+    if ((mask & INITIO_BEHAVE_SONAR) && initio_SonarGet (e->params.sonar, &r) > 0)
+    {
+        in->cm = r.cm ;
+        in->sonarTime = r.time ;
+    }
+    if (mask & INITIO_BEHAVE_WHEELCOUNT)
+    {
+        in->countLeft = initio_ctxWheelCountLeft (ctx) - e->countLeft0 ;
+        in->countRight = initio_ctxWheelCountRight (ctx) - e->countRight0 ;
+    }
+}
+
+// maskInputs(): the inputs of in that behaviour b declared, the others 0
+static void maskInputs (const behaviour_t *b, const initio_behaveInputs *in, initio_behaveInputs *view)
+{
+    unsigned int inputs = b->b.inputs ;
+
+    *view = *in ;
+    view->sense &= inputs ;
+    if (!(inputs & INITIO_BEHAVE_SONAR))
+    {
+        view->cm = 0 ;
+        view->sonarTime = 0 ;
+    }
+    if (!(inputs & INITIO_BEHAVE_WHEELCOUNT))
+    {
+        view->countLeft = 0 ;
+        view->countRight = 0 ;
+    }
+}
+
+// arbitrate(): writes the outputs of the claiming behaviours of highest
+// priority, where they changed
+static void arbitrate (initio_behave *e)
+{
+    behaviour_t *b ;
+    unsigned long motorWrites = 0, servoWrites = 0, switches = 0 ;
+    int k, s, winner = -1 ;
+
+    for (k = 0; k < e->n && winner < 0; k++)
+        if (e->behaviours[e->order[k]].out.claim & INITIO_BEHAVE_MOTORS)
+            winner = e->order[k] ;
+    if (winner >= 0)
+    {
+        b = &e->behaviours[winner] ;
+        if (!e->motorsKnown || b->out.left != e->left || b->out.right != e->right)
+        {
+            initio_ctxSetMotors (e->ctx, b->out.left, b->out.right) ;
+            e->left = b->out.left ;
+            e->right = b->out.right ;
+            e->motorsKnown = TRUE ;
+            motorWrites++ ;
+        }
+    }
+    else if (!e->motorsKnown || e->left != 0 || e->right != 0)
+    {
+        initio_ctxStop (e->ctx) ;
+        e->left = e->right = 0 ;
+        e->motorsKnown = TRUE ;
+        motorWrites++ ;
+    }
+    if (winner != e->winner)
+    {
+        __atomic_store_n (&e->winner, winner, __ATOMIC_RELAXED) ;
+        switches++ ;
+    }
+
+    for (s = 0; s < INITIO_BEHAVE_SERVOS; s++)
+    {
+        for (k = 0, b = NULL; k < e->n && b == NULL; k++)
+            if (e->behaviours[e->order[k]].out.claim & INITIO_BEHAVE_SERVO(s))
+                b = &e->behaviours[e->order[k]] ;
+        if (b == NULL)
+            e->servoKnown &= ~(1u << s) ;  // unclaimed servos stay where they are
+        else if (!(e->servoKnown & (1u << s)) || b->out.servo[s] != e->servo[s])
+        {
+            initio_ctxSetServo (e->ctx, s, b->out.servo[s]) ;
+            e->servo[s] = b->out.servo[s] ;
+            e->servoKnown |= 1u << s ;
+            servoWrites++ ;
+        }
+    }
+
+    pthread_mutex_lock (&e->statsMutex) ;
+    if (winner >= 0)
+        e->behaviours[winner].stats.wins++ ;
+    e->stats.motorWrites += motorWrites ;
+    e->stats.servoWrites += servoWrites ;
+    e->stats.switches += switches ;
+    pthread_mutex_unlock (&e->statsMutex) ;
+}
+
+static BOOL engineCycle (void *arg)
+{
+    initio_behave *e = arg ;
+    initio_behaveInputs in, view ;
+    struct sched_param sp ;
+    behaviour_t *b ;
+    double t = initio_Now (), slack = 0.5 / e->params.hz, start, end, execUs ;
+    unsigned int due = 0, mask = 0 ;
+    unsigned long misses ;
+    int k ;
+
+    if (!e->started)
+    {
+        if (e->params.rtPriority > 0)
+        {
+            sp.sched_priority = e->params.rtPriority ;
+            k = pthread_setschedparam (pthread_self (), SCHED_FIFO, &sp) ;
+            pthread_mutex_lock (&e->statsMutex) ;
+            e->stats.realtime = (k == 0) ;
+            pthread_mutex_unlock (&e->statsMutex) ;
+        }
+        for (k = 0; k < e->n; k++)
+            e->behaviours[k].release = t ;
+        e->started = TRUE ;
+    }
+
+    for (k = 0; k < e->n; k++)
+        if (t >= e->behaviours[k].release - slack)
+        {
+            due |= 1u << k ;
+            mask |= e->behaviours[k].b.inputs ;
+        }
+    if (due == 0)
+        return TRUE ;
+    memset (&in, 0, sizeof(in)) ;
+    in.time = t ;
+    readInputs (e, mask, &in) ;
+
+    for (k = 0; k < e->n; k++)
+    {
+        b = &e->behaviours[e->order[k]] ;
+        if (!(due & (1u << e->order[k])))
+            continue ;
+        maskInputs (b, &in, &view) ;  // in holds the inputs of all due behaviours
+        start = initio_Now () ;
+        b->b.func (b->b.arg, &view, &b->out) ;
+        end = initio_Now () ;
+        execUs = (end - start) * 1e6 ;
+        misses = (end > b->release + b->period) ? 1 : 0 ;
+        b->release += b->period ;
+        while (b->release + b->period <= end)  // a whole period skipped
+        {
+            b->release += b->period ;
+            misses++ ;
+        }
+        b->execSumUs += execUs ;
+        pthread_mutex_lock (&e->statsMutex) ;
+        b->stats.runs++ ;
+        b->stats.misses += misses ;
+        b->stats.execAvgUs = b->execSumUs / b->stats.runs ;
+        if (execUs > b->stats.execMaxUs)
+            b->stats.execMaxUs = execUs ;
+        pthread_mutex_unlock (&e->statsMutex) ;
+    }
+    arbitrate (e) ;
+    return TRUE ;
+}
+
+initio_behave *initio_BehaveStart (initio_ctx *ctx, const initio_behaveParams *params,
+                                   const initio_behaviour *behaviours, int n)
+{
+    initio_behave *e ;
+    int i, k ;
+
+    if (n < 1 || n > INITIO_BEHAVE_MAX)
+        return NULL ;
+    e = calloc (1, sizeof(initio_behave)) ;
+    if (e == NULL)
+        return NULL ;
+    e->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    if (params != NULL)
+        e->params = *params ;
+    else
+        initio_BehaveDefaultParams (&e->params) ;
+    if (e->params.hz <= 0)
+    {
+        free (e) ;
+        return NULL ;
+    }
+    e->n = n ;
+    e->winner = -1 ;
+    for (i = 0; i < n; i++)
+    {
+        e->behaviours[i].b = behaviours[i] ;
+        e->behaviours[i].period = 1.0 / e->params.hz ;
+        if (behaviours[i].hz > 0 && 1.0 / behaviours[i].hz > e->behaviours[i].period)
+            e->behaviours[i].period = 1.0 / behaviours[i].hz ;
+        e->inputs |= behaviours[i].inputs ;
+        // insertion into the priority order, stable for equal priorities
+        for (k = i; k > 0 && e->behaviours[e->order[k - 1]].b.priority < behaviours[i].priority; k--)
+            e->order[k] = e->order[k - 1] ;
+        e->order[k] = i ;
+    }
+
+    if ((e->inputs & INITIO_BEHAVE_SONAR) && e->params.sonar == NULL)
+    {
+        e->ownSonar = e->params.sonar = initio_SonarStart (e->ctx, NULL) ;
+        if (e->ownSonar == NULL)
+        {
+            free (e) ;
+            return NULL ;
+        }
+    }
+    if (e->inputs & INITIO_BEHAVE_WHEELCOUNT)
+    {
+        initio_ctxWheelCountStart (e->ctx) ;
+        e->countLeft0 = initio_ctxWheelCountLeft (e->ctx) ;
+        e->countRight0 = initio_ctxWheelCountRight (e->ctx) ;
+    }
+    pthread_mutex_init (&e->statsMutex, NULL) ;
+
+    e->rate = initio_RateStart (e->params.hz, engineCycle, e) ;
+    if (e->rate == NULL)
+    {
+        if (e->ownSonar != NULL)
+            initio_SonarStop (e->ownSonar, NULL) ;
+        pthread_mutex_destroy (&e->statsMutex) ;
+        free (e) ;
+        return NULL ;
+    }
+    return e ;
+}
+
+void initio_BehaveStop (initio_behave *engine, initio_behaveStats *stats, initio_behaveEngineStats *engineStats)
+{
+    initio_rateStats rs ;
+    int i ;
+
+    initio_RateStop (engine->rate, &rs) ;
+    initio_ctxStop (engine->ctx) ;
+    if (engine->ownSonar != NULL)
+        initio_SonarStop (engine->ownSonar, NULL) ;
+    if (stats != NULL)
+        for (i = 0; i < engine->n; i++)
+            stats[i] = engine->behaviours[i].stats ;
+    if (engineStats != NULL)
+    {
+        *engineStats = engine->stats ;
+        engineStats->rate = rs ;
+    }
+    pthread_mutex_destroy (&engine->statsMutex) ;
+    free (engine) ;
+}
+
+int initio_BehaveWinner (initio_behave *engine)
+{
+    return __atomic_load_n (&engine->winner, __ATOMIC_RELAXED) ;
+}
+
+void initio_BehaveGetStats (initio_behave *engine, int index, initio_behaveStats *stats)
+{
+    pthread_mutex_lock (&engine->statsMutex) ;
+    *stats = engine->behaviours[index].stats ;
+    pthread_mutex_unlock (&engine->statsMutex) ;
+}
+
+void initio_BehaveGetEngineStats (initio_behave *engine, initio_behaveEngineStats *stats)
+{
+    pthread_mutex_lock (&engine->statsMutex) ;
+    *stats = engine->stats ;
+    pthread_mutex_unlock (&engine->statsMutex) ;
+    initio_RateGetStats (engine->rate, &stats->rate) ;
+}
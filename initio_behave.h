@@ -0,0 +1,131 @@
+#ifndef _4TRONIX_INITIO_BEHAVE_H_
+#define _4TRONIX_INITIO_BEHAVE_H_
+//======================================================================
+//
+// Behaviour engine (subsumption) of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Runs a set of behaviours (e.g. wander, follow a line, avoid obstacles)
+// from one fixed-rate thread (initio_rate.h). Each behaviour declares its
+// rate, the inputs it reads and its priority. In every cycle of the
+// engine the due behaviours get the inputs they declared and set their
+// output: the motor duties and servo positions they want, or nothing.
+// An output holds until the behaviour runs again. Per actuator (motors,
+// each servo) the claiming behaviour of highest priority wins and only
+// its value is written, and only when it changes; when no behaviour
+// claims the motors they are stopped.
+//
+// A behaviour misses its deadline when it finishes later than one period
+// after it was due, or when the engine skips a whole period of it.
+// Behaviours must not block: the sonar is read from a ping scheduler
+// (initio_sonar.h), not pinged by the engine.
+//
+//======================================================================
+
+#include <stdint.h>
+#include "initio.h"
+#include "initio_rate.h"
+#include "initio_sonar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INITIO_BEHAVE_MAX     16   // behaviours per engine
+#define INITIO_BEHAVE_SERVOS  8    // servos an output can claim
+
+// Inputs of a behaviour: INITIO_SENSE_* bits and
+#define INITIO_BEHAVE_SONAR      0x40  // latest sonar range
+#define INITIO_BEHAVE_WHEELCOUNT 0x80  // wheel pulse counts
+
+// Claims of an output
+#define INITIO_BEHAVE_MOTORS     0x01
+#define INITIO_BEHAVE_SERVO(n)   (0x02 << (n))
+
+typedef struct {
+    double time ;              // CLOCK_MONOTONIC time of the engine cycle in s
+    unsigned int sense ;       // INITIO_SENSE_* bits, declared inputs only
+    unsigned int cm ;          // latest sonar range, 0 == no object (or not declared)
+    double sonarTime ;         // time of that ping in s, 0: none yet (or not declared)
+    unsigned long countLeft ;  // wheel pulses since the engine started, 0 if not declared
+    unsigned long countRight ;
+} initio_behaveInputs ;
+
+typedef struct {
+    unsigned int claim ;                   // INITIO_BEHAVE_MOTORS | INITIO_BEHAVE_SERVO(n), 0: inactive
+    int left, right ;                      // signed duties as initio_ctxSetMotors
+    int8_t servo[INITIO_BEHAVE_SERVOS] ;   // degrees as initio_ctxSetServo
+} initio_behaveOutput ;
+
+// Behaviour function: out holds the previous output of the behaviour
+typedef void (*initio_behaveFunc)(void *arg, const initio_behaveInputs *in, initio_behaveOutput *out) ;
+
+typedef struct {
+    const char *name ;
+    int priority ;             // higher subsumes lower
+    double hz ;                // run rate, at most the engine rate
+    unsigned int inputs ;      // INITIO_SENSE_* | INITIO_BEHAVE_SONAR | INITIO_BEHAVE_WHEELCOUNT
+    initio_behaveFunc func ;
+    void *arg ;
+} initio_behaviour ;
+
+typedef struct {
+    double hz ;                // engine rate
+    int rtPriority ;           // SCHED_FIFO priority of the engine thread, 0: normal scheduling
+    initio_sonar *sonar ;      // range source, NULL: own ping scheduler if a behaviour reads the sonar
+} initio_behaveParams ;
+
+typedef struct {
+    unsigned long runs ;
+    unsigned long misses ;     // deadline misses
+    unsigned long wins ;       // engine cycles in which it held the motors
+    double execAvgUs ;         // time spent in the behaviour function
+    double execMaxUs ;
+} initio_behaveStats ;
+
+typedef struct {
+    initio_rateStats rate ;    // timing of the engine thread
+    unsigned long motorWrites ;
+    unsigned long servoWrites ;
+    unsigned long switches ;   // changes of the behaviour holding the motors
+    BOOL realtime ;            // rtPriority was granted
+} initio_behaveEngineStats ;
+
+typedef struct initio_behave initio_behave ;
+
+// initio_BehaveDefaultParams (params):
+// Fills params with 200 cycles/s, normal scheduling and an own sonar.
+void initio_BehaveDefaultParams (initio_behaveParams *params) ;
+
+// initio_BehaveStart (ctx, params, behaviours, n):
+// Starts the engine on ctx (NULL: default context) with n behaviours
+// (copied). params == NULL selects the defaults. Returns NULL on error.
+initio_behave *initio_BehaveStart (initio_ctx *ctx, const initio_behaveParams *params,
+                                   const initio_behaviour *behaviours, int n) ;
+
+// initio_BehaveStop (engine, stats, engineStats):
+// Stops the engine and the motors and frees engine. The final statistics
+// are copied to stats (n entries, in the order of the behaviours) and
+// engineStats if not NULL.
+void initio_BehaveStop (initio_behave *engine, initio_behaveStats *stats, initio_behaveEngineStats *engineStats) ;
+
+// initio_BehaveWinner (engine):
+// Returns the index of the behaviour holding the motors, -1: none.
+int initio_BehaveWinner (initio_behave *engine) ;
+
+// initio_BehaveGetStats (engine, index, stats):
+// Copies the statistics of behaviour index.
+void initio_BehaveGetStats (initio_behave *engine, int index, initio_behaveStats *stats) ;
+
+// initio_BehaveGetEngineStats (engine, stats):
+// Copies the statistics of the engine.
+void initio_BehaveGetEngineStats (initio_behave *engine, initio_behaveEngineStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_BEHAVE_H_ */
@@ -0,0 +1,289 @@
+//======================================================================
+//
+// Sensor cache of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "initio_cache.h"
+#include "initio_seqlock.h"
+#include "initio_time.h"
+
+struct initio_cache {
+    initio_ctx *ctx ;
+    initio_cacheParams params ;
+    initio_rate *rate ;        // refresher, NULL: none
+
+    // latest values, published by whoever refreshes
+    initio_seqlock lock ;
+    initio_cacheValues shared ;
+    pthread_mutex_t publishMutex ;  // serialises the writers of shared
+    initio_cacheValues latest ;     // writers' copy of shared
+
+    pthread_mutex_t senseMutex ;    // one digital refresh at a time
+    pthread_mutex_t sonarMutex ;    // one ping at a time
+
+    initio_cacheStats stats ;       // counters, atomic
+
+    // refresher thread only
+    double hz, sonarHz ;            // current rates
+    unsigned long cycles ;
+    unsigned long cyclePings ;      // pings by the refresher
+    double pingCpuUs ;              // CPU time of these pings
+    double skippedCycles ;          // cycles and pings fewer than at the max rates
+    double skippedPings ;
+    pthread_mutex_t statsMutex ;    // protects the rates and CPU times of stats
+} ;
+
+static double threadCpuUs (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) ;
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3 ;
+}
+
+static void count (unsigned long *counter)
+{
+    __atomic_add_fetch (counter, 1, __ATOMIC_RELAXED) ;
+}
+
+void initio_CacheDefaultParams (initio_cacheParams *params)
+{
+    params->hz = 200 ;
+    params->sonarHz = 10 ;
+    params->maxHz = 0 ;
+    params->sonarMaxHz = 0 ;
+}
+
+// refreshSense(): reads the digital inputs and publishes them, unless
+// another thread has done so since time 'since'; returns the bits
+static unsigned int refreshSense (initio_cache *cache, double since)
+{
+    initio_ctx *ctx = cache->ctx ;
+    unsigned int sense ;
+    double t ;
+
+    pthread_mutex_lock (&cache->senseMutex) ;
+    if (cache->latest.senseTime > since)  // refreshed while waiting
+    {
+        sense = cache->latest.sense ;
+        pthread_mutex_unlock (&cache->senseMutex) ;
+        return sense ;
+    }
+    t = initio_Now () ;
+    sense = (initio_ctxIrLeft (ctx) ? INITIO_SENSE_IRLEFT : 0)
+          | (initio_ctxIrRight (ctx) ? INITIO_SENSE_IRRIGHT : 0)
+          | (initio_ctxIrLineLeft (ctx) ? INITIO_SENSE_LINELEFT : 0)
+          | (initio_ctxIrLineRight (ctx) ? INITIO_SENSE_LINERIGHT : 0)
+          | (initio_ctxWheelSensorLeft (ctx) ? INITIO_SENSE_WHEELLEFT : 0)
+          | (initio_ctxWheelSensorRight (ctx) ? INITIO_SENSE_WHEELRIGHT : 0) ;
+    pthread_mutex_lock (&cache->publishMutex) ;
+    cache->latest.sense = sense ;
+    cache->latest.senseTime = t ;
+    initio_SeqWrite (&cache->lock, &cache->shared, &cache->latest, sizeof(initio_cacheValues)) ;
+    pthread_mutex_unlock (&cache->publishMutex) ;
+    pthread_mutex_unlock (&cache->senseMutex) ;
+    count (&cache->stats.refreshes) ;
+    return sense ;
+}
+
+// refreshSonar(): pings and publishes the range, unless another thread
+// has pinged since time 'since'; returns the range
+static unsigned int refreshSonar (initio_cache *cache, double since)
+{
+    unsigned int cm ;
+    double t ;
+
+    pthread_mutex_lock (&cache->sonarMutex) ;
+    if (cache->latest.sonarTime > since)
+    {
+        cm = cache->latest.cm ;
+        pthread_mutex_unlock (&cache->sonarMutex) ;
+        return cm ;
+    }
+    t = initio_Now () ;
+    cm = initio_ctxUsGetDistance (cache->ctx) ;
+    pthread_mutex_lock (&cache->publishMutex) ;
+    cache->latest.cm = cm ;
+    cache->latest.sonarTime = t ;
+    initio_SeqWrite (&cache->lock, &cache->shared, &cache->latest, sizeof(initio_cacheValues)) ;
+    pthread_mutex_unlock (&cache->publishMutex) ;
+    pthread_mutex_unlock (&cache->sonarMutex) ;
+    count (&cache->stats.pings) ;
+    return cm ;
+}
+
+// refresherCycle(): digital inputs every cycle, the sonar when due; then
+// the rates for the current speed
+static BOOL refresherCycle (void *arg)
+{
+    initio_cache *cache = arg ;
+    const initio_cacheParams *p = &cache->params ;
+    double maxHz = (p->maxHz > p->hz) ? p->maxHz : p->hz ;
+    double sonarMaxHz = (p->sonarMaxHz > p->sonarHz) ? p->sonarMaxHz : p->sonarHz ;
+    double t = initio_Now (), cpu, saved ;
+    initio_cacheValues v ;
+    initio_rate *rate ;
+    unsigned long pings ;
+    int left, right ;
+
+    refreshSense (cache, t) ;
+    cache->cycles++ ;
+    cache->skippedCycles += maxHz / cache->hz - 1 ;  // a cycle at hz stands for maxHz/hz at maxHz
+    if (cache->sonarHz > 0)
+    {
+        initio_SeqRead (&cache->lock, &v, &cache->shared, sizeof(v)) ;
+        if (t - v.sonarTime >= 1.0 / cache->sonarHz)
+        {
+            pings = __atomic_load_n (&cache->stats.pings, __ATOMIC_RELAXED) ;
+            cpu = threadCpuUs () ;
+            refreshSonar (cache, v.sonarTime) ;
+            if (__atomic_load_n (&cache->stats.pings, __ATOMIC_RELAXED) != pings)
+            {
+                cache->pingCpuUs += threadCpuUs () - cpu ;
+                cache->cyclePings++ ;
+                cache->skippedPings += sonarMaxHz / cache->sonarHz - 1 ;
+            }
+        }
+    }
+
+    // rates: linear in the larger duty between the rest and the max rates
+    if (maxHz > p->hz || sonarMaxHz > p->sonarHz)
+    {
+        double f ;
+
+        initio_ctxGetMotors (cache->ctx, &left, &right) ;
+        f = ((abs (left) > abs (right)) ? abs (left) : abs (right)) / 100.0 ;
+        cache->sonarHz = p->sonarHz + (sonarMaxHz - p->sonarHz) * f ;
+        rate = __atomic_load_n (&cache->rate, __ATOMIC_ACQUIRE) ;
+        if (rate != NULL)  // NULL in the first cycle, before initio_RateStart returned
+        {
+            cache->hz = p->hz + (maxHz - p->hz) * f ;
+            initio_RateSetHz (rate, cache->hz) ;
+        }
+    }
+
+    // CPU time saved: the skipped cycles and pings at the CPU time they
+    // cost on average
+    cpu = threadCpuUs () ;
+    saved = cache->skippedCycles * (cpu - cache->pingCpuUs) / cache->cycles ;
+    if (cache->cyclePings > 0)
+        saved += cache->skippedPings * cache->pingCpuUs / cache->cyclePings ;
+    pthread_mutex_lock (&cache->statsMutex) ;
+    cache->stats.hz = cache->hz ;
+    cache->stats.sonarHz = cache->sonarHz ;
+    cache->stats.cpuUs = cpu ;
+    cache->stats.savedCpuUs = saved ;
+    pthread_mutex_unlock (&cache->statsMutex) ;
+    return TRUE ;
+}
+
+initio_cache *initio_CacheStart (initio_ctx *ctx, const initio_cacheParams *params)
+{
+    initio_cache *cache = calloc (1, sizeof(initio_cache)) ;
+
+    if (cache == NULL)
+        return NULL ;
+    cache->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    if (params != NULL)
+        cache->params = *params ;
+    else
+        initio_CacheDefaultParams (&cache->params) ;
+    pthread_mutex_init (&cache->publishMutex, NULL) ;
+    pthread_mutex_init (&cache->senseMutex, NULL) ;
+    pthread_mutex_init (&cache->sonarMutex, NULL) ;
+    pthread_mutex_init (&cache->statsMutex, NULL) ;
+
+    if (cache->params.hz > 0)
+    {
+        cache->hz = cache->params.hz ;
+        cache->sonarHz = cache->params.sonarHz ;
+        __atomic_store_n (&cache->rate, initio_RateStart (cache->params.hz, refresherCycle, cache), __ATOMIC_RELEASE) ;
+        if (cache->rate == NULL)
+        {
+            initio_CacheStop (cache, NULL) ;
+            return NULL ;
+        }
+    }
+    return cache ;
+}
+
+void initio_CacheStop (initio_cache *cache, initio_cacheStats *stats)
+{
+    initio_rateStats rs = { 0 } ;
+
+    if (cache->rate != NULL)
+        initio_RateStop (cache->rate, &rs) ;
+    if (stats != NULL)
+    {
+        *stats = cache->stats ;
+        stats->rate = rs ;
+    }
+    pthread_mutex_destroy (&cache->publishMutex) ;
+    pthread_mutex_destroy (&cache->senseMutex) ;
+    pthread_mutex_destroy (&cache->sonarMutex) ;
+    pthread_mutex_destroy (&cache->statsMutex) ;
+    free (cache) ;
+}
+
+void initio_CacheGet (initio_cache *cache, initio_cacheValues *values)
+{
+    initio_SeqRead (&cache->lock, values, &cache->shared, sizeof(initio_cacheValues)) ;
+}
+
+unsigned int initio_CacheSense (initio_cache *cache, double maxAge)
+{
+    initio_cacheValues v ;
+
+    initio_SeqRead (&cache->lock, &v, &cache->shared, sizeof(v)) ;
+    if (v.senseTime > 0 && (maxAge < 0 || initio_Now () - v.senseTime <= maxAge))
+    {
+        count (&cache->stats.hits) ;
+        return v.sense ;
+    }
+    count (&cache->stats.misses) ;
+    return refreshSense (cache, v.senseTime) ;
+}
+
+unsigned int initio_CacheUsGetDistance (initio_cache *cache, double maxAge)
+{
+    initio_cacheValues v ;
+
+    initio_SeqRead (&cache->lock, &v, &cache->shared, sizeof(v)) ;
+    if (v.sonarTime > 0 && (maxAge < 0 || initio_Now () - v.sonarTime <= maxAge))
+    {
+        count (&cache->stats.sonarHits) ;
+        return v.cm ;
+    }
+    count (&cache->stats.sonarMisses) ;
+    return refreshSonar (cache, v.sonarTime) ;
+}
+
+void initio_CacheGetStats (initio_cache *cache, initio_cacheStats *stats)
+{
+    stats->hits = __atomic_load_n (&cache->stats.hits, __ATOMIC_RELAXED) ;
+    stats->misses = __atomic_load_n (&cache->stats.misses, __ATOMIC_RELAXED) ;
+    stats->sonarHits = __atomic_load_n (&cache->stats.sonarHits, __ATOMIC_RELAXED) ;
+    stats->sonarMisses = __atomic_load_n (&cache->stats.sonarMisses, __ATOMIC_RELAXED) ;
+    stats->refreshes = __atomic_load_n (&cache->stats.refreshes, __ATOMIC_RELAXED) ;
+    stats->pings = __atomic_load_n (&cache->stats.pings, __ATOMIC_RELAXED) ;
+    pthread_mutex_lock (&cache->statsMutex) ;
+    stats->hz = cache->stats.hz ;
+    stats->sonarHz = cache->stats.sonarHz ;
+    stats->cpuUs = cache->stats.cpuUs ;
+    stats->savedCpuUs = cache->stats.savedCpuUs ;
+    pthread_mutex_unlock (&cache->statsMutex) ;
+    if (cache->rate != NULL)
+        initio_RateGetStats (cache->rate, &stats->rate) ;
+    else
+        memset (&stats->rate, 0, sizeof(stats->rate)) ;
+}
@@ -0,0 +1,146 @@
+#ifndef _4TRONIX_INITIO_CACHE_H_
+#define _4TRONIX_INITIO_CACHE_H_
+//======================================================================
+//
+// Sensor cache of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Keeps the latest values of all sensors of a context with their time
+// stamps: the six digital inputs (INITIO_SENSE_* bits) and the sonar
+// range. A refresher thread (initio_rate.h) reads the digital inputs at a
+// fixed rate and pings the sonar at a lower one, and publishes the values
+// through a sequence lock (initio_seqlock.h), so any number of threads
+// read them lock-free instead of reading the pins over and over.
+//
+// Each read passes the largest age acceptable to the caller. A value
+// that is older is refreshed synchronously by the reader (a miss);
+// concurrent misses are served by one refresh. Without a refresher
+// thread (hz == 0) the cache only refreshes on misses.
+// A sonar ping blocks the digital refresh of the thread doing it for up
+// to the echo time of the range limit.
+//
+// With maxHz/sonarMaxHz set, the refresher adapts its rates to the speed:
+// hz and sonarHz apply at rest and grow linearly with the larger commanded
+// motor duty (initio_ctxGetMotors, set by every motor function) up to the
+// max rates at duty 100. A parked robot so costs little CPU, and a fast
+// one sees its sensors more often; a change of speed takes effect after
+// the current refresh period. The statistics give the current rates, the
+// CPU time of the refresher and an estimate of the CPU time saved against
+// refreshing at the max rates all the time.
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    double hz ;                // refresh rate of the digital inputs (at rest), 0: on misses only
+    double sonarHz ;           // ping rate of the refresher (at rest), 0: on misses only
+    double maxHz ;             // refresh rate at duty 100, 0: fixed at hz
+    double sonarMaxHz ;        // ping rate at duty 100, 0: fixed at sonarHz
+} initio_cacheParams ;
+
+typedef struct {
+    unsigned int sense ;       // INITIO_SENSE_* bits
+    double senseTime ;         // CLOCK_MONOTONIC time of the digital inputs in s, 0: never read
+    unsigned int cm ;          // sonar range as initio_UsGetDistance, 0 == no object
+    double sonarTime ;         // CLOCK_MONOTONIC time of the ping in s, 0: never pinged
+} initio_cacheValues ;
+
+typedef struct {
+    unsigned long hits ;       // digital reads served from the cache
+    unsigned long misses ;     // digital reads that found the values too old
+    unsigned long sonarHits ;  // sonar reads served from the cache
+    unsigned long sonarMisses ;
+    unsigned long refreshes ;  // digital refreshes (refresher and misses)
+    unsigned long pings ;      // sonar pings (refresher and misses)
+    double hz ;                // current refresh rate of the refresher
+    double sonarHz ;           // current ping rate of the refresher
+    double cpuUs ;             // CPU time of the refresher thread
+    double savedCpuUs ;        // estimated CPU time saved against the max rates
+    initio_rateStats rate ;    // timing of the refresher thread (rate.rateHz: average)
+} initio_cacheStats ;
+
+typedef struct initio_cache initio_cache ;
+
+// initio_CacheDefaultParams (params):
+// Fills params with 200 digital refreshes/s and 10 pings/s, independent
+// of the speed.
+void initio_CacheDefaultParams (initio_cacheParams *params) ;
+
+// initio_CacheStart (ctx, params):
+// Creates a cache of the sensors of ctx (NULL: default context) and starts
+// its refresher. params == NULL selects the defaults. Returns NULL on error.
+initio_cache *initio_CacheStart (initio_ctx *ctx, const initio_cacheParams *params) ;
+
+// initio_CacheStop (cache, stats):
+// Stops the refresher and frees cache. If stats != NULL the final
+// statistics are copied to it.
+void initio_CacheStop (initio_cache *cache, initio_cacheStats *stats) ;
+
+// initio_CacheGet (cache, values):
+// Copies the latest values, whatever their age; lock-free.
+void initio_CacheGet (initio_cache *cache, initio_cacheValues *values) ;
+
+// initio_CacheSense (cache, maxAge):
+// Returns the INITIO_SENSE_* bits, read at most maxAge s ago (refreshed
+// first if older; maxAge < 0: any age).
+unsigned int initio_CacheSense (initio_cache *cache, double maxAge) ;
+
+// initio_CacheUsGetDistance (cache, maxAge):
+// Returns the sonar range in cm, pinged at most maxAge s ago (pinged
+// first if older; maxAge < 0: any age).
+unsigned int initio_CacheUsGetDistance (initio_cache *cache, double maxAge) ;
+
+// initio_CacheGetStats (cache, stats):
+// Copies the counters and the timing of the refresher.
+void initio_CacheGetStats (initio_cache *cache, initio_cacheStats *stats) ;
+
+// Cached variants of the sensor functions
+static inline BOOL initio_CacheIrLeft (initio_cache *cache, double maxAge)
+{
+    return (initio_CacheSense (cache, maxAge) & INITIO_SENSE_IRLEFT) != 0 ;
+}
+
+static inline BOOL initio_CacheIrRight (initio_cache *cache, double maxAge)
+{
+    return (initio_CacheSense (cache, maxAge) & INITIO_SENSE_IRRIGHT) != 0 ;
+}
+
+static inline BOOL initio_CacheIrAll (initio_cache *cache, double maxAge)
+{
+    return (initio_CacheSense (cache, maxAge) & (INITIO_SENSE_IRLEFT | INITIO_SENSE_IRRIGHT)) != 0 ;
+}
+
+static inline BOOL initio_CacheIrLineLeft (initio_cache *cache, double maxAge)
+{
+    return (initio_CacheSense (cache, maxAge) & INITIO_SENSE_LINELEFT) != 0 ;
+}
+
+static inline BOOL initio_CacheIrLineRight (initio_cache *cache, double maxAge)
+{
+    return (initio_CacheSense (cache, maxAge) & INITIO_SENSE_LINERIGHT) != 0 ;
+}
+
+static inline BOOL initio_CacheWheelSensorLeft (initio_cache *cache, double maxAge)
+{
+    return (initio_CacheSense (cache, maxAge) & INITIO_SENSE_WHEELLEFT) != 0 ;
+}
+
+static inline BOOL initio_CacheWheelSensorRight (initio_cache *cache, double maxAge)
+{
+    return (initio_CacheSense (cache, maxAge) & INITIO_SENSE_WHEELRIGHT) != 0 ;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_CACHE_H_ */
@@ -0,0 +1,574 @@
+#ifndef _4TRONIX_INITIO_CO_HPP_
+#define _4TRONIX_INITIO_CO_HPP_
+//======================================================================
+//
+// C++20 coroutine layer for the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Header-only; compile with a C++20 compiler:
+// g++ -std=c++20 -o myprog myprog.cpp -linitio -lwiringPi -lpthread
+//
+// Behaviours are written as coroutines returning initio::Task<> and run
+// on a single-threaded initio::Executor. The executor sleeps in ppoll()
+// until the next timer expires or a GPIO event arrives; GPIO events are
+// delivered by wiringPiISR() handlers through a pipe. The only extra
+// threads are the wiringPi interrupt threads (one per watched pin) and
+// one sonar thread shared by all behaviours, so any number of concurrent
+// behaviours costs no additional threads.
+//
+//   initio::Task<> avoid (initio::Robot &robot)
+//   {
+//       for (;;) {
+//           if (co_await robot.ir_edge(initio::Left))  // obstacle appeared
+//               robot.spin_right(40) ;
+//           co_await robot.sleep(20ms) ;
+//       }
+//   }
+//
+// Events are posted to a non-blocking pipe, so an interrupt thread never
+// blocks. If the loop stalls until the pipe is full, further edge and
+// wheel events are dropped and counted (Executor::dropped()).
+//
+// Thread-safety: Executor and Robot must only be used from the thread
+// calling Executor::run(), except Executor::post() which may be called
+// from any thread. Only one Robot may exist per process, as wiringPi
+// interrupt handlers are process-wide.
+//
+//======================================================================
+
+#include <coroutine>
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <vector>
+#include <unordered_set>
+#include <optional>
+#include <functional>
+#include <exception>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "initio.h"
+
+namespace initio {
+
+using Clock = std::chrono::steady_clock ;
+
+enum Side { Left, Right, Both } ;
+
+class Executor ;
+template <typename T = void> class Task ;
+
+
+//======================================================================
+// Task<T>: lazily started coroutine, awaitable from other coroutines or
+// spawned as a detached behaviour via Executor::spawn().
+
+namespace detail {
+
+struct PromiseBase
+{
+    std::coroutine_handle<> continuation ;  // coroutine awaiting this task
+    Executor *executor = nullptr ;         // set for detached (spawned) tasks
+    std::exception_ptr error ;
+
+    std::suspend_always initial_suspend () noexcept { return {} ; }
+    void unhandled_exception () noexcept { error = std::current_exception () ; }
+} ;
+
+template <typename T>
+struct Promise : PromiseBase
+{
+    std::optional<T> value ;
+    void return_value (T v) { value = std::move (v) ; }
+    T result () { if (error) std::rethrow_exception (error) ; return std::move (*value) ; }
+} ;
+
+template <>
+struct Promise<void> : PromiseBase
+{
+    void return_void () noexcept {}
+    void result () { if (error) std::rethrow_exception (error) ; }
+} ;
+
+} // namespace detail
+
+template <typename T>
+class Task
+{
+public:
+    struct promise_type ;
+    using Handle = std::coroutine_handle<promise_type> ;
+
+    struct FinalAwaiter
+    {
+        bool await_ready () noexcept { return false ; }
+        std::coroutine_handle<> await_suspend (Handle h) noexcept ;
+        void await_resume () noexcept {}
+    } ;
+
+    struct promise_type : detail::Promise<T>
+    {
+        Task get_return_object () { return Task (Handle::from_promise (*this)) ; }
+        FinalAwaiter final_suspend () noexcept { return {} ; }
+    } ;
+
+    Task (Task &&other) noexcept : h (std::exchange (other.h, nullptr)) {}
+    Task &operator= (Task &&other) noexcept
+    {
+        if (this != &other) { if (h) h.destroy () ; h = std::exchange (other.h, nullptr) ; }
+        return *this ;
+    }
+    Task (const Task &) = delete ;
+    Task &operator= (const Task &) = delete ;
+    ~Task () { if (h) h.destroy () ; }
+
+    // awaiting a task starts it and resumes the awaiting coroutine on completion
+    bool await_ready () const noexcept { return false ; }
+    std::coroutine_handle<> await_suspend (std::coroutine_handle<> awaiting) noexcept
+    {
+        h.promise ().continuation = awaiting ;
+        return h ;
+    }
+    T await_resume () { return h.promise ().result () ; }
+
+    Handle release () noexcept { return std::exchange (h, nullptr) ; }
+
+private:
+    explicit Task (Handle handle) : h (handle) {}
+    Handle h ;
+} ;
+
+
+//======================================================================
+// Executor: single-threaded event loop over timers and posted events.
+
+class Executor
+{
+public:
+    using EventHandler = std::function<void (uint8_t)> ;
+
+    Executor ()
+    {
+        if (pipe2 (fds, O_CLOEXEC) == 0)
+            fcntl (fds[1], F_SETFL, O_NONBLOCK) ; // never block an interrupt thread
+    }
+
+    ~Executor ()
+    {
+        for (void *addr : roots)
+            std::coroutine_handle<>::from_address (addr).destroy () ;
+        close (fds[0]) ;
+        close (fds[1]) ;
+    }
+
+    Executor (const Executor &) = delete ;
+    Executor &operator= (const Executor &) = delete ;
+
+    // spawn(task): starts task as detached behaviour on the next loop iteration
+    void spawn (Task<> task)
+    {
+        auto h = task.release () ;
+        h.promise ().executor = this ;
+        roots.insert (h.address ()) ;
+        ready.push_back (h) ;
+    }
+
+    // run(): runs until all spawned tasks have finished or stop() is called.
+    // Rethrows the first exception escaping from a spawned task.
+    void run ()
+    {
+        stopped = false ;
+        while (!stopped && !roots.empty ())
+        {
+            while (!ready.empty () && !stopped)
+            {
+                auto h = ready.front () ;
+                ready.pop_front () ;
+                h.resume () ;
+            }
+            if (stopped || roots.empty ())
+                break ;
+            waitForEvents () ;
+        }
+        if (error)
+            std::rethrow_exception (std::exchange (error, nullptr)) ;
+    }
+
+    void stop () { stopped = true ; }
+
+    // post(event): thread- and interrupt-safe notification of the loop.
+    // Returns false if the pipe is full (the loop has not read the last
+    // 64 KiB of events); the event is then dropped and counted.
+    bool post (uint8_t event)
+    {
+        if (write (fds[1], &event, 1) == 1)
+            return true ;
+        droppedEvents.fetch_add (1, std::memory_order_relaxed) ;
+        return false ;
+    }
+
+    // dropped(): events lost on a full pipe
+    uint64_t dropped () const { return droppedEvents.load (std::memory_order_relaxed) ; }
+
+    void onEvent (EventHandler handler) { eventHandler = std::move (handler) ; }
+
+    void schedule (std::coroutine_handle<> h) { ready.push_back (h) ; }
+
+    void addTimer (Clock::time_point when, std::coroutine_handle<> h)
+    {
+        timers.push (Timer{ when, timerSeq++, h }) ;
+    }
+
+    size_t tasks () const { return roots.size () ; }
+
+    // called by detached tasks on completion
+    void finished (std::coroutine_handle<> h, std::exception_ptr err)
+    {
+        roots.erase (h.address ()) ;
+        if (err && !error) { error = err ; stopped = true ; }
+    }
+
+private:
+    struct Timer
+    {
+        Clock::time_point when ;
+        uint64_t seq ;                // keeps timers with equal deadline in FIFO order
+        std::coroutine_handle<> h ;
+        bool operator> (const Timer &o) const
+        { return (when != o.when) ? when > o.when : seq > o.seq ; }
+    } ;
+
+    void waitForEvents ()
+    {
+        struct pollfd pfd = { fds[0], POLLIN, 0 } ;
+        struct timespec ts, *pts = nullptr ;
+        uint8_t buf[256] ;
+
+        if (!timers.empty ())
+        {
+            auto wait = timers.top ().when - Clock::now () ;
+            auto ns = std::max<int64_t> (0, std::chrono::duration_cast<std::chrono::nanoseconds> (wait).count ()) ;
+            ts.tv_sec = ns / 1000000000 ;
+            ts.tv_nsec = ns % 1000000000 ;
+            pts = &ts ;
+        }
+        if (ppoll (&pfd, 1, pts, nullptr) > 0 && (pfd.revents & POLLIN))
+        {
+            ssize_t n = read (fds[0], buf, sizeof(buf)) ;
+            for (ssize_t i = 0; i < n; i++)
+                if (eventHandler) eventHandler (buf[i]) ;
+        }
+        auto now = Clock::now () ;
+        while (!timers.empty () && timers.top ().when <= now)
+        {
+            ready.push_back (timers.top ().h) ;
+            timers.pop () ;
+        }
+    }
+
+    int fds[2] = { -1, -1 } ;
+    std::atomic<uint64_t> droppedEvents{ 0 } ;
+    std::deque<std::coroutine_handle<>> ready ;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers ;
+    uint64_t timerSeq = 0 ;
+    std::unordered_set<void *> roots ;       // frames of spawned, unfinished tasks
+    EventHandler eventHandler ;
+    std::exception_ptr error ;
+    bool stopped = false ;
+} ;
+
+template <typename T>
+std::coroutine_handle<> Task<T>::FinalAwaiter::await_suspend (Handle h) noexcept
+{
+    auto &p = h.promise () ;
+    auto cont = p.continuation ;
+    if (p.executor != nullptr)
+    {
+        // detached task: nobody owns the frame, so release it here
+        p.executor->finished (h, p.error) ;
+        h.destroy () ;
+    }
+    return cont ? cont : std::noop_coroutine () ;
+}
+
+
+//======================================================================
+// Robot: awaitable sensors and timers of the initio robot car.
+
+class Robot
+{
+public:
+    explicit Robot (Executor &executor) : ex (executor)
+    {
+        int lineLeftPin = (initio_identifyControlBoard () == PIROCON2) ? lineLeft_PiRoCon : lineLeft_RoboHat ;
+
+        instance = this ;
+        ex.onEvent ([this] (uint8_t ev) { dispatch (ev) ; }) ;
+        wiringPiISR (irFL,        INT_EDGE_BOTH,   &isr<EvIrLeft>) ;
+        wiringPiISR (irFR,        INT_EDGE_BOTH,   &isr<EvIrRight>) ;
+        wiringPiISR (lineLeftPin, INT_EDGE_BOTH,   &isr<EvLineLeft>) ;
+        wiringPiISR (lineRight,   INT_EDGE_BOTH,   &isr<EvLineRight>) ;
+        wiringPiISR (wheelLeft,   INT_EDGE_RISING, &isr<EvWheelLeft>) ;
+        wiringPiISR (wheelRight,  INT_EDGE_RISING, &isr<EvWheelRight>) ;
+        sonarThread = std::thread ([this] { sonarLoop () ; }) ;
+    }
+
+    ~Robot ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (sonarMutex) ;
+            sonarQuit = true ;
+        }
+        sonarCv.notify_one () ;
+        sonarThread.join () ;
+        instance = nullptr ;  // wiringPi interrupts cannot be unregistered
+        ex.onEvent (nullptr) ;
+    }
+
+    Robot (const Robot &) = delete ;
+    Robot &operator= (const Robot &) = delete ;
+
+    Executor &executor () { return ex ; }
+
+    // co_await sleep(duration): resumes after the given time
+    auto sleep (Clock::duration d) { return TimerAwaiter{ ex, Clock::now () + d } ; }
+    auto sleep_until (Clock::time_point t) { return TimerAwaiter{ ex, t } ; }
+
+    // co_await distance(): ultrasonic distance in cm (0 == no object).
+    // Concurrent requests share one measurement.
+    auto distance () { return DistanceAwaiter{ *this } ; }
+
+    // co_await ir_edge(side): resumes on the next change of the IR obstacle
+    // sensor and returns whether it is triggered now (Both: on a change of
+    // either sensor, returns whether either is triggered)
+    auto ir_edge (Side side) { return edge (side, EvIrLeft, EvIrRight) ; }
+
+    // co_await line_edge(side): same for the IR line sensors
+    auto line_edge (Side side) { return edge (side, EvLineLeft, EvLineRight) ; }
+
+    // co_await ticks(n, side): resumes after n wheel sensor pulses on the given
+    // wheel (Both: average of both wheels)
+    auto ticks (unsigned n, Side side = Both) { return TickAwaiter{ *this, n, side } ; }
+
+    uint64_t tickCount (Side side) const
+    { return side == Left ? ticksLeft : side == Right ? ticksRight : (ticksLeft + ticksRight) / 2 ; }
+
+    // Motion and servo commands do not block and are forwarded directly
+    void stop ()                                 { initio_Stop () ; }
+    void drive_forward (int8_t speed)            { initio_DriveForward (speed) ; }
+    void drive_reverse (int8_t speed)            { initio_DriveReverse (speed) ; }
+    void spin_left (int8_t speed)                { initio_SpinLeft (speed) ; }
+    void spin_right (int8_t speed)               { initio_SpinRight (speed) ; }
+    void turn_forward (int8_t left, int8_t right) { initio_TurnForward (left, right) ; }
+    void turn_reverse (int8_t left, int8_t right) { initio_TurnReverse (left, right) ; }
+    void set_servo (int8_t servo, int8_t degrees) { initio_SetServo (servo, degrees) ; }
+
+    // Direct (non-waiting) sensor reads
+    bool ir_left ()    { return initio_IrLeft () ; }
+    bool ir_right ()   { return initio_IrRight () ; }
+    bool line_left ()  { return initio_IrLineLeft () ; }
+    bool line_right () { return initio_IrLineRight () ; }
+
+private:
+    enum Event : uint8_t { EvIrLeft, EvIrRight, EvLineLeft, EvLineRight, EvWheelLeft, EvWheelRight, EvSonar, EvCount } ;
+
+    struct TimerAwaiter
+    {
+        Executor &ex ;
+        Clock::time_point when ;
+        bool await_ready () const { return when <= Clock::now () ; }
+        void await_suspend (std::coroutine_handle<> h) { ex.addTimer (when, h) ; }
+        void await_resume () const noexcept {}
+    } ;
+
+    struct DistanceAwaiter
+    {
+        Robot &robot ;
+        unsigned int distance = 0 ;
+        std::coroutine_handle<> h ;
+        bool await_ready () const noexcept { return false ; }
+        void await_suspend (std::coroutine_handle<> handle) { h = handle ; robot.requestDistance (this) ; }
+        unsigned int await_resume () const noexcept { return distance ; }
+    } ;
+
+    struct EdgeAwaiter
+    {
+        Robot &robot ;
+        uint8_t event ;
+        uint8_t other ;               // second event for Both, EvCount: none
+        bool state = false ;
+        std::coroutine_handle<> h ;
+        bool await_ready () const noexcept { return false ; }
+        void await_suspend (std::coroutine_handle<> handle)
+        {
+            h = handle ;
+            robot.edgeWaiters[event].push_back (this) ;
+            if (other != EvCount)
+                robot.edgeWaiters[other].push_back (this) ;
+        }
+        bool await_resume () const noexcept { return state ; }
+    } ;
+
+    EdgeAwaiter edge (Side side, uint8_t left, uint8_t right)
+    {
+        if (side == Both)
+            return EdgeAwaiter{ *this, left, right } ;
+        return EdgeAwaiter{ *this, side == Right ? right : left, EvCount } ;
+    }
+
+    struct TickAwaiter
+    {
+        Robot &robot ;
+        unsigned n ;
+        Side side ;
+        uint64_t target = 0 ;
+        std::coroutine_handle<> h ;
+        bool await_ready () const noexcept { return n == 0 ; }
+        void await_suspend (std::coroutine_handle<> handle)
+        {
+            h = handle ;
+            target = robot.tickCount (side) + n ;
+            robot.tickWaiters.push_back (this) ;
+        }
+        void await_resume () const noexcept {}
+    } ;
+
+    template <int Ev>
+    static void isr () { Robot *r = instance ; if (r) r->ex.post (Ev) ; }
+
+    bool readEvent (uint8_t ev)
+    {
+        switch (ev)
+        {
+        case EvIrLeft:    return initio_IrLeft () ;
+        case EvIrRight:   return initio_IrRight () ;
+        case EvLineLeft:  return initio_IrLineLeft () ;
+        case EvLineRight: return initio_IrLineRight () ;
+        default:          return false ;
+        }
+    }
+
+    void dispatch (uint8_t ev)
+    {
+        if (ev == EvWheelLeft || ev == EvWheelRight)
+        {
+            (ev == EvWheelLeft) ? ticksLeft++ : ticksRight++ ;
+            for (size_t i = 0; i < tickWaiters.size (); )
+            {
+                TickAwaiter *w = tickWaiters[i] ;
+                if (tickCount (w->side) >= w->target)
+                {
+                    ex.schedule (w->h) ;
+                    tickWaiters[i] = tickWaiters.back () ;
+                    tickWaiters.pop_back () ;
+                }
+                else
+                    i++ ;
+            }
+        }
+        else if (ev == EvSonar)
+            sonarDone () ;
+        else if (ev < EvCount)
+        {
+            bool state = readEvent (ev) ;
+            std::vector<EdgeAwaiter *> waiters ;
+            waiters.swap (edgeWaiters[ev]) ;
+            for (EdgeAwaiter *w : waiters)
+            {
+                w->state = state ;
+                if (w->other != EvCount)
+                {
+                    // Both: also leave the list of the other sensor
+                    uint8_t o = (w->event == ev) ? w->other : w->event ;
+                    std::erase (edgeWaiters[o], w) ;
+                    w->state = readEvent (w->event) || readEvent (w->other) ;
+                }
+                ex.schedule (w->h) ;
+            }
+        }
+    }
+
+    // Sonar: requests arriving during a measurement wait for the next one,
+    // so every awaiter gets a range measured after it asked.
+    void requestDistance (DistanceAwaiter *w)
+    {
+        if (sonarBusy)
+            sonarPending.push_back (w) ;
+        else
+        {
+            sonarInFlight.push_back (w) ;
+            startPing () ;
+        }
+    }
+
+    void startPing ()
+    {
+        sonarBusy = true ;
+        {
+            std::lock_guard<std::mutex> lock (sonarMutex) ;
+            sonarRequest = true ;
+        }
+        sonarCv.notify_one () ;
+    }
+
+    void sonarDone ()
+    {
+        unsigned int d = sonarResult.load () ;
+        for (DistanceAwaiter *w : sonarInFlight)
+        {
+            w->distance = d ;
+            ex.schedule (w->h) ;
+        }
+        sonarInFlight.clear () ;
+        sonarBusy = false ;
+        if (!sonarPending.empty ())
+        {
+            sonarInFlight.swap (sonarPending) ;
+            startPing () ;
+        }
+    }
+
+    void sonarLoop ()
+    {
+        std::unique_lock<std::mutex> lock (sonarMutex) ;
+        for (;;)
+        {
+            sonarCv.wait (lock, [this] { return sonarRequest || sonarQuit ; }) ;
+            if (sonarQuit) break ;
+            sonarRequest = false ;
+            lock.unlock () ;
+            sonarResult = initio_UsGetDistance () ;
+            while (!ex.post (EvSonar))  // the awaiters would wait forever
+                std::this_thread::sleep_for (std::chrono::milliseconds (1)) ;
+            lock.lock () ;
+        }
+    }
+
+    static inline Robot *instance = nullptr ;
+
+    Executor &ex ;
+    std::vector<EdgeAwaiter *> edgeWaiters[EvCount] ;
+    std::vector<TickAwaiter *> tickWaiters ;
+    uint64_t ticksLeft = 0, ticksRight = 0 ;
+
+    std::vector<DistanceAwaiter *> sonarInFlight, sonarPending ;
+    bool sonarBusy = false ;
+    std::thread sonarThread ;
+    std::mutex sonarMutex ;
+    std::condition_variable sonarCv ;
+    bool sonarRequest = false, sonarQuit = false ;
+    std::atomic<unsigned int> sonarResult { 0 } ;
+} ;
+
+} // namespace initio
+
+#endif /* _4TRONIX_INITIO_CO_HPP_ */
@@ -0,0 +1,461 @@
+//======================================================================
+//
+// Extended Kalman filter pose estimator of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "initio_ekf.h"
+#include "initio_seqlock.h"
+#include "initio_time.h"
+
+#define N 5  // state: x, y, theta, vLeft, vRight
+#define X 0
+#define Y 1
+#define TH 2
+#define VL 3
+#define VR 4
+
+#define MAX_INCIDENCE 0.785  // rad, walls seen more obliquely reflect the ping away
+#define NO_RANGE (-1)
+
+struct initio_ekf {
+    initio_ctx *ctx ;
+    initio_ekfParams params ;
+    initio_wall *walls ;
+    int numWalls ;
+
+    // filter state, only used by the stepping thread
+    double x[N] ;
+    double P[N][N] ;
+    double t ;
+    unsigned long lastLeft, lastRight ;
+    int dirLeft, dirRight ;
+
+    int pendingRange ;  // latest sonar range in cm, NO_RANGE if none
+    int pan ;           // sonar pan angle in degrees
+
+    initio_seqlock lock ;        // publishes estimate
+    initio_ekfEstimate estimate ;
+
+    pthread_mutex_t mutex ;      // protects stats
+    initio_ekfStats stats ;
+    double costSum, rangeCostSum ;
+
+    initio_rate *rate ;          // filter thread
+    initio_rate *sonarRate ;     // sonar thread
+    double last ;
+} ;
+
+void initio_EkfDefaultParams (initio_ekfParams *params)
+{
+    initio_SimDefaultParams (&params->model) ;
+    params->useTicks = TRUE ;
+    params->dutyNoise = 0.3 ;
+    params->speedNoise = 10.0 ;
+    params->tickNoise = 0.5 ;
+    params->sonarNoise = 2.0 ;
+    params->sonarOffset = 8.0 ;
+    params->sonarMax = 300.0 ;
+    params->gate = 3.0 ;
+    params->sonarHz = 0 ;
+}
+
+// publish(): makes the current state visible to initio_EkfGet()
+static void publish (initio_ekf *ekf)
+{
+    initio_ekfEstimate e ;
+    int i, j ;
+
+    e.pose.x = ekf->x[X] ;
+    e.pose.y = ekf->x[Y] ;
+    e.pose.theta = ekf->x[TH] ;
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            e.cov[i][j] = ekf->P[i][j] ;
+    e.vLeft = ekf->x[VL] ;
+    e.vRight = ekf->x[VR] ;
+    e.time = ekf->t ;
+    e.updates = ekf->stats.steps ;
+    initio_SeqWrite (&ekf->lock, &ekf->estimate, &e, sizeof(e)) ;
+}
+
+initio_ekf *initio_EkfCreate (initio_ctx *ctx, const initio_ekfParams *params, const initio_pose *start,
+                              const initio_wall *walls, int numWalls)
+{
+    initio_ekf *ekf = calloc (1, sizeof(initio_ekf)) ;
+
+    if (ekf == NULL)
+        return NULL ;
+    if (numWalls > 0)
+    {
+        ekf->walls = malloc (numWalls * sizeof(initio_wall)) ;
+        if (ekf->walls == NULL)
+        {
+            free (ekf) ;
+            return NULL ;
+        }
+        memcpy (ekf->walls, walls, numWalls * sizeof(initio_wall)) ;
+        ekf->numWalls = numWalls ;
+    }
+    ekf->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    if (params != NULL)
+        ekf->params = *params ;
+    else
+        initio_EkfDefaultParams (&ekf->params) ;
+    if (start != NULL)
+    {
+        ekf->x[X] = start->x ;
+        ekf->x[Y] = start->y ;
+        ekf->x[TH] = start->theta ;
+    }
+    ekf->P[X][X] = ekf->P[Y][Y] = 1.0 ;        // 1 cm
+    ekf->P[TH][TH] = 0.0003 ;                  // 1 degree
+    ekf->P[VL][VL] = ekf->P[VR][VR] = 1.0 ;    // 1 cm/s
+    ekf->dirLeft = ekf->dirRight = 1 ;
+    ekf->pendingRange = NO_RANGE ;
+    pthread_mutex_init (&ekf->mutex, NULL) ;
+
+    if (ekf->params.useTicks)
+    {
+        initio_ctxWheelCountStart (ekf->ctx) ;
+        ekf->lastLeft = initio_ctxWheelCountLeft (ekf->ctx) ;
+        ekf->lastRight = initio_ctxWheelCountRight (ekf->ctx) ;
+    }
+    publish (ekf) ;
+    return ekf ;
+}
+
+void initio_EkfFree (initio_ekf *ekf)
+{
+    if (ekf == NULL)
+        return ;
+    initio_EkfStop (ekf) ;
+    pthread_mutex_destroy (&ekf->mutex) ;
+    free (ekf->walls) ;
+    free (ekf) ;
+}
+
+
+//======================================================================
+// Filter
+
+// predict(): propagates state and covariance over dt with the commanded duties
+static void predict (initio_ekf *ekf, double dt, int dutyLeft, int dutyRight)
+{
+    const initio_ekfParams *p = &ekf->params ;
+    const initio_simParams *m = &p->model ;
+    double *x = ekf->x ;
+    double a = (m->tau > 0) ? 1 - exp (-dt / m->tau) : 1 ;
+    double cl = initio_SimWheelSpeed (m, dutyLeft) ;
+    double cr = initio_SimWheelSpeed (m, dutyRight) ;
+    double vl = x[VL] + a * (cl - x[VL]) ;
+    double vr = x[VR] + a * (cr - x[VR]) ;
+    double ds = (vl + vr) / 2 * dt ;
+    double dth = (vr - vl) / m->wheelBase * dt ;
+    double phi = x[TH] + dth / 2 ;
+    double c = cos (phi), s = sin (phi) ;
+    double dds = (1 - a) * dt / 2 ;              // d ds / d vLeft, d vRight
+    double dthl = -(1 - a) * dt / m->wheelBase ; // d dth / d vLeft (vRight: -dthl)
+    double F[N][N], FP[N][N], qv ;
+    int i, j, k ;
+
+    memset (F, 0, sizeof(F)) ;
+    F[X][X] = F[Y][Y] = F[TH][TH] = 1 ;
+    F[X][TH] = -ds * s ;
+    F[Y][TH] = ds * c ;
+    F[X][VL] = c * dds - ds * s * dthl / 2 ;
+    F[X][VR] = c * dds + ds * s * dthl / 2 ;
+    F[Y][VL] = s * dds + ds * c * dthl / 2 ;
+    F[Y][VR] = s * dds - ds * c * dthl / 2 ;
+    F[TH][VL] = dthl ;
+    F[TH][VR] = -dthl ;
+    F[VL][VL] = F[VR][VR] = 1 - a ;
+
+    x[X] += ds * c ;
+    x[Y] += ds * s ;
+    x[TH] = remainder (x[TH] + dth, 2 * M_PI) ;
+    x[VL] = vl ;
+    x[VR] = vr ;
+
+    // P = F P F' + Q
+    for (i = 0; i < N; i++)
+        for (j = 0; j < N; j++)
+        {
+            FP[i][j] = 0 ;
+            for (k = 0; k < N; k++)
+                FP[i][j] += F[i][k] * ekf->P[k][j] ;
+        }
+    for (i = 0; i < N; i++)
+        for (j = 0; j < N; j++)
+        {
+            ekf->P[i][j] = 0 ;
+            for (k = 0; k < N; k++)
+                ekf->P[i][j] += FP[i][k] * F[j][k] ;
+        }
+
+    // uncertainty of the motor model (proportional to the commanded speed) plus random walk
+    qv = p->speedNoise * p->speedNoise * dt ;
+    ekf->P[VL][VL] += qv + pow (a * p->dutyNoise * cl, 2) ;
+    ekf->P[VR][VR] += qv + pow (a * p->dutyNoise * cr, 2) ;
+}
+
+// update(): scalar measurement update with innovation and variance r.
+// Returns FALSE (and leaves the state) if the innovation fails the gate.
+static BOOL update (initio_ekf *ekf, const double H[N], double innov, double r, double gate)
+{
+    double PH[N], K[N], S = r ;
+    int i, j ;
+
+    for (i = 0; i < N; i++)
+    {
+        PH[i] = 0 ;
+        for (j = 0; j < N; j++)
+            PH[i] += ekf->P[i][j] * H[j] ;
+        S += H[i] * PH[i] ;
+    }
+    if (gate > 0 && innov * innov > gate * gate * S)
+        return FALSE ;
+    for (i = 0; i < N; i++)
+    {
+        K[i] = PH[i] / S ;
+        ekf->x[i] += K[i] * innov ;
+    }
+    ekf->x[TH] = remainder (ekf->x[TH], 2 * M_PI) ;
+    for (i = 0; i < N; i++)
+        for (j = 0; j <= i; j++)
+        {
+            ekf->P[i][j] -= K[i] * PH[j] ;
+            ekf->P[j][i] = ekf->P[i][j] ;
+        }
+    return TRUE ;
+}
+
+// expectedRange(): distance from the sonar at pose to the nearest wall, -1 if none in view
+static double expectedRange (initio_ekf *ekf, double x, double y, double theta)
+{
+    double phi = theta + __atomic_load_n (&ekf->pan, __ATOMIC_RELAXED) * M_PI / 180 ;
+    double dx = cos (phi), dy = sin (phi) ;
+    double sx = x + ekf->params.sonarOffset * cos (theta) ;
+    double sy = y + ekf->params.sonarOffset * sin (theta) ;
+    double best = INFINITY ;
+    BOOL reflects = FALSE ;
+    int i ;
+
+    for (i = 0; i < ekf->numWalls; i++)
+    {
+        const initio_wall *w = &ekf->walls[i] ;
+        double ex = w->x2 - w->x1, ey = w->y2 - w->y1 ;
+        double denom = dx * ey - dy * ex ;
+        double wx = w->x1 - sx, wy = w->y1 - sy ;
+        double t, u ;
+
+        if (fabs (denom) < 1e-12)
+            continue ;
+        t = (wx * ey - wy * ex) / denom ;
+        u = (wx * dy - wy * dx) / denom ;
+        if (t > 0 && u >= 0 && u <= 1 && t < best)
+        {
+            best = t ;
+            // |sin| of the angle between ray and wall == |cos| of the incidence angle
+            reflects = (fabs (denom) / hypot (ex, ey) >= cos (MAX_INCIDENCE)) ;
+        }
+    }
+    return (isinf (best) || !reflects) ? -1 : best ;  // oblique walls reflect the ping away
+}
+
+// rangeUpdate(): fuses a sonar range. Returns 1 used, 0 rejected, -1 unmapped.
+static int rangeUpdate (initio_ekf *ekf, double range)
+{
+    const double eps[3] = { 0.01, 0.01, 1e-4 } ;
+    double H[N] = { 0, 0, 0, 0, 0 } ;
+    double h, r ;
+    int i ;
+
+    if (range <= 0 || range > ekf->params.sonarMax)
+        return -1 ;
+    h = expectedRange (ekf, ekf->x[X], ekf->x[Y], ekf->x[TH]) ;
+    if (h < 0)
+        return -1 ;
+    // numerical Jacobian w.r.t. x, y, theta (central differences)
+    for (i = 0; i < 3; i++)
+    {
+        double xp[3] = { ekf->x[X], ekf->x[Y], ekf->x[TH] } ;
+        double xm[3] = { ekf->x[X], ekf->x[Y], ekf->x[TH] } ;
+        double hp, hm ;
+        xp[i] += eps[i] ;
+        xm[i] -= eps[i] ;
+        hp = expectedRange (ekf, xp[X], xp[Y], xp[TH]) ;
+        hm = expectedRange (ekf, xm[X], xm[Y], xm[TH]) ;
+        if (hp < 0 || hm < 0)
+            return -1 ;  // at the edge of a wall
+        H[i] = (hp - hm) / (2 * eps[i]) ;
+    }
+    r = ekf->params.sonarNoise * ekf->params.sonarNoise ;
+    return update (ekf, H, range - h, r, ekf->params.gate) ? 1 : 0 ;
+}
+
+void initio_EkfStep (initio_ekf *ekf, double dt)
+{
+    const initio_ekfParams *p = &ekf->params ;
+    double t0 = initio_Now (), t1, t2 ;
+    int dutyLeft, dutyRight, range, used = -2 ;
+
+    if (dt <= 0)
+        return ;
+    initio_ctxGetMotors (ekf->ctx, &dutyLeft, &dutyRight) ;
+    predict (ekf, dt, dutyLeft, dutyRight) ;
+
+    if (p->useTicks)
+    {
+        unsigned long countLeft = initio_ctxWheelCountLeft (ekf->ctx) ;
+        unsigned long countRight = initio_ctxWheelCountRight (ekf->ctx) ;
+        double H[N] = { 0, 0, 0, 0, 0 } ;
+        double r = pow (p->tickNoise * p->model.cmPerTick, 2) ;
+
+        // pulse direction: last motor command, estimated speed while stopped
+        if (dutyLeft != 0) ekf->dirLeft = (dutyLeft < 0) ? -1 : 1 ;
+        else if (ekf->x[VL] != 0) ekf->dirLeft = (ekf->x[VL] < 0) ? -1 : 1 ;
+        if (dutyRight != 0) ekf->dirRight = (dutyRight < 0) ? -1 : 1 ;
+        else if (ekf->x[VR] != 0) ekf->dirRight = (ekf->x[VR] < 0) ? -1 : 1 ;
+
+        // travel during dt, measured as mean wheel speed
+        H[VL] = dt ;
+        update (ekf, H, ekf->dirLeft * (double)(countLeft - ekf->lastLeft) * p->model.cmPerTick - ekf->x[VL] * dt, r, 0) ;
+        H[VL] = 0 ;
+        H[VR] = dt ;
+        update (ekf, H, ekf->dirRight * (double)(countRight - ekf->lastRight) * p->model.cmPerTick - ekf->x[VR] * dt, r, 0) ;
+        ekf->lastLeft = countLeft ;
+        ekf->lastRight = countRight ;
+    }
+
+    t1 = initio_Now () ;
+    range = __atomic_exchange_n (&ekf->pendingRange, NO_RANGE, __ATOMIC_ACQ_REL) ;
+    if (range != NO_RANGE)
+        used = rangeUpdate (ekf, range) ;
+    t2 = initio_Now () ;
+
+    ekf->t += dt ;
+    pthread_mutex_lock (&ekf->mutex) ;
+    {
+        initio_ekfStats *s = &ekf->stats ;
+        double cost = (t2 - t0) * 1e6 ;
+        s->steps++ ;
+        ekf->costSum += cost ;
+        s->costAvgUs = ekf->costSum / s->steps ;
+        if (cost > s->costMaxUs) s->costMaxUs = cost ;
+        if (used == 1) s->ranges++ ;
+        else if (used == 0) s->rejected++ ;
+        else if (used == -1) s->unmapped++ ;
+        if (used != -2)
+        {
+            ekf->rangeCostSum += (t2 - t1) * 1e6 ;
+            s->rangeCostAvgUs = ekf->rangeCostSum / (s->ranges + s->rejected + s->unmapped) ;
+        }
+    }
+    pthread_mutex_unlock (&ekf->mutex) ;
+    publish (ekf) ;
+}
+
+// End of Filter
+//======================================================================
+
+
+
+//======================================================================
+// Threads and Access
+
+static BOOL ekfCycle (void *arg)
+{
+    initio_ekf *ekf = arg ;
+    double t = initio_Now () ;
+
+    ekf->t = ekf->last ;  // estimate time follows the monotonic clock
+    initio_EkfStep (ekf, t - ekf->last) ;
+    ekf->last = t ;
+    return TRUE ;
+}
+
+static BOOL sonarCycle (void *arg)
+{
+    initio_ekf *ekf = arg ;
+    initio_EkfAddRange (ekf, initio_ctxUsGetDistance (ekf->ctx)) ;
+    return TRUE ;
+}
+
+BOOL initio_EkfStart (initio_ekf *ekf, double hz)
+{
+    if (ekf->rate != NULL)
+        return FALSE ;
+    ekf->last = initio_Now () ;
+    ekf->rate = initio_RateStart (hz, ekfCycle, ekf) ;
+    if (ekf->rate == NULL)
+        return FALSE ;
+    if (ekf->params.sonarHz > 0)
+        ekf->sonarRate = initio_RateStart (ekf->params.sonarHz, sonarCycle, ekf) ;
+    return TRUE ;
+}
+
+void initio_EkfStop (initio_ekf *ekf)
+{
+    initio_rateStats rs ;
+
+    if (ekf->sonarRate != NULL)
+    {
+        initio_RateStop (ekf->sonarRate, NULL) ;
+        ekf->sonarRate = NULL ;
+    }
+    if (ekf->rate != NULL)
+    {
+        initio_RateStop (ekf->rate, &rs) ;
+        ekf->rate = NULL ;
+        pthread_mutex_lock (&ekf->mutex) ;
+        ekf->stats.rate = rs ;
+        pthread_mutex_unlock (&ekf->mutex) ;
+    }
+}
+
+void initio_EkfAddRange (initio_ekf *ekf, unsigned int cm)
+{
+    __atomic_store_n (&ekf->pendingRange, (int)cm, __ATOMIC_RELEASE) ;
+}
+
+void initio_EkfSetPan (initio_ekf *ekf, int degrees)
+{
+    __atomic_store_n (&ekf->pan, degrees, __ATOMIC_RELAXED) ;
+}
+
+void initio_EkfGet (initio_ekf *ekf, initio_ekfEstimate *estimate)
+{
+    initio_SeqRead (&ekf->lock, estimate, &ekf->estimate, sizeof(initio_ekfEstimate)) ;
+}
+
+BOOL initio_EkfPose (void *ekf, initio_pose *pose)
+{
+    initio_ekfEstimate e ;
+
+    initio_EkfGet ((initio_ekf *)ekf, &e) ;
+    *pose = e.pose ;
+    return TRUE ;
+}
+
+void initio_EkfGetStats (initio_ekf *ekf, initio_ekfStats *stats)
+{
+    pthread_mutex_lock (&ekf->mutex) ;
+    *stats = ekf->stats ;
+    pthread_mutex_unlock (&ekf->mutex) ;
+    if (ekf->rate != NULL)
+        initio_RateGetStats (ekf->rate, &stats->rate) ;
+}
+
+// End of Threads and Access
+//======================================================================
@@ -0,0 +1,129 @@
+#ifndef _4TRONIX_INITIO_EKF_H_
+#define _4TRONIX_INITIO_EKF_H_
+//======================================================================
+//
+// Extended Kalman filter pose estimator of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Estimates the pose (x, y, theta) and both wheel speeds of a robot by
+// fusing three sources:
+//   o the commanded duties (initio_ctxGetMotors) as motion prior, through
+//     the motor model of initio_sim.h (stall duty, speed, motor lag),
+//   o the wheel sensor pulses (initio_ctxWheelCount*), whose direction is
+//     taken from the last motor command (or from the estimated speed
+//     while the motors are stopped),
+//   o sonar ranges against a map of known walls; ranges that do not fit
+//     the map (e.g. unmapped obstacles) are rejected by a gate.
+// The filter runs in a fixed-rate thread (initio_rate.h), or is stepped
+// by the caller (e.g. in simulated time). The latest estimate is
+// published through a sequence lock: initio_EkfGet() never blocks the
+// filter and never waits for it.
+//
+// Coordinates in cm, theta in rad counter-clockwise from the x axis.
+// The sonar looks along theta plus its pan angle (initio_EkfSetPan).
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_path.h"
+#include "initio_rate.h"
+#include "initio_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    double x1, y1, x2, y2 ;  // end points in cm
+} initio_wall ;
+
+typedef struct {
+    initio_simParams model ;  // motor model and geometry of the robot
+    BOOL useTicks ;           // wheel sensors connected
+    double dutyNoise ;        // std. deviation of the speed predicted from a duty, relative
+    double speedNoise ;       // random walk of the wheel speeds in cm/s per sqrt(s)
+    double tickNoise ;        // std. deviation of a wheel travel measurement in ticks
+    double sonarNoise ;       // std. deviation of a sonar range in cm
+    double sonarOffset ;      // distance of the sonar in front of the wheel axis in cm
+    double sonarMax ;         // longer ranges are ignored, in cm
+    double gate ;             // reject sonar ranges more than gate std. deviations off
+    double sonarHz ;          // ping rate of the built-in sonar thread, 0: ranges
+                              // are only supplied by initio_EkfAddRange()
+} initio_ekfParams ;
+
+typedef struct {
+    initio_pose pose ;        // estimated pose
+    double cov[3][3] ;        // covariance of x, y, theta
+    double vLeft, vRight ;    // estimated wheel speeds in cm/s
+    double time ;             // CLOCK_MONOTONIC time (s) or simulated time of the estimate
+    unsigned long updates ;   // filter steps so far
+} initio_ekfEstimate ;
+
+typedef struct {
+    unsigned long steps ;       // filter steps
+    unsigned long ranges ;      // sonar ranges used
+    unsigned long rejected ;    // sonar ranges rejected by the gate
+    unsigned long unmapped ;    // sonar ranges without a wall in view or out of range
+    double costAvgUs ;          // computation time per filter step
+    double costMaxUs ;
+    double rangeCostAvgUs ;     // additional time of a sonar update
+    initio_rateStats rate ;     // loop timing of the filter thread
+} initio_ekfStats ;
+
+typedef struct initio_ekf initio_ekf ;
+
+// initio_EkfDefaultParams (params):
+// Fills params with values for the initio chassis and the HC-SR04.
+void initio_EkfDefaultParams (initio_ekfParams *params) ;
+
+// initio_EkfCreate (ctx, params, start, walls, numWalls):
+// Creates a filter for the robot of ctx (NULL: default context) starting at
+// pose start with small uncertainty. walls are copied. params == NULL
+// selects the defaults. Starts counting wheel pulses. Returns NULL on error.
+initio_ekf *initio_EkfCreate (initio_ctx *ctx, const initio_ekfParams *params, const initio_pose *start,
+                              const initio_wall *walls, int numWalls) ;
+
+// initio_EkfFree (ekf):
+// Stops the threads and frees ekf.
+void initio_EkfFree (initio_ekf *ekf) ;
+
+// initio_EkfStart (ekf, hz):
+// Runs the filter at hz in its own thread (and the sonar thread, if enabled).
+BOOL initio_EkfStart (initio_ekf *ekf, double hz) ;
+
+// initio_EkfStop (ekf):
+// Stops the filter and sonar threads.
+void initio_EkfStop (initio_ekf *ekf) ;
+
+// initio_EkfStep (ekf, dt):
+// One filter step covering dt seconds, for callers without initio_EkfStart().
+void initio_EkfStep (initio_ekf *ekf, double dt) ;
+
+// initio_EkfAddRange (ekf, cm):
+// Supplies a sonar range (as returned by initio_UsGetDistance) for the next step.
+void initio_EkfAddRange (initio_ekf *ekf, unsigned int cm) ;
+
+// initio_EkfSetPan (ekf, degrees):
+// Sets the pan angle of the sonar, positive to the left (counter-clockwise).
+void initio_EkfSetPan (initio_ekf *ekf, int degrees) ;
+
+// initio_EkfGet (ekf, estimate):
+// Copies the latest estimate; lock-free, callable from any thread.
+void initio_EkfGet (initio_ekf *ekf, initio_ekfEstimate *estimate) ;
+
+// initio_EkfPose (ekf, pose):
+// Pose source (initio_path.h) returning the estimated pose.
+BOOL initio_EkfPose (void *ekf, initio_pose *pose) ;
+
+// initio_EkfGetStats (ekf, stats):
+// Copies counters and computation times.
+void initio_EkfGetStats (initio_ekf *ekf, initio_ekfStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_EKF_H_ */
@@ -0,0 +1,202 @@
+//======================================================================
+//
+// Motor characterisation and feedforward of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "initio_ff.h"
+
+#define MAGIC "INITIOF1"
+
+void initio_FfDefaultParams (initio_ffParams *params)
+{
+    params->step = 5 ;
+    params->settle = 0.5 ;
+    params->measure = 1.0 ;
+    params->minRate = 0.5 ;
+}
+
+// dutyAt(): duty of step i of a table
+static int dutyAt (const initio_ffTable *table, int i)
+{
+    return (i * table->step < 100) ? i * table->step : 100 ;
+}
+
+static void sleepWait (void *arg, double seconds)
+{
+    struct timespec ts ;
+
+    ts.tv_sec = (time_t)seconds ;
+    ts.tv_nsec = (long)((seconds - ts.tv_sec) * 1e9) ;
+    while (nanosleep (&ts, &ts) != 0)
+        ;
+}
+
+BOOL initio_FfCalibrate (initio_ctx *ctx, const initio_ffParams *params,
+                         initio_ffTable *table, initio_ffWait wait, void *arg)
+{
+    initio_ffParams p ;
+    unsigned long l0, r0, pulses = 0 ;
+    int dir, m, i, duty ;
+
+    if (params != NULL)
+        p = *params ;
+    else
+        initio_FfDefaultParams (&p) ;
+    if (p.step < 1 || p.step > 100 || (100 + p.step - 1) / p.step + 1 > INITIO_FF_STEPS || p.measure <= 0)
+        return FALSE ;
+    if (ctx == NULL)
+        ctx = initio_DefaultCtx () ;
+    if (wait == NULL)
+        wait = sleepWait ;
+
+    memset (table, 0, sizeof(initio_ffTable)) ;
+    table->step = p.step ;
+    table->steps = (100 + p.step - 1) / p.step + 1 ;
+    initio_ctxWheelCountStart (ctx) ;
+    for (dir = 0; dir < 2; dir++)
+    {
+        for (i = 1; i < table->steps; i++)  // duty 0 does not move
+        {
+            duty = dutyAt (table, i) ;
+            initio_ctxSetMotors (ctx, dir ? -duty : duty, dir ? -duty : duty) ;
+            wait (arg, p.settle) ;
+            l0 = initio_ctxWheelCountLeft (ctx) ;
+            r0 = initio_ctxWheelCountRight (ctx) ;
+            wait (arg, p.measure) ;
+            l0 = initio_ctxWheelCountLeft (ctx) - l0 ;
+            r0 = initio_ctxWheelCountRight (ctx) - r0 ;
+            table->rate[INITIO_FF_LEFT][dir][i] = l0 / p.measure ;
+            table->rate[INITIO_FF_RIGHT][dir][i] = r0 / p.measure ;
+            pulses += l0 + r0 ;
+        }
+        initio_ctxStop (ctx) ;
+        wait (arg, p.settle) ;
+    }
+
+    // fit: rates below minRate are stalls, rates do not decrease with the duty
+    for (m = 0; m < 2; m++)
+        for (dir = 0; dir < 2; dir++)
+        {
+            float *rate = table->rate[m][dir] ;
+
+            for (i = 1; i < table->steps; i++)
+            {
+                if (rate[i] < p.minRate)
+                    rate[i] = 0 ;
+                if (rate[i] < rate[i - 1])
+                    rate[i] = rate[i - 1] ;
+                if (rate[i] == 0)
+                    table->stall[m][dir] = dutyAt (table, i) ;
+            }
+        }
+    return pulses > 0 ;
+}
+
+BOOL initio_FfSave (const initio_ffTable *table, const char *path)
+{
+    FILE *f = fopen (path, "wb") ;
+    int32_t hdr[2] = { table->steps, table->step } ;
+    BOOL ok ;
+    int m, dir ;
+
+    if (f == NULL)
+        return FALSE ;
+    ok = fwrite (MAGIC, 8, 1, f) == 1
+      && fwrite (hdr, sizeof(hdr), 1, f) == 1
+      && fwrite (table->stall, sizeof(table->stall), 1, f) == 1 ;
+    for (m = 0; m < 2; m++)
+        for (dir = 0; dir < 2; dir++)
+            ok = ok && fwrite (table->rate[m][dir], sizeof(float), table->steps, f) == (size_t)table->steps ;
+    return (fclose (f) == 0) && ok ;
+}
+
+BOOL initio_FfLoad (initio_ffTable *table, const char *path)
+{
+    FILE *f = fopen (path, "rb") ;
+    char magic[8] ;
+    int32_t hdr[2] ;
+    BOOL ok ;
+    int m, dir ;
+
+    if (f == NULL)
+        return FALSE ;
+    memset (table, 0, sizeof(initio_ffTable)) ;
+    ok = fread (magic, 8, 1, f) == 1 && memcmp (magic, MAGIC, 8) == 0
+      && fread (hdr, sizeof(hdr), 1, f) == 1
+      && hdr[1] >= 1 && hdr[1] <= 100 && hdr[0] == (100 + hdr[1] - 1) / hdr[1] + 1 && hdr[0] <= INITIO_FF_STEPS
+      && fread (table->stall, sizeof(table->stall), 1, f) == 1 ;
+    if (ok)
+    {
+        table->steps = hdr[0] ;
+        table->step = hdr[1] ;
+    }
+    for (m = 0; m < 2; m++)
+        for (dir = 0; dir < 2; dir++)
+            ok = ok && fread (table->rate[m][dir], sizeof(float), table->steps, f) == (size_t)table->steps ;
+    fclose (f) ;
+    return ok ;
+}
+
+double initio_FfRate (const initio_ffTable *table, int motor, int duty)
+{
+    const float *rate = table->rate[motor][duty < 0] ;
+    int d = abs (duty), i, d0, d1 ;
+    double r ;
+
+    if (d > 100)
+        d = 100 ;
+    for (i = 1; i < table->steps - 1 && dutyAt (table, i) < d; i++)
+        ;
+    // d within duties of steps i-1 and i
+    d0 = dutyAt (table, i - 1) ;
+    d1 = dutyAt (table, i) ;
+    r = rate[i - 1] + (rate[i] - rate[i - 1]) * (d - d0) / (double)(d1 - d0) ;
+    return (duty < 0) ? -r : r ;
+}
+
+int initio_FfDuty (const initio_ffTable *table, int motor, double rate)
+{
+    int dir = rate < 0, i, d0, d1, duty, move ;
+    const float *r = table->rate[motor][dir] ;
+    double want = fabs (rate) ;
+
+    if (want == 0 || table->steps < 2)
+        return 0 ;
+    for (i = 1; i < table->steps && r[i] < want; i++)
+        ;
+    if (i == table->steps)
+        duty = 100 ;
+    else
+    {
+        d0 = dutyAt (table, i - 1) ;
+        d1 = dutyAt (table, i) ;
+        duty = (int)lround (d0 + (d1 - d0) * (want - r[i - 1]) / (r[i] - r[i - 1])) ;
+        // below the step after the stall duty the wheel is not known to move
+        move = table->stall[motor][dir] + table->step ;
+        if (move > 100)
+            move = 100 ;
+        if (duty < move)
+            duty = move ;
+    }
+    return dir ? -duty : duty ;
+}
+
+void initio_FfSetSpeeds (initio_ctx *ctx, const initio_ffTable *table, double left, double right)
+{
+    if (ctx == NULL)
+        ctx = initio_DefaultCtx () ;
+    initio_ctxSetMotors (ctx, initio_FfDuty (table, INITIO_FF_LEFT, left),
+                         initio_FfDuty (table, INITIO_FF_RIGHT, right)) ;
+}
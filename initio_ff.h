@@ -0,0 +1,97 @@
+#ifndef _4TRONIX_INITIO_FF_H_
+#define _4TRONIX_INITIO_FF_H_
+//======================================================================
+//
+// Motor characterisation and feedforward of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// The duty of the motor functions is no speed: a wheel does not turn
+// below a stall duty, and above it the speed is not proportional to the
+// duty and differs between the motors and directions. initio_FfCalibrate
+// sweeps the duty of both motors in steps, forward and in reverse, and
+// measures the wheel pulse rates (wheel sensors on pins 15/16); the table
+// keeps the rate per motor, direction and duty step, made monotonic, and
+// the stall duties. It is stored in a small binary file.
+//
+// With the table, initio_FfDuty returns the duty for a wheel speed in
+// pulses/s by inverse interpolation, so a speed controller starts from
+// nearly the right duty and only has to correct the rest.
+//
+// The calibration drives the robot: lift the wheels off the ground or
+// give it room for some metres straight ahead and back. The wheel sensors
+// cannot tell the direction, reverse rates are taken as negative.
+//
+//======================================================================
+
+#include "initio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INITIO_FF_STEPS 51      // most duty steps of a table (step 2: 0, 2, ..., 100)
+
+#define INITIO_FF_LEFT  0       // motors of the table
+#define INITIO_FF_RIGHT 1
+
+typedef struct {
+    int step ;                 // duty step of the sweep (1..100)
+    double settle ;            // s to wait after a duty change before measuring
+    double measure ;           // s to count pulses per duty step
+    double minRate ;           // pulses/s below which a wheel counts as stalled
+} initio_ffParams ;
+
+typedef struct {
+    int steps ;                // duty steps: duties 0, step, 2*step, ..., 100
+    int step ;
+    float rate[2][2][INITIO_FF_STEPS] ;  // [motor][0: forward, 1: reverse] pulses/s
+                                         // (unsigned) at duty i*step, non-decreasing
+    int8_t stall[2][2] ;       // [motor][direction] largest step duty not moving the wheel (0: none)
+} initio_ffTable ;
+
+// Waits seconds during a calibration; in a simulation it advances the
+// simulated time.
+typedef void (*initio_ffWait) (void *arg, double seconds) ;
+
+// initio_FfDefaultParams (params):
+// Fills params with a sweep in steps of 5, settling 0.5 s and measuring
+// 1 s per step (about 1 minute), stall below 0.5 pulses/s.
+void initio_FfDefaultParams (initio_ffParams *params) ;
+
+// initio_FfCalibrate (ctx, params, table, wait, arg):
+// Sweeps both motors of ctx (NULL: default context) forward and in reverse
+// and fills table. params == NULL selects the defaults, wait == NULL
+// sleeps. The motors are stopped at the end. Returns FALSE on invalid
+// parameters or if no wheel pulse was seen at all (sensors missing).
+BOOL initio_FfCalibrate (initio_ctx *ctx, const initio_ffParams *params,
+                         initio_ffTable *table, initio_ffWait wait, void *arg) ;
+
+// initio_FfSave (table, path), initio_FfLoad (table, path):
+// Writes/reads table as binary file (356 bytes with steps of 5). Return FALSE on error.
+BOOL initio_FfSave (const initio_ffTable *table, const char *path) ;
+BOOL initio_FfLoad (initio_ffTable *table, const char *path) ;
+
+// initio_FfRate (table, motor, duty):
+// Returns the wheel speed of motor at a signed duty in pulses/s (signed).
+double initio_FfRate (const initio_ffTable *table, int motor, int duty) ;
+
+// initio_FfDuty (table, motor, rate):
+// Returns the signed duty giving motor the signed wheel speed rate in
+// pulses/s: 0 for rate 0, at least the first measured duty that moved
+// the wheel (stall + step, at most 100; step if the first step already
+// moved it) for any other rate, 100 for rates beyond the table.
+int initio_FfDuty (const initio_ffTable *table, int motor, double rate) ;
+
+// initio_FfSetSpeeds (ctx, table, left, right):
+// Sets the motors of ctx (NULL: default context) to the duties of the
+// signed wheel speeds left and right in pulses/s.
+void initio_FfSetSpeeds (initio_ctx *ctx, const initio_ffTable *table, double left, double right) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_FF_H_ */
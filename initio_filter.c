@@ -0,0 +1,212 @@
+//======================================================================
+//
+// Debounce and glitch filter of the digital inputs of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "initio_filter.h"
+
+struct initio_filter {
+    initio_ctx *ctx ;
+    initio_filterParams params ;
+    initio_filterCore core ;       // sampling thread only
+    unsigned int raw ;             // last raw sample, sampling thread only
+    unsigned int sense ;           // filtered levels, atomic
+    initio_filterStats stats ;     // counters, atomic
+    initio_rate *rate ;
+} ;
+
+void initio_FilterDefaultParams (initio_filterParams *params)
+{
+    int i ;
+
+    params->hz = 20000 ;
+    for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+    {
+        params->majority[i] = 3 ;
+        params->debounceUs[i] = ((1 << i) & (INITIO_SENSE_WHEELLEFT | INITIO_SENSE_WHEELRIGHT)) ? 200 : 2000 ;
+    }
+}
+
+void initio_FilterInit (initio_filterCore *core, const initio_filterParams *params, unsigned int initial)
+{
+    long samples ;
+    int i, j ;
+
+    memset (core, 0, sizeof(*core)) ;
+    for (j = 0; j < 14; j++)
+        core->hist[j] = initial ;
+    core->state = initial ;
+    for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+    {
+        switch (params->majority[i])
+        {
+        case 3:  core->win3 |= 1u << i ; break ;
+        case 5:  core->win5 |= 1u << i ; break ;
+        case 7:  core->win7 |= 1u << i ; break ;
+        default: core->win1 |= 1u << i ; break ;
+        }
+        samples = lround (params->debounceUs[i] * 1e-6 * params->hz) ;
+        if (samples < 1)
+            samples = 1 ;
+        if (samples > (1 << INITIO_FILTER_BITS) - 1)
+            samples = (1 << INITIO_FILTER_BITS) - 1 ;
+        for (j = 0; j < INITIO_FILTER_BITS; j++)
+            if (samples & (1 << j))
+                core->limit[j] |= 1u << i ;
+    }
+}
+
+unsigned int initio_FilterStep (initio_filterCore *core, unsigned int raw)
+{
+    uint32_t s0 = 0, s1 = 0, s2 = 0, c0, c1, maj5 = 0 ;
+    uint32_t in, diff, carry, t, equal, *h ;
+    int j ;
+
+    // majority: bit-sliced sum s2 s1 s0 of the last samples; the history
+    // is stored twice so h[0] (newest) .. h[6] (oldest) are contiguous
+    core->pos = (core->pos == 0) ? 6 : core->pos - 1 ;
+    core->hist[core->pos] = core->hist[core->pos + 7] = raw ;
+    h = &core->hist[core->pos] ;
+    in = (raw & core->win1) | (((h[0] & h[1]) | (h[0] & h[2]) | (h[1] & h[2])) & core->win3) ;
+    if (core->win5 | core->win7)
+    {
+        for (j = 0; j < 7; j++)
+        {
+            c0 = s0 & h[j] ;
+            s0 ^= h[j] ;
+            c1 = s1 & c0 ;
+            s1 ^= c0 ;
+            s2 |= c1 ;
+            if (j == 4)
+                maj5 = s2 | (s1 & s0) ;  // >= 3 of 5
+        }
+        in |= (maj5 & core->win5) | (s2 & core->win7) ;  // >= 4 of 7
+    }
+
+    // debounce: count the samples that differ from the state, reset the
+    // counters of the inputs that agree, take the inputs whose count
+    // reaches their limit
+    diff = in ^ core->state ;
+    carry = diff ;
+    equal = diff ;
+    for (j = 0; j < INITIO_FILTER_BITS; j++)
+    {
+        t = core->count[j] & carry ;
+        core->count[j] = (core->count[j] ^ carry) & diff ;
+        carry = t ;
+        equal &= ~(core->count[j] ^ core->limit[j]) ;
+    }
+    core->state ^= equal ;
+    for (j = 0; j < INITIO_FILTER_BITS; j++)
+        core->count[j] &= ~equal ;
+    return core->state ;
+}
+
+// sample(): reads the six inputs of ctx as INITIO_SENSE_* bits
+static unsigned int sample (initio_ctx *ctx)
+{
+    return (initio_ctxIrLeft (ctx) ? INITIO_SENSE_IRLEFT : 0)
+         | (initio_ctxIrRight (ctx) ? INITIO_SENSE_IRRIGHT : 0)
+         | (initio_ctxIrLineLeft (ctx) ? INITIO_SENSE_LINELEFT : 0)
+         | (initio_ctxIrLineRight (ctx) ? INITIO_SENSE_LINERIGHT : 0)
+         | (initio_ctxWheelSensorLeft (ctx) ? INITIO_SENSE_WHEELLEFT : 0)
+         | (initio_ctxWheelSensorRight (ctx) ? INITIO_SENSE_WHEELRIGHT : 0) ;
+}
+
+// countChanges(): counts the inputs that changed, one counter per bit
+static void countChanges (unsigned long *counters, unsigned int changed)
+{
+    int i ;
+
+    for (i = 0; changed != 0; i++, changed >>= 1)
+        if (changed & 1)
+            __atomic_add_fetch (&counters[i], 1, __ATOMIC_RELAXED) ;
+}
+
+static BOOL samplerCycle (void *arg)
+{
+    initio_filter *filter = arg ;
+    unsigned int raw = sample (filter->ctx), old = filter->core.state, state ;
+
+    state = initio_FilterStep (&filter->core, raw) ;
+    if (raw != filter->raw)
+        countChanges (filter->stats.rawChanges, raw ^ filter->raw) ;
+    if (state != old)
+    {
+        countChanges (filter->stats.changes, state ^ old) ;
+        __atomic_store_n (&filter->sense, state, __ATOMIC_RELEASE) ;
+    }
+    filter->raw = raw ;
+    __atomic_add_fetch (&filter->stats.samples, 1, __ATOMIC_RELAXED) ;
+    return TRUE ;
+}
+
+initio_filter *initio_FilterStart (initio_ctx *ctx, const initio_filterParams *params)
+{
+    initio_filter *filter = calloc (1, sizeof(initio_filter)) ;
+
+    if (filter == NULL)
+        return NULL ;
+    filter->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    if (params != NULL)
+        filter->params = *params ;
+    else
+        initio_FilterDefaultParams (&filter->params) ;
+    if (filter->params.hz <= 0)
+    {
+        free (filter) ;
+        return NULL ;
+    }
+    // start from the current levels rather than debouncing into them
+    filter->raw = sample (filter->ctx) ;
+    filter->sense = filter->raw ;
+    initio_FilterInit (&filter->core, &filter->params, filter->raw) ;
+
+    filter->rate = initio_RateStart (filter->params.hz, samplerCycle, filter) ;
+    if (filter->rate == NULL)
+    {
+        free (filter) ;
+        return NULL ;
+    }
+    return filter ;
+}
+
+void initio_FilterStop (initio_filter *filter, initio_filterStats *stats)
+{
+    initio_rateStats rs ;
+
+    initio_RateStop (filter->rate, &rs) ;
+    if (stats != NULL)
+    {
+        *stats = filter->stats ;
+        stats->rate = rs ;
+    }
+    free (filter) ;
+}
+
+unsigned int initio_FilterSense (initio_filter *filter)
+{
+    return __atomic_load_n (&filter->sense, __ATOMIC_ACQUIRE) ;
+}
+
+void initio_FilterGetStats (initio_filter *filter, initio_filterStats *stats)
+{
+    int i ;
+
+    stats->samples = __atomic_load_n (&filter->stats.samples, __ATOMIC_RELAXED) ;
+    for (i = 0; i < INITIO_FILTER_INPUTS; i++)
+    {
+        stats->rawChanges[i] = __atomic_load_n (&filter->stats.rawChanges[i], __ATOMIC_RELAXED) ;
+        stats->changes[i] = __atomic_load_n (&filter->stats.changes[i], __ATOMIC_RELAXED) ;
+    }
+    initio_RateGetStats (filter->rate, &stats->rate) ;
+}
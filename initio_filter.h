@@ -0,0 +1,101 @@
+#ifndef _4TRONIX_INITIO_FILTER_H_
+#define _4TRONIX_INITIO_FILTER_H_
+//======================================================================
+//
+// Debounce and glitch filter of the digital inputs of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Filters the six digital inputs (IR obstacle, IR line and wheel sensors)
+// as one bit vector per sample, bit i being INITIO_SENSE_* (1 << i), with
+// bitwise operations on all inputs at once:
+//   o a majority filter removes glitches: an input is the level it had in
+//     most of the last 3, 5 or 7 samples (1: off),
+//   o a debounce takes a new level only after the majority output has
+//     stayed at it for a number of consecutive samples. The sample counts
+//     of all inputs are kept as vertical counters (bit j of the counts of
+//     all inputs in one word), so one sample costs some 40 word operations
+//     whatever the number of inputs.
+// Window and debounce time are set per input. initio_FilterStep is the
+// filter alone, for any sampling loop; initio_FilterStart samples the
+// inputs of a context in a fixed-rate thread (initio_rate.h) and
+// publishes the filtered levels.
+//
+//======================================================================
+
+#include <stdint.h>
+#include "initio.h"
+#include "initio_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INITIO_FILTER_INPUTS 6     // bit i: INITIO_SENSE_* == 1 << i
+#define INITIO_FILTER_BITS   8     // debounce counts up to 255 samples
+
+typedef struct {
+    double hz ;                                       // sampling rate
+    unsigned int debounceUs[INITIO_FILTER_INPUTS] ;   // time a new level must hold
+    int majority[INITIO_FILTER_INPUTS] ;              // window in samples: 1, 3, 5 or 7
+} initio_filterParams ;
+
+// State of the filter (initio_FilterInit/initio_FilterStep)
+typedef struct {
+    uint32_t hist[14] ;                     // last 7 raw samples, twice, newest at pos
+    int pos ;
+    uint32_t win1, win3, win5, win7 ;       // inputs per majority window
+    uint32_t count[INITIO_FILTER_BITS] ;    // vertical counters of the debounce
+    uint32_t limit[INITIO_FILTER_BITS] ;    // their limits, bit-sliced alike
+    uint32_t state ;                        // filtered levels
+} initio_filterCore ;
+
+typedef struct {
+    unsigned long samples ;
+    unsigned long rawChanges[INITIO_FILTER_INPUTS] ;  // level changes sampled
+    unsigned long changes[INITIO_FILTER_INPUTS] ;     // level changes after filtering
+    initio_rateStats rate ;                           // timing of the sampling thread
+} initio_filterStats ;
+
+typedef struct initio_filter initio_filter ;
+
+// initio_FilterDefaultParams (params):
+// Fills params with 20000 samples/s, windows of 3 samples, 2 ms debounce
+// for the IR and line sensors and 0.2 ms for the wheel sensors.
+void initio_FilterDefaultParams (initio_filterParams *params) ;
+
+// initio_FilterInit (core, params, initial):
+// Sets up core for params (debounce times are rounded to samples at
+// params->hz, 1..255) with the filtered levels initial.
+void initio_FilterInit (initio_filterCore *core, const initio_filterParams *params, unsigned int initial) ;
+
+// initio_FilterStep (core, raw):
+// Filters one sample raw of the INITIO_SENSE_* bits; returns the
+// filtered levels.
+unsigned int initio_FilterStep (initio_filterCore *core, unsigned int raw) ;
+
+// initio_FilterStart (ctx, params):
+// Samples the inputs of ctx (NULL: default context) at params->hz through
+// the filter; params == NULL selects the defaults. Returns NULL on error.
+initio_filter *initio_FilterStart (initio_ctx *ctx, const initio_filterParams *params) ;
+
+// initio_FilterStop (filter, stats):
+// Stops sampling and frees filter. If stats != NULL the final statistics
+// are copied to it.
+void initio_FilterStop (initio_filter *filter, initio_filterStats *stats) ;
+
+// initio_FilterSense (filter):
+// Returns the filtered levels as INITIO_SENSE_* bits; lock-free.
+unsigned int initio_FilterSense (initio_filter *filter) ;
+
+// initio_FilterGetStats (filter, stats):
+// Copies the counters and the timing of the sampling thread.
+void initio_FilterGetStats (initio_filter *filter, initio_filterStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_FILTER_H_ */
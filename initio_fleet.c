@@ -0,0 +1,587 @@
+//======================================================================
+//
+// Batch simulation of a fleet of initio robots.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "initio_fleet.h"
+
+#define LANES 4  // robots per vector
+
+// GCC vector extensions: SSE on x86, NEON on ARMv7/v8, scalar code elsewhere
+typedef float v4f __attribute__ ((vector_size (16))) ;
+typedef int32_t v4i __attribute__ ((vector_size (16))) ;
+typedef uint32_t v4u __attribute__ ((vector_size (16))) ;
+
+#define LOAD(p)  (*(v4f *)(p))
+#define LOADU(p) (*(v4u *)(p))
+
+struct initio_fleet {
+    initio_fleetState s ;   // arrays padded to a multiple of LANES
+    int padded ;
+    initio_fleetParams params ;
+    initio_fleetWorld world ;
+
+    // thread pool: worker i steps block i+1, the caller block 0
+    int threads ;
+    pthread_t *workers ;
+    pthread_mutex_t mutex ;
+    pthread_cond_t go, done ;
+    unsigned long generation ;
+    int pending ;
+    int quit ;
+    float dt ;
+} ;
+
+typedef struct {
+    initio_fleet *fleet ;
+    int index ;
+} worker_t ;
+
+
+//======================================================================
+// Vector Helpers
+
+static inline v4f vsplat (float f)
+{
+    return (v4f){ f, f, f, f } ;
+}
+
+static inline v4f vsel (v4i mask, v4f a, v4f b)
+{
+    return (v4f)((mask & (v4i)a) | (~mask & (v4i)b)) ;
+}
+
+static inline v4f vmin (v4f a, v4f b)
+{
+    return vsel (a < b, a, b) ;
+}
+
+static inline v4f vmax (v4f a, v4f b)
+{
+    return vsel (a > b, a, b) ;
+}
+
+static inline v4f vabs (v4f a)
+{
+    return (v4f)((v4i)a & 0x7fffffff) ;
+}
+
+static inline v4f vsqrt (v4f a)
+{
+    v4f r ;
+    int i ;
+    for (i = 0; i < LANES; i++)
+        r[i] = __builtin_sqrtf (a[i]) ;
+    return r ;
+}
+
+// vtrunc(): rounds towards zero (|a| < 2^31)
+static inline v4f vtrunc (v4f a)
+{
+    return __builtin_convertvector (__builtin_convertvector (a, v4i), v4f) ;
+}
+
+// vwrap(): maps an angle into [-pi, pi]
+static inline v4f vwrap (v4f a)
+{
+    v4f k = a * (float)(0.5 / M_PI) ;
+    k = vtrunc (k + vsel (k < 0, vsplat (-0.5f), vsplat (0.5f))) ;
+    return a - k * (float)(2 * M_PI) ;
+}
+
+// vsin(): sine of an angle in [-pi, pi], error < 1e-6
+static inline v4f vsin (v4f a)
+{
+    const float h = (float)(M_PI / 2) ;
+    v4f x2 ;
+
+    a = vsel (a > h, (float)M_PI - a, a) ;     // fold into [-pi/2, pi/2]
+    a = vsel (a < -h, (float)-M_PI - a, a) ;
+    x2 = a * a ;
+    return a * (1.0f + x2 * (-1.0f / 6 + x2 * (1.0f / 120 + x2 * (-1.0f / 5040 +
+               x2 * (1.0f / 362880 + x2 * (-1.0f / 39916800)))))) ;
+}
+
+// vcos(): cosine of an angle in [-pi, pi]
+static inline v4f vcos (v4f a)
+{
+    a = a + (float)(M_PI / 2) ;
+    return vsin (vsel (a > (float)M_PI, a - (float)(2 * M_PI), a)) ;
+}
+
+// vrandom(): xorshift32 per lane, returns uniform numbers in [0, 1)
+static inline v4f vrandom (v4u *state)
+{
+    v4u x = *state ;
+    x ^= x << 13 ;
+    x ^= x >> 17 ;
+    x ^= x << 5 ;
+    *state = x ;
+    return __builtin_convertvector (x >> 8, v4f) * (1.0f / 16777216) ;
+}
+
+// vgauss(): approximately normal numbers (sum of four uniforms), std. deviation 1
+static inline v4f vgauss (v4u *state)
+{
+    v4f sum = vrandom (state) + vrandom (state) + vrandom (state) + vrandom (state) ;
+    return (sum - 2.0f) * 1.7320508f ;
+}
+
+// End of Vector Helpers
+//======================================================================
+
+
+
+//======================================================================
+// Kernels
+
+// wheelSpeed(): steady-state speed of signed duties (see initio_SimWheelSpeed)
+static inline v4f wheelSpeed (const initio_simParams *p, v4f duty)
+{
+    v4f mag = vmax (vabs (duty) - (float)p->stallDuty, vsplat (0)) ;
+    v4f speed = mag * (float)(p->maxSpeed / (100.0 - p->stallDuty)) ;
+    return vsel (duty < 0, -speed, speed) ;
+}
+
+// castRay(): distance from (px, py) in direction (dx, dy) to the nearest wall or obstacle
+static v4f castRay (const initio_fleetWorld *w, v4f px, v4f py, v4f dx, v4f dy)
+{
+    v4f dxs = vsel (dx >= 0, vmax (dx, vsplat (1e-9f)), vmin (dx, vsplat (-1e-9f))) ;
+    v4f dys = vsel (dy >= 0, vmax (dy, vsplat (1e-9f)), vmin (dy, vsplat (-1e-9f))) ;
+    v4f t = vmin (vsel (dx >= 0, w->width - px, -px) / dxs,
+                  vsel (dy >= 0, w->height - py, -py) / dys) ;
+    int i ;
+
+    t = vmax (t, vsplat (0)) ;
+    for (i = 0; i < w->numObstacles; i++)
+    {
+        const initio_circle *c = &w->obstacles[i] ;
+        v4f ox = px - c->x, oy = py - c->y ;
+        v4f b = ox * dx + oy * dy ;
+        v4f disc = b * b - (ox * ox + oy * oy - c->r * c->r) ;
+        v4f hit = -b - vsqrt (vmax (disc, vsplat (0))) ;
+        t = vsel ((disc >= 0) & (hit >= 0), vmin (t, hit), t) ;
+    }
+    return t ;
+}
+
+// onLine(): whether points are on the circular line track
+static inline v4i onLine (const initio_fleetWorld *w, v4f px, v4f py)
+{
+    v4f ox = px - w->line.x, oy = py - w->line.y ;
+    v4f d = vsqrt (ox * ox + oy * oy) ;
+    return vabs (d - w->line.r) < (0.5f * w->lineWidth) ;
+}
+
+// senseBlock(): evaluates the sensors of the robots at i .. i+LANES-1
+static void senseBlock (initio_fleet *fleet, int i)
+{
+    const initio_fleetParams *p = &fleet->params ;
+    const initio_fleetWorld *w = &fleet->world ;
+    initio_fleetState *s = &fleet->s ;
+    v4f theta = LOAD (&s->theta[i]) ;
+    v4f c = vcos (theta), sn = vsin (theta) ;
+    v4f fx = LOAD (&s->x[i]) + c * p->sensorOffset ;   // front centre
+    v4f fy = LOAD (&s->y[i]) + sn * p->sensorOffset ;
+    v4f ca = vsplat (cosf (p->irAngle)), sa = vsplat (sinf (p->irAngle)) ;
+    v4f range, q, lx, ly ;
+    v4i bits = { 0, 0, 0, 0 } ;
+    v4u rng = LOADU (&s->rng[i]) ;
+    int k ;
+
+    // sonar straight ahead, with noise; out of range reads 0
+    range = castRay (w, fx, fy, c, sn) + vgauss (&rng) * p->sonarNoise ;
+    range = vmax (range, vsplat (0)) ;
+    LOAD (&s->sonar[i]) = vsel (range > p->sonarMax, vsplat (0), range) ;
+    LOADU (&s->rng[i]) = rng ;
+
+    // IR obstacle sensors looking irAngle to the left/right
+    bits |= (castRay (w, fx, fy, c * ca - sn * sa, sn * ca + c * sa) < p->irRange) & INITIO_SENSE_IRLEFT ;
+    bits |= (castRay (w, fx, fy, c * ca + sn * sa, sn * ca - c * sa) < p->irRange) & INITIO_SENSE_IRRIGHT ;
+
+    // line sensors left/right of the front centre
+    if (w->line.r > 0)
+    {
+        lx = -sn * (0.5f * p->lineSpacing) ;
+        ly = c * (0.5f * p->lineSpacing) ;
+        bits |= onLine (w, fx + lx, fy + ly) & INITIO_SENSE_LINELEFT ;
+        bits |= onLine (w, fx - lx, fy - ly) & INITIO_SENSE_LINERIGHT ;
+    }
+
+    // wheel sensors: high during the first half of each tick
+    q = LOAD (&s->distLeft[i]) * (float)(1.0 / p->chassis.cmPerTick) ;
+    bits |= ((q - vtrunc (q)) < 0.5f) & INITIO_SENSE_WHEELLEFT ;
+    q = LOAD (&s->distRight[i]) * (float)(1.0 / p->chassis.cmPerTick) ;
+    bits |= ((q - vtrunc (q)) < 0.5f) & INITIO_SENSE_WHEELRIGHT ;
+
+    for (k = 0; k < LANES; k++)
+        s->sensors[i + k] = (uint8_t)bits[k] ;
+}
+
+// stepBlock(): advances the robots at i .. i+LANES-1 by dt
+static void stepBlock (initio_fleet *fleet, int i, float dt)
+{
+    const initio_fleetParams *p = &fleet->params ;
+    const initio_fleetWorld *w = &fleet->world ;
+    initio_fleetState *s = &fleet->s ;
+    float a = (p->chassis.tau > 0) ? 1 - expf (-dt / p->chassis.tau) : 1 ;
+    v4u rng = LOADU (&s->rng[i]) ;
+    v4f vl = LOAD (&s->vLeft[i]), vr = LOAD (&s->vRight[i]) ;
+    v4f x = LOAD (&s->x[i]), y = LOAD (&s->y[i]), theta = LOAD (&s->theta[i]) ;
+    v4f sl, sr, ds, dth, mid ;
+    int k ;
+
+    // first-order lag towards the steady-state wheel speeds, with slip noise
+    vl += a * (wheelSpeed (&p->chassis, LOAD (&s->dutyLeft[i])) * (1.0f + vgauss (&rng) * p->slip) - vl) ;
+    vr += a * (wheelSpeed (&p->chassis, LOAD (&s->dutyRight[i])) * (1.0f + vgauss (&rng) * p->slip) - vr) ;
+
+    sl = vl * dt ;
+    sr = vr * dt ;
+    ds = (sl + sr) * 0.5f ;
+    dth = (sr - sl) * (float)(1.0 / p->chassis.wheelBase) ;
+    mid = vwrap (theta + dth * 0.5f) ;
+    x += ds * vcos (mid) ;
+    y += ds * vsin (mid) ;
+    theta = vwrap (theta + dth) ;
+
+    // robots cannot pass walls or obstacles
+    x = vmin (vmax (x, vsplat (0)), vsplat (w->width)) ;
+    y = vmin (vmax (y, vsplat (0)), vsplat (w->height)) ;
+    for (k = 0; k < w->numObstacles; k++)
+    {
+        const initio_circle *c = &w->obstacles[k] ;
+        v4f ox = x - c->x, oy = y - c->y ;
+        v4f d = vsqrt (ox * ox + oy * oy) ;
+        v4i inside = (d < c->r) & (d > 1e-6f) ;
+        v4f f = c->r / vmax (d, vsplat (1e-6f)) ;
+        x = vsel (inside, c->x + ox * f, x) ;
+        y = vsel (inside, c->y + oy * f, y) ;
+    }
+
+    LOAD (&s->vLeft[i]) = vl ;
+    LOAD (&s->vRight[i]) = vr ;
+    LOAD (&s->x[i]) = x ;
+    LOAD (&s->y[i]) = y ;
+    LOAD (&s->theta[i]) = theta ;
+    LOAD (&s->distLeft[i]) += vabs (sl) ;
+    LOAD (&s->distRight[i]) += vabs (sr) ;
+    LOADU (&s->rng[i]) = rng ;
+
+    senseBlock (fleet, i) ;
+}
+
+// stepRange(): steps the share of worker index (index 0 == caller)
+static void stepRange (initio_fleet *fleet, int index, float dt)
+{
+    int blocks = fleet->padded / LANES ;
+    int first = (int)((long)blocks * index / fleet->threads) ;
+    int last = (int)((long)blocks * (index + 1) / fleet->threads) ;
+    int b ;
+
+    for (b = first; b < last; b++)
+        stepBlock (fleet, b * LANES, dt) ;
+}
+
+// End of Kernels
+//======================================================================
+
+
+
+//======================================================================
+// Thread Pool
+
+static void *workerThread (void *arg)
+{
+    worker_t *wk = arg ;
+    initio_fleet *fleet = wk->fleet ;
+    unsigned long seen = 0 ;
+
+    pthread_mutex_lock (&fleet->mutex) ;
+    for (;;)
+    {
+        while (fleet->generation == seen && !fleet->quit)
+            pthread_cond_wait (&fleet->go, &fleet->mutex) ;
+        if (fleet->quit)
+            break ;
+        seen = fleet->generation ;
+        pthread_mutex_unlock (&fleet->mutex) ;
+
+        stepRange (fleet, wk->index, fleet->dt) ;
+
+        pthread_mutex_lock (&fleet->mutex) ;
+        if (--fleet->pending == 0)
+            pthread_cond_signal (&fleet->done) ;
+    }
+    pthread_mutex_unlock (&fleet->mutex) ;
+    free (wk) ;
+    return NULL ;
+}
+
+// End of Thread Pool
+//======================================================================
+
+
+
+//======================================================================
+// Fleet Functions
+
+static uint32_t splitmix32 (uint32_t x)
+{
+    x += 0x9e3779b9 ;
+    x = (x ^ (x >> 16)) * 0x85ebca6b ;
+    x = (x ^ (x >> 13)) * 0xc2b2ae35 ;
+    x ^= x >> 16 ;
+    return (x != 0) ? x : 1 ;  // xorshift state must not be 0
+}
+
+static float uniform (uint32_t *state)
+{
+    uint32_t x = *state ;
+    x ^= x << 13 ;
+    x ^= x >> 17 ;
+    x ^= x << 5 ;
+    *state = x ;
+    return (x >> 8) * (1.0f / 16777216) ;
+}
+
+void initio_FleetDefaultParams (initio_fleetParams *params)
+{
+    initio_SimDefaultParams (&params->chassis) ;
+    params->slip = 0.02f ;
+    params->sonarNoise = 1.0f ;
+    params->sonarMax = 400.0f ;
+    params->irRange = 15.0f ;
+    params->irAngle = 0.35f ;
+    params->sensorOffset = 10.0f ;
+    params->lineSpacing = 4.0f ;
+}
+
+initio_fleet *initio_FleetCreate (int count, int threads, const initio_fleetParams *params,
+                                  const initio_fleetWorld *world, uint32_t seed)
+{
+    initio_fleet *fleet ;
+    initio_fleetState *s ;
+    float **arrays[10] ;
+    size_t bytes ;
+    int i ;
+
+    if (count < 1 || world == NULL || world->width <= 0 || world->height <= 0)
+        return NULL ;
+    fleet = calloc (1, sizeof(initio_fleet)) ;
+    if (fleet == NULL)
+        return NULL ;
+    s = &fleet->s ;
+    s->count = count ;
+    fleet->padded = (count + LANES - 1) / LANES * LANES ;
+    if (params != NULL)
+        fleet->params = *params ;
+    else
+        initio_FleetDefaultParams (&fleet->params) ;
+    fleet->world = *world ;
+
+    // one cache line aligned array per state variable
+    arrays[0] = &s->x ; arrays[1] = &s->y ; arrays[2] = &s->theta ;
+    arrays[3] = &s->dutyLeft ; arrays[4] = &s->dutyRight ;
+    arrays[5] = &s->vLeft ; arrays[6] = &s->vRight ;
+    arrays[7] = &s->distLeft ; arrays[8] = &s->distRight ; arrays[9] = &s->sonar ;
+    bytes = (fleet->padded * sizeof(float) + 63) / 64 * 64 ;
+    for (i = 0; i < 10; i++)
+    {
+        *arrays[i] = aligned_alloc (64, bytes) ;
+        if (*arrays[i] == NULL)
+            goto error ;
+        memset (*arrays[i], 0, bytes) ;
+    }
+    s->rng = aligned_alloc (64, bytes) ;
+    s->sensors = calloc (fleet->padded, 1) ;
+    if (s->rng == NULL || s->sensors == NULL)
+        goto error ;
+
+    // deterministic start poses (padding lanes are simulated as well)
+    for (i = 0; i < fleet->padded; i++)
+    {
+        s->rng[i] = splitmix32 (seed ^ splitmix32 (i)) ;
+        s->x[i] = world->width * (0.1f + 0.8f * uniform (&s->rng[i])) ;
+        s->y[i] = world->height * (0.1f + 0.8f * uniform (&s->rng[i])) ;
+        s->theta[i] = (float)(2 * M_PI) * (uniform (&s->rng[i]) - 0.5f) ;
+    }
+    for (i = 0; i < fleet->padded; i += LANES)
+        senseBlock (fleet, i) ;
+
+    // thread pool
+    fleet->threads = (threads < 1) ? 1 : threads ;
+    if (fleet->threads > fleet->padded / LANES)
+        fleet->threads = fleet->padded / LANES ;
+    pthread_mutex_init (&fleet->mutex, NULL) ;
+    pthread_cond_init (&fleet->go, NULL) ;
+    pthread_cond_init (&fleet->done, NULL) ;
+    fleet->workers = calloc (fleet->threads, sizeof(pthread_t)) ;
+    if (fleet->workers == NULL)
+        goto error ;
+    for (i = 1; i < fleet->threads; i++)
+    {
+        worker_t *wk = malloc (sizeof(worker_t)) ;
+        if (wk == NULL)
+            break ;
+        wk->fleet = fleet ;
+        wk->index = i ;
+        if (pthread_create (&fleet->workers[i], NULL, workerThread, wk) != 0)
+        {
+            free (wk) ;
+            break ;
+        }
+    }
+    fleet->threads = i ;  // fewer threads if creation failed
+    return fleet ;
+
+error:
+    initio_FleetFree (fleet) ;
+    return NULL ;
+}
+
+void initio_FleetFree (initio_fleet *fleet)
+{
+    initio_fleetState *s ;
+    int i ;
+
+    if (fleet == NULL)
+        return ;
+    s = &fleet->s ;
+    if (fleet->workers != NULL)
+    {
+        pthread_mutex_lock (&fleet->mutex) ;
+        fleet->quit = TRUE ;
+        pthread_cond_broadcast (&fleet->go) ;
+        pthread_mutex_unlock (&fleet->mutex) ;
+        for (i = 1; i < fleet->threads; i++)
+            pthread_join (fleet->workers[i], NULL) ;
+        free (fleet->workers) ;
+        pthread_mutex_destroy (&fleet->mutex) ;
+        pthread_cond_destroy (&fleet->go) ;
+        pthread_cond_destroy (&fleet->done) ;
+    }
+    free (s->x) ; free (s->y) ; free (s->theta) ;
+    free (s->dutyLeft) ; free (s->dutyRight) ;
+    free (s->vLeft) ; free (s->vRight) ;
+    free (s->distLeft) ; free (s->distRight) ; free (s->sonar) ;
+    free (s->rng) ;
+    free (s->sensors) ;
+    free (fleet) ;
+}
+
+const initio_fleetState *initio_FleetState (initio_fleet *fleet)
+{
+    return &fleet->s ;
+}
+
+void initio_FleetSetPose (initio_fleet *fleet, int robot, const initio_pose *pose)
+{
+    initio_fleetState *s = &fleet->s ;
+
+    if (robot < 0 || robot >= s->count)
+        return ;
+    s->x[robot] = pose->x ;
+    s->y[robot] = pose->y ;
+    s->theta[robot] = remainder (pose->theta, 2 * M_PI) ;
+    s->dutyLeft[robot] = s->dutyRight[robot] = 0 ;
+    s->vLeft[robot] = s->vRight[robot] = 0 ;
+    senseBlock (fleet, robot / LANES * LANES) ;
+}
+
+// commandDuties(): signed wheel duties of a motor command, as written to L1-L2 and R1-R2 by initio.c
+static void commandDuties (const initio_fleetCmd *cmd, float *left, float *right)
+{
+    float a = (cmd->a > 100) ? 100 : cmd->a, b = (cmd->b > 100) ? 100 : cmd->b ;  // as initio_FleetSetDuties
+
+    switch (cmd->op)
+    {
+    case INITIO_FLEET_DRIVEFORWARD: *left = a ;  *right = a ;  break ;
+    case INITIO_FLEET_DRIVEREVERSE: *left = -a ; *right = -a ; break ;
+    case INITIO_FLEET_SPINLEFT:     *left = -a ; *right = a ;  break ;
+    case INITIO_FLEET_SPINRIGHT:    *left = a ;  *right = -a ; break ;
+    case INITIO_FLEET_TURNFORWARD:  *left = a ;  *right = b ;  break ;
+    case INITIO_FLEET_TURNREVERSE:  *left = -a ; *right = -b ; break ;
+    default:                        *left = 0 ;  *right = 0 ;  break ;
+    }
+}
+
+void initio_FleetCommand (initio_fleet *fleet, const initio_fleetCmd *cmds)
+{
+    initio_fleetState *s = &fleet->s ;
+    int i ;
+
+    for (i = 0; i < s->count; i++)
+        commandDuties (&cmds[i], &s->dutyLeft[i], &s->dutyRight[i]) ;
+}
+
+void initio_FleetCommandAll (initio_fleet *fleet, const initio_fleetCmd *cmd)
+{
+    initio_fleetState *s = &fleet->s ;
+    float left, right ;
+    int i ;
+
+    commandDuties (cmd, &left, &right) ;
+    for (i = 0; i < s->count; i++)
+    {
+        s->dutyLeft[i] = left ;
+        s->dutyRight[i] = right ;
+    }
+}
+
+void initio_FleetSetDuties (initio_fleet *fleet, const int8_t *left, const int8_t *right)
+{
+    initio_fleetState *s = &fleet->s ;
+    int i ;
+
+    for (i = 0; i < s->count; i++)
+    {
+        s->dutyLeft[i] = (left[i] < -100) ? -100 : (left[i] > 100) ? 100 : left[i] ;
+        s->dutyRight[i] = (right[i] < -100) ? -100 : (right[i] > 100) ? 100 : right[i] ;
+    }
+}
+
+void initio_FleetStep (initio_fleet *fleet, double dt)
+{
+    if (fleet->threads > 1)
+    {
+        pthread_mutex_lock (&fleet->mutex) ;
+        fleet->dt = (float)dt ;
+        fleet->pending = fleet->threads - 1 ;
+        fleet->generation++ ;
+        pthread_cond_broadcast (&fleet->go) ;
+        pthread_mutex_unlock (&fleet->mutex) ;
+    }
+
+    stepRange (fleet, 0, (float)dt) ;
+
+    if (fleet->threads > 1)
+    {
+        pthread_mutex_lock (&fleet->mutex) ;
+        while (fleet->pending > 0)
+            pthread_cond_wait (&fleet->done, &fleet->mutex) ;
+        pthread_mutex_unlock (&fleet->mutex) ;
+    }
+}
+
+void initio_FleetGetSensors (initio_fleet *fleet, uint8_t *bits)
+{
+    memcpy (bits, fleet->s.sensors, fleet->s.count) ;
+}
+
+void initio_FleetGetSonar (initio_fleet *fleet, float *cm)
+{
+    memcpy (cm, fleet->s.sonar, fleet->s.count * sizeof(float)) ;
+}
+
+// End of Fleet Functions
+//======================================================================
@@ -0,0 +1,136 @@
+#ifndef _4TRONIX_INITIO_FLEET_H_
+#define _4TRONIX_INITIO_FLEET_H_
+//======================================================================
+//
+// Batch simulation of a fleet of initio robots.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Simulates thousands of robots with the chassis model of initio_sim.h
+// (stall threshold, first-order motor lag) in a shared world: a walled
+// rectangular arena with circular obstacles and a circular line track.
+// The state is kept as a structure of arrays and stepped with SIMD
+// kernels (4 robots per vector) by a pool of threads. Every robot has its
+// own random number generator for wheel slip and sonar noise, so the
+// results only depend on the seed, never on the number of threads.
+//
+// The batch functions mirror initio.h: motor commands with the semantics
+// of initio_DriveForward() ... initio_TurnReverse(), and the sensors as
+// INITIO_SENSE_* bitmasks plus sonar distances of all robots.
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_path.h"
+#include "initio_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Motor commands of initio_FleetCommand()
+#define INITIO_FLEET_STOP          0 // initio_Stop()
+#define INITIO_FLEET_DRIVEFORWARD  1 // initio_DriveForward(a)
+#define INITIO_FLEET_DRIVEREVERSE  2 // initio_DriveReverse(a)
+#define INITIO_FLEET_SPINLEFT      3 // initio_SpinLeft(a)
+#define INITIO_FLEET_SPINRIGHT     4 // initio_SpinRight(a)
+#define INITIO_FLEET_TURNFORWARD   5 // initio_TurnForward(a, b)
+#define INITIO_FLEET_TURNREVERSE   6 // initio_TurnReverse(a, b)
+
+typedef struct {
+    uint8_t op ;      // INITIO_FLEET_*
+    uint8_t a, b ;    // speeds 0..100, larger ones count as 100
+} initio_fleetCmd ;
+
+typedef struct {
+    float x, y, r ;   // centre and radius in cm
+} initio_circle ;
+
+typedef struct {
+    float width, height ;          // arena, walls at x = 0, width and y = 0, height (cm)
+    const initio_circle *obstacles ;
+    int numObstacles ;
+    initio_circle line ;           // circular line track (radius 0: no line)
+    float lineWidth ;              // width of the line in cm
+} initio_fleetWorld ;
+
+typedef struct {
+    initio_simParams chassis ;     // wheel base, speed, stall duty, motor lag, cm per tick
+    float slip ;                   // std. deviation of the wheel speeds, relative
+    float sonarNoise ;             // std. deviation of the sonar distance in cm
+    float sonarMax ;               // sonar range in cm, farther objects read as 0
+    float irRange ;                // IR obstacle sensors trigger below this distance in cm
+    float irAngle ;                // IR sensors look this many rad left/right of the heading
+    float sensorOffset ;           // distance of the front sensors from the wheel axis in cm
+    float lineSpacing ;            // distance between the line sensors in cm
+} initio_fleetParams ;
+
+// State of all robots (structure of arrays, index == robot). Valid until
+// initio_FleetFree(); must only be read between initio_FleetStep() calls.
+typedef struct {
+    int count ;
+    float *x, *y, *theta ;         // poses in cm and rad
+    float *dutyLeft, *dutyRight ;  // signed duties -100..100
+    float *vLeft, *vRight ;        // wheel speeds in cm/s
+    float *distLeft, *distRight ;  // travelled distance per wheel (unsigned) in cm
+    float *sonar ;                 // sonar distance in cm, 0 == no object
+    uint8_t *sensors ;             // INITIO_SENSE_* bits
+    uint32_t *rng ;                // random number generator states
+} initio_fleetState ;
+
+typedef struct initio_fleet initio_fleet ;
+
+// initio_FleetDefaultParams (params):
+// Fills params with values approximating the initio and its sensors.
+void initio_FleetDefaultParams (initio_fleetParams *params) ;
+
+// initio_FleetCreate (count, threads, params, world, seed):
+// Creates count robots at random poses in the arena, stepped by threads
+// threads (including the caller). params == NULL selects the defaults.
+// world is copied, the obstacles are not. Returns NULL on error.
+initio_fleet *initio_FleetCreate (int count, int threads, const initio_fleetParams *params,
+                                  const initio_fleetWorld *world, uint32_t seed) ;
+
+// initio_FleetFree (fleet):
+// Stops the threads and frees fleet.
+void initio_FleetFree (initio_fleet *fleet) ;
+
+// initio_FleetState (fleet):
+// Returns the state arrays of all robots.
+const initio_fleetState *initio_FleetState (initio_fleet *fleet) ;
+
+// initio_FleetSetPose (fleet, robot, pose):
+// Places a robot at pose and stops it.
+void initio_FleetSetPose (initio_fleet *fleet, int robot, const initio_pose *pose) ;
+
+// initio_FleetCommand (fleet, cmds):
+// Sets the motors of every robot i according to cmds[i].
+void initio_FleetCommand (initio_fleet *fleet, const initio_fleetCmd *cmds) ;
+
+// initio_FleetCommandAll (fleet, cmd):
+// Sets the motors of all robots according to cmd.
+void initio_FleetCommandAll (initio_fleet *fleet, const initio_fleetCmd *cmd) ;
+
+// initio_FleetSetDuties (fleet, left, right):
+// Sets the signed wheel duties -100..100 of every robot.
+void initio_FleetSetDuties (initio_fleet *fleet, const int8_t *left, const int8_t *right) ;
+
+// initio_FleetStep (fleet, dt):
+// Advances all robots by dt seconds and updates their sensors.
+void initio_FleetStep (initio_fleet *fleet, double dt) ;
+
+// initio_FleetGetSensors (fleet, bits):
+// Copies the INITIO_SENSE_* bitmasks of all robots.
+void initio_FleetGetSensors (initio_fleet *fleet, uint8_t *bits) ;
+
+// initio_FleetGetSonar (fleet, cm):
+// Copies the sonar distances of all robots (0 == no object).
+void initio_FleetGetSonar (initio_fleet *fleet, float *cm) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_FLEET_H_ */
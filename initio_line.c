@@ -0,0 +1,287 @@
+//======================================================================
+//
+// High-rate line follower of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "initio_line.h"
+#include "initio_time.h"
+#include "initio_path.h"  // initio_PathMotors()
+
+#define EDGE_TIMEOUT_NS 2000000L  // INITIO_LINE_EDGE: evaluate timers at least every 2 ms
+
+struct initio_line {
+    int mode ;
+    pthread_mutex_t mutex ;   // protects params and stats
+    initio_lineParams params ;
+    initio_lineStats stats ;
+    initio_rate *rate ;       // INITIO_LINE_POLL
+    pthread_t thread ;        // INITIO_LINE_EDGE
+    sem_t wake ;
+    volatile int quit ;
+
+    // controller state, only used by the sampling thread
+    double start, last, lastLine, lostSince, lastMarker ;
+    int prevError, searchDir, prevLevels ;
+    double dFiltered ;
+    BOOL marker ;
+    double lapSum ;
+} ;
+
+static initio_line *edgeLine = NULL ;  // follower woken by the interrupt handlers
+
+static int clampDuty (double duty, int max)
+{
+    if (duty > max) return max ;
+    if (duty < -max) return -max ;
+    return (int)lround (duty) ;
+}
+
+void initio_LineDefaultParams (initio_lineParams *params)
+{
+    params->geometry = INITIO_LINE_STRADDLE ;
+    params->kp = 35.0 ;
+    params->kd = 1.5 ;
+    params->dFilter = 0.02 ;
+    params->speed = 40 ;
+    params->maxDuty = 80 ;
+    params->searchSpeed = 35 ;
+    params->lostTimeoutMs = 0 ;
+    params->minLapMs = 1000 ;
+    params->sampleHz = 1000.0 ;
+}
+
+// lineSample(): reads both sensors and updates motors and statistics.
+static void lineSample (initio_line *line)
+{
+    initio_lineParams p ;
+    BOOL l = initio_IrLineLeft () ;
+    BOOL r = initio_IrLineRight () ;
+    int levels = (l ? 1 : 0) | (r ? 2 : 0) ;
+    double t = initio_Now (), dt, left, right ;
+    int error = 0 ;
+    BOOL onLine, lost, marker ;
+
+    pthread_mutex_lock (&line->mutex) ;
+    p = line->params ;
+    pthread_mutex_unlock (&line->mutex) ;
+
+    if (l && !r) error = -1 ;
+    else if (r && !l) error = 1 ;
+
+    onLine = l || r ;
+    marker = (p.geometry == INITIO_LINE_STRADDLE) && l && r ;
+    if (onLine)
+        line->lastLine = t ;
+    if (error != 0)
+        line->searchDir = error ;
+
+    // line lost if nothing was seen for lostTimeoutMs (STRADDLE: only if enabled)
+    lost = !onLine && (p.geometry == INITIO_LINE_COVER || p.lostTimeoutMs > 0) &&
+           (t - line->lastLine) * 1000.0 >= p.lostTimeoutMs ;
+
+    // PD steering law with low-pass filtered derivative
+    dt = t - line->last ;
+    if (dt > 0 && line->last > 0)
+    {
+        double a = (p.dFilter > 0) ? 1 - exp (-dt / p.dFilter) : 1 ;
+        line->dFiltered += a * ((error - line->prevError) / dt - line->dFiltered) ;
+    }
+    line->prevError = error ;
+    line->last = t ;
+
+    if (lost)
+    {
+        // search spin towards the side the line was seen last
+        left = (line->searchDir < 0) ? -p.searchSpeed : p.searchSpeed ;
+        right = -left ;
+    }
+    else
+    {
+        double u = p.kp * error + p.kd * line->dFiltered ;
+        left = p.speed + u ;
+        right = p.speed - u ;
+    }
+
+    pthread_mutex_lock (&line->mutex) ;
+    {
+        initio_lineStats *s = &line->stats ;
+        s->samples++ ;
+        s->sampleHz = s->samples / (t - line->start + 1e-9) ;
+        if (levels != line->prevLevels)
+            s->edges++ ;
+        if (lost && !s->searching)
+        {
+            s->lostEvents++ ;
+            line->lostSince = t ;
+        }
+        else if (!lost && s->searching)
+            s->lostTime += t - line->lostSince ;
+        s->searching = lost ;
+        s->error = error ;
+        s->left = clampDuty (left, p.maxDuty) ;
+        s->right = clampDuty (right, p.maxDuty) ;
+        left = s->left ;
+        right = s->right ;
+
+        // lap marker: rising edge of "both sensors on the line"
+        if (marker && !line->marker)
+        {
+            if (line->lastMarker == 0)
+                line->lastMarker = t ;
+            else if ((t - line->lastMarker) * 1000.0 >= p.minLapMs)
+            {
+                double lap = t - line->lastMarker ;
+                s->laps++ ;
+                s->lapLast = lap ;
+                if (s->lapBest == 0 || lap < s->lapBest) s->lapBest = lap ;
+                line->lapSum += lap ;
+                s->lapAvg = line->lapSum / s->laps ;
+                line->lastMarker = t ;
+            }
+        }
+    }
+    pthread_mutex_unlock (&line->mutex) ;
+    line->marker = marker ;
+    line->prevLevels = levels ;
+
+    initio_PathMotors (NULL, (int)left, (int)right) ;
+}
+
+static BOOL lineCycle (void *arg)
+{
+    initio_line *line = arg ;
+    lineSample (line) ;
+    return !line->quit ;
+}
+
+static void lineIsr (void)
+{
+    initio_line *line = edgeLine ;
+    if (line != NULL)
+        sem_post (&line->wake) ;
+}
+
+static void *lineEdgeThread (void *arg)
+{
+    initio_line *line = arg ;
+    struct timespec ts ;
+
+    while (!line->quit)
+    {
+        clock_gettime (CLOCK_REALTIME, &ts) ;
+        ts.tv_nsec += EDGE_TIMEOUT_NS ;
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++ ;
+            ts.tv_nsec -= 1000000000L ;
+        }
+        while (sem_timedwait (&line->wake, &ts) != 0 && errno == EINTR)
+            ;
+        while (sem_trywait (&line->wake) == 0)  // coalesce bursts of edges
+            ;
+        lineSample (line) ;
+    }
+    return NULL ;
+}
+
+initio_line *initio_LineStart (int mode, const initio_lineParams *params)
+{
+    initio_line *line = calloc (1, sizeof(initio_line)) ;
+
+    if (line == NULL)
+        return NULL ;
+    if (params != NULL)
+        line->params = *params ;
+    else
+        initio_LineDefaultParams (&line->params) ;
+    line->mode = mode ;
+    line->start = initio_Now () ;
+    line->lastLine = line->start ;
+    line->prevLevels = -1 ;
+    line->searchDir = 1 ;
+    pthread_mutex_init (&line->mutex, NULL) ;
+    sem_init (&line->wake, 0, 0) ;
+
+    if (mode == INITIO_LINE_EDGE)
+    {
+        int pinLineLeft = (initio_identifyControlBoard () == PIROCON2) ? lineLeft_PiRoCon : lineLeft_RoboHat ;
+        edgeLine = line ;
+        wiringPiISR (pinLineLeft, INT_EDGE_BOTH, lineIsr) ;
+        wiringPiISR (lineRight, INT_EDGE_BOTH, lineIsr) ;
+        if (pthread_create (&line->thread, NULL, lineEdgeThread, line) != 0)
+            goto error ;
+    }
+    else
+    {
+        line->rate = initio_RateStart (line->params.sampleHz, lineCycle, line) ;
+        if (line->rate == NULL)
+            goto error ;
+    }
+    return line ;
+
+error:
+    edgeLine = NULL ;
+    sem_destroy (&line->wake) ;
+    pthread_mutex_destroy (&line->mutex) ;
+    free (line) ;
+    return NULL ;
+}
+
+void initio_LineSetParams (initio_line *line, const initio_lineParams *params)
+{
+    pthread_mutex_lock (&line->mutex) ;
+    line->params = *params ;
+    pthread_mutex_unlock (&line->mutex) ;
+    if (line->rate != NULL)
+        initio_RateSetHz (line->rate, params->sampleHz) ;
+}
+
+void initio_LineGetParams (initio_line *line, initio_lineParams *params)
+{
+    pthread_mutex_lock (&line->mutex) ;
+    *params = line->params ;
+    pthread_mutex_unlock (&line->mutex) ;
+}
+
+void initio_LineGetStats (initio_line *line, initio_lineStats *stats)
+{
+    pthread_mutex_lock (&line->mutex) ;
+    *stats = line->stats ;
+    pthread_mutex_unlock (&line->mutex) ;
+    if (line->rate != NULL)
+        initio_RateGetStats (line->rate, &stats->rate) ;
+}
+
+void initio_LineStop (initio_line *line)
+{
+    if (line == NULL)
+        return ;
+    line->quit = TRUE ;
+    if (line->mode == INITIO_LINE_EDGE)
+    {
+        sem_post (&line->wake) ;
+        pthread_join (line->thread, NULL) ;
+        edgeLine = NULL ;  // wiringPi interrupts cannot be unregistered
+    }
+    else
+        initio_RateStop (line->rate, NULL) ;
+    initio_Stop () ;
+    sem_destroy (&line->wake) ;
+    pthread_mutex_destroy (&line->mutex) ;
+    free (line) ;
+}
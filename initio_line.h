@@ -0,0 +1,104 @@
+#ifndef _4TRONIX_INITIO_LINE_H_
+#define _4TRONIX_INITIO_LINE_H_
+//======================================================================
+//
+// High-rate line follower of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// A background thread samples the IR line sensors (lineLeft, lineRight),
+// either periodically at a configurable rate (typically kHz) or woken by
+// interrupts on both edges of the sensors, runs a PD steering law on the
+// line position and drives the motors directly. When the line is lost
+// it spins towards the side where the line was seen last.
+//
+// Line position error: -1 line seen by the left sensor only (steer left),
+// +1 right sensor only (steer right), 0 otherwise. The meaning of "both"
+// and "none" depends on the sensor geometry:
+//   INITIO_LINE_STRADDLE: line between the sensors (initio default).
+//       none == centred, both == crossing marker (counts laps).
+//   INITIO_LINE_COVER: line wider than the sensor spacing.
+//       both == centred, none == line lost.
+//
+// Interrupt mode uses wiringPiISR() on the line sensor pins, which
+// replaces other interrupt handlers on these pins (e.g. initio_co.hpp).
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sampling modes
+#define INITIO_LINE_POLL 0  // fixed-rate sampling at sampleHz
+#define INITIO_LINE_EDGE 1  // sampling on sensor edges (plus timeout)
+
+// Sensor geometries
+#define INITIO_LINE_STRADDLE 0
+#define INITIO_LINE_COVER    1
+
+typedef struct {
+    int geometry ;              // INITIO_LINE_STRADDLE or INITIO_LINE_COVER
+    double kp ;                 // proportional gain, duty per unit error
+    double kd ;                 // derivative gain, duty per unit error per second
+    double dFilter ;            // time constant of the derivative low-pass in s
+    int speed ;                 // base duty on the line, 0..100
+    int maxDuty ;               // limit of either wheel duty, 0..100
+    int searchSpeed ;           // spin duty while searching the line
+    unsigned int lostTimeoutMs ;  // no line for this long == lost (0: immediately
+                                  // in COVER geometry, never in STRADDLE geometry)
+    unsigned int minLapMs ;     // ignore lap markers closer than this
+    double sampleHz ;           // sampling rate in INITIO_LINE_POLL mode
+} initio_lineParams ;
+
+typedef struct {
+    unsigned long samples ;     // sensor samples processed
+    double sampleHz ;           // achieved sampling rate since start
+    unsigned long edges ;       // sensor level changes seen
+    unsigned long lostEvents ;  // number of times the line was lost
+    double lostTime ;           // total time spent searching in s
+    BOOL searching ;            // currently searching the line
+    int error ;                 // last line position error (-1, 0, +1)
+    int left, right ;           // last signed motor duties
+    unsigned long laps ;        // completed laps (marker to marker)
+    double lapLast, lapBest, lapAvg ;  // lap times in s
+    initio_rateStats rate ;     // loop timing in INITIO_LINE_POLL mode
+} initio_lineStats ;
+
+typedef struct initio_line initio_line ;
+
+// initio_LineDefaultParams (params):
+// Fills params with conservative defaults for the initio.
+void initio_LineDefaultParams (initio_lineParams *params) ;
+
+// initio_LineStart (mode, params):
+// Starts the line follower thread in INITIO_LINE_POLL or INITIO_LINE_EDGE mode.
+// params == NULL selects the defaults. Returns NULL on error.
+initio_line *initio_LineStart (int mode, const initio_lineParams *params) ;
+
+// initio_LineSetParams (line, params):
+// Changes gains, speeds and rate while running.
+void initio_LineSetParams (initio_line *line, const initio_lineParams *params) ;
+
+// initio_LineGetParams (line, params):
+// Copies the current parameters.
+void initio_LineGetParams (initio_line *line, initio_lineParams *params) ;
+
+// initio_LineGetStats (line, stats):
+// Copies loop rate, line loss and lap statistics.
+void initio_LineGetStats (initio_line *line, initio_lineStats *stats) ;
+
+// initio_LineStop (line):
+// Stops the thread and the motors and frees line.
+void initio_LineStop (initio_line *line) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_LINE_H_ */
@@ -0,0 +1,278 @@
+//======================================================================
+//
+// Prometheus metrics exporter of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "initio_metrics.h"
+
+#define REQUEST_MAX 2048   // bytes of a request read
+
+struct initio_metrics {
+    initio_ctx *ctx ;
+    initio_metricsParams params ;
+    int fd ;                     // listening socket
+    pthread_t thread ;
+    int quit ;                   // atomic
+    char *buf ;                  // response text, server thread only
+    size_t size ;
+    initio_metricsStats stats ;  // atomic
+} ;
+
+void initio_MetricsDefaultParams (initio_metricsParams *params)
+{
+    params->port = 9101 ;
+}
+
+// Appender for initio_MetricsFormat: counts the full length, writes what fits
+typedef struct {
+    char *buf ;
+    size_t size ;
+    size_t len ;
+} text_t ;
+
+static void put (text_t *t, const char *fmt, ...)
+{
+    va_list ap ;
+    int n ;
+
+    va_start (ap, fmt) ;
+    n = vsnprintf (t->buf + (t->len < t->size ? t->len : t->size),
+                   t->len < t->size ? t->size - t->len : 0, fmt, ap) ;
+    va_end (ap) ;
+    if (n > 0)
+        t->len += n ;
+}
+
+// putThreads(): CPU time of each thread of the process from /proc
+static void putThreads (text_t *t)
+{
+    char path[300], comm[32], stat[512], *p ;
+    unsigned long utime, stime ;
+    double tick = sysconf (_SC_CLK_TCK) ;
+    struct dirent *d ;
+    DIR *dir = opendir ("/proc/self/task") ;
+    FILE *fp ;
+    size_t n ;
+
+    if (dir == NULL)
+        return ;
+    put (t, "# HELP initio_thread_cpu_seconds_total CPU time of the threads of the process.\n"
+            "# TYPE initio_thread_cpu_seconds_total counter\n") ;
+    while ((d = readdir (dir)) != NULL)
+    {
+        if (d->d_name[0] == '.')
+            continue ;
+        snprintf (path, sizeof(path), "/proc/self/task/%s/comm", d->d_name) ;
+        if ((fp = fopen (path, "r")) == NULL)
+            continue ;  // thread has ended
+        n = fread (comm, 1, sizeof(comm) - 1, fp) ;
+        fclose (fp) ;
+        comm[n] = '\0' ;
+        comm[strcspn (comm, "\n\"\\")] = '\0' ;
+        snprintf (path, sizeof(path), "/proc/self/task/%s/stat", d->d_name) ;
+        if ((fp = fopen (path, "r")) == NULL)
+            continue ;
+        n = fread (stat, 1, sizeof(stat) - 1, fp) ;
+        fclose (fp) ;
+        stat[n] = '\0' ;
+        // fields after the command: state ppid ... utime (14) stime (15)
+        if ((p = strrchr (stat, ')')) == NULL
+            || sscanf (p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+            continue ;
+        put (t, "initio_thread_cpu_seconds_total{tid=\"%s\",name=\"%s\"} %.2f\n",
+             d->d_name, comm, (utime + stime) / tick) ;
+    }
+    closedir (dir) ;
+}
+
+size_t initio_MetricsFormat (initio_ctx *ctx, char *buf, size_t size)
+{
+    static const char *calls[INITIO_CALLS] = { "usgetdistance", "setmotors", "setservo" } ;
+    static const char *states[] = { "stopped", "launching", "running", "none" } ;
+    text_t t = { buf, size, 0 } ;
+    initio_callMetrics m ;
+    struct timespec ts ;
+    unsigned long cumulative ;
+    int c, b ;
+
+    initio_ctxGetCallMetrics ((ctx != NULL) ? ctx : initio_DefaultCtx (), &m) ;
+    if (size > 0)
+        buf[0] = '\0' ;
+
+    put (&t, "# HELP initio_call_duration_seconds Latency of the sonar, motor and servo calls.\n"
+             "# TYPE initio_call_duration_seconds histogram\n") ;
+    for (c = 0; c < INITIO_CALLS; c++)
+    {
+        cumulative = 0 ;
+        for (b = 0; b < INITIO_CALL_BUCKETS; b++)
+        {
+            cumulative += m.call[c].buckets[b] ;
+            put (&t, "initio_call_duration_seconds_bucket{call=\"%s\",le=\"%g\"} %lu\n",
+                 calls[c], initio_callBoundsUs[b] * 1e-6, cumulative) ;
+        }
+        put (&t, "initio_call_duration_seconds_bucket{call=\"%s\",le=\"+Inf\"} %lu\n", calls[c], m.call[c].count) ;
+        put (&t, "initio_call_duration_seconds_sum{call=\"%s\"} %.6f\n", calls[c], m.call[c].sumUs * 1e-6) ;
+        put (&t, "initio_call_duration_seconds_count{call=\"%s\"} %lu\n", calls[c], m.call[c].count) ;
+    }
+    put (&t, "# HELP initio_motor_duty Commanded signed motor duty, -100..100.\n"
+             "# TYPE initio_motor_duty gauge\n"
+             "initio_motor_duty{motor=\"left\"} %d\n"
+             "initio_motor_duty{motor=\"right\"} %d\n", m.left, m.right) ;
+    put (&t, "# HELP initio_sonar_distance_cm Last sonar range, 0 == no object.\n"
+             "# TYPE initio_sonar_distance_cm gauge\n"
+             "initio_sonar_distance_cm %u\n", m.cm) ;
+    put (&t, "# HELP initio_servod_state State of the servo demon.\n"
+             "# TYPE initio_servod_state gauge\n") ;
+    for (c = 0; c < sizeof(states) / sizeof(states[0]); c++)
+        put (&t, "initio_servod_state{state=\"%s\"} %d\n", states[c], m.servod == c) ;
+    putThreads (&t) ;
+    clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts) ;
+    put (&t, "# HELP process_cpu_seconds_total CPU time of the process.\n"
+             "# TYPE process_cpu_seconds_total counter\n"
+             "process_cpu_seconds_total %.3f\n", ts.tv_sec + ts.tv_nsec * 1e-9) ;
+    return t.len ;
+}
+
+// respond(): reads one request from fd and answers it
+static void respond (initio_metrics *metrics, int fd)
+{
+    char request[REQUEST_MAX + 1], header[160] ;
+    struct timeval tv = { 0, 500000 } ;  // a slow client only delays the next scrape
+    size_t got = 0, len ;
+    ssize_t n ;
+
+    setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) ;
+    setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) ;
+    while (got < REQUEST_MAX && (n = recv (fd, request + got, REQUEST_MAX - got, 0)) > 0)
+    {
+        got += n ;
+        request[got] = '\0' ;
+        if (strstr (request, "\r\n\r\n") != NULL || strstr (request, "\n\n") != NULL)
+            break ;
+    }
+    request[got] = '\0' ;
+    if (strncmp (request, "GET /metrics ", 13) != 0 && strncmp (request, "GET /metrics?", 13) != 0)
+    {
+        static const char notFound[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n" ;
+
+        send (fd, notFound, sizeof(notFound) - 1, MSG_NOSIGNAL) ;
+        __atomic_add_fetch (&metrics->stats.errors, 1, __ATOMIC_RELAXED) ;
+        return ;
+    }
+    while ((len = initio_MetricsFormat (metrics->ctx, metrics->buf, metrics->size)) >= metrics->size)
+    {
+        char *buf = realloc (metrics->buf, len + 1024) ;
+
+        if (buf == NULL)
+        {
+            static const char error[] = "HTTP/1.0 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n" ;
+
+            send (fd, error, sizeof(error) - 1, MSG_NOSIGNAL) ;
+            __atomic_add_fetch (&metrics->stats.errors, 1, __ATOMIC_RELAXED) ;
+            return ;
+        }
+        metrics->buf = buf ;
+        metrics->size = len + 1024 ;
+    }
+    snprintf (header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+              "Content-Length: %zu\r\nConnection: close\r\n\r\n", len) ;
+    if (send (fd, header, strlen (header), MSG_NOSIGNAL) < 0
+        || send (fd, metrics->buf, len, MSG_NOSIGNAL) < 0)
+        __atomic_add_fetch (&metrics->stats.errors, 1, __ATOMIC_RELAXED) ;
+    else
+        __atomic_add_fetch (&metrics->stats.scrapes, 1, __ATOMIC_RELAXED) ;
+}
+
+static void *serverThread (void *arg)
+{
+    initio_metrics *metrics = arg ;
+    struct pollfd pfd = { metrics->fd, POLLIN, 0 } ;
+    int fd ;
+
+    pthread_setname_np (pthread_self (), "initio-metrics") ;
+    while (!__atomic_load_n (&metrics->quit, __ATOMIC_ACQUIRE))
+    {
+        if (poll (&pfd, 1, 200) <= 0)
+            continue ;
+        fd = accept (metrics->fd, NULL, NULL) ;
+        if (fd < 0)
+            continue ;
+        respond (metrics, fd) ;
+        close (fd) ;
+    }
+    return NULL ;
+}
+
+initio_metrics *initio_MetricsStart (initio_ctx *ctx, const initio_metricsParams *params)
+{
+    initio_metrics *metrics = calloc (1, sizeof(initio_metrics)) ;
+    struct sockaddr_in addr ;
+    int on = 1 ;
+
+    if (metrics == NULL)
+        return NULL ;
+    metrics->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    if (params != NULL)
+        metrics->params = *params ;
+    else
+        initio_MetricsDefaultParams (&metrics->params) ;
+
+    // non-blocking: accept() fails instead of waiting if the client gave up after poll()
+    metrics->fd = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0) ;
+    if (metrics->fd < 0)
+    {
+        free (metrics) ;
+        return NULL ;
+    }
+    setsockopt (metrics->fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) ;
+    memset (&addr, 0, sizeof(addr)) ;
+    addr.sin_family = AF_INET ;
+    addr.sin_port = htons (metrics->params.port) ;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK) ;
+    if (bind (metrics->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen (metrics->fd, 4) != 0
+        || pthread_create (&metrics->thread, NULL, serverThread, metrics) != 0)
+    {
+        close (metrics->fd) ;
+        free (metrics) ;
+        return NULL ;
+    }
+    return metrics ;
+}
+
+void initio_MetricsStop (initio_metrics *metrics, initio_metricsStats *stats)
+{
+    __atomic_store_n (&metrics->quit, 1, __ATOMIC_RELEASE) ;
+    pthread_join (metrics->thread, NULL) ;
+    close (metrics->fd) ;
+    if (stats != NULL)
+        *stats = metrics->stats ;
+    free (metrics->buf) ;
+    free (metrics) ;
+}
+
+void initio_MetricsGetStats (initio_metrics *metrics, initio_metricsStats *stats)
+{
+    stats->scrapes = __atomic_load_n (&metrics->stats.scrapes, __ATOMIC_RELAXED) ;
+    stats->errors = __atomic_load_n (&metrics->stats.errors, __ATOMIC_RELAXED) ;
+}
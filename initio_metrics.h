@@ -0,0 +1,74 @@
+#ifndef _4TRONIX_INITIO_METRICS_H_
+#define _4TRONIX_INITIO_METRICS_H_
+//======================================================================
+//
+// Prometheus metrics exporter of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Serves GET /metrics on a loopback port in the Prometheus text format
+// from a thread of its own:
+//   initio_call_duration_seconds   histograms of initio_ctxUsGetDistance,
+//                                  initio_ctxSetMotors (all motor functions)
+//                                  and initio_ctxSetServo; _count are the calls
+//   initio_motor_duty              commanded signed duties
+//   initio_sonar_distance_cm       last sonar range, 0 == no object
+//   initio_servod_state            1 for the current servod state
+//   initio_thread_cpu_seconds_total  CPU time of each thread of the process
+//                                  (initio_rate threads are named initio-rate)
+//   process_cpu_seconds_total
+// The values come from initio_ctxGetCallMetrics() and /proc, so a scrape
+// never waits for a ping, a motor command or servod. Remote scrapers
+// reach the port through a proxy or an SSH tunnel.
+//
+//======================================================================
+
+#include <stddef.h>
+#include "initio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned short port ;      // TCP port on 127.0.0.1
+} initio_metricsParams ;
+
+typedef struct {
+    unsigned long scrapes ;    // /metrics requests served
+    unsigned long errors ;     // other or broken requests
+} initio_metricsStats ;
+
+typedef struct initio_metrics initio_metrics ;
+
+// initio_MetricsDefaultParams (params):
+// Fills params with port 9101.
+void initio_MetricsDefaultParams (initio_metricsParams *params) ;
+
+// initio_MetricsFormat (ctx, buf, size):
+// Writes the metrics of ctx (NULL: default context) in the Prometheus text
+// format to buf like snprintf: returns the length of the full text, which
+// is truncated if that is size or more.
+size_t initio_MetricsFormat (initio_ctx *ctx, char *buf, size_t size) ;
+
+// initio_MetricsStart (ctx, params):
+// Starts serving the metrics of ctx (NULL: default context). params ==
+// NULL selects the defaults. Returns NULL on error (e.g. port in use).
+initio_metrics *initio_MetricsStart (initio_ctx *ctx, const initio_metricsParams *params) ;
+
+// initio_MetricsStop (metrics, stats):
+// Stops serving and frees metrics. If stats != NULL the final counters
+// are copied to it.
+void initio_MetricsStop (initio_metrics *metrics, initio_metricsStats *stats) ;
+
+// initio_MetricsGetStats (metrics, stats):
+// Copies the counters.
+void initio_MetricsGetStats (initio_metrics *metrics, initio_metricsStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_METRICS_H_ */
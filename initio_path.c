@@ -0,0 +1,332 @@
+//======================================================================
+//
+// Pure-pursuit path follower of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "initio_path.h"
+
+#define SEARCH_SEGMENTS 3  // segments ahead of the current one searched for the closest point
+
+struct initio_path {
+    initio_point *wp ;
+    int count ;
+    initio_pathParams params ;
+    initio_poseFunc poseFunc ;
+    void *poseArg ;
+    initio_motorFunc motorFunc ;
+    void *motorArg ;
+    initio_rate *rate ;
+    pthread_mutex_t mutex ;  // protects stats
+    initio_pathStats stats ;
+    double xteAbsSum, xteSqSum ;
+} ;
+
+struct initio_odometry {
+    double cmPerTick, wheelBase ;
+    initio_pose pose ;
+    unsigned long lastLeft, lastRight ;
+} ;
+
+
+//======================================================================
+// Path Follower Functions
+
+void initio_PathDefaultParams (initio_pathParams *params)
+{
+    params->lookahead = 25.0 ;
+    params->wheelBase = 14.0 ;
+    params->speed = 50 ;
+    params->maxDuty = 100 ;
+    params->goalTolerance = 5.0 ;
+}
+
+initio_path *initio_PathCreate (const initio_point *waypoints, int count, const initio_pathParams *params)
+{
+    initio_path *path ;
+
+    if (waypoints == NULL || count < 2)
+        return NULL ;
+    path = calloc (1, sizeof(initio_path)) ;
+    if (path == NULL)
+        return NULL ;
+    path->wp = malloc (count * sizeof(initio_point)) ;
+    if (path->wp == NULL)
+    {
+        free (path) ;
+        return NULL ;
+    }
+    memcpy (path->wp, waypoints, count * sizeof(initio_point)) ;
+    path->count = count ;
+    if (params != NULL)
+        path->params = *params ;
+    else
+        initio_PathDefaultParams (&path->params) ;
+    path->motorFunc = initio_PathMotors ;
+    pthread_mutex_init (&path->mutex, NULL) ;
+    return path ;
+}
+
+void initio_PathFree (initio_path *path)
+{
+    if (path == NULL)
+        return ;
+    initio_RateStop (path->rate, NULL) ;
+    pthread_mutex_destroy (&path->mutex) ;
+    free (path->wp) ;
+    free (path) ;
+}
+
+void initio_PathSetPoseSource (initio_path *path, initio_poseFunc func, void *arg)
+{
+    path->poseFunc = func ;
+    path->poseArg = arg ;
+}
+
+void initio_PathSetMotorSink (initio_path *path, initio_motorFunc func, void *arg)
+{
+    path->motorFunc = func ;
+    path->motorArg = arg ;
+}
+
+// closestPoint(): projects pos onto the segments following the current one.
+// Returns the segment index, sets t (0..1 along the segment) and signed distance.
+static int closestPoint (initio_path *path, int first, double px, double py, double *t, double *xte)
+{
+    int i, last = first + SEARCH_SEGMENTS, best = first ;
+    double bestDist = INFINITY ;
+
+    if (last > path->count - 2)
+        last = path->count - 2 ;
+    for (i = first; i <= last; i++)
+    {
+        const initio_point *a = &path->wp[i], *b = &path->wp[i+1] ;
+        double sx = b->x - a->x, sy = b->y - a->y ;
+        double len2 = sx * sx + sy * sy ;
+        double u = (len2 > 0) ? ((px - a->x) * sx + (py - a->y) * sy) / len2 : 0 ;
+        double cx, cy, d ;
+
+        if (u < 0) u = 0 ;
+        if (u > 1 && i < path->count - 2) u = 1 ;  // only the last segment extends beyond its end
+        cx = a->x + u * sx ;
+        cy = a->y + u * sy ;
+        d = hypot (px - cx, py - cy) ;
+        if (d < bestDist)
+        {
+            bestDist = d ;
+            best = i ;
+            *t = u ;
+            // positive if the robot is left of the path direction
+            *xte = (len2 > 0) ? (sx * (py - a->y) - sy * (px - a->x)) / sqrt (len2) : d ;
+        }
+    }
+    return best ;
+}
+
+// lookaheadPoint(): walks dist cm along the path from segment seg at fraction t.
+static initio_point lookaheadPoint (initio_path *path, int seg, double t, double dist)
+{
+    initio_point p ;
+
+    while (seg < path->count - 1)
+    {
+        const initio_point *a = &path->wp[seg], *b = &path->wp[seg+1] ;
+        double len = hypot (b->x - a->x, b->y - a->y) ;
+        double rest = len * (1 - t) ;
+        if (dist <= rest && len > 0)
+        {
+            double u = t + dist / len ;
+            p.x = a->x + u * (b->x - a->x) ;
+            p.y = a->y + u * (b->y - a->y) ;
+            return p ;
+        }
+        dist -= rest ;
+        seg++ ;
+        t = 0 ;
+    }
+    return path->wp[path->count - 1] ;
+}
+
+BOOL initio_PathStep (initio_path *path)
+{
+    const initio_pathParams *pp = &path->params ;
+    const initio_point *goal = &path->wp[path->count - 1] ;
+    initio_pose pose ;
+    initio_point target ;
+    double t = 0, xte = 0, dx, dy, ly, d2, k, left, right, scale ;
+    int seg ;
+    BOOL done ;
+
+    if (path->poseFunc == NULL || !path->poseFunc (path->poseArg, &pose))
+    {
+        // no pose: do not keep driving blind at the last duties
+        if (path->motorFunc != NULL)
+            path->motorFunc (path->motorArg, 0, 0) ;
+        pthread_mutex_lock (&path->mutex) ;
+        path->stats.noPose++ ;
+        pthread_mutex_unlock (&path->mutex) ;
+        return TRUE ;
+    }
+
+    seg = closestPoint (path, path->stats.segment, pose.x, pose.y, &t, &xte) ;
+    done = (seg == path->count - 2) &&
+           ((hypot (goal->x - pose.x, goal->y - pose.y) < pp->goalTolerance) || (t >= 1)) ;
+
+    // curvature of the arc from the robot through the lookahead point
+    target = lookaheadPoint (path, seg, t, pp->lookahead) ;
+    dx = target.x - pose.x ;
+    dy = target.y - pose.y ;
+    ly = -sin (pose.theta) * dx + cos (pose.theta) * dy ;
+    d2 = dx * dx + dy * dy ;
+    k = (d2 > 1e-9) ? 2 * ly / d2 : 0 ;
+
+    // differential drive: v_left/right = v * (1 -/+ k * b / 2)
+    left = pp->speed * (1 - k * pp->wheelBase / 2) ;
+    right = pp->speed * (1 + k * pp->wheelBase / 2) ;
+    scale = fmax (fabs (left), fabs (right)) ;
+    if (scale > pp->maxDuty)
+    {
+        left = left * pp->maxDuty / scale ;
+        right = right * pp->maxDuty / scale ;
+    }
+    if (done)
+        left = right = 0 ;
+    if (path->motorFunc != NULL)
+        path->motorFunc (path->motorArg, (int)lround (left), (int)lround (right)) ;
+
+    pthread_mutex_lock (&path->mutex) ;
+    {
+        initio_pathStats *s = &path->stats ;
+        s->steps++ ;
+        s->segment = seg ;
+        s->curvature = k ;
+        s->xte = xte ;
+        s->done = done ;
+        path->xteAbsSum += fabs (xte) ;
+        path->xteSqSum += xte * xte ;
+        s->xteAbsAvg = path->xteAbsSum / s->steps ;
+        s->xteRms = sqrt (path->xteSqSum / s->steps) ;
+        if (fabs (xte) > s->xteMax) s->xteMax = fabs (xte) ;
+    }
+    pthread_mutex_unlock (&path->mutex) ;
+
+    return !done ;
+}
+
+static BOOL pathCycle (void *arg)
+{
+    return initio_PathStep ((initio_path *)arg) ;
+}
+
+BOOL initio_PathStart (initio_path *path, double hz)
+{
+    if (path->rate != NULL || path->poseFunc == NULL)
+        return FALSE ;
+    path->rate = initio_RateStart (hz, pathCycle, path) ;
+    return (path->rate != NULL) ;
+}
+
+void initio_PathStop (initio_path *path)
+{
+    initio_rateStats rs ;
+
+    if (path->rate == NULL)
+        return ;
+    initio_RateStop (path->rate, &rs) ;
+    path->rate = NULL ;
+    pthread_mutex_lock (&path->mutex) ;
+    path->stats.rate = rs ;
+    pthread_mutex_unlock (&path->mutex) ;
+    if (path->motorFunc != NULL)
+        path->motorFunc (path->motorArg, 0, 0) ;
+}
+
+BOOL initio_PathDone (initio_path *path)
+{
+    BOOL done ;
+
+    pthread_mutex_lock (&path->mutex) ;
+    done = path->stats.done ;
+    pthread_mutex_unlock (&path->mutex) ;
+    return done ;
+}
+
+void initio_PathGetStats (initio_path *path, initio_pathStats *stats)
+{
+    pthread_mutex_lock (&path->mutex) ;
+    *stats = path->stats ;
+    pthread_mutex_unlock (&path->mutex) ;
+    if (path->rate != NULL)
+        initio_RateGetStats (path->rate, &stats->rate) ;
+}
+
+void initio_PathMotors (void *arg, int left, int right)
+{
+    (void)arg ;
+    initio_SetMotors (left, right) ;
+}
+
+// End of Path Follower Functions
+//======================================================================
+
+
+
+//======================================================================
+// Wheel Odometry
+
+initio_odometry *initio_OdometryCreate (double cmPerTick, double wheelBase, const initio_pose *start)
+{
+    initio_odometry *odo = calloc (1, sizeof(initio_odometry)) ;
+
+    if (odo == NULL)
+        return NULL ;
+    odo->cmPerTick = cmPerTick ;
+    odo->wheelBase = wheelBase ;
+    if (start != NULL)
+        odo->pose = *start ;
+    initio_WheelCountStart () ;
+    odo->lastLeft = initio_WheelCountLeft () ;
+    odo->lastRight = initio_WheelCountRight () ;
+    return odo ;
+}
+
+void initio_OdometryFree (initio_odometry *odo)
+{
+    free (odo) ;
+}
+
+BOOL initio_OdometryPose (void *arg, initio_pose *pose)
+{
+    initio_odometry *odo = arg ;
+    unsigned long countLeft = initio_WheelCountLeft () ;
+    unsigned long countRight = initio_WheelCountRight () ;
+    int dirLeft, dirRight ;
+    double sl, sr, ds, dth ;
+
+    initio_GetMotors (&dirLeft, &dirRight) ;
+    sl = (double)(countLeft - odo->lastLeft) * odo->cmPerTick * ((dirLeft < 0) ? -1 : 1) ;
+    sr = (double)(countRight - odo->lastRight) * odo->cmPerTick * ((dirRight < 0) ? -1 : 1) ;
+    odo->lastLeft = countLeft ;
+    odo->lastRight = countRight ;
+
+    // integrate along the arc using the mid-point heading
+    ds = (sl + sr) / 2 ;
+    dth = (sr - sl) / odo->wheelBase ;
+    odo->pose.x += ds * cos (odo->pose.theta + dth / 2) ;
+    odo->pose.y += ds * sin (odo->pose.theta + dth / 2) ;
+    odo->pose.theta = remainder (odo->pose.theta + dth, 2 * M_PI) ;
+    *pose = odo->pose ;
+    return TRUE ;
+}
+
+// End of Wheel Odometry
+//======================================================================
@@ -0,0 +1,153 @@
+#ifndef _4TRONIX_INITIO_PATH_H_
+#define _4TRONIX_INITIO_PATH_H_
+//======================================================================
+//
+// Pure-pursuit path follower of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// The follower steers the robot along a polyline of waypoints. In every
+// control step it reads the pose from a pose source, looks up the point
+// on the path 'lookahead' cm ahead of the robot, computes the curvature
+// of the arc through that point and maps it onto left/right duties.
+// Steps are executed either by a fixed-rate thread (initio_PathStart)
+// or explicitly (initio_PathStep), e.g. in a simulation.
+//
+// Coordinates are in cm, angles in radians (counter-clockwise, 0 == +x).
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    double x, y ;
+} initio_point ;
+
+typedef struct {
+    double x, y ;    // position in cm
+    double theta ;   // heading in rad
+} initio_pose ;
+
+// Pose source: fills pose, returns FALSE if no pose is available
+typedef BOOL (*initio_poseFunc)(void *arg, initio_pose *pose) ;
+
+// Motor sink: receives signed duties -100..100 (negative == reverse)
+typedef void (*initio_motorFunc)(void *arg, int left, int right) ;
+
+typedef struct {
+    double lookahead ;      // lookahead distance in cm
+    double wheelBase ;      // distance between left and right wheels in cm
+    int speed ;             // nominal duty on straight path segments, 0..100
+    int maxDuty ;           // limit of either wheel duty, 0..100
+    double goalTolerance ;  // distance to last waypoint that counts as arrived, cm
+} initio_pathParams ;
+
+typedef struct {
+    unsigned long steps ;   // executed control steps
+    unsigned long noPose ;  // steps skipped without a pose (motors stopped)
+    BOOL done ;             // goal reached
+    int segment ;           // index of the current path segment
+    double curvature ;      // last commanded curvature in 1/cm
+    double xte ;            // last signed cross-track error in cm (positive == left of path)
+    double xteAbsAvg ;      // mean absolute cross-track error in cm
+    double xteRms ;         // root mean square cross-track error in cm
+    double xteMax ;         // maximum absolute cross-track error in cm
+    initio_rateStats rate ; // timing of the fixed-rate loop (zero if driven by initio_PathStep)
+} initio_pathStats ;
+
+typedef struct initio_path initio_path ;
+
+
+//======================================================================
+// Path Follower Functions
+
+// initio_PathDefaultParams (params):
+// Fills params with defaults suitable for the initio chassis.
+void initio_PathDefaultParams (initio_pathParams *params) ;
+
+// initio_PathCreate (waypoints, count, params):
+// Creates a follower for a polyline of count >= 2 waypoints (copied).
+// params == NULL selects the defaults. Returns NULL on error.
+initio_path *initio_PathCreate (const initio_point *waypoints, int count, const initio_pathParams *params) ;
+
+// initio_PathFree (path):
+// Stops a running loop and frees the follower.
+void initio_PathFree (initio_path *path) ;
+
+// initio_PathSetPoseSource (path, func, arg):
+// Sets the pose source (e.g. initio_OdometryPose or initio_SimPose).
+void initio_PathSetPoseSource (initio_path *path, initio_poseFunc func, void *arg) ;
+
+// initio_PathSetMotorSink (path, func, arg):
+// Sets the motor sink. Default is initio_PathMotors driving the robot.
+void initio_PathSetMotorSink (initio_path *path, initio_motorFunc func, void *arg) ;
+
+// initio_PathStep (path):
+// Executes one control step. Returns FALSE when the goal has been reached
+// (motors are stopped then). Without a pose the motors are stopped and the
+// step is skipped (stats.noPose); it returns TRUE, so a fixed-rate loop
+// keeps going and resumes once the pose source delivers again.
+BOOL initio_PathStep (initio_path *path) ;
+
+// initio_PathStart (path, hz):
+// Runs initio_PathStep() at hz steps per second in a background thread
+// until the goal is reached or initio_PathStop() is called. Returns FALSE
+// if no pose source is set or the loop is running already.
+BOOL initio_PathStart (initio_path *path, double hz) ;
+
+// initio_PathStop (path):
+// Stops the background loop and the motors.
+void initio_PathStop (initio_path *path) ;
+
+// initio_PathDone (path):
+// Returns TRUE once the goal has been reached.
+BOOL initio_PathDone (initio_path *path) ;
+
+// initio_PathGetStats (path, stats):
+// Copies the tracking and timing statistics.
+void initio_PathGetStats (initio_path *path, initio_pathStats *stats) ;
+
+// initio_PathMotors (arg, left, right):
+// Motor sink passing the signed duties to initio_SetMotors().
+void initio_PathMotors (void *arg, int left, int right) ;
+
+// End of Path Follower Functions
+//======================================================================
+
+
+
+//======================================================================
+// Wheel Odometry
+// Dead reckoning from the wheel sensor pulses. As only one phase per wheel
+// is connected, the direction of each wheel is taken from the sign of the
+// last commanded duty (initio_GetMotors).
+
+typedef struct initio_odometry initio_odometry ;
+
+// initio_OdometryCreate (cmPerTick, wheelBase, start):
+// Starts the wheel pulse counters and creates an odometry pose source.
+// start == NULL starts at the origin heading along +x.
+initio_odometry *initio_OdometryCreate (double cmPerTick, double wheelBase, const initio_pose *start) ;
+
+// initio_OdometryFree (odo):
+void initio_OdometryFree (initio_odometry *odo) ;
+
+// initio_OdometryPose (odo, pose):
+// Pose source integrating the pulses counted since the previous call.
+BOOL initio_OdometryPose (void *odo, initio_pose *pose) ;
+
+// End of Wheel Odometry
+//======================================================================
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_PATH_H_ */
@@ -0,0 +1,782 @@
+//======================================================================
+//
+// Incremental path planner (D* Lite) of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// The search follows the optimised D* Lite of Koenig and Likhachev
+// (2002): g and rhs are the cost-to-goal and its one-step lookahead,
+// keys are [min(g, rhs) + h + km; min(g, rhs)], packed into one 64-bit
+// word so the heap compares a single integer. Costs are integers, 10
+// per straight and 14 per diagonal step, with the octile distance as
+// heuristic.
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "initio_plan.h"
+#include "initio_time.h"
+
+#define INF       UINT32_MAX
+#define STRAIGHT  10             // cost of a straight step
+#define DIAGONAL  14             // ... of a diagonal step
+
+// Obstacle evidence of a cell
+#define EVIDENCE_MAX  15
+#define EVIDENCE_ON   4          // becomes occupied at this evidence
+#define EVIDENCE_HIT  2          // added by a sonar echo
+#define EVIDENCE_MISS 1          // removed by a sonar ray passing through
+
+// Cell flags
+#define CELL_OCCUPIED 1
+#define CELL_CHANGED  2          // queued in the list of changed cells
+
+typedef struct {
+    uint8_t evidence ;           // 0..EVIDENCE_MAX, free again at 0
+    uint8_t flags ;              // CELL_*
+    uint16_t near ;              // occupied cells within the robot radius, 0: enterable
+} cell ;
+
+typedef struct {
+    uint64_t key ;               // k1 << 32 | k2
+    uint32_t node ;
+} heapEntry ;
+
+struct initio_plan {
+    initio_planParams params ;
+    int n ;                      // number of cells
+    cell *cells ;
+    uint32_t *g, *rhs ;
+    uint32_t *pos ;              // heap index + 1, 0: not queued
+
+    heapEntry *heap ;
+    int heapSize, heapCap ;
+
+    int *offX, *offY ;           // cells within the robot radius of (0, 0)
+    int offCount ;
+
+    uint32_t *changed ;          // cells whose enterability changed
+    int changedCount, changedCap ;
+
+    BOOL hasGoal, fresh ;        // fresh: the search starts over at the next replan
+    uint32_t goal, start, km ;
+    double goalX, goalY ;
+    initio_pose pose ;           // of the last replan
+    BOOL found ;
+
+    uint32_t *path ;             // cells from start to goal
+    int pathCount, pathCap ;
+    initio_point *wp ;           // waypoints, valid if wpValid
+    int wpCount, wpCap ;
+    BOOL wpValid ;
+
+    initio_planStats stats ;
+} ;
+
+// neighbours; k and (k + 4) % 8 are opposite
+static const int dx8[8] = { 1, 1, 0, -1, -1, -1,  0,  1 } ;
+static const int dy8[8] = { 0, 1, 1,  1,  0, -1, -1, -1 } ;
+
+// grow(): makes room for count elements of size in *buf
+static BOOL grow (void **buf, int *cap, int count, size_t size)
+{
+    void *p ;
+    int c ;
+
+    if (count <= *cap)
+        return TRUE ;
+    c = (*cap > 0) ? *cap : 64 ;
+    while (c < count)
+        c *= 2 ;
+    p = realloc (*buf, c * size) ;
+    if (p == NULL)
+        return FALSE ;
+    *buf = p ;
+    *cap = c ;
+    return TRUE ;
+}
+
+void initio_PlanDefaultParams (initio_planParams *params)
+{
+    params->width = 200 ;
+    params->height = 200 ;
+    params->cellCm = 5 ;
+    params->originX = -500 ;
+    params->originY = -500 ;
+    params->robotRadius = 12 ;
+    params->sonarMaxCm = 150 ;
+    params->irCm = 15 ;
+    params->speed = 60 ;
+    params->spinDuty = 50 ;
+    params->spinAngle = 0.6 ;
+    params->goalTolerance = 5 ;
+}
+
+initio_plan *initio_PlanCreate (const initio_planParams *params)
+{
+    initio_plan *plan ;
+    initio_planParams defaults ;
+    double r, ex, ey ;
+    int R, x, y ;
+
+    if (params == NULL)
+    {
+        initio_PlanDefaultParams (&defaults) ;
+        params = &defaults ;
+    }
+    if (params->width <= 0 || params->height <= 0 || params->cellCm <= 0 || params->robotRadius < 0
+        || (double)params->width * params->height >= INT32_MAX)
+        return NULL ;
+    // a cell is blocked if its centre is closer than the radius to the
+    // edge of an occupied cell, i.e. offsets up to r + 1/2 cells
+    r = params->robotRadius / params->cellCm ;
+    R = (int)(r + 0.5) ;
+    if ((2 * R + 1) * (2 * R + 1) > UINT16_MAX)
+        return NULL ;
+
+    plan = calloc (1, sizeof(initio_plan)) ;
+    if (plan == NULL)
+        return NULL ;
+    plan->params = *params ;
+    plan->n = params->width * params->height ;
+    plan->cells = calloc (plan->n, sizeof(cell)) ;
+    plan->g = malloc (plan->n * sizeof(uint32_t)) ;
+    plan->rhs = malloc (plan->n * sizeof(uint32_t)) ;
+    plan->pos = calloc (plan->n, sizeof(uint32_t)) ;
+    plan->offX = malloc ((2 * R + 1) * (2 * R + 1) * sizeof(int)) ;
+    plan->offY = malloc ((2 * R + 1) * (2 * R + 1) * sizeof(int)) ;
+    if (plan->cells == NULL || plan->g == NULL || plan->rhs == NULL || plan->pos == NULL
+        || plan->offX == NULL || plan->offY == NULL)
+    {
+        initio_PlanFree (plan) ;
+        return NULL ;
+    }
+    for (y = -R; y <= R; y++)
+        for (x = -R; x <= R; x++)
+        {
+            ex = (abs (x) > 0) ? abs (x) - 0.5 : 0 ;
+            ey = (abs (y) > 0) ? abs (y) - 0.5 : 0 ;
+            if ((x == 0 && y == 0) || ex * ex + ey * ey < r * r - 1e-9)
+            {
+                plan->offX[plan->offCount] = x ;
+                plan->offY[plan->offCount] = y ;
+                plan->offCount++ ;
+            }
+        }
+    plan->stats.cost = INFINITY ;
+    return plan ;
+}
+
+void initio_PlanFree (initio_plan *plan)
+{
+    free (plan->cells) ;
+    free (plan->g) ;
+    free (plan->rhs) ;
+    free (plan->pos) ;
+    free (plan->heap) ;
+    free (plan->offX) ;
+    free (plan->offY) ;
+    free (plan->changed) ;
+    free (plan->path) ;
+    free (plan->wp) ;
+    free (plan) ;
+}
+
+// cellAt(): index of the cell containing (x, y) in cm, -1 outside the grid
+static int cellAt (const initio_plan *plan, double x, double y)
+{
+    const initio_planParams *p = &plan->params ;
+    int cx = (int)floor ((x - p->originX) / p->cellCm) ;
+    int cy = (int)floor ((y - p->originY) / p->cellCm) ;
+
+    if (cx < 0 || cy < 0 || cx >= p->width || cy >= p->height)
+        return -1 ;
+    return cy * p->width + cx ;
+}
+
+// centre(): position of the centre of cell u in cm
+static initio_point centre (const initio_plan *plan, uint32_t u)
+{
+    const initio_planParams *p = &plan->params ;
+    initio_point c ;
+
+    c.x = p->originX + (u % p->width + 0.5) * p->cellCm ;
+    c.y = p->originY + (u / p->width + 0.5) * p->cellCm ;
+    return c ;
+}
+
+
+//======================================================================
+// Occupancy grid
+
+static void markChanged (initio_plan *plan, uint32_t u)
+{
+    plan->stats.changedCells++ ;
+    if (plan->cells[u].flags & CELL_CHANGED)
+        return ;
+    if (!grow ((void **)&plan->changed, &plan->changedCap, plan->changedCount + 1, sizeof(uint32_t)))
+    {
+        plan->fresh = TRUE ;  // cannot track the change: search again
+        return ;
+    }
+    plan->cells[u].flags |= CELL_CHANGED ;
+    plan->changed[plan->changedCount++] = u ;
+}
+
+// setOccupied(): updates the inflation counts around cell u
+static void setOccupied (initio_plan *plan, uint32_t u, BOOL occupied)
+{
+    const initio_planParams *p = &plan->params ;
+    int x = u % p->width, y = u / p->width, nx, ny, i ;
+    cell *c ;
+
+    if (((plan->cells[u].flags & CELL_OCCUPIED) != 0) == occupied)
+        return ;
+    plan->cells[u].flags ^= CELL_OCCUPIED ;
+    for (i = 0; i < plan->offCount; i++)
+    {
+        nx = x + plan->offX[i] ;
+        ny = y + plan->offY[i] ;
+        if (nx < 0 || ny < 0 || nx >= p->width || ny >= p->height)
+            continue ;
+        c = &plan->cells[ny * p->width + nx] ;
+        if (occupied ? c->near++ == 0 : --c->near == 0)
+            markChanged (plan, ny * p->width + nx) ;
+    }
+}
+
+// addEvidence(): adds delta to the evidence of cell u; occupied from
+// EVIDENCE_ON, free again at 0
+static void addEvidence (initio_plan *plan, uint32_t u, int delta)
+{
+    cell *c = &plan->cells[u] ;
+    int e = c->evidence + delta ;
+
+    e = (e < 0) ? 0 : (e > EVIDENCE_MAX) ? EVIDENCE_MAX : e ;
+    c->evidence = e ;
+    if (e >= EVIDENCE_ON)
+        setOccupied (plan, u, TRUE) ;
+    else if (e == 0)
+        setOccupied (plan, u, FALSE) ;
+}
+
+void initio_PlanSetCell (initio_plan *plan, int cx, int cy, BOOL occupied)
+{
+    uint32_t u ;
+
+    if (cx < 0 || cy < 0 || cx >= plan->params.width || cy >= plan->params.height)
+        return ;
+    u = cy * plan->params.width + cx ;
+    plan->cells[u].evidence = occupied ? EVIDENCE_MAX : 0 ;
+    setOccupied (plan, u, occupied) ;
+}
+
+BOOL initio_PlanCellBlocked (initio_plan *plan, int cx, int cy)
+{
+    if (cx < 0 || cy < 0 || cx >= plan->params.width || cy >= plan->params.height)
+        return TRUE ;
+    return plan->cells[cy * plan->params.width + cx].near != 0 ;
+}
+
+void initio_PlanSonar (initio_plan *plan, const initio_pose *pose, double bearing, unsigned int cm)
+{
+    const initio_planParams *p = &plan->params ;
+    double dir = pose->theta + bearing, range, d ;
+    BOOL echo = (cm > 0 && cm <= p->sonarMaxCm) ;
+    int u, hit = -1, last = -1 ;
+
+    range = echo ? cm : p->sonarMaxCm ;
+    if (echo)
+        hit = cellAt (plan, pose->x + range * cos (dir), pose->y + range * sin (dir)) ;
+    // cells up to one cell before the echo were seen empty
+    for (d = 0; d < range - p->cellCm; d += p->cellCm / 2)
+    {
+        u = cellAt (plan, pose->x + d * cos (dir), pose->y + d * sin (dir)) ;
+        if (u < 0)
+            break ;
+        if (u != last && u != hit)
+            addEvidence (plan, u, -EVIDENCE_MISS) ;
+        last = u ;
+    }
+    if (hit >= 0)
+        addEvidence (plan, hit, EVIDENCE_HIT) ;
+}
+
+void initio_PlanIr (initio_plan *plan, const initio_pose *pose, BOOL left, BOOL right)
+{
+    const double side = 0.35 ;  // direction of the IR sensors off the heading in rad
+    double d = plan->params.irCm / cos (side) ;
+    int u ;
+
+    if (left && (u = cellAt (plan, pose->x + d * cos (pose->theta + side), pose->y + d * sin (pose->theta + side))) >= 0)
+        addEvidence (plan, u, EVIDENCE_MAX) ;
+    if (right && (u = cellAt (plan, pose->x + d * cos (pose->theta - side), pose->y + d * sin (pose->theta - side))) >= 0)
+        addEvidence (plan, u, EVIDENCE_MAX) ;
+}
+
+// End of Occupancy grid
+//======================================================================
+
+
+//======================================================================
+// Binary heap with decrease-key
+
+static void heapPlace (initio_plan *plan, int i, heapEntry e)
+{
+    plan->heap[i] = e ;
+    plan->pos[e.node] = i + 1 ;
+}
+
+static void heapUp (initio_plan *plan, int i)
+{
+    heapEntry e = plan->heap[i] ;
+    int parent ;
+
+    while (i > 0 && plan->heap[parent = (i - 1) / 2].key > e.key)
+    {
+        heapPlace (plan, i, plan->heap[parent]) ;
+        i = parent ;
+    }
+    heapPlace (plan, i, e) ;
+}
+
+static void heapDown (initio_plan *plan, int i)
+{
+    heapEntry e = plan->heap[i] ;
+    int child ;
+
+    while ((child = 2 * i + 1) < plan->heapSize)
+    {
+        if (child + 1 < plan->heapSize && plan->heap[child + 1].key < plan->heap[child].key)
+            child++ ;
+        if (plan->heap[child].key >= e.key)
+            break ;
+        heapPlace (plan, i, plan->heap[child]) ;
+        i = child ;
+    }
+    heapPlace (plan, i, e) ;
+}
+
+// heapSet(): queues u with key, or changes its key if already queued
+static BOOL heapSet (initio_plan *plan, uint32_t u, uint64_t key)
+{
+    int i ;
+
+    if (plan->pos[u] != 0)
+    {
+        i = plan->pos[u] - 1 ;
+        if (key < plan->heap[i].key)
+        {
+            plan->heap[i].key = key ;
+            heapUp (plan, i) ;
+        }
+        else
+        {
+            plan->heap[i].key = key ;
+            heapDown (plan, i) ;
+        }
+        return TRUE ;
+    }
+    if (!grow ((void **)&plan->heap, &plan->heapCap, plan->heapSize + 1, sizeof(heapEntry)))
+        return FALSE ;
+    i = plan->heapSize++ ;
+    plan->heap[i].key = key ;
+    plan->heap[i].node = u ;
+    heapUp (plan, i) ;
+    return TRUE ;
+}
+
+static void heapRemove (initio_plan *plan, uint32_t u)
+{
+    int i = plan->pos[u] - 1 ;
+    heapEntry last = plan->heap[--plan->heapSize] ;
+
+    plan->pos[u] = 0 ;
+    if (i == plan->heapSize)
+        return ;
+    heapPlace (plan, i, last) ;
+    if (i > 0 && plan->heap[(i - 1) / 2].key > last.key)
+        heapUp (plan, i) ;
+    else
+        heapDown (plan, i) ;
+}
+
+// End of Binary heap with decrease-key
+//======================================================================
+
+
+//======================================================================
+// D* Lite
+
+// heuristic(): octile distance between cells a and b
+static uint32_t heuristic (const initio_plan *plan, uint32_t a, uint32_t b)
+{
+    int w = plan->params.width ;
+    uint32_t dx = abs ((int)(a % w) - (int)(b % w)), dy = abs ((int)(a / w) - (int)(b / w)) ;
+
+    return (dx > dy) ? STRAIGHT * dx + (DIAGONAL - STRAIGHT) * dy : STRAIGHT * dy + (DIAGONAL - STRAIGHT) * dx ;
+}
+
+static uint64_t key (const initio_plan *plan, uint32_t u)
+{
+    uint64_t m = (plan->g[u] < plan->rhs[u]) ? plan->g[u] : plan->rhs[u] ;
+    uint64_t k1 = m + heuristic (plan, plan->start, u) + plan->km ;
+
+    if (k1 > UINT32_MAX)
+        k1 = UINT32_MAX ;
+    return k1 << 32 | m ;
+}
+
+// edgeCost(): cost of the step from cell (x, y) to its neighbour k; INF
+// if that cell cannot be entered or a diagonal step cuts a blocked corner
+static uint32_t edgeCost (const initio_plan *plan, int x, int y, int k)
+{
+    int w = plan->params.width, nx = x + dx8[k], ny = y + dy8[k] ;
+
+    if (nx < 0 || ny < 0 || nx >= w || ny >= plan->params.height || plan->cells[ny * w + nx].near)
+        return INF ;
+    if (dx8[k] == 0 || dy8[k] == 0)
+        return STRAIGHT ;
+    if (plan->cells[y * w + nx].near || plan->cells[ny * w + x].near)
+        return INF ;
+    return DIAGONAL ;
+}
+
+// minSucc(): smallest cost to the goal over the successors of u
+static uint32_t minSucc (const initio_plan *plan, uint32_t u)
+{
+    int w = plan->params.width, x = u % w, y = u / w, k ;
+    uint32_t best = INF, c, s ;
+
+    for (k = 0; k < 8; k++)
+    {
+        c = edgeCost (plan, x, y, k) ;
+        if (c == INF)
+            continue ;
+        s = (y + dy8[k]) * w + x + dx8[k] ;
+        if (plan->g[s] != INF && c + plan->g[s] < best)
+            best = c + plan->g[s] ;
+    }
+    return best ;
+}
+
+// settle(): queues u if it is inconsistent, removes it otherwise
+static void settle (initio_plan *plan, uint32_t u)
+{
+    if (plan->g[u] != plan->rhs[u])
+    {
+        if (!heapSet (plan, u, key (plan, u)))
+            plan->fresh = TRUE ;  // cannot queue u: the search is incomplete, search again
+    }
+    else if (plan->pos[u] != 0)
+        heapRemove (plan, u) ;
+}
+
+static void updateVertex (initio_plan *plan, uint32_t u)
+{
+    if (u != plan->goal)
+        plan->rhs[u] = minSucc (plan, u) ;
+    settle (plan, u) ;
+}
+
+static unsigned long computeShortestPath (initio_plan *plan)
+{
+    int w = plan->params.width, h = plan->params.height, x, y, sx, sy, k ;
+    uint32_t u, s, c, gOld, *g = plan->g, *rhs = plan->rhs ;
+    uint64_t top, knew ;
+    unsigned long expanded = 0 ;
+
+    while (plan->heapSize > 0 && !plan->fresh)
+    {
+        top = plan->heap[0].key ;
+        if (top >= key (plan, plan->start) && rhs[plan->start] == g[plan->start])
+            break ;
+        u = plan->heap[0].node ;
+        knew = key (plan, u) ;
+        expanded++ ;
+        if (top < knew)
+        {
+            heapSet (plan, u, knew) ;  // km grew since u was queued
+            continue ;
+        }
+        x = u % w ;
+        y = u / w ;
+        if (g[u] > rhs[u])
+        {
+            // overconsistent: g drops to rhs, predecessors may get cheaper
+            g[u] = rhs[u] ;
+            heapRemove (plan, u) ;
+            for (k = 0; k < 8; k++)
+            {
+                sx = x + dx8[k] ;
+                sy = y + dy8[k] ;
+                if (sx < 0 || sy < 0 || sx >= w || sy >= h)
+                    continue ;
+                s = sy * w + sx ;
+                c = edgeCost (plan, sx, sy, (k + 4) % 8) ;
+                if (s != plan->goal && c != INF && c + g[u] < rhs[s])
+                {
+                    rhs[s] = c + g[u] ;
+                    settle (plan, s) ;
+                }
+            }
+        }
+        else
+        {
+            // underconsistent: u and the predecessors that went through u
+            gOld = g[u] ;
+            g[u] = INF ;
+            updateVertex (plan, u) ;
+            for (k = 0; k < 8; k++)
+            {
+                sx = x + dx8[k] ;
+                sy = y + dy8[k] ;
+                if (sx < 0 || sy < 0 || sx >= w || sy >= h)
+                    continue ;
+                s = sy * w + sx ;
+                c = edgeCost (plan, sx, sy, (k + 4) % 8) ;
+                if (s != plan->goal && c != INF && rhs[s] == c + gOld)
+                    updateVertex (plan, s) ;
+            }
+        }
+    }
+    return expanded ;
+}
+
+BOOL initio_PlanSetGoal (initio_plan *plan, double x, double y)
+{
+    int u = cellAt (plan, x, y) ;
+
+    if (u < 0)
+        return FALSE ;
+    plan->goal = u ;
+    plan->goalX = x ;
+    plan->goalY = y ;
+    plan->hasGoal = TRUE ;
+    plan->fresh = TRUE ;
+    return TRUE ;
+}
+
+BOOL initio_PlanReplan (initio_plan *plan, const initio_pose *pose)
+{
+    int w = plan->params.width, u = cellAt (plan, pose->x, pose->y), i, k, x, y ;
+    BOOL search = FALSE ;
+    double t ;
+
+    if (!plan->hasGoal || u < 0)
+        return FALSE ;
+    plan->pose = *pose ;
+    t = initio_Now () ;
+    if (plan->fresh)
+    {
+        memset (plan->g, 0xff, plan->n * sizeof(uint32_t)) ;
+        memset (plan->rhs, 0xff, plan->n * sizeof(uint32_t)) ;
+        for (i = 0; i < plan->heapSize; i++)
+            plan->pos[plan->heap[i].node] = 0 ;
+        plan->heapSize = 0 ;
+        plan->km = 0 ;
+        plan->start = u ;
+        plan->rhs[plan->goal] = 0 ;
+        plan->fresh = FALSE ;
+        settle (plan, plan->goal) ;
+        search = TRUE ;
+    }
+    else if (u != plan->start)
+    {
+        plan->km += heuristic (plan, plan->start, u) ;
+        plan->start = u ;
+        search = TRUE ;
+    }
+    for (i = 0; i < plan->changedCount; i++)
+    {
+        u = plan->changed[i] ;
+        plan->cells[u].flags &= ~CELL_CHANGED ;
+        updateVertex (plan, u) ;
+        x = u % w ;
+        y = u / w ;
+        for (k = 0; k < 8; k++)
+            if (x + dx8[k] >= 0 && y + dy8[k] >= 0 && x + dx8[k] < w && y + dy8[k] < plan->params.height)
+                updateVertex (plan, (y + dy8[k]) * w + x + dx8[k]) ;
+        search = TRUE ;
+    }
+    plan->changedCount = 0 ;
+
+    if (search)
+    {
+        plan->stats.lastExpanded = computeShortestPath (plan) ;
+        t = (initio_Now () - t) * 1e3 ;
+        plan->stats.replans++ ;
+        plan->stats.expanded += plan->stats.lastExpanded ;
+        plan->stats.lastMs = t ;
+        plan->stats.totalMs += t ;
+        if (t > plan->stats.maxMs)
+            plan->stats.maxMs = t ;
+        plan->found = !plan->fresh && plan->g[plan->start] != INF ;
+        plan->stats.cost = plan->found ? plan->g[plan->start] * plan->params.cellCm / STRAIGHT : INFINITY ;
+        plan->wpValid = FALSE ;
+    }
+    return plan->found ;
+}
+
+// End of D* Lite
+//======================================================================
+
+
+//======================================================================
+// Waypoints and driving
+
+// extractPath(): follows the cheapest successors from start to goal
+static BOOL extractPath (initio_plan *plan)
+{
+    int w = plan->params.width, x, y, k ;
+    uint32_t u = plan->start, best, bestS = 0, c, s ;
+
+    plan->pathCount = 0 ;
+    for (;;)
+    {
+        if (!grow ((void **)&plan->path, &plan->pathCap, plan->pathCount + 1, sizeof(uint32_t)))
+            return FALSE ;
+        plan->path[plan->pathCount++] = u ;
+        if (u == plan->goal)
+            return TRUE ;
+        if (plan->pathCount > plan->n)
+            return FALSE ;
+        x = u % w ;
+        y = u / w ;
+        best = INF ;
+        for (k = 0; k < 8; k++)
+        {
+            c = edgeCost (plan, x, y, k) ;
+            s = (y + dy8[k]) * w + x + dx8[k] ;
+            if (c != INF && plan->g[s] != INF && c + plan->g[s] < best)
+            {
+                best = c + plan->g[s] ;
+                bestS = s ;
+            }
+        }
+        if (best == INF)
+            return FALSE ;
+        u = bestS ;
+    }
+}
+
+// lineOfSight(): TRUE if the straight line between the centres of cells
+// a and b only crosses enterable cells
+static BOOL lineOfSight (const initio_plan *plan, uint32_t a, uint32_t b)
+{
+    int w = plan->params.width, ax = a % w, ay = a / w ;
+    int dx = (int)(b % w) - ax, dy = (int)(b / w) - ay ;
+    int steps = 2 * ((abs (dx) > abs (dy)) ? abs (dx) : abs (dy)), i, x, y ;
+
+    for (i = 1; i < steps; i++)
+    {
+        x = ax + (int)floor ((double)dx * i / steps + 0.5) ;
+        y = ay + (int)floor ((double)dy * i / steps + 0.5) ;
+        if (plan->cells[y * w + x].near)
+            return FALSE ;
+    }
+    return TRUE ;
+}
+
+// addWaypoint()
+static BOOL addWaypoint (initio_plan *plan, initio_point p)
+{
+    if (!grow ((void **)&plan->wp, &plan->wpCap, plan->wpCount + 1, sizeof(initio_point)))
+        return FALSE ;
+    plan->wp[plan->wpCount++] = p ;
+    return TRUE ;
+}
+
+// makeWaypoints(): shortens the cell path to the cells where the line of
+// sight from the previous waypoint ends
+static BOOL makeWaypoints (initio_plan *plan)
+{
+    initio_point p ;
+    int anchor = 0, i ;
+
+    plan->wpCount = 0 ;
+    if (!plan->found || !extractPath (plan))
+        return FALSE ;
+    p.x = plan->pose.x ;
+    p.y = plan->pose.y ;
+    addWaypoint (plan, p) ;
+    for (i = 2; i < plan->pathCount; i++)
+        if (!lineOfSight (plan, plan->path[anchor], plan->path[i]))
+        {
+            anchor = i - 1 ;
+            if (!addWaypoint (plan, centre (plan, plan->path[anchor])))
+                return FALSE ;
+        }
+    p.x = plan->goalX ;
+    p.y = plan->goalY ;
+    if (!addWaypoint (plan, p))
+        return FALSE ;
+    plan->wpValid = TRUE ;
+    return TRUE ;
+}
+
+int initio_PlanGetWaypoints (initio_plan *plan, initio_point *wp, int max)
+{
+    if (!plan->wpValid && !makeWaypoints (plan))
+        return 0 ;
+    memcpy (wp, plan->wp, ((plan->wpCount < max) ? plan->wpCount : max) * sizeof(initio_point)) ;
+    return plan->wpCount ;
+}
+
+int initio_PlanDrive (initio_plan *plan, initio_ctx *ctx, const initio_pose *pose)
+{
+    const initio_planParams *p = &plan->params ;
+    double e, turn ;
+    int left, right ;
+
+    if (ctx == NULL)
+        ctx = initio_DefaultCtx () ;
+    // arrived even if the goal has become blocked meanwhile
+    if (plan->hasGoal && hypot (plan->goalX - pose->x, plan->goalY - pose->y) <= p->goalTolerance)
+    {
+        initio_ctxStop (ctx) ;
+        return INITIO_PLAN_ARRIVED ;
+    }
+    if (!initio_PlanReplan (plan, pose) || (!plan->wpValid && !makeWaypoints (plan)))
+    {
+        initio_ctxStop (ctx) ;
+        return INITIO_PLAN_NOPATH ;
+    }
+
+    // heading error to the next waypoint, normalised to -pi..pi
+    e = atan2 (plan->wp[1].y - pose->y, plan->wp[1].x - pose->x) - pose->theta ;
+    e = atan2 (sin (e), cos (e)) ;
+    if (e > p->spinAngle)
+        initio_ctxSpinLeft (ctx, p->spinDuty) ;
+    else if (e < -p->spinAngle)
+        initio_ctxSpinRight (ctx, p->spinDuty) ;
+    else
+    {
+        turn = p->speed * e / p->spinAngle ;
+        left = lround (p->speed - turn) ;
+        right = lround (p->speed + turn) ;
+        left = (left < 0) ? 0 : (left > 100) ? 100 : left ;
+        right = (right < 0) ? 0 : (right > 100) ? 100 : right ;
+        initio_ctxTurnForward (ctx, left, right) ;
+    }
+    return INITIO_PLAN_DRIVING ;
+}
+
+void initio_PlanGetStats (initio_plan *plan, initio_planStats *stats)
+{
+    *stats = plan->stats ;
+    stats->bytes = sizeof(initio_plan) + plan->n * (sizeof(cell) + 3 * sizeof(uint32_t))
+                 + plan->heapCap * sizeof(heapEntry) + plan->changedCap * sizeof(uint32_t)
+                 + plan->pathCap * sizeof(uint32_t) + plan->wpCap * sizeof(initio_point)
+                 + 2 * plan->offCount * sizeof(int) ;
+}
+
+// End of Waypoints and driving
+//======================================================================
@@ -0,0 +1,146 @@
+#ifndef _4TRONIX_INITIO_PLAN_H_
+#define _4TRONIX_INITIO_PLAN_H_
+//======================================================================
+//
+// Incremental path planner (D* Lite) of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Plans a path to a goal over an occupancy grid that is filled in from
+// the sonar and IR sensors while driving:
+//   o a cell is occupied after repeated sonar echoes or one IR trip and
+//     free again after enough sonar rays passed through it; occupied
+//     cells are inflated by the robot radius: a cell whose centre is
+//     closer than the radius to the edge of an occupied cell cannot be
+//     entered,
+//   o the search runs from the goal to the robot on the 8-connected grid
+//     (D* Lite), so a replan after a move or after a few changed cells
+//     only repairs the part of the search those changes affect. Diagonal
+//     moves must not cut the corner of a blocked cell,
+//   o per cell the grid keeps 16 bytes (g, rhs, heap position, evidence,
+//     inflation count); the open list is a binary heap with decrease-key,
+//   o the cell path is shortened to waypoints between which the robot
+//     sees free cells only (line of sight).
+// initio_PlanDrive steers the robot towards the next waypoint with the
+// spin and turn motor calls; alternatively the waypoints can be handed
+// to a path follower (initio_path.h). The planner is not thread-safe.
+//
+// Coordinates are in cm, angles in radians (counter-clockwise, 0 == +x).
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_path.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Results of initio_PlanDrive
+#define INITIO_PLAN_DRIVING  0   // moving towards the next waypoint
+#define INITIO_PLAN_ARRIVED  1   // within goalTolerance of the goal, motors stopped
+#define INITIO_PLAN_NOPATH   2   // no path to the goal, motors stopped
+
+typedef struct {
+    int width, height ;          // grid size in cells
+    double cellCm ;              // cell size in cm
+    double originX, originY ;    // position of the outer corner of cell (0, 0) in cm
+    double robotRadius ;         // occupied cells are inflated by this in cm
+    double sonarMaxCm ;          // range up to which the sonar is trusted in cm
+    double irCm ;                // distance of a tripping obstacle ahead of the robot centre in cm
+    int speed ;                  // duty on straight segments, 0..100
+    int spinDuty ;               // duty when turning on the spot, 0..100
+    double spinAngle ;           // heading error in rad above which the robot turns on the spot
+    double goalTolerance ;       // distance to the goal that counts as arrived in cm
+} initio_planParams ;
+
+typedef struct {
+    unsigned long replans ;      // searches (initio_PlanReplan with changes or a move)
+    unsigned long expanded ;     // nodes expanded in total
+    unsigned long lastExpanded ; // ... by the last search
+    unsigned long changedCells ; // cells that became blocked or free
+    double lastMs ;              // duration of the last search in ms
+    double maxMs ;               // longest search in ms
+    double totalMs ;             // all searches in ms
+    double cost ;                // length of the cell path in cm, INFINITY: no path
+    size_t bytes ;               // memory of grid and heap
+} initio_planStats ;
+
+typedef struct initio_plan initio_plan ;
+
+
+//======================================================================
+// Grid and Planner
+
+// initio_PlanDefaultParams (params):
+// Fills params with a 10 m x 10 m grid of 5 cm cells centred on the
+// origin, a robot radius of 12 cm, a sonar range of 150 cm, IR at 15 cm
+// and driving at duty 60, spinning at duty 50 above 0.6 rad.
+void initio_PlanDefaultParams (initio_planParams *params) ;
+
+// initio_PlanCreate (params):
+// Creates a planner with an empty grid; params == NULL selects the
+// defaults. Returns NULL on error.
+initio_plan *initio_PlanCreate (const initio_planParams *params) ;
+
+// initio_PlanFree (plan):
+void initio_PlanFree (initio_plan *plan) ;
+
+// initio_PlanSetGoal (plan, x, y):
+// Sets the goal and discards the search, so the next replan searches
+// from scratch. Returns FALSE if the goal is outside the grid.
+BOOL initio_PlanSetGoal (initio_plan *plan, double x, double y) ;
+
+// initio_PlanSetCell (plan, cx, cy, occupied):
+// Marks cell (cx, cy) as known occupied or free, e.g. from a map.
+void initio_PlanSetCell (initio_plan *plan, int cx, int cy, BOOL occupied) ;
+
+// initio_PlanCellBlocked (plan, cx, cy):
+// Returns TRUE if cell (cx, cy) is occupied or within the robot radius
+// of an occupied cell, or outside the grid.
+BOOL initio_PlanCellBlocked (initio_plan *plan, int cx, int cy) ;
+
+// initio_PlanSonar (plan, pose, bearing, cm):
+// Enters a sonar range cm (0 == no echo) seen from pose at bearing
+// relative to the heading: cells along the ray count as free, the cell
+// at the range as occupied. The beam is taken as a single ray.
+void initio_PlanSonar (initio_plan *plan, const initio_pose *pose, double bearing, unsigned int cm) ;
+
+// initio_PlanIr (plan, pose, left, right):
+// Enters the IR obstacle sensors: a tripped sensor marks the cell irCm
+// ahead on its side as occupied.
+void initio_PlanIr (initio_plan *plan, const initio_pose *pose, BOOL left, BOOL right) ;
+
+// initio_PlanReplan (plan, pose):
+// Moves the start of the search to pose and repairs the search for the
+// cells changed since the last call. Returns FALSE if there is no goal,
+// pose is outside the grid, the goal cannot be reached or memory for the
+// search ran out (the next call then searches from scratch).
+BOOL initio_PlanReplan (initio_plan *plan, const initio_pose *pose) ;
+
+// initio_PlanGetWaypoints (plan, wp, max):
+// Copies up to max waypoints of the path found by the last replan, from
+// the pose of the replan to the goal, and returns their number (0: no
+// path). The number may exceed max.
+int initio_PlanGetWaypoints (initio_plan *plan, initio_point *wp, int max) ;
+
+// initio_PlanDrive (plan, ctx, pose):
+// One navigation step for ctx (NULL: default context) at pose: stops if
+// the goal is within goalTolerance, otherwise replans, then spins towards
+// the next waypoint or drives a forward turn onto it. Returns
+// INITIO_PLAN_*.
+int initio_PlanDrive (initio_plan *plan, initio_ctx *ctx, const initio_pose *pose) ;
+
+// initio_PlanGetStats (plan, stats):
+void initio_PlanGetStats (initio_plan *plan, initio_planStats *stats) ;
+
+// End of Grid and Planner
+//======================================================================
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_PLAN_H_ */
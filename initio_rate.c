@@ -0,0 +1,162 @@
+//======================================================================
+//
+// Fixed-rate loop helper of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "initio_rate.h"
+
+struct initio_rate {
+    pthread_t thread ;
+    pthread_mutex_t mutex ;   // protects stats
+    initio_rateFunc func ;
+    void *arg ;
+    volatile long periodNs ;
+    volatile int running ;
+    volatile int quit ;
+    initio_rateStats stats ;
+    double periodSumUs, execSumUs ;
+    struct timespec start ;
+} ;
+
+static long long tsToNs (const struct timespec *ts)
+{
+    return (long long)ts->tv_sec * 1000000000LL + ts->tv_nsec ;
+}
+
+static void nsToTs (long long ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / 1000000000LL ;
+    ts->tv_nsec = ns % 1000000000LL ;
+}
+
+static void *rateThread (void *arg)
+{
+    initio_rate *rate = arg ;
+    struct timespec ts ;
+    long long deadline, begin, end, prevBegin = 0 ;
+
+    pthread_setname_np (pthread_self (), "initio-rate") ;  // shows in /proc/<pid>/task/*/comm
+    clock_gettime (CLOCK_MONOTONIC, &rate->start) ;
+    deadline = tsToNs (&rate->start) ;
+    while (!rate->quit)
+    {
+        long long period ;
+        BOOL more ;
+
+        nsToTs (deadline, &ts) ;
+        clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ;
+        clock_gettime (CLOCK_MONOTONIC, &ts) ;
+        begin = tsToNs (&ts) ;
+
+        more = rate->func (rate->arg) ;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts) ;
+        end = tsToNs (&ts) ;
+
+        pthread_mutex_lock (&rate->mutex) ;
+        {
+            initio_rateStats *s = &rate->stats ;
+            double execUs = (end - begin) / 1000.0 ;
+            double jitterUs = (begin - deadline) / 1000.0 ;
+
+            s->cycles++ ;
+            rate->execSumUs += execUs ;
+            s->execAvgUs = rate->execSumUs / s->cycles ;
+            if (execUs > s->execMaxUs) s->execMaxUs = execUs ;
+            if (jitterUs > s->jitterMaxUs) s->jitterMaxUs = jitterUs ;
+            if (prevBegin != 0)
+            {
+                double periodUs = (begin - prevBegin) / 1000.0 ;
+                rate->periodSumUs += periodUs ;
+                s->periodAvgUs = rate->periodSumUs / (s->cycles - 1) ;
+                if (s->periodMinUs == 0 || periodUs < s->periodMinUs) s->periodMinUs = periodUs ;
+                if (periodUs > s->periodMaxUs) s->periodMaxUs = periodUs ;
+            }
+            s->rateHz = s->cycles * 1e9 / (double)(end - tsToNs (&rate->start) + 1) ;
+        }
+        pthread_mutex_unlock (&rate->mutex) ;
+        prevBegin = begin ;
+
+        if (!more)
+            break ;
+
+        // next deadline at the current rate (initio_RateSetHz, also from
+        // func); if we are more than one period late, skip the missed ones
+        period = rate->periodNs ;
+        deadline += period ;
+        if (end - deadline > period)
+        {
+            pthread_mutex_lock (&rate->mutex) ;
+            rate->stats.overruns++ ;
+            pthread_mutex_unlock (&rate->mutex) ;
+            deadline = end + period - (end - deadline) % period ;
+        }
+    }
+    rate->running = FALSE ;
+    return NULL ;
+}
+
+initio_rate *initio_RateStart (double hz, initio_rateFunc func, void *arg)
+{
+    initio_rate *rate ;
+
+    if (hz <= 0 || func == NULL)
+        return NULL ;
+    rate = calloc (1, sizeof(initio_rate)) ;
+    if (rate == NULL)
+        return NULL ;
+    pthread_mutex_init (&rate->mutex, NULL) ;
+    rate->func = func ;
+    rate->arg = arg ;
+    rate->periodNs = (long)(1e9 / hz) ;
+    rate->running = TRUE ;
+    if (pthread_create (&rate->thread, NULL, rateThread, rate) != 0)
+    {
+        pthread_mutex_destroy (&rate->mutex) ;
+        free (rate) ;
+        return NULL ;
+    }
+    return rate ;
+}
+
+void initio_RateSetHz (initio_rate *rate, double hz)
+{
+    if (hz > 0)
+        rate->periodNs = (long)(1e9 / hz) ;
+}
+
+BOOL initio_RateRunning (initio_rate *rate)
+{
+    return rate->running ;
+}
+
+void initio_RateGetStats (initio_rate *rate, initio_rateStats *stats)
+{
+    pthread_mutex_lock (&rate->mutex) ;
+    *stats = rate->stats ;
+    pthread_mutex_unlock (&rate->mutex) ;
+}
+
+void initio_RateStop (initio_rate *rate, initio_rateStats *stats)
+{
+    if (rate == NULL)
+        return ;
+    rate->quit = TRUE ;
+    pthread_join (rate->thread, NULL) ;
+    if (stats != NULL)
+        *stats = rate->stats ;
+    pthread_mutex_destroy (&rate->mutex) ;
+    free (rate) ;
+}
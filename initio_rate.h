@@ -0,0 +1,63 @@
+#ifndef _4TRONIX_INITIO_RATE_H_
+#define _4TRONIX_INITIO_RATE_H_
+//======================================================================
+//
+// Fixed-rate loop helper of the initio library: runs a function
+// periodically in its own thread and keeps timing statistics.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include "initio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timing statistics of a fixed-rate loop (times in us)
+typedef struct {
+    unsigned long cycles ;    // number of executed cycles
+    unsigned long overruns ;  // cycles started more than one period late (deadlines skipped)
+    double rateHz ;           // achieved rate since start
+    double periodAvgUs ;      // start-to-start time of consecutive cycles
+    double periodMinUs ;
+    double periodMaxUs ;
+    double jitterMaxUs ;      // largest deviation of a cycle start from its deadline
+    double execAvgUs ;        // time spent in the cycle function
+    double execMaxUs ;
+} initio_rateStats ;
+
+// Cycle function, returns FALSE to end the loop
+typedef BOOL (*initio_rateFunc)(void *arg) ;
+
+typedef struct initio_rate initio_rate ;
+
+// initio_RateStart (hz, func, arg):
+// Starts a thread calling func(arg) at hz cycles per second. Returns NULL on error.
+initio_rate *initio_RateStart (double hz, initio_rateFunc func, void *arg) ;
+
+// initio_RateSetHz (rate, hz):
+// Changes the loop rate, effective from the next cycle.
+void initio_RateSetHz (initio_rate *rate, double hz) ;
+
+// initio_RateRunning (rate):
+// Returns TRUE while the cycle function has not ended the loop.
+BOOL initio_RateRunning (initio_rate *rate) ;
+
+// initio_RateGetStats (rate, stats):
+// Copies the current timing statistics.
+void initio_RateGetStats (initio_rate *rate, initio_rateStats *stats) ;
+
+// initio_RateStop (rate, stats):
+// Ends the loop, waits for the thread and frees rate. If stats != NULL
+// the final timing statistics are copied to it.
+void initio_RateStop (initio_rate *rate, initio_rateStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_RATE_H_ */
@@ -0,0 +1,709 @@
+//======================================================================
+//
+// Record/replay hardware access of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "initio_replay.h"
+
+#define MAGIC "INITIOR1"  // file header, followed by the entries (host byte order)
+#define PINS 64           // pin numbers stored in the log
+#define WINDOW 256        // entries searched ahead to resynchronise a replay
+
+// Operations in the log
+enum { OP_SETUP, OP_PINMODE, OP_PUD, OP_READ, OP_WRITE, OP_PWMCREATE, OP_PWMWRITE,
+       OP_PWMSTOP, OP_MICROS, OP_DELAY, OP_ISRSET, OP_ISR, OP_SERVO, OP_RUN } ;
+
+// Polling loops (e.g. the sonar waiting for its echo) alternate digitalRead
+// and micros() thousands of times with the same level. Such a run of n pairs
+// is logged as the pair before it, OP_RUN (pin, level, n - 1) standing for
+// the pairs but the last, and the last pair: the times in between are
+// interpolated on replay. The level and the time of the last pair, which
+// decide when the loop ends, are exact.
+
+typedef struct {
+    uint32_t t ;       // us since the start of the recording
+    uint8_t op ;
+    uint8_t pin ;      // pin, or servo of OP_SERVO
+    int16_t value2 ;   // range of OP_PWMCREATE, result of OP_ISRSET
+    int32_t value ;    // level, mode, duty, time, ...
+} entry_t ;
+
+
+//======================================================================
+// Recording
+
+typedef struct {
+    initio_recorder *rec ;
+    int pin ;
+    void (*func) (void *) ;
+    void *arg ;
+} recIsr_t ;
+
+struct initio_recorder {
+    const initio_hw *hw ;   // wrapped hardware access
+    void *arg ;
+    initio_hw ops ;         // returned by initio_RecordHw
+    FILE *fp ;
+    pthread_mutex_t mutex ; // serialises the writes to fp
+    struct timespec start ;
+    initio_recordStats stats ;
+    BOOL failed ;
+    recIsr_t isr[PINS] ;
+
+    entry_t prev[2] ;       // last two entries written, prev[1] the latest
+    struct {
+        BOOL active ;
+        unsigned long pairs ;   // complete read/micros pairs
+        BOOL readPending ;      // read of the next pair logged
+        entry_t read, last[2] ; // pending read, last complete pair
+    } run ;                 // polling run being compressed
+} ;
+
+static void writeEntry (initio_recorder *rec, const entry_t *e)
+{
+    if (fwrite (e, sizeof(*e), 1, rec->fp) != 1)
+        rec->failed = TRUE ;
+    rec->stats.entries++ ;
+    rec->prev[0] = rec->prev[1] ;
+    rec->prev[1] = *e ;
+}
+
+// flushRun(): writes a polling run
+static void flushRun (initio_recorder *rec)
+{
+    if (rec->run.pairs > 1)
+    {
+        entry_t r = rec->run.last[0] ;
+
+        r.op = OP_RUN ;
+        r.value2 = rec->run.last[0].value ;
+        r.value = rec->run.pairs - 1 ;
+        writeEntry (rec, &r) ;
+    }
+    if (rec->run.pairs > 0)
+    {
+        writeEntry (rec, &rec->run.last[0]) ;
+        writeEntry (rec, &rec->run.last[1]) ;
+    }
+    if (rec->run.readPending)
+        writeEntry (rec, &rec->run.read) ;
+    memset (&rec->run, 0, sizeof(rec->run)) ;
+}
+
+static void logEntry (initio_recorder *rec, int op, int pin, int32_t value, int16_t value2)
+{
+    struct timespec ts ;
+    entry_t e ;
+
+    memset (&e, 0, sizeof(e)) ;
+    e.op = op ;
+    e.pin = pin ;
+    e.value = value ;
+    e.value2 = value2 ;
+    pthread_mutex_lock (&rec->mutex) ;
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    e.t = (uint32_t)((ts.tv_sec - rec->start.tv_sec) * 1000000LL + (ts.tv_nsec - rec->start.tv_nsec) / 1000) ;
+    rec->stats.operations++ ;
+
+    if (rec->run.active)
+    {
+        if (!rec->run.readPending && op == OP_READ && pin == rec->run.read.pin && value == rec->run.read.value)
+        {
+            rec->run.read = e ;
+            rec->run.readPending = TRUE ;
+            goto done ;
+        }
+        if (rec->run.readPending && op == OP_MICROS)
+        {
+            rec->run.last[0] = rec->run.read ;
+            rec->run.last[1] = e ;
+            rec->run.pairs++ ;
+            rec->run.readPending = FALSE ;
+            goto done ;
+        }
+        flushRun (rec) ;
+    }
+    if (op == OP_READ && rec->prev[1].op == OP_MICROS && rec->prev[0].op == OP_READ
+        && rec->prev[0].pin == pin && rec->prev[0].value == value && rec->stats.entries >= 2)
+    {
+        // third read of a polling loop: start a run
+        rec->run.active = TRUE ;
+        rec->run.read = e ;
+        rec->run.readPending = TRUE ;
+        goto done ;
+    }
+    writeEntry (rec, &e) ;
+done:
+    pthread_mutex_unlock (&rec->mutex) ;
+}
+
+static void recSetup (void *arg)
+{
+    initio_recorder *rec = arg ;
+
+    if (rec->hw->setup != NULL)
+        rec->hw->setup (rec->arg) ;
+    logEntry (rec, OP_SETUP, 0, 0, 0) ;
+}
+
+static void recPinMode (void *arg, int pin, int mode)
+{
+    initio_recorder *rec = arg ;
+
+    rec->hw->pinMode (rec->arg, pin, mode) ;
+    logEntry (rec, OP_PINMODE, pin, mode, 0) ;
+}
+
+static void recPullUpDnControl (void *arg, int pin, int pud)
+{
+    initio_recorder *rec = arg ;
+
+    rec->hw->pullUpDnControl (rec->arg, pin, pud) ;
+    logEntry (rec, OP_PUD, pin, pud, 0) ;
+}
+
+static int recDigitalRead (void *arg, int pin)
+{
+    initio_recorder *rec = arg ;
+    int value = rec->hw->digitalRead (rec->arg, pin) ;
+
+    logEntry (rec, OP_READ, pin, value, 0) ;
+    return value ;
+}
+
+static void recDigitalWrite (void *arg, int pin, int value)
+{
+    initio_recorder *rec = arg ;
+
+    rec->hw->digitalWrite (rec->arg, pin, value) ;
+    logEntry (rec, OP_WRITE, pin, value, 0) ;
+}
+
+static int recSoftPwmCreate (void *arg, int pin, int value, int range)
+{
+    initio_recorder *rec = arg ;
+    int result = rec->hw->softPwmCreate (rec->arg, pin, value, range) ;
+
+    logEntry (rec, OP_PWMCREATE, pin, value, range) ;
+    return result ;
+}
+
+static void recSoftPwmWrite (void *arg, int pin, int value)
+{
+    initio_recorder *rec = arg ;
+
+    rec->hw->softPwmWrite (rec->arg, pin, value) ;
+    logEntry (rec, OP_PWMWRITE, pin, value, 0) ;
+}
+
+static void recSoftPwmStop (void *arg, int pin)
+{
+    initio_recorder *rec = arg ;
+
+    rec->hw->softPwmStop (rec->arg, pin) ;
+    logEntry (rec, OP_PWMSTOP, pin, 0, 0) ;
+}
+
+static unsigned int recMicros (void *arg)
+{
+    initio_recorder *rec = arg ;
+    unsigned int us = rec->hw->micros (rec->arg) ;
+
+    logEntry (rec, OP_MICROS, 0, (int32_t)us, 0) ;
+    return us ;
+}
+
+static void recDelayMicroseconds (void *arg, unsigned int us)
+{
+    initio_recorder *rec = arg ;
+
+    rec->hw->delayMicroseconds (rec->arg, us) ;
+    logEntry (rec, OP_DELAY, 0, (int32_t)us, 0) ;
+}
+
+// recIsrFired(): logs an interrupt before passing it on
+static void recIsrFired (void *arg)
+{
+    recIsr_t *isr = arg ;
+
+    logEntry (isr->rec, OP_ISR, isr->pin, 0, 0) ;
+    isr->func (isr->arg) ;
+}
+
+static int recIsr (void *arg, int pin, int edge, void (*func) (void *), void *funcArg)
+{
+    initio_recorder *rec = arg ;
+    int result ;
+
+    if (pin < 0 || pin >= PINS)
+        return -1 ;
+    rec->isr[pin].func = func ;
+    rec->isr[pin].arg = funcArg ;
+    result = rec->hw->isr (rec->arg, pin, edge, recIsrFired, &rec->isr[pin]) ;
+    logEntry (rec, OP_ISRSET, pin, edge, result) ;
+    return result ;
+}
+
+static void recServoWrite (void *arg, int servo, int position)
+{
+    initio_recorder *rec = arg ;
+
+    rec->hw->servoWrite (rec->arg, servo, position) ;
+    logEntry (rec, OP_SERVO, servo, position, 0) ;
+}
+
+initio_recorder *initio_RecordStart (const char *path, const initio_hw *hw, void *arg)
+{
+    initio_recorder *rec = calloc (1, sizeof(initio_recorder)) ;
+    int i ;
+
+    if (rec == NULL)
+        return NULL ;
+    rec->fp = fopen (path, "wb") ;
+    if (rec->fp == NULL || fwrite (MAGIC, 8, 1, rec->fp) != 1)
+    {
+        if (rec->fp != NULL)
+            fclose (rec->fp) ;
+        free (rec) ;
+        return NULL ;
+    }
+    rec->hw = (hw != NULL) ? hw : &initio_wiringPiHw ;
+    rec->arg = arg ;
+    rec->ops = (initio_hw) {
+        .setup = recSetup,
+        .pinMode = recPinMode,
+        .pullUpDnControl = recPullUpDnControl,
+        .digitalRead = recDigitalRead,
+        .digitalWrite = recDigitalWrite,
+        .softPwmCreate = recSoftPwmCreate,
+        .softPwmWrite = recSoftPwmWrite,
+        .softPwmStop = recSoftPwmStop,
+        .micros = recMicros,
+        .delayMicroseconds = recDelayMicroseconds,
+        .isr = recIsr,
+        .servoWrite = (rec->hw->servoWrite != NULL) ? recServoWrite : NULL,
+    } ;
+    for (i = 0; i < PINS; i++)
+    {
+        rec->isr[i].rec = rec ;
+        rec->isr[i].pin = i ;
+    }
+    pthread_mutex_init (&rec->mutex, NULL) ;
+    clock_gettime (CLOCK_MONOTONIC, &rec->start) ;
+    return rec ;
+}
+
+const initio_hw *initio_RecordHw (initio_recorder *rec)
+{
+    return &rec->ops ;
+}
+
+void initio_RecordGetStats (initio_recorder *rec, initio_recordStats *stats)
+{
+    pthread_mutex_lock (&rec->mutex) ;
+    *stats = rec->stats ;
+    pthread_mutex_unlock (&rec->mutex) ;
+}
+
+BOOL initio_RecordStop (initio_recorder *rec)
+{
+    BOOL ok ;
+
+    if (rec->run.active)
+        flushRun (rec) ;
+    ok = !rec->failed ;
+
+    if (fclose (rec->fp) != 0)
+        ok = FALSE ;
+    pthread_mutex_destroy (&rec->mutex) ;
+    free (rec) ;
+    return ok ;
+}
+
+// End of Recording
+//======================================================================
+
+
+
+//======================================================================
+// Replay
+
+typedef struct {
+    void (*func) (void *) ;
+    void *arg ;
+} isr_t ;
+
+struct initio_replay {
+    entry_t *log ;
+    pthread_mutex_t mutex ;   // serialises the accesses
+    int level[PINS] ;         // last level read or written per pin
+    uint32_t micros ;         // last time returned by micros()
+    isr_t isr[PINS] ;
+    isr_t *due ;              // interrupts passed, not yet delivered
+    unsigned long dueHead, dueCount, dueSize ;
+    initio_replayStats stats ;
+
+    // expansion of the OP_RUN entry at stats.position
+    unsigned long runLeft ;   // pairs left
+    unsigned long runDone ;   // pairs replayed
+    BOOL runMicros ;          // read of the current pair replayed
+    uint32_t runT0, runT1 ;   // times before and at the end of the run
+    entry_t synth ;           // entry returned for a pair of the run
+} ;
+
+static void mismatch (initio_replay *rp) ;
+
+// pass(): replays the effects of entry e on the inputs. Interrupts are
+// queued; unlock() delivers them once the mutex is released.
+static void pass (initio_replay *rp, const entry_t *e)
+{
+    if (e->pin >= PINS)
+        return ;
+    switch (e->op)
+    {
+    case OP_READ:
+    case OP_WRITE:
+        rp->level[e->pin] = e->value ;
+        break ;
+    case OP_RUN:
+        rp->level[e->pin] = e->value2 ;
+        break ;
+    case OP_MICROS:
+        rp->micros = (uint32_t)e->value ;
+        break ;
+    case OP_ISR:
+        if (rp->isr[e->pin].func == NULL)
+            break ;
+        if (rp->dueCount == rp->dueSize)
+        {
+            unsigned long size = rp->dueSize ? 2 * rp->dueSize : 16 ;
+            isr_t *due = realloc (rp->due, size * sizeof(isr_t)) ;
+
+            if (due == NULL)
+            {
+                mismatch (rp) ;  // interrupt lost
+                break ;
+            }
+            rp->due = due ;
+            rp->dueSize = size ;
+        }
+        rp->due[rp->dueCount++] = rp->isr[e->pin] ;
+        break ;
+    }
+}
+
+static void mismatch (initio_replay *rp)
+{
+    if (rp->stats.mismatches++ == 0)
+        rp->stats.firstMismatch = rp->stats.position ;
+}
+
+// unlock(): releases the mutex and delivers the queued interrupts in log
+// order. The handlers run without the mutex, so they may access the
+// hardware themselves.
+static void unlock (initio_replay *rp)
+{
+    isr_t isr ;
+
+    while (rp->dueHead < rp->dueCount)
+    {
+        isr = rp->due[rp->dueHead++] ;
+        if (rp->dueHead == rp->dueCount)
+            rp->dueHead = rp->dueCount = 0 ;
+        pthread_mutex_unlock (&rp->mutex) ;
+        isr.func (isr.arg) ;
+        pthread_mutex_lock (&rp->mutex) ;
+    }
+    pthread_mutex_unlock (&rp->mutex) ;
+}
+
+// skip(): passes the entries up to end, which the controller did not
+// access; recorded commands it did not issue count as mismatches
+static void skip (initio_replay *rp, unsigned long end)
+{
+    initio_replayStats *s = &rp->stats ;
+
+    for (; s->position < end; s->position++)
+    {
+        const entry_t *e = &rp->log[s->position] ;
+
+        pass (rp, e) ;
+        if (e->op == OP_ISR)
+            continue ;
+        s->skipped++ ;
+        if (e->op != OP_READ && e->op != OP_MICROS && e->op != OP_RUN)
+            mismatch (rp) ;
+    }
+}
+
+// next(): finds the next entry for op on pin within the window, passing the
+// entries before it. Returns NULL (and passes nothing) if there is none.
+static const entry_t *next (initio_replay *rp, int op, int pin)
+{
+    initio_replayStats *s = &rp->stats ;
+    unsigned long i ;
+
+    if (rp->runLeft > 0)
+    {
+        const entry_t *r = &rp->log[s->position] ;
+
+        rp->synth = *r ;
+        rp->synth.op = op ;
+        if (!rp->runMicros && op == OP_READ && pin == r->pin)
+        {
+            rp->runMicros = TRUE ;
+            rp->level[pin] = rp->synth.value = r->value2 ;
+            return &rp->synth ;
+        }
+        if (rp->runMicros && op == OP_MICROS)
+        {
+            rp->runMicros = FALSE ;
+            rp->runDone++ ;
+            rp->micros = rp->runT0 + (uint32_t)((uint64_t)(rp->runT1 - rp->runT0) * rp->runDone / (r->value + 1)) ;
+            rp->synth.pin = 0 ;
+            rp->synth.value = (int32_t)rp->micros ;
+            if (--rp->runLeft == 0)
+            {
+                s->position++ ;
+                s->done = (s->position == s->entries) ;
+            }
+            return &rp->synth ;
+        }
+        // the controller left the polling loop: drop the rest of the run
+        rp->runLeft = 0 ;
+        rp->runMicros = FALSE ;
+        s->position++ ;
+        s->skipped++ ;
+    }
+
+    for (i = s->position; i < s->entries && i < s->position + WINDOW; i++)
+    {
+        const entry_t *e = &rp->log[i] ;
+
+        if (e->op == OP_RUN && op == OP_READ && e->pin == pin && e->value > 0)
+        {
+            skip (rp, i) ;
+            rp->runLeft = e->value ;
+            rp->runDone = 0 ;
+            rp->runT0 = rp->micros ;
+            rp->runT1 = (i + 2 < s->entries && rp->log[i + 2].op == OP_MICROS) ? (uint32_t)rp->log[i + 2].value : rp->micros ;
+            return next (rp, op, pin) ;
+        }
+        if (e->op == op && e->pin == pin)
+        {
+            skip (rp, i) ;
+            pass (rp, e) ;
+            // interrupts that came before the next access are delivered now
+            for (s->position = i + 1; s->position < s->entries && rp->log[s->position].op == OP_ISR; s->position++)
+                pass (rp, &rp->log[s->position]) ;
+            s->done = (s->position == s->entries) ;
+            return e ;
+        }
+    }
+    return NULL ;
+}
+
+// command(): replays a command, compares it with the log
+static void command (initio_replay *rp, int op, int pin, int32_t value, int16_t value2)
+{
+    const entry_t *e ;
+
+    pthread_mutex_lock (&rp->mutex) ;
+    rp->stats.commands++ ;
+    e = next (rp, op, pin) ;
+    if (e == NULL || e->value != value || e->value2 != value2)
+        mismatch (rp) ;
+    if (op == OP_WRITE)
+        rp->level[pin] = value ;
+    unlock (rp) ;
+}
+
+static void rpSetup (void *arg)
+{
+    command (arg, OP_SETUP, 0, 0, 0) ;
+}
+
+static void rpPinMode (void *arg, int pin, int mode)
+{
+    command (arg, OP_PINMODE, pin, mode, 0) ;
+}
+
+static void rpPullUpDnControl (void *arg, int pin, int pud)
+{
+    command (arg, OP_PUD, pin, pud, 0) ;
+}
+
+static int rpDigitalRead (void *arg, int pin)
+{
+    initio_replay *rp = arg ;
+    const entry_t *e ;
+    int value ;
+
+    if (pin < 0 || pin >= PINS)
+        return 0 ;
+    pthread_mutex_lock (&rp->mutex) ;
+    rp->stats.reads++ ;
+    e = next (rp, OP_READ, pin) ;
+    if (e == NULL)
+        rp->stats.offLog++ ;
+    value = rp->level[pin] ;
+    unlock (rp) ;
+    return value ;
+}
+
+static void rpDigitalWrite (void *arg, int pin, int value)
+{
+    if (pin >= 0 && pin < PINS)
+        command (arg, OP_WRITE, pin, value, 0) ;
+}
+
+static int rpSoftPwmCreate (void *arg, int pin, int value, int range)
+{
+    command (arg, OP_PWMCREATE, pin, value, range) ;
+    return 0 ;
+}
+
+static void rpSoftPwmWrite (void *arg, int pin, int value)
+{
+    command (arg, OP_PWMWRITE, pin, value, 0) ;
+}
+
+static void rpSoftPwmStop (void *arg, int pin)
+{
+    command (arg, OP_PWMSTOP, pin, 0, 0) ;
+}
+
+static unsigned int rpMicros (void *arg)
+{
+    initio_replay *rp = arg ;
+    unsigned int us ;
+
+    pthread_mutex_lock (&rp->mutex) ;
+    rp->stats.reads++ ;
+    if (next (rp, OP_MICROS, 0) == NULL)
+    {
+        rp->stats.offLog++ ;
+        rp->micros++ ;  // let polling loops time out
+    }
+    us = rp->micros ;
+    unlock (rp) ;
+    return us ;
+}
+
+static void rpDelayMicroseconds (void *arg, unsigned int us)
+{
+    command (arg, OP_DELAY, 0, (int32_t)us, 0) ;
+}
+
+static int rpIsr (void *arg, int pin, int edge, void (*func) (void *), void *funcArg)
+{
+    initio_replay *rp = arg ;
+    const entry_t *e ;
+    int result = -1 ;
+
+    if (pin < 0 || pin >= PINS)
+        return -1 ;
+    pthread_mutex_lock (&rp->mutex) ;
+    rp->isr[pin].func = func ;
+    rp->isr[pin].arg = funcArg ;
+    rp->stats.commands++ ;
+    e = next (rp, OP_ISRSET, pin) ;
+    if (e == NULL || e->value != edge)
+        mismatch (rp) ;
+    if (e != NULL)
+        result = e->value2 ;
+    unlock (rp) ;
+    return result ;
+}
+
+static void rpServoWrite (void *arg, int servo, int position)
+{
+    command (arg, OP_SERVO, servo, position, 0) ;
+}
+
+const initio_hw initio_replayHw = {
+    .setup = rpSetup,
+    .pinMode = rpPinMode,
+    .pullUpDnControl = rpPullUpDnControl,
+    .digitalRead = rpDigitalRead,
+    .digitalWrite = rpDigitalWrite,
+    .softPwmCreate = rpSoftPwmCreate,
+    .softPwmWrite = rpSoftPwmWrite,
+    .softPwmStop = rpSoftPwmStop,
+    .micros = rpMicros,
+    .delayMicroseconds = rpDelayMicroseconds,
+    .isr = rpIsr,
+    .servoWrite = rpServoWrite,  // no servod while replaying
+} ;
+
+initio_replay *initio_ReplayOpen (const char *path)
+{
+    initio_replay *rp ;
+    char magic[8] ;
+    long size ;
+    FILE *fp ;
+
+    fp = fopen (path, "rb") ;
+    if (fp == NULL)
+        return NULL ;
+    rp = calloc (1, sizeof(initio_replay)) ;
+    if (rp == NULL || fread (magic, 8, 1, fp) != 1 || memcmp (magic, MAGIC, 8) != 0
+        || fseek (fp, 0, SEEK_END) != 0 || (size = ftell (fp)) < 8 || fseek (fp, 8, SEEK_SET) != 0)
+        goto fail ;
+    rp->stats.entries = (size - 8) / sizeof(entry_t) ;
+    rp->log = malloc (rp->stats.entries * sizeof(entry_t) + 1) ;
+    if (rp->log == NULL || fread (rp->log, sizeof(entry_t), rp->stats.entries, fp) != rp->stats.entries)
+        goto fail ;
+    fclose (fp) ;
+    rp->stats.firstMismatch = -1 ;
+    rp->stats.done = (rp->stats.entries == 0) ;
+    pthread_mutex_init (&rp->mutex, NULL) ;
+    return rp ;
+
+fail:
+    fclose (fp) ;
+    if (rp != NULL)
+        free (rp->log) ;
+    free (rp) ;
+    return NULL ;
+}
+
+BOOL initio_ReplayDone (initio_replay *rp)
+{
+    BOOL done ;
+
+    pthread_mutex_lock (&rp->mutex) ;
+    done = rp->stats.done ;
+    pthread_mutex_unlock (&rp->mutex) ;
+    return done ;
+}
+
+void initio_ReplayGetStats (initio_replay *rp, initio_replayStats *stats)
+{
+    pthread_mutex_lock (&rp->mutex) ;
+    *stats = rp->stats ;
+    pthread_mutex_unlock (&rp->mutex) ;
+}
+
+void initio_ReplayClose (initio_replay *rp)
+{
+    pthread_mutex_destroy (&rp->mutex) ;
+    free (rp->due) ;
+    free (rp->log) ;
+    free (rp) ;
+}
+
+// End of Replay
+//======================================================================
@@ -0,0 +1,115 @@
+#ifndef _4TRONIX_INITIO_REPLAY_H_
+#define _4TRONIX_INITIO_REPLAY_H_
+//======================================================================
+//
+// Record/replay hardware access of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// A recorder wraps another hardware access (e.g. initio_wiringPiHw
+// on the robot) and logs every operation in the order issued: the values
+// read (digitalRead levels of the IR, line and wheel sensors and the
+// sonar, micros() time stamps), the commands (pinMode, digitalWrite,
+// softPwm*, delays, servos) and every interrupt delivered (wheel pulses).
+//
+// initio_replayHw plays such a log back at full CPU speed, without
+// waiting: reads return the recorded values and interrupts are delivered
+// at the position they happened, so an unchanged controller sees exactly
+// the recorded run. The interrupt handlers run in the thread whose access
+// reached them, before that access returns and without the replay's lock
+// held. Commands are compared with the log. A changed
+// controller that issues other operations is resynchronised on the next
+// matching entry within a window; reads off the log return the last
+// level recorded for the pin and micros() advances by 1 us per call.
+// The differences are counted (initio_ReplayGetStats).
+//
+// Replay is deterministic as long as the hardware is accessed from one
+// thread at a time (plus interrupts), as by the classic API.
+// Servos driven by servod (servoWrite == NULL of the wrapped access)
+// bypass the hardware access and are not recorded.
+// Polling loops, like the sonar waiting for its echo, are compressed to a
+// few entries per loop. Time stamps in the log are in us since the start
+// of the recording, the recording covers up to 71 minutes.
+//
+// Usage:
+//   rec = initio_RecordStart ("run.log", NULL, NULL) ;
+//   ctx = initio_Open (ROBOHAT, initio_RecordHw (rec), rec, INITIO_ALL) ;
+//   ... controller ... ; initio_Close (ctx) ; initio_RecordStop (rec) ;
+// and off the robot:
+//   rp = initio_ReplayOpen ("run.log") ;
+//   ctx = initio_Open (ROBOHAT, &initio_replayHw, rp, INITIO_ALL) ;
+//   ... controller, until initio_ReplayDone (rp) ...
+//
+//======================================================================
+
+#include "initio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct initio_recorder initio_recorder ;
+typedef struct initio_replay initio_replay ;
+
+// Hardware access replaying an initio_replay (arg)
+extern const initio_hw initio_replayHw ;
+
+typedef struct {
+    unsigned long operations ;  // hardware accesses recorded
+    unsigned long entries ;     // entries written to the log (12 bytes each)
+} initio_recordStats ;
+
+typedef struct {
+    unsigned long entries ;     // entries in the log
+    unsigned long position ;    // entries replayed or skipped so far
+    unsigned long reads ;       // digitalRead/micros calls
+    unsigned long offLog ;      // reads that found no matching entry
+    unsigned long commands ;    // commands issued
+    unsigned long mismatches ;  // commands differing from the log or not found
+    unsigned long skipped ;     // entries skipped to resynchronise
+    long firstMismatch ;        // position of the first difference, -1: none
+    BOOL done ;                 // all entries replayed
+} initio_replayStats ;
+
+// initio_RecordStart (path, hw, arg):
+// Creates a recorder logging the accesses to hw with argument arg
+// (hw == NULL: initio_wiringPiHw) into the file path. Returns NULL on error.
+initio_recorder *initio_RecordStart (const char *path, const initio_hw *hw, void *arg) ;
+
+// initio_RecordHw (rec):
+// Returns the hardware access recording into rec (the argument of its
+// functions). It drives the servos like the wrapped one does.
+const initio_hw *initio_RecordHw (initio_recorder *rec) ;
+
+// initio_RecordGetStats (rec, stats):
+// Copies the counters.
+void initio_RecordGetStats (initio_recorder *rec, initio_recordStats *stats) ;
+
+// initio_RecordStop (rec):
+// Completes the log and frees rec; close the contexts using it first.
+// Returns FALSE if writing the log failed.
+BOOL initio_RecordStop (initio_recorder *rec) ;
+
+// initio_ReplayOpen (path):
+// Loads a log written by a recorder. Returns NULL on error.
+initio_replay *initio_ReplayOpen (const char *path) ;
+
+// initio_ReplayDone (rp):
+// Returns TRUE when all entries have been replayed.
+BOOL initio_ReplayDone (initio_replay *rp) ;
+
+// initio_ReplayGetStats (rp, stats):
+// Copies the counters.
+void initio_ReplayGetStats (initio_replay *rp, initio_replayStats *stats) ;
+
+// initio_ReplayClose (rp):
+// Frees rp; close the contexts using it first.
+void initio_ReplayClose (initio_replay *rp) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_REPLAY_H_ */
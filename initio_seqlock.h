@@ -0,0 +1,69 @@
+#ifndef _4TRONIX_INITIO_SEQLOCK_H_
+#define _4TRONIX_INITIO_SEQLOCK_H_
+//======================================================================
+//
+// Sequence lock for publishing a latest value of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// One writer publishes a value, any number of readers copy it. The writer
+// never waits; a reader retries its copy if a write happened meanwhile,
+// so it always gets a complete value and never blocks the writer. A
+// reader that finds a write in progress yields the CPU before it retries,
+// so on a single core it lets a preempted writer finish instead of
+// spinning for its whole time slice.
+// Several writers must be serialised by the caller.
+//
+//======================================================================
+
+#include <string.h>
+#include <sched.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned int seq ;  // odd while a write is in progress
+} initio_seqlock ;
+
+// initio_SeqWrite (lock, dst, src, size):
+// Publishes size bytes from src into the shared dst.
+static inline void initio_SeqWrite (initio_seqlock *lock, void *dst, const void *src, size_t size)
+{
+    unsigned int seq = __atomic_load_n (&lock->seq, __ATOMIC_RELAXED) ;
+
+    __atomic_store_n (&lock->seq, seq + 1, __ATOMIC_RELAXED) ;
+    __atomic_thread_fence (__ATOMIC_RELEASE) ;
+    memcpy (dst, src, size) ;
+    __atomic_store_n (&lock->seq, seq + 2, __ATOMIC_RELEASE) ;
+}
+
+// initio_SeqRead (lock, dst, src, size):
+// Copies a consistent snapshot of the shared src into dst. Returns the
+// number of writes published so far (0: nothing published yet).
+static inline unsigned int initio_SeqRead (const initio_seqlock *lock, void *dst, const void *src, size_t size)
+{
+    unsigned int seq ;
+
+    for (;;)
+    {
+        seq = __atomic_load_n (&lock->seq, __ATOMIC_ACQUIRE) ;
+        if ((seq & 1) == 0)
+        {
+            memcpy (dst, src, size) ;
+            __atomic_thread_fence (__ATOMIC_ACQUIRE) ;
+            if (__atomic_load_n (&lock->seq, __ATOMIC_RELAXED) == seq)
+                return seq / 2 ;
+        }
+        sched_yield () ;  // a write is in progress or happened meanwhile
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_SEQLOCK_H_ */
@@ -0,0 +1,256 @@
+//======================================================================
+//
+// Kinematic simulation of the initio chassis.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "initio_sim.h"
+
+void initio_SimDefaultParams (initio_simParams *params)
+{
+    params->wheelBase = 14.0 ;
+    params->maxSpeed = 60.0 ;
+    params->stallDuty = 15 ;
+    params->tau = 0.08 ;
+    params->tauCoast = 0.08 ;
+    params->tauBrake = 0.025 ;
+    params->cmPerTick = 1.0 ;
+}
+
+void initio_SimInit (initio_sim *sim, const initio_simParams *params, const initio_pose *start)
+{
+    memset (sim, 0, sizeof(initio_sim)) ;
+    if (params != NULL)
+        sim->params = *params ;
+    else
+        initio_SimDefaultParams (&sim->params) ;
+    if (start != NULL)
+        sim->pose = *start ;
+}
+
+void initio_SimSetMotors (initio_sim *sim, int left, int right)
+{
+    sim->dutyLeft = (left < -100) ? -100 : (left > 100) ? 100 : left ;
+    sim->dutyRight = (right < -100) ? -100 : (right > 100) ? 100 : right ;
+}
+
+double initio_SimWheelSpeed (const initio_simParams *params, int duty)
+{
+    int mag = abs (duty) ;
+
+    if (mag <= params->stallDuty)
+        return 0 ;
+    return ((duty < 0) ? -1 : 1) * params->maxSpeed * (mag - params->stallDuty) / (100.0 - params->stallDuty) ;
+}
+
+// lag(): first-order lag of a wheel at speed v towards the steady-state
+// speed of duty over dt: with tau while driven, tauBrake while braked and
+// tauCoast otherwise
+static double lag (const initio_simParams *p, double v, int duty, BOOL brake, double dt)
+{
+    double tau = (duty != 0) ? p->tau : brake ? p->tauBrake : p->tauCoast ;
+    double rate = (tau > 0) ? 1 / tau : INFINITY ;
+
+    if (dt <= 0)
+        return v ;
+    return v + (1 - exp (-dt * rate)) * (initio_SimWheelSpeed (p, duty) - v) ;
+}
+
+void initio_SimStep (initio_sim *sim, double dt)
+{
+    const initio_simParams *p = &sim->params ;
+    double sl, sr, ds, dth ;
+    unsigned long ticks[2] ;
+    int i ;
+
+    sim->vLeft = lag (p, sim->vLeft, sim->dutyLeft, sim->brakeLeft, dt) ;
+    sim->vRight = lag (p, sim->vRight, sim->dutyRight, sim->brakeRight, dt) ;
+
+    sl = sim->vLeft * dt ;
+    sr = sim->vRight * dt ;
+    ds = (sl + sr) / 2 ;
+    dth = (sr - sl) / p->wheelBase ;
+    sim->pose.x += ds * cos (sim->pose.theta + dth / 2) ;
+    sim->pose.y += ds * sin (sim->pose.theta + dth / 2) ;
+    sim->pose.theta = remainder (sim->pose.theta + dth, 2 * M_PI) ;
+
+    sim->distLeft += fabs (sl) ;
+    sim->distRight += fabs (sr) ;
+    ticks[0] = (unsigned long)(sim->distLeft / p->cmPerTick) ;
+    ticks[1] = (unsigned long)(sim->distRight / p->cmPerTick) ;
+    sim->time += dt ;
+
+    // one rising edge of the wheel sensor per tick
+    for (i = 0; i < 2; i++)
+    {
+        unsigned long *count = (i == 0) ? &sim->ticksLeft : &sim->ticksRight ;
+        while (*count < ticks[i])
+        {
+            (*count)++ ;
+            if (sim->isrFunc[i] != NULL)
+                sim->isrFunc[i] (sim->isrArg[i]) ;
+        }
+    }
+}
+
+BOOL initio_SimPose (void *sim, initio_pose *pose)
+{
+    *pose = ((initio_sim *)sim)->pose ;
+    return TRUE ;
+}
+
+void initio_SimMotors (void *sim, int left, int right)
+{
+    initio_SimSetMotors ((initio_sim *)sim, left, right) ;
+}
+
+
+
+//======================================================================
+// Simulated Hardware Access
+
+#define SONAR_LATENCY 100e-6  // trigger to start of the echo pulse in s
+
+static double simNow (initio_sim *sim)
+{
+    return sim->time + sim->hwTime ;
+}
+
+// motorIndex(): index of a motor pin of either board in pwm[], -1 if none
+static int motorIndex (int pin)
+{
+    if (pin == L1_PiRoCon || pin == L1_RoboHAT) return 0 ;
+    if (pin == L2_PiRoCon || pin == L2_RoboHAT) return 1 ;
+    if (pin == R1_PiRoCon || pin == R1_RoboHAT) return 2 ;
+    if (pin == R2_PiRoCon || pin == R2_RoboHAT) return 3 ;
+    return -1 ;
+}
+
+static void simPinMode (void *arg, int pin, int mode)
+{
+}
+
+static void simPullUpDnControl (void *arg, int pin, int pud)
+{
+}
+
+static int simDigitalRead (void *arg, int pin)
+{
+    initio_sim *sim = arg ;
+    double frac ;
+
+    sim->hwTime += 1e-6 ;
+    switch (pin)
+    {
+    case irFL: return !sim->ir[0] ;  // sensors are active low
+    case irFR: return !sim->ir[1] ;
+    case lineLeft_PiRoCon:
+    case lineLeft_RoboHat: return !sim->line[0] ;
+    case lineRight: return !sim->line[1] ;
+    case wheelLeft:
+    case wheelRight:
+        frac = ((pin == wheelLeft) ? sim->distLeft : sim->distRight) / sim->params.cmPerTick ;
+        return (frac - floor (frac)) < 0.5 ;
+    case sonar_PiRoCon:
+    case sonar_RoboHAT:
+        if (sim->sonarCm > 0)
+        {
+            double t = simNow (sim) - sim->sonarTrigger - SONAR_LATENCY ;
+            return (t >= 0 && t < (sim->sonarCm + 0.5) * 2 / 34400.0) ;
+        }
+        return sim->sonarOut ;
+    }
+    return 0 ;
+}
+
+static void simDigitalWrite (void *arg, int pin, int value)
+{
+    initio_sim *sim = arg ;
+
+    sim->hwTime += 1e-6 ;
+    if (pin == sonar_PiRoCon || pin == sonar_RoboHAT)
+    {
+        if (sim->sonarOut && !value)
+            sim->sonarTrigger = simNow (sim) ;  // end of the trigger pulse
+        sim->sonarOut = value ;
+    }
+}
+
+static int simSoftPwmCreate (void *arg, int pin, int value, int range)
+{
+    return 0 ;
+}
+
+static void simSoftPwmWrite (void *arg, int pin, int value)
+{
+    initio_sim *sim = arg ;
+    int i = motorIndex (pin) ;
+
+    if (i < 0)
+        return ;
+    sim->pwm[i] = value ;
+    // partly on inputs overlap only by chance (softPwm phases): no brake
+    sim->brakeLeft = (sim->pwm[0] >= 100 && sim->pwm[1] >= 100) ;
+    sim->brakeRight = (sim->pwm[2] >= 100 && sim->pwm[3] >= 100) ;
+    initio_SimSetMotors (sim, sim->pwm[0] - sim->pwm[1], sim->pwm[2] - sim->pwm[3]) ;
+}
+
+static void simSoftPwmStop (void *arg, int pin)
+{
+    simSoftPwmWrite (arg, pin, 0) ;
+}
+
+static unsigned int simMicros (void *arg)
+{
+    initio_sim *sim = arg ;
+
+    sim->hwTime += 1e-6 ;
+    return (unsigned int)(simNow (sim) * 1e6) ;
+}
+
+static void simDelayMicroseconds (void *arg, unsigned int us)
+{
+    ((initio_sim *)arg)->hwTime += us * 1e-6 ;
+}
+
+static int simIsr (void *arg, int pin, int edge, void (*func) (void *), void *funcArg)
+{
+    initio_sim *sim = arg ;
+    int i = (pin == wheelLeft) ? 0 : (pin == wheelRight) ? 1 : -1 ;
+
+    if (i < 0)
+        return -1 ;  // only the wheel sensors generate interrupts
+    sim->isrArg[i] = funcArg ;
+    sim->isrFunc[i] = func ;
+    return 0 ;
+}
+
+static void simServoWrite (void *arg, int servo, int position)
+{
+}
+
+const initio_hw initio_simHw = {
+    .setup = NULL,
+    .pinMode = simPinMode,
+    .pullUpDnControl = simPullUpDnControl,
+    .digitalRead = simDigitalRead,
+    .digitalWrite = simDigitalWrite,
+    .softPwmCreate = simSoftPwmCreate,
+    .softPwmWrite = simSoftPwmWrite,
+    .softPwmStop = simSoftPwmStop,
+    .micros = simMicros,
+    .delayMicroseconds = simDelayMicroseconds,
+    .isr = simIsr,
+    .servoWrite = simServoWrite,
+} ;
+
+// End of Simulated Hardware Access
+//======================================================================
@@ -0,0 +1,103 @@
+#ifndef _4TRONIX_INITIO_SIM_H_
+#define _4TRONIX_INITIO_SIM_H_
+//======================================================================
+//
+// Kinematic simulation of the initio chassis.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Differential drive with a stall threshold and a first-order motor lag:
+// a wheel does not move below stallDuty, above it the steady-state speed
+// grows linearly up to maxSpeed at duty 100. An undriven wheel slows down
+// with tauCoast, or with tauBrake while both motor inputs are fully on
+// (short-circuit brake). The simulation provides a
+// pose source and a motor sink for the controllers of the library, so
+// they can be tested and measured without the robot.
+//
+// initio_simHw is a hardware access for initio_Open() driving a simulated
+// chassis: the motor pins set its duties, the wheel sensors follow its
+// wheel travel, and IR, line and ultrasonic sensors report the values set
+// in the sim structure. Its micros() clock is the simulated time plus the
+// time consumed by the hardware accesses themselves (1us per access), so
+// polling loops like initio_ctxUsGetDistance() finish at full CPU speed.
+// Every simulated robot needs its own initio_sim and context.
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_path.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    double wheelBase ;   // distance between the wheels in cm
+    double maxSpeed ;    // wheel speed at duty 100 in cm/s
+    int stallDuty ;      // largest duty that does not move a wheel
+    double tau ;         // motor time constant in s
+    double tauCoast ;    // time constant of a wheel with both motor inputs off (coasting)
+    double tauBrake ;    // ... with both inputs on (short-circuit brake, initio_ctxBrake)
+    double cmPerTick ;   // wheel travel per wheel sensor pulse in cm
+} initio_simParams ;
+
+typedef struct {
+    initio_simParams params ;
+    initio_pose pose ;          // true pose
+    double time ;               // simulated time in s
+    int dutyLeft, dutyRight ;   // commanded signed duties
+    BOOL brakeLeft, brakeRight ; // both inputs of a motor fully on
+    double vLeft, vRight ;      // wheel speeds in cm/s
+    double distLeft, distRight ;         // travelled distance per wheel (unsigned) in cm
+    unsigned long ticksLeft, ticksRight ; // wheel sensor pulses
+
+    // simulated sensors and pins of initio_simHw
+    BOOL ir[2] ;                // IR obstacle sensors left/right triggered
+    BOOL line[2] ;              // IR line sensors left/right triggered
+    unsigned int sonarCm ;      // distance seen by the sonar, 0 == no object
+    int pwm[4] ;                // duties of L1, L2, R1, R2
+    double hwTime ;             // time consumed by hardware accesses in s
+    double sonarTrigger ;       // time of the last trigger pulse in s
+    int sonarOut ;              // level written to the sonar pin
+    void (*isrFunc[2]) (void *) ;  // wheel sensor interrupt handlers
+    void *isrArg[2] ;
+} initio_sim ;
+
+// Hardware access for initio_Open() with arg == initio_sim *
+extern const initio_hw initio_simHw ;
+
+// initio_SimDefaultParams (params):
+// Fills params with values approximating the initio chassis.
+void initio_SimDefaultParams (initio_simParams *params) ;
+
+// initio_SimInit (sim, params, start):
+// Initialises sim; params == NULL selects the defaults, start == NULL the origin.
+void initio_SimInit (initio_sim *sim, const initio_simParams *params, const initio_pose *start) ;
+
+// initio_SimSetMotors (sim, left, right):
+// Sets the signed duties -100..100 of the simulated motors.
+void initio_SimSetMotors (initio_sim *sim, int left, int right) ;
+
+// initio_SimStep (sim, dt):
+// Advances the simulation by dt seconds.
+void initio_SimStep (initio_sim *sim, double dt) ;
+
+// initio_SimWheelSpeed (params, duty):
+// Returns the steady-state wheel speed in cm/s for a signed duty.
+double initio_SimWheelSpeed (const initio_simParams *params, int duty) ;
+
+// initio_SimPose (sim, pose):
+// Pose source returning the true pose of sim.
+BOOL initio_SimPose (void *sim, initio_pose *pose) ;
+
+// initio_SimMotors (sim, left, right):
+// Motor sink forwarding to initio_SimSetMotors().
+void initio_SimMotors (void *sim, int left, int right) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_SIM_H_ */
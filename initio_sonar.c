@@ -0,0 +1,137 @@
+//======================================================================
+//
+// Ping scheduler for the ultrasonic sensor of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "initio_sonar.h"
+#include "initio_seqlock.h"
+#include "initio_time.h"
+
+struct initio_sonar {
+    initio_ctx *ctx ;
+    initio_sonarParams params ;
+    unsigned int prevMaxCm ;   // range limit of ctx before the start
+    initio_rate *rate ;
+
+    // latest reading, published by the ping thread
+    initio_seqlock lock ;
+    initio_sonarReading reading ;
+
+    pthread_mutex_t mutex ;    // protects stats
+    initio_sonarStats stats ;
+    double pingSumUs ;
+} ;
+
+void initio_SonarDefaultParams (initio_sonarParams *params)
+{
+    params->maxCm = 400 ;
+    params->quietCm = 500 ;
+    params->recoveryUs = 1000 ;
+    params->hz = 0 ;
+}
+
+double initio_SonarMaxHz (const initio_sonarParams *params)
+{
+    unsigned int cm = (params->maxCm > params->quietCm) ? params->maxCm : params->quietCm ;
+
+    // trigger to trigger: the echoes of the farthest object, then the recovery
+    return 1e6 / (INITIO_US_ECHOTIME (cm) + params->recoveryUs) ;
+}
+
+// sonarCycle(): one ping of the ping thread
+static BOOL sonarCycle (void *arg)
+{
+    initio_sonar *sonar = arg ;
+    initio_sonarReading r ;
+    double t, us ;
+
+    t = initio_Now () ;
+    r.cm = initio_ctxUsGetDistance (sonar->ctx) ;
+    us = (initio_Now () - t) * 1e6 ;
+    r.time = t ;
+    r.pings = sonar->reading.pings + 1 ;  // only this thread writes the reading
+    initio_SeqWrite (&sonar->lock, &sonar->reading, &r, sizeof(r)) ;
+
+    pthread_mutex_lock (&sonar->mutex) ;
+    {
+        initio_sonarStats *s = &sonar->stats ;
+
+        s->pings++ ;
+        if (r.cm > 0) s->echoes++ ;
+        sonar->pingSumUs += us ;
+        s->pingAvgUs = sonar->pingSumUs / s->pings ;
+        if (us > s->pingMaxUs) s->pingMaxUs = us ;
+    }
+    pthread_mutex_unlock (&sonar->mutex) ;
+    return TRUE ;
+}
+
+initio_sonar *initio_SonarStart (initio_ctx *ctx, const initio_sonarParams *params)
+{
+    initio_sonar *sonar = calloc (1, sizeof(initio_sonar)) ;
+    double hz ;
+
+    if (sonar == NULL)
+        return NULL ;
+    sonar->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    if (params != NULL)
+        sonar->params = *params ;
+    else
+        initio_SonarDefaultParams (&sonar->params) ;
+    pthread_mutex_init (&sonar->mutex, NULL) ;
+
+    hz = sonar->stats.maxHz = initio_SonarMaxHz (&sonar->params) ;
+    if (sonar->params.hz > 0 && sonar->params.hz < hz)
+        hz = sonar->params.hz ;
+
+    sonar->prevMaxCm = initio_ctxUsGetMaxRange (sonar->ctx) ;
+    initio_ctxUsSetMaxRange (sonar->ctx, sonar->params.maxCm) ;
+    sonar->rate = initio_RateStart (hz, sonarCycle, sonar) ;
+    if (sonar->rate == NULL)
+    {
+        initio_ctxUsSetMaxRange (sonar->ctx, sonar->prevMaxCm) ;
+        pthread_mutex_destroy (&sonar->mutex) ;
+        free (sonar) ;
+        return NULL ;
+    }
+    return sonar ;
+}
+
+void initio_SonarStop (initio_sonar *sonar, initio_sonarStats *stats)
+{
+    initio_rateStats rs ;
+
+    initio_RateStop (sonar->rate, &rs) ;
+    initio_ctxUsSetMaxRange (sonar->ctx, sonar->prevMaxCm) ;
+    if (stats != NULL)
+    {
+        *stats = sonar->stats ;
+        stats->rate = rs ;
+    }
+    pthread_mutex_destroy (&sonar->mutex) ;
+    free (sonar) ;
+}
+
+unsigned long initio_SonarGet (initio_sonar *sonar, initio_sonarReading *reading)
+{
+    initio_SeqRead (&sonar->lock, reading, &sonar->reading, sizeof(*reading)) ;
+    return reading->pings ;
+}
+
+void initio_SonarGetStats (initio_sonar *sonar, initio_sonarStats *stats)
+{
+    pthread_mutex_lock (&sonar->mutex) ;
+    *stats = sonar->stats ;
+    pthread_mutex_unlock (&sonar->mutex) ;
+    initio_RateGetStats (sonar->rate, &stats->rate) ;
+}
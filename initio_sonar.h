@@ -0,0 +1,85 @@
+#ifndef _4TRONIX_INITIO_SONAR_H_
+#define _4TRONIX_INITIO_SONAR_H_
+//======================================================================
+//
+// Ping scheduler for the ultrasonic sensor of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Pings the HC-SR04 from a fixed-rate thread (initio_rate.h) as often as
+// the sensor allows and publishes the latest range lock-free. A ping may
+// only follow the previous one when the echoes of its burst have died
+// away: sound reflected by objects up to quietCm needs the echo time of
+// quietCm to return, even if the range is limited to a shorter maxCm, and
+// the sensor needs recoveryUs before the next trigger. Shorter ranges and
+// a quiet (e.g. small or damped) surrounding allow higher ping rates.
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned int maxCm ;       // range limit (initio_ctxUsSetMaxRange), 0: none
+    unsigned int quietCm ;     // objects farther away reflect no disturbing echo
+    unsigned int recoveryUs ;  // pause of the sensor between pings
+    double hz ;                // ping rate wanted, 0: as fast as the sensor allows
+} initio_sonarParams ;
+
+typedef struct {
+    unsigned int cm ;          // distance as returned by initio_UsGetDistance, 0 == no object
+    double time ;              // CLOCK_MONOTONIC time of the ping in s
+    unsigned long pings ;      // pings so far, including this one
+} initio_sonarReading ;
+
+typedef struct {
+    unsigned long pings ;      // pings sent
+    unsigned long echoes ;     // pings with an object in range
+    double maxHz ;             // ping rate allowed by the parameters
+    double pingAvgUs ;         // duration of initio_UsGetDistance
+    double pingMaxUs ;
+    initio_rateStats rate ;    // achieved ping rate (rate.rateHz) and timing
+} initio_sonarStats ;
+
+typedef struct initio_sonar initio_sonar ;
+
+// initio_SonarDefaultParams (params):
+// Fills params with values for the HC-SR04: 4m range, echoes die away
+// beyond 5m, 1ms recovery, as fast as possible (about 33 pings/s).
+void initio_SonarDefaultParams (initio_sonarParams *params) ;
+
+// initio_SonarMaxHz (params):
+// Returns the highest ping rate the parameters allow.
+double initio_SonarMaxHz (const initio_sonarParams *params) ;
+
+// initio_SonarStart (ctx, params):
+// Sets the range limit of ctx (NULL: default context) to params->maxCm and
+// starts pinging at the lower of params->hz and the allowed rate. params ==
+// NULL selects the defaults. Returns NULL on error.
+initio_sonar *initio_SonarStart (initio_ctx *ctx, const initio_sonarParams *params) ;
+
+// initio_SonarStop (sonar, stats):
+// Stops pinging, restores the previous range limit and frees sonar. If
+// stats != NULL the final statistics are copied to it.
+void initio_SonarStop (initio_sonar *sonar, initio_sonarStats *stats) ;
+
+// initio_SonarGet (sonar, reading):
+// Copies the latest reading; lock-free, callable from any thread.
+// Returns the number of pings so far (0: no reading yet).
+unsigned long initio_SonarGet (initio_sonar *sonar, initio_sonarReading *reading) ;
+
+// initio_SonarGetStats (sonar, stats):
+// Copies counters and the achieved rate.
+void initio_SonarGetStats (initio_sonar *sonar, initio_sonarStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_SONAR_H_ */
@@ -0,0 +1,46 @@
+#ifndef _4TRONIX_INITIO_TIME_H_
+#define _4TRONIX_INITIO_TIME_H_
+//======================================================================
+//
+// Monotonic clock readings shared by the modules of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// CLOCK_MONOTONIC does not jump with the wall clock, so differences of
+// two readings are elapsed times.
+//
+//======================================================================
+
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// initio_Now ():
+// Returns the monotonic time in seconds.
+static inline double initio_Now (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec + ts.tv_nsec * 1e-9 ;
+}
+
+// initio_NowNs ():
+// Returns the monotonic time in nanoseconds.
+static inline double initio_NowNs (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return ts.tv_sec * 1e9 + ts.tv_nsec ;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_TIME_H_ */
@@ -0,0 +1,208 @@
+//======================================================================
+//
+// Event tracing of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "initio_trace.h"
+
+typedef struct {
+    uint64_t ns ;
+    const char *cat ;
+    const char *name ;
+    char ph ;  // 'B' or 'E'
+} event_t ;
+
+// Ring of one thread: only the owner advances head, only
+// initio_TraceWrite advances tail.
+typedef struct traceBuf {
+    struct traceBuf *next ;
+    int tid ;
+    char threadName[16] ;
+    unsigned long head ;
+    unsigned long tail ;
+    unsigned long dropped ;
+    unsigned long open ;  // recorded begins without end, their ends are reserved
+    event_t events[INITIO_TRACE_EVENTS] ;
+} traceBuf ;
+
+int initio_traceOn = 0 ;
+
+static traceBuf *buffers = NULL ;       // all rings, pushed lock-free
+static __thread traceBuf *myBuf = NULL ;
+static __thread BOOL myBufFailed = FALSE ;
+static uint64_t epochNs = 0 ;
+static pthread_mutex_t writeMutex = PTHREAD_MUTEX_INITIALIZER ;  // serialises writers
+static unsigned long written = 0 ;
+
+static uint64_t nowNs (void)
+{
+    struct timespec ts ;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec ;
+}
+
+// newBuf(): ring of the calling thread, registered on first use
+static traceBuf *newBuf (void)
+{
+    traceBuf *b ;
+
+    if (myBufFailed || (b = calloc (1, sizeof(traceBuf))) == NULL)
+    {
+        myBufFailed = TRUE ;
+        return NULL ;
+    }
+    b->tid = (int)syscall (SYS_gettid) ;
+    if (pthread_getname_np (pthread_self (), b->threadName, sizeof(b->threadName)) != 0)
+        b->threadName[0] = '\0' ;
+    b->next = __atomic_load_n (&buffers, __ATOMIC_RELAXED) ;
+    while (!__atomic_compare_exchange_n (&buffers, &b->next, b, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    return myBuf = b ;
+}
+
+static BOOL record (const char *cat, const char *name, char ph)
+{
+    traceBuf *b = (myBuf != NULL) ? myBuf : newBuf () ;
+    unsigned long head ;
+    event_t *e ;
+
+    if (b == NULL)
+        return FALSE ;
+    head = b->head ;
+    if (ph == 'E' && b->open > 0)
+        b->open-- ;  // space reserved by the begin
+    else if (head - __atomic_load_n (&b->tail, __ATOMIC_ACQUIRE) + b->open + (ph == 'B' ? 2 : 1)
+             > INITIO_TRACE_EVENTS)
+    {
+        __atomic_store_n (&b->dropped, b->dropped + 1, __ATOMIC_RELAXED) ;
+        return FALSE ;
+    }
+    else if (ph == 'B')
+        b->open++ ;
+    e = &b->events[head % INITIO_TRACE_EVENTS] ;
+    e->ns = nowNs () ;
+    e->cat = cat ;
+    e->name = name ;
+    e->ph = ph ;
+    __atomic_store_n (&b->head, head + 1, __ATOMIC_RELEASE) ;
+    return TRUE ;
+}
+
+void initio_TraceEnable (BOOL on)
+{
+    uint64_t zero = 0 ;
+
+    if (on)
+        __atomic_compare_exchange_n (&epochNs, &zero, nowNs (), FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED) ;
+    __atomic_store_n (&initio_traceOn, on ? 1 : 0, __ATOMIC_RELAXED) ;
+}
+
+BOOL initio_TraceEnabled (void)
+{
+    return __atomic_load_n (&initio_traceOn, __ATOMIC_RELAXED) ;
+}
+
+BOOL initio_TraceBegin (const char *cat, const char *name)
+{
+    return record (cat, name, 'B') ;
+}
+
+void initio_TraceEnd (const char *cat, const char *name)
+{
+    record (cat, name, 'E') ;
+}
+
+// jsonName(): copies s without characters that would need escaping
+static const char *jsonName (const char *s, char *buf, size_t size)
+{
+    size_t i ;
+
+    for (i = 0; s[i] != '\0' && i + 1 < size; i++)
+        buf[i] = (s[i] == '"' || s[i] == '\\' || (unsigned char)s[i] < ' ') ? '_' : s[i] ;
+    buf[i] = '\0' ;
+    return buf ;
+}
+
+long initio_TraceWrite (const char *path)
+{
+    uint64_t epoch = __atomic_load_n (&epochNs, __ATOMIC_RELAXED) ;
+    int pid = (int)getpid () ;
+    const char *sep = "" ;
+    long count = 0 ;
+    traceBuf *b ;
+    FILE *fp ;
+
+    pthread_mutex_lock (&writeMutex) ;
+    fp = fopen (path, "w") ;
+    if (fp == NULL)
+    {
+        pthread_mutex_unlock (&writeMutex) ;
+        return -1 ;
+    }
+    fprintf (fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") ;
+    for (b = __atomic_load_n (&buffers, __ATOMIC_ACQUIRE); b != NULL; b = b->next)
+    {
+        unsigned long head = __atomic_load_n (&b->head, __ATOMIC_ACQUIRE) ;
+        unsigned long i ;
+        char name[64] ;
+
+        if (b->threadName[0] != '\0')
+        {
+            fprintf (fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     sep, pid, b->tid, jsonName (b->threadName, name, sizeof(name))) ;
+            sep = "," ;
+        }
+        for (i = b->tail; i != head; i++)
+        {
+            const event_t *e = &b->events[i % INITIO_TRACE_EVENTS] ;
+            char cat[64] ;
+
+            fprintf (fp, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                     sep, jsonName (e->name, name, sizeof(name)), jsonName (e->cat, cat, sizeof(cat)), e->ph,
+                     (e->ns - epoch) / 1000.0, pid, b->tid) ;
+            sep = "," ;
+            count++ ;
+        }
+        __atomic_store_n (&b->tail, head, __ATOMIC_RELEASE) ;
+    }
+    fprintf (fp, "\n]}\n") ;
+    if (fclose (fp) != 0)
+        count = -1 ;
+    else
+        written += count ;
+    pthread_mutex_unlock (&writeMutex) ;
+    return count ;
+}
+
+void initio_TraceGetStats (initio_traceStats *stats)
+{
+    traceBuf *b ;
+
+    stats->events = stats->dropped = 0 ;
+    stats->threads = 0 ;
+    for (b = __atomic_load_n (&buffers, __ATOMIC_ACQUIRE); b != NULL; b = b->next)
+    {
+        stats->events += __atomic_load_n (&b->head, __ATOMIC_RELAXED) ;
+        stats->dropped += __atomic_load_n (&b->dropped, __ATOMIC_RELAXED) ;
+        stats->threads++ ;
+    }
+    pthread_mutex_lock (&writeMutex) ;
+    stats->written = written ;
+    pthread_mutex_unlock (&writeMutex) ;
+}
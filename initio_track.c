@@ -0,0 +1,211 @@
+//======================================================================
+//
+// Sonar head target tracking of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "initio_track.h"
+#include "initio_seqlock.h"
+#include "initio_time.h"
+
+struct initio_track {
+    initio_ctx *ctx ;
+    initio_trackCore core ;    // tracking thread only
+    unsigned int prevMaxCm ;   // range limit of ctx before the start
+    initio_rate *rate ;
+
+    // latest estimate, published by the tracking thread
+    initio_seqlock lock ;
+    initio_trackReading reading ;
+
+    initio_trackStats stats ;  // atomic
+} ;
+
+static int clampInt (int v, int lo, int hi)
+{
+    return (v < lo) ? lo : (v > hi) ? hi : v ;
+}
+
+void initio_TrackDefaultParams (initio_trackParams *params)
+{
+    params->hz = 20 ;
+    params->bearingServo = servoTilt ;
+    params->elevationServo = servoPan ;
+    params->minBearing = -80 ;
+    params->maxBearing = 80 ;
+    params->minElevation = -40 ;
+    params->maxElevation = 80 ;
+    params->elevation = 0 ;
+    params->dither = 6 ;
+    params->rate = 40 ;
+    params->searchRate = 60 ;
+    params->deadbandCm = 2 ;
+    params->maxCm = 150 ;
+}
+
+void initio_TrackInit (initio_trackCore *core, const initio_trackParams *params, double bearing)
+{
+    core->params = *params ;
+    core->bearing = fmin (fmax (bearing, params->minBearing), params->maxBearing) ;
+    core->side = -1 ;
+    core->cm[0] = core->cm[1] = 0 ;
+    core->range = 0 ;
+    core->sweep = 1 ;
+    core->locked = FALSE ;
+}
+
+int initio_TrackAim (const initio_trackCore *core)
+{
+    const initio_trackParams *p = &core->params ;
+
+    return clampInt (lround (core->bearing + core->side * p->dither), p->minBearing, p->maxBearing) ;
+}
+
+BOOL initio_TrackStep (initio_trackCore *core, unsigned int cm)
+{
+    const initio_trackParams *p = &core->params ;
+    double dt = 2 / p->hz ;   // duration of a dither cycle
+    unsigned int l, r ;
+    int dir = 0 ;
+
+    core->cm[core->side > 0] = cm ;
+    core->side = -core->side ;
+    if (core->side > 0)
+        return FALSE ;  // the other side is still to ping
+
+    l = core->cm[0] ;
+    r = core->cm[1] ;
+    core->locked = (l > 0 || r > 0) ;
+    if (!core->locked)
+    {
+        // search: sweep on between the limits
+        core->range = 0 ;
+        core->bearing += core->sweep * p->searchRate * dt ;
+        if (core->bearing >= p->maxBearing)
+            core->sweep = -1 ;
+        else if (core->bearing <= p->minBearing)
+            core->sweep = 1 ;
+    }
+    else
+    {
+        core->range = (l == 0) ? r : (r == 0) ? l : (l < r) ? l : r ;
+        if (r == 0 || (l > 0 && l + p->deadbandCm < r))
+            dir = -1 ;
+        else if (l == 0 || r + p->deadbandCm < l)
+            dir = 1 ;
+        core->bearing += dir * p->rate * dt ;
+        if (dir != 0)
+            core->sweep = dir ;  // if lost, search on where it went
+    }
+    core->bearing = fmin (fmax (core->bearing, p->minBearing), p->maxBearing) ;
+    return TRUE ;
+}
+
+// trackCycle(): one ping of the tracking thread, then the aim for the next
+static BOOL trackCycle (void *arg)
+{
+    initio_track *track = arg ;
+    initio_trackCore *core = &track->core ;
+    initio_trackReading r ;
+    double bearing = core->bearing ;
+    BOOL wasLocked = core->locked ;
+    unsigned int cm ;
+
+    cm = initio_ctxUsGetDistance (track->ctx) ;
+    __atomic_add_fetch (&track->stats.pings, 1, __ATOMIC_RELAXED) ;
+    if (initio_TrackStep (core, cm))
+    {
+        r.bearing = core->bearing ;
+        r.cm = core->range ;
+        r.locked = core->locked ;
+        r.time = initio_Now () ;
+        r.cycles = track->reading.cycles + 1 ;  // only this thread writes the reading
+        initio_SeqWrite (&track->lock, &track->reading, &r, sizeof(r)) ;
+
+        __atomic_add_fetch (&track->stats.cycles, 1, __ATOMIC_RELAXED) ;
+        if (core->locked)
+        {
+            __atomic_add_fetch (&track->stats.lockedCycles, 1, __ATOMIC_RELAXED) ;
+            if (core->bearing != bearing)
+                __atomic_add_fetch (&track->stats.steps, 1, __ATOMIC_RELAXED) ;
+        }
+        else if (wasLocked)
+            __atomic_add_fetch (&track->stats.losses, 1, __ATOMIC_RELAXED) ;
+    }
+    initio_ctxSetServo (track->ctx, core->params.bearingServo, initio_TrackAim (core)) ;
+    return TRUE ;
+}
+
+initio_track *initio_TrackStart (initio_ctx *ctx, const initio_trackParams *params, double bearing)
+{
+    initio_track *track = calloc (1, sizeof(initio_track)) ;
+    initio_trackParams defaults ;
+    const initio_trackParams *p ;
+
+    if (track == NULL)
+        return NULL ;
+    if (params == NULL)
+    {
+        initio_TrackDefaultParams (&defaults) ;
+        params = &defaults ;
+    }
+    if (params->hz <= 0)
+    {
+        free (track) ;
+        return NULL ;
+    }
+    track->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    initio_TrackInit (&track->core, params, bearing) ;
+    p = &track->core.params ;
+
+    initio_ctxSetServo (track->ctx, p->elevationServo, clampInt (p->elevation, p->minElevation, p->maxElevation)) ;
+    initio_ctxSetServo (track->ctx, p->bearingServo, initio_TrackAim (&track->core)) ;
+    track->prevMaxCm = initio_ctxUsGetMaxRange (track->ctx) ;
+    initio_ctxUsSetMaxRange (track->ctx, p->maxCm) ;
+    track->rate = initio_RateStart (p->hz, trackCycle, track) ;
+    if (track->rate == NULL)
+    {
+        initio_ctxUsSetMaxRange (track->ctx, track->prevMaxCm) ;
+        free (track) ;
+        return NULL ;
+    }
+    return track ;
+}
+
+void initio_TrackStop (initio_track *track, initio_trackStats *stats)
+{
+    initio_rateStats rs ;
+
+    initio_RateStop (track->rate, &rs) ;
+    initio_ctxUsSetMaxRange (track->ctx, track->prevMaxCm) ;
+    if (stats != NULL)
+    {
+        *stats = track->stats ;
+        stats->rate = rs ;
+    }
+    free (track) ;
+}
+
+unsigned long initio_TrackGet (initio_track *track, initio_trackReading *reading)
+{
+    initio_SeqRead (&track->lock, reading, &track->reading, sizeof(*reading)) ;
+    return reading->cycles ;
+}
+
+void initio_TrackGetStats (initio_track *track, initio_trackStats *stats)
+{
+    stats->pings = __atomic_load_n (&track->stats.pings, __ATOMIC_RELAXED) ;
+    stats->cycles = __atomic_load_n (&track->stats.cycles, __ATOMIC_RELAXED) ;
+    stats->lockedCycles = __atomic_load_n (&track->stats.lockedCycles, __ATOMIC_RELAXED) ;
+    stats->steps = __atomic_load_n (&track->stats.steps, __ATOMIC_RELAXED) ;
+    stats->losses = __atomic_load_n (&track->stats.losses, __ATOMIC_RELAXED) ;
+    initio_RateGetStats (track->rate, &stats->rate) ;
+}
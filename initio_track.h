@@ -0,0 +1,126 @@
+#ifndef _4TRONIX_INITIO_TRACK_H_
+#define _4TRONIX_INITIO_TRACK_H_
+//======================================================================
+//
+// Sonar head target tracking of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Keeps the sonar head on the nearest object: the head is dithered by
+// +-dither degrees around the estimated bearing of the target, one ping
+// on each side. If the two ranges differ by more than deadbandCm, or
+// only one side sees an object, the bearing moves towards the nearer side
+// at the fixed steering rate; otherwise it holds. Without an echo on
+// either side the head sweeps between the limits until it finds an
+// object again. The other servo holds the head at a fixed elevation.
+//
+// The limits default to those of remoteControl2.c. There the servo
+// servoTilt turns the head horizontally (-80..80) and servoPan vertically
+// (-40..80), so the bearing is driven by servoTilt; both can be swapped
+// in the parameters.
+//
+// initio_TrackStep is the controller alone, for simulations or any ping
+// loop; initio_TrackStart runs it on a context in a fixed-rate thread
+// (initio_rate.h) and publishes bearing and range lock-free.
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    double hz ;                 // pings per s; a dither cycle takes two
+    int bearingServo ;          // servo turning the head horizontally
+    int elevationServo ;        // servo turning it vertically
+    int minBearing, maxBearing ;       // limits of the bearing servo in degrees
+    int minElevation, maxElevation ;   // ... and of the elevation servo
+    int elevation ;             // elevation held while tracking
+    int dither ;                // half width of the dither in degrees
+    double rate ;               // steering rate in degrees/s
+    double searchRate ;         // sweep rate without a target in degrees/s
+    unsigned int deadbandCm ;   // range difference taken as equal
+    unsigned int maxCm ;        // range limit (initio_ctxUsSetMaxRange), 0: none
+} initio_trackParams ;
+
+// State of the controller (initio_TrackInit/initio_TrackStep)
+typedef struct {
+    initio_trackParams params ;
+    double bearing ;            // estimated bearing of the target in degrees
+    int side ;                  // -1/+1: side of the next ping
+    unsigned int cm[2] ;        // last ranges of the sides -1 and +1, 0 == no object
+    unsigned int range ;        // nearer range of the last dither cycle, 0 == none
+    int sweep ;                 // direction of the search sweep
+    BOOL locked ;               // the last dither cycle saw an object
+} initio_trackCore ;
+
+typedef struct {
+    double bearing ;            // bearing of the target in degrees
+    unsigned int cm ;           // its range, 0 == no target
+    BOOL locked ;               // FALSE while searching
+    double time ;               // CLOCK_MONOTONIC time of the estimate in s
+    unsigned long cycles ;      // dither cycles so far
+} initio_trackReading ;
+
+typedef struct {
+    unsigned long pings ;
+    unsigned long cycles ;      // dither cycles (two pings)
+    unsigned long lockedCycles ; // ... with an object seen
+    unsigned long steps ;       // cycles that moved the bearing towards the target
+    unsigned long losses ;      // changes from locked to searching
+    initio_rateStats rate ;     // timing of the tracking thread
+} initio_trackStats ;
+
+typedef struct initio_track initio_track ;
+
+// initio_TrackDefaultParams (params):
+// Fills params with 20 pings/s, the servos and limits of remoteControl2.c,
+// elevation 0, dither 6 degrees, steering at 40 and sweeping at 60
+// degrees/s, 2 cm deadband and a range limit of 150 cm.
+void initio_TrackDefaultParams (initio_trackParams *params) ;
+
+// initio_TrackInit (core, params, bearing):
+// Sets up core for params with the target assumed at bearing.
+void initio_TrackInit (initio_trackCore *core, const initio_trackParams *params, double bearing) ;
+
+// initio_TrackAim (core):
+// Returns the bearing servo position for the next ping, in degrees.
+int initio_TrackAim (const initio_trackCore *core) ;
+
+// initio_TrackStep (core, cm):
+// Feeds the range cm (0 == no object) pinged at initio_TrackAim(core) and
+// advances the dither; after the second side the bearing is updated.
+// Returns TRUE when a dither cycle is complete.
+BOOL initio_TrackStep (initio_trackCore *core, unsigned int cm) ;
+
+// initio_TrackStart (ctx, params, bearing):
+// Tracks with the sonar and servos of ctx (NULL: default context),
+// starting at bearing; params == NULL selects the defaults. Returns NULL
+// on error.
+initio_track *initio_TrackStart (initio_ctx *ctx, const initio_trackParams *params, double bearing) ;
+
+// initio_TrackStop (track, stats):
+// Stops tracking, restores the range limit and frees track; the head
+// stays where it is. If stats != NULL the final statistics are copied
+// to it.
+void initio_TrackStop (initio_track *track, initio_trackStats *stats) ;
+
+// initio_TrackGet (track, reading):
+// Copies the latest estimate; lock-free, callable from any thread.
+// Returns the number of dither cycles so far (0: no estimate yet).
+unsigned long initio_TrackGet (initio_track *track, initio_trackReading *reading) ;
+
+// initio_TrackGetStats (track, stats):
+// Copies the counters and the timing of the tracking thread.
+void initio_TrackGetStats (initio_track *track, initio_trackStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_TRACK_H_ */
@@ -0,0 +1,311 @@
+//======================================================================
+//
+// Time-to-collision speed governor of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "initio_ttc.h"
+#include "initio_seqlock.h"
+#include "initio_time.h"
+
+struct initio_ttc {
+    initio_ctx *ctx ;
+    initio_ttcCore core ;        // governor thread only
+    initio_sonar *sonar ;
+    initio_rate *rate ;
+    unsigned long pings ;        // pings fed so far
+    double scale ;               // forward scale last set
+
+    // latest estimate, published by the governor thread
+    initio_seqlock lock ;
+    initio_ttcState state ;
+
+    pthread_mutex_t mutex ;      // protects the events and stats.minTtc
+    initio_ttcEvent events[INITIO_TTC_EVENTS] ;
+    int head, count ;            // oldest event, number queued
+    initio_ttcStats stats ;      // counters atomic
+} ;
+
+void initio_TtcDefaultParams (initio_ttcParams *params)
+{
+    params->hz = 200 ;
+    params->horizon = 1.5 ;
+    params->stopTtc = 0.3 ;
+    params->maxSpeed = 60 ;
+    params->stallDuty = 15 ;
+    params->alpha = 0.5 ;
+    params->beta = 0.1 ;
+    initio_SonarDefaultParams (&params->sonar) ;
+    params->sonar.maxCm = 200 ;
+}
+
+// wheelSpeed(): steady-state speed of a wheel at a signed duty in cm/s
+static double wheelSpeed (const initio_ttcParams *p, int duty)
+{
+    int mag = abs (duty) ;
+
+    if (mag <= p->stallDuty)
+        return 0 ;
+    return ((duty < 0) ? -1 : 1) * p->maxSpeed * (mag - p->stallDuty) / (100.0 - p->stallDuty) ;
+}
+
+// robotSpeed(): forward speed of the robot at the duties in cm/s
+static double robotSpeed (const initio_ttcParams *p, int left, int right)
+{
+    return (wheelSpeed (p, left) + wheelSpeed (p, right)) / 2 ;
+}
+
+void initio_TtcInit (initio_ttcCore *core, const initio_ttcParams *params)
+{
+    core->params = *params ;
+    core->cm = 0 ;
+    core->vObject = 0 ;
+    core->closing = 0 ;
+    core->ttc = INFINITY ;
+    core->scale = 1 ;
+    core->time = 0 ;
+    core->pingTime = 0 ;
+}
+
+void initio_TtcPing (initio_ttcCore *core, unsigned int cm, double time)
+{
+    const initio_ttcParams *p = &core->params ;
+    double predicted, residual ;
+
+    if (cm == 0)
+    {
+        core->cm = 0 ;  // nothing in range
+        core->vObject = 0 ;
+    }
+    else if (core->cm == 0 || core->pingTime == 0)
+    {
+        core->cm = cm ;  // new object
+        core->vObject = 0 ;
+    }
+    else
+    {
+        // the estimate may be newer than the ping: predict either way
+        predicted = core->cm - core->closing * (time - core->time) ;
+        residual = cm - predicted ;
+        core->cm = fmax (predicted + p->alpha * residual, 1) ;
+        if (time > core->pingTime)
+            core->vObject -= p->beta * residual / (time - core->pingTime) ;  // nearer than predicted: approaching
+    }
+    core->time = time ;
+    core->pingTime = time ;
+}
+
+double initio_TtcUpdate (initio_ttcCore *core, double time, int left, int right, int reqLeft, int reqRight)
+{
+    const initio_ttcParams *p = &core->params ;
+    double closing ;
+
+    if (time > core->time)
+    {
+        if (core->cm > 0)
+            core->cm = fmax (core->cm - core->closing * (time - core->time), 1) ;
+        core->time = time ;
+    }
+    core->closing = robotSpeed (p, left, right) + core->vObject ;
+    core->ttc = (core->cm > 0 && core->closing > 0) ? core->cm / core->closing : INFINITY ;
+
+    // governor: TTC at the requested duties, so that scaling does not feed back
+    core->scale = 1 ;
+    closing = robotSpeed (p, reqLeft, reqRight) + core->vObject ;
+    if (core->cm > 0 && closing > 0 && reqLeft >= 0 && reqRight >= 0)
+    {
+        core->scale = (core->cm / closing - p->stopTtc) / (p->horizon - p->stopTtc) ;
+        core->scale = fmin (fmax (core->scale, 0), 1) ;
+    }
+    return core->scale ;
+}
+
+// queue(): adds an event, dropping the oldest on a full queue
+static void queue (initio_ttc *ttc, int type, double t)
+{
+    const initio_ttcCore *core = &ttc->core ;
+    initio_ttcEvent *e ;
+
+    pthread_mutex_lock (&ttc->mutex) ;
+    if (ttc->count == INITIO_TTC_EVENTS)
+    {
+        ttc->head = (ttc->head + 1) % INITIO_TTC_EVENTS ;
+        ttc->count-- ;
+        __atomic_add_fetch (&ttc->stats.dropped, 1, __ATOMIC_RELAXED) ;
+    }
+    e = &ttc->events[(ttc->head + ttc->count) % INITIO_TTC_EVENTS] ;
+    e->type = type ;
+    e->time = t ;
+    e->cm = core->cm ;
+    e->closing = core->closing ;
+    e->ttc = core->ttc ;
+    e->scale = ttc->scale ;
+    ttc->count++ ;
+    pthread_mutex_unlock (&ttc->mutex) ;
+}
+
+// governorCycle(): feeds a new ping, updates the estimate and sets the scale
+static BOOL governorCycle (void *arg)
+{
+    initio_ttc *ttc = arg ;
+    initio_ttcCore *core = &ttc->core ;
+    initio_sonarReading r ;
+    initio_ttcState s ;
+    double t = initio_Now (), scale, last = ttc->scale ;
+    int left, right, reqLeft, reqRight ;
+
+    if (initio_SonarGet (ttc->sonar, &r) != ttc->pings)
+    {
+        ttc->pings = r.pings ;
+        initio_TtcPing (core, r.cm, r.time) ;
+        __atomic_add_fetch (&ttc->stats.pings, 1, __ATOMIC_RELAXED) ;
+    }
+    initio_ctxGetMotors (ttc->ctx, &left, &right) ;
+    initio_ctxGetMotorRequest (ttc->ctx, &reqLeft, &reqRight) ;
+    scale = initio_TtcUpdate (core, t, left, right, reqLeft, reqRight) ;
+
+    // set in steps of 1%, and always when reaching 0 or 1
+    if (fabs (scale - last) >= 0.01 || (scale != last && (scale == 0 || scale == 1)))
+    {
+        initio_ctxSetForwardScale (ttc->ctx, scale) ;
+        ttc->scale = scale ;
+        if (last == 1)
+        {
+            __atomic_add_fetch (&ttc->stats.limits, 1, __ATOMIC_RELAXED) ;
+            queue (ttc, INITIO_TTC_LIMIT, t) ;
+        }
+        if (scale == 0)
+        {
+            __atomic_add_fetch (&ttc->stats.stops, 1, __ATOMIC_RELAXED) ;
+            queue (ttc, INITIO_TTC_STOP, t) ;
+        }
+        else if (scale == 1)
+        {
+            __atomic_add_fetch (&ttc->stats.releases, 1, __ATOMIC_RELAXED) ;
+            queue (ttc, INITIO_TTC_RELEASE, t) ;
+        }
+    }
+
+    s.cm = core->cm ;
+    s.closing = core->closing ;
+    s.ttc = core->ttc ;
+    s.scale = ttc->scale ;
+    s.time = t ;
+    initio_SeqWrite (&ttc->lock, &ttc->state, &s, sizeof(s)) ;
+
+    __atomic_add_fetch (&ttc->stats.cycles, 1, __ATOMIC_RELAXED) ;
+    if (ttc->scale < 1)
+        __atomic_add_fetch (&ttc->stats.limitedCycles, 1, __ATOMIC_RELAXED) ;
+    if (core->ttc < ttc->stats.minTtc)  // only this thread writes minTtc
+    {
+        pthread_mutex_lock (&ttc->mutex) ;
+        ttc->stats.minTtc = core->ttc ;
+        pthread_mutex_unlock (&ttc->mutex) ;
+    }
+    return TRUE ;
+}
+
+initio_ttc *initio_TtcStart (initio_ctx *ctx, const initio_ttcParams *params)
+{
+    initio_ttc *ttc = calloc (1, sizeof(initio_ttc)) ;
+    initio_ttcParams defaults ;
+
+    if (ttc == NULL)
+        return NULL ;
+    if (params == NULL)
+    {
+        initio_TtcDefaultParams (&defaults) ;
+        params = &defaults ;
+    }
+    if (params->hz <= 0 || params->horizon <= params->stopTtc)
+    {
+        free (ttc) ;
+        return NULL ;
+    }
+    ttc->ctx = (ctx != NULL) ? ctx : initio_DefaultCtx () ;
+    initio_TtcInit (&ttc->core, params) ;
+    ttc->scale = 1 ;
+    ttc->state.ttc = INFINITY ;
+    ttc->state.scale = 1 ;
+    ttc->stats.minTtc = INFINITY ;
+    pthread_mutex_init (&ttc->mutex, NULL) ;
+    initio_ctxSetForwardScale (ttc->ctx, 1) ;
+
+    ttc->sonar = initio_SonarStart (ttc->ctx, &params->sonar) ;
+    if (ttc->sonar == NULL)
+    {
+        pthread_mutex_destroy (&ttc->mutex) ;
+        free (ttc) ;
+        return NULL ;
+    }
+    ttc->rate = initio_RateStart (params->hz, governorCycle, ttc) ;
+    if (ttc->rate == NULL)
+    {
+        initio_SonarStop (ttc->sonar, NULL) ;
+        pthread_mutex_destroy (&ttc->mutex) ;
+        free (ttc) ;
+        return NULL ;
+    }
+    return ttc ;
+}
+
+void initio_TtcStop (initio_ttc *ttc, initio_ttcStats *stats)
+{
+    initio_rateStats rs ;
+
+    initio_RateStop (ttc->rate, &rs) ;
+    initio_SonarStop (ttc->sonar, NULL) ;
+    initio_ctxSetForwardScale (ttc->ctx, 1) ;
+    if (stats != NULL)
+    {
+        *stats = ttc->stats ;
+        stats->rate = rs ;
+    }
+    pthread_mutex_destroy (&ttc->mutex) ;
+    free (ttc) ;
+}
+
+void initio_TtcGet (initio_ttc *ttc, initio_ttcState *state)
+{
+    initio_SeqRead (&ttc->lock, state, &ttc->state, sizeof(*state)) ;
+}
+
+BOOL initio_TtcNextEvent (initio_ttc *ttc, initio_ttcEvent *event)
+{
+    BOOL got = FALSE ;
+
+    pthread_mutex_lock (&ttc->mutex) ;
+    if (ttc->count > 0)
+    {
+        *event = ttc->events[ttc->head] ;
+        ttc->head = (ttc->head + 1) % INITIO_TTC_EVENTS ;
+        ttc->count-- ;
+        got = TRUE ;
+    }
+    pthread_mutex_unlock (&ttc->mutex) ;
+    return got ;
+}
+
+void initio_TtcGetStats (initio_ttc *ttc, initio_ttcStats *stats)
+{
+    stats->cycles = __atomic_load_n (&ttc->stats.cycles, __ATOMIC_RELAXED) ;
+    stats->pings = __atomic_load_n (&ttc->stats.pings, __ATOMIC_RELAXED) ;
+    stats->limits = __atomic_load_n (&ttc->stats.limits, __ATOMIC_RELAXED) ;
+    stats->stops = __atomic_load_n (&ttc->stats.stops, __ATOMIC_RELAXED) ;
+    stats->releases = __atomic_load_n (&ttc->stats.releases, __ATOMIC_RELAXED) ;
+    stats->limitedCycles = __atomic_load_n (&ttc->stats.limitedCycles, __ATOMIC_RELAXED) ;
+    stats->dropped = __atomic_load_n (&ttc->stats.dropped, __ATOMIC_RELAXED) ;
+    pthread_mutex_lock (&ttc->mutex) ;
+    stats->minTtc = ttc->stats.minTtc ;
+    pthread_mutex_unlock (&ttc->mutex) ;
+    initio_RateGetStats (ttc->rate, &stats->rate) ;
+}
@@ -0,0 +1,145 @@
+#ifndef _4TRONIX_INITIO_TTC_H_
+#define _4TRONIX_INITIO_TTC_H_
+//======================================================================
+//
+// Time-to-collision speed governor of the initio library.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Estimates the closing speed to the object in front of the sonar and the
+// time to collision (TTC), and slows the robot down before it gets close:
+//   o the closing speed is the speed of the robot at the commanded duties
+//     (linear above the stall duty, as initio_sim) plus the speed of the
+//     object itself, which an alpha-beta filter estimates from the
+//     differences between the time-stamped sonar ranges and the ranges
+//     predicted from the robot speed,
+//   o between pings the range is predicted at the loop rate, so the TTC
+//     follows a change of the duties at once,
+//   o the governor computes the TTC at the requested (unscaled) duties and
+//     scales forward duties (initio_ctxSetForwardScale) linearly from 1 at
+//     the horizon down to 0 at stopTtc. Reverse and spins are not scaled.
+// The sonar is assumed to look ahead. Pings come from a ping scheduler
+// (initio_sonar.h), the governor runs in a fixed-rate thread of its own
+// (initio_rate.h). Each start and end of an intervention is queued as an
+// event and counted.
+//
+// initio_TtcPing/initio_TtcUpdate are the estimator and governor alone,
+// for simulations or any other loop.
+//
+//======================================================================
+
+#include "initio.h"
+#include "initio_rate.h"
+#include "initio_sonar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INITIO_TTC_EVENTS 64     // events queued until initio_TtcNextEvent
+
+// Event types
+#define INITIO_TTC_LIMIT    1    // forward duties scaled down (scale < 1)
+#define INITIO_TTC_STOP     2    // ... down to 0
+#define INITIO_TTC_RELEASE  3    // back to full forward duties
+
+typedef struct {
+    double hz ;                  // governor loop rate
+    double horizon ;             // TTC in s below which forward duties are scaled down
+    double stopTtc ;             // TTC in s at which they are scaled to 0
+    double maxSpeed ;            // speed of the robot at duty 100 in cm/s
+    int stallDuty ;              // largest duty that does not move the robot
+    double alpha, beta ;         // gains of the range and object speed filter
+    initio_sonarParams sonar ;   // ping scheduler
+} initio_ttcParams ;
+
+// State of the estimator (initio_TtcPing/initio_TtcUpdate)
+typedef struct {
+    initio_ttcParams params ;
+    double cm ;                  // estimated range, 0: no object
+    double vObject ;             // speed of the object towards the robot in cm/s
+    double closing ;             // closing speed at the applied duties in cm/s
+    double ttc ;                 // time to collision in s, INFINITY: none
+    double scale ;               // forward scale for the requested duties
+    double time ;                // time of the estimate in s
+    double pingTime ;            // time of the last ping in s
+} initio_ttcCore ;
+
+typedef struct {
+    double cm ;                  // estimated range, 0: no object
+    double closing ;             // closing speed in cm/s
+    double ttc ;                 // time to collision in s, INFINITY: none
+    double scale ;               // forward scale set
+    double time ;                // CLOCK_MONOTONIC time of the estimate in s
+} initio_ttcState ;
+
+typedef struct {
+    int type ;                   // INITIO_TTC_*
+    double time ;                // CLOCK_MONOTONIC time in s
+    double cm, closing, ttc ;    // estimate at the event
+    double scale ;               // forward scale set
+} initio_ttcEvent ;
+
+typedef struct {
+    unsigned long cycles ;       // governor cycles
+    unsigned long pings ;        // sonar ranges fed to the estimator
+    unsigned long limits ;       // interventions (INITIO_TTC_LIMIT events)
+    unsigned long stops ;        // INITIO_TTC_STOP events
+    unsigned long releases ;     // INITIO_TTC_RELEASE events
+    unsigned long limitedCycles ; // cycles with scale < 1
+    unsigned long dropped ;      // events dropped on a full queue
+    double minTtc ;              // smallest TTC seen in s
+    initio_rateStats rate ;      // timing of the governor thread
+} initio_ttcStats ;
+
+typedef struct initio_ttc initio_ttc ;
+
+// initio_TtcDefaultParams (params):
+// Fills params with a 200 Hz loop, 1.5 s horizon, 0.3 s stopTtc, the
+// chassis of initio_sim (60 cm/s, stall duty 15), alpha 0.5, beta 0.1
+// and the ping scheduler defaults with a range limit of 200 cm.
+void initio_TtcDefaultParams (initio_ttcParams *params) ;
+
+// initio_TtcInit (core, params):
+// Sets up core for params without an object.
+void initio_TtcInit (initio_ttcCore *core, const initio_ttcParams *params) ;
+
+// initio_TtcPing (core, cm, time):
+// Feeds a sonar range cm (0 == no object) pinged at time (s).
+void initio_TtcPing (initio_ttcCore *core, unsigned int cm, double time) ;
+
+// initio_TtcUpdate (core, time, left, right, reqLeft, reqRight):
+// Predicts the range to time (s) at the applied duties left/right and
+// updates closing speed and TTC; returns the forward scale for the
+// requested duties reqLeft/reqRight.
+double initio_TtcUpdate (initio_ttcCore *core, double time, int left, int right, int reqLeft, int reqRight) ;
+
+// initio_TtcStart (ctx, params):
+// Starts pinging and governing the motors of ctx (NULL: default context);
+// params == NULL selects the defaults. Returns NULL on error.
+initio_ttc *initio_TtcStart (initio_ctx *ctx, const initio_ttcParams *params) ;
+
+// initio_TtcStop (ttc, stats):
+// Stops governing, sets the forward scale back to 1 and frees ttc. If
+// stats != NULL the final statistics are copied to it.
+void initio_TtcStop (initio_ttc *ttc, initio_ttcStats *stats) ;
+
+// initio_TtcGet (ttc, state):
+// Copies the latest estimate; lock-free, callable from any thread.
+void initio_TtcGet (initio_ttc *ttc, initio_ttcState *state) ;
+
+// initio_TtcNextEvent (ttc, event):
+// Takes the oldest queued event; returns FALSE if there is none.
+BOOL initio_TtcNextEvent (initio_ttc *ttc, initio_ttcEvent *event) ;
+
+// initio_TtcGetStats (ttc, stats):
+// Copies the counters and the timing of the governor thread.
+void initio_TtcGetStats (initio_ttc *ttc, initio_ttcStats *stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _4TRONIX_INITIO_TTC_H_ */
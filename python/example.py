@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+#======================================================================
+#
+# Example of the Python binding: drives forward, logging the sensors
+# at 100 Hz (sonar every 5th sample), and evaluates the log with NumPy.
+#
+# license: GNU LESSER GENERAL PUBLIC LICENSE
+#          Version 2.1, February 1999
+#          (for details see LICENSE file)
+#
+# Usage: python3 example.py
+#
+#======================================================================
+
+import time
+import initio
+
+initio.Init(initio.MOTORS | initio.SENSORS | initio.SONAR)
+initio.UsSetMaxRange(200)
+initio.WheelCountStart()
+
+log = initio.SensorLog(1000, sonarEvery=5)
+log.start(100)
+initio.DriveForward(60)
+time.sleep(1)
+initio.Stop()
+log.stop()
+print('distance %d cm, stats %s' % (initio.UsGetDistance(), log.stats()))
+
+try:
+    import numpy as np
+    a = np.asarray(log)  # no copy, one structured record per sample
+    pinged = a[a['sonar'] >= 0]
+    print('%d samples over %.2f s, %d pings, duties %s' %
+          (len(a), a['time'][-1] - a['time'][0], len(pinged), np.unique(a['left'])))
+except ImportError:
+    m = memoryview(log)
+    print('%d samples of %d bytes (format %s)' % (len(m), m.itemsize, m.format))
+
+initio.Cleanup()
@@ -0,0 +1,609 @@
+//======================================================================
+//
+// Python binding of the initio library (module 'initio').
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Exposes the functions of initio.h with their C names, without the
+// initio_ prefix (initio.Init(), initio.DriveForward(50), initio.IrLeft(),
+// initio.UsGetDistance(), ...), and a sensor log type: initio.SensorLog
+// samples all sensors and the motor duties in a background thread into
+// a preallocated array of records, which supports the buffer protocol:
+// numpy.asarray(log) views the samples without copying, with the fields
+// time, sense, sonar, pulsesLeft, pulsesRight, left and right.
+//
+// The GIL is released while a call may block: ultrasonic pings, motor
+// and servo commands (which wait for other threads of the library), and
+// bring-up and clean-up.
+//
+// Build: see setup.py (make python in the top directory).
+//
+//======================================================================
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "initio.h"
+#include "initio_rate.h"
+
+// Calls a void function of the library without the GIL
+#define NOGIL(call) do { Py_BEGIN_ALLOW_THREADS call ; Py_END_ALLOW_THREADS } while (0)
+
+
+//======================================================================
+// Module Functions
+
+static PyObject *pyInit (PyObject *self, PyObject *args)
+{
+    int subsystems = INITIO_ALL ;
+
+    if (!PyArg_ParseTuple (args, "|i", &subsystems))
+        return NULL ;
+    NOGIL (initio_InitEx (subsystems)) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pyCleanup (PyObject *self, PyObject *args)
+{
+    NOGIL (initio_Cleanup ()) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pyVersion (PyObject *self, PyObject *args)
+{
+    return PyFloat_FromDouble (initio_Version ()) ;
+}
+
+static PyObject *pyIdentifyControlBoard (PyObject *self, PyObject *args)
+{
+    return PyLong_FromLong (initio_identifyControlBoard ()) ;
+}
+
+// speed(): parses a speed 0..100 of the classic motor functions
+static int speed (PyObject *arg, int8_t *s)
+{
+    long v = PyLong_AsLong (arg) ;
+
+    if (v == -1 && PyErr_Occurred ())
+        return 0 ;
+    if (v < 0 || v > 100)
+    {
+        PyErr_SetString (PyExc_ValueError, "speed must be within 0..100") ;
+        return 0 ;
+    }
+    *s = (int8_t)v ;
+    return 1 ;
+}
+
+static PyObject *pyStop (PyObject *self, PyObject *args)
+{
+    NOGIL (initio_Stop ()) ;
+    Py_RETURN_NONE ;
+}
+
+#define MOTOR1(name)                                            \
+static PyObject *py##name (PyObject *self, PyObject *args)      \
+{                                                               \
+    int8_t s ;                                                  \
+                                                                \
+    if (!PyArg_ParseTuple (args, "O&", speed, &s))              \
+        return NULL ;                                           \
+    NOGIL (initio_##name (s)) ;                                 \
+    Py_RETURN_NONE ;                                            \
+}
+
+#define MOTOR2(name)                                            \
+static PyObject *py##name (PyObject *self, PyObject *args)      \
+{                                                               \
+    int8_t l, r ;                                               \
+                                                                \
+    if (!PyArg_ParseTuple (args, "O&O&", speed, &l, speed, &r)) \
+        return NULL ;                                           \
+    NOGIL (initio_##name (l, r)) ;                              \
+    Py_RETURN_NONE ;                                            \
+}
+
+MOTOR1(DriveForward)
+MOTOR1(DriveReverse)
+MOTOR1(SpinLeft)
+MOTOR1(SpinRight)
+MOTOR2(TurnForward)
+MOTOR2(TurnReverse)
+MOTOR1(Brake)
+
+static PyObject *pySetBrakeHold (PyObject *self, PyObject *args)
+{
+    unsigned int ms ;
+
+    if (!PyArg_ParseTuple (args, "I", &ms))
+        return NULL ;
+    initio_SetBrakeHold (ms) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pySetForwardScale (PyObject *self, PyObject *args)
+{
+    double scale ;
+
+    if (!PyArg_ParseTuple (args, "d", &scale))
+        return NULL ;
+    NOGIL (initio_SetForwardScale (scale)) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pySetMotors (PyObject *self, PyObject *args)
+{
+    int left, right ;
+
+    if (!PyArg_ParseTuple (args, "ii", &left, &right))
+        return NULL ;
+    NOGIL (initio_SetMotors (left, right)) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pyGetMotors (PyObject *self, PyObject *args)
+{
+    int left, right ;
+
+    initio_GetMotors (&left, &right) ;
+    return Py_BuildValue ("(ii)", left, right) ;
+}
+
+static PyObject *pyGetMotorStats (PyObject *self, PyObject *args)
+{
+    initio_motorStats s ;
+
+    initio_GetMotorStats (&s) ;
+    return Py_BuildValue ("{s:k,s:k,s:k,s:d,s:d}", "calls", s.calls, "writes", s.writes,
+                          "skipped", s.skipped, "latencyAvgNs", s.latencyAvgNs, "latencyMaxNs", s.latencyMaxNs) ;
+}
+
+static PyObject *pyResetMotorStats (PyObject *self, PyObject *args)
+{
+    initio_ResetMotorStats () ;
+    Py_RETURN_NONE ;
+}
+
+// Lock-free sensor reads keep the GIL
+#define SENSOR(name)                                            \
+static PyObject *py##name (PyObject *self, PyObject *args)      \
+{                                                               \
+    return PyBool_FromLong (initio_##name ()) ;                 \
+}
+
+SENSOR(wheelSensorLeft)
+SENSOR(wheelSensorRight)
+SENSOR(IrLeft)
+SENSOR(IrRight)
+SENSOR(IrAll)
+SENSOR(IrLineLeft)
+SENSOR(IrLineRight)
+
+static PyObject *pyWheelCountStart (PyObject *self, PyObject *args)
+{
+    NOGIL (initio_WheelCountStart ()) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pyWheelCountLeft (PyObject *self, PyObject *args)
+{
+    return PyLong_FromUnsignedLong (initio_WheelCountLeft ()) ;
+}
+
+static PyObject *pyWheelCountRight (PyObject *self, PyObject *args)
+{
+    return PyLong_FromUnsignedLong (initio_WheelCountRight ()) ;
+}
+
+static PyObject *pyUsGetDistance (PyObject *self, PyObject *args)
+{
+    unsigned int cm ;
+
+    Py_BEGIN_ALLOW_THREADS
+    cm = initio_UsGetDistance () ;
+    Py_END_ALLOW_THREADS
+    return PyLong_FromUnsignedLong (cm) ;
+}
+
+static PyObject *pyUsSetMaxRange (PyObject *self, PyObject *args)
+{
+    unsigned int cm ;
+
+    if (!PyArg_ParseTuple (args, "I", &cm))
+        return NULL ;
+    initio_UsSetMaxRange (cm) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pyUsGetMaxRange (PyObject *self, PyObject *args)
+{
+    return PyLong_FromUnsignedLong (initio_UsGetMaxRange ()) ;
+}
+
+static PyObject *pyStartServos (PyObject *self, PyObject *args)
+{
+    NOGIL (initio_StartServos ()) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pyStopServos (PyObject *self, PyObject *args)
+{
+    NOGIL (initio_StopServos ()) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *pySetServo (PyObject *self, PyObject *args)
+{
+    int servo, degrees ;
+
+    if (!PyArg_ParseTuple (args, "ii", &servo, &degrees))
+        return NULL ;
+    if (degrees < -90 || degrees > 90)
+    {
+        PyErr_SetString (PyExc_ValueError, "degrees must be within -90..90") ;
+        return NULL ;
+    }
+    NOGIL (initio_SetServo ((int8_t)servo, (int8_t)degrees)) ;
+    Py_RETURN_NONE ;
+}
+
+// End of Module Functions
+//======================================================================
+
+
+
+//======================================================================
+// Sensor Log
+
+typedef struct {
+    double time ;                     // s since the start of the log
+    uint32_t sense ;                  // INITIO_SENSE_* bits
+    int32_t sonar ;                   // cm, 0 == no object, -1 == not pinged
+    uint32_t pulsesLeft, pulsesRight ;  // wheel pulses since initio_WheelCountStart
+    int32_t left, right ;             // signed motor duties
+} logRecord ;
+
+// PEP 3118 format of logRecord, with field names for NumPy
+static char logFormat[] = "T{d:time:I:sense:i:sonar:I:pulsesLeft:I:pulsesRight:i:left:i:right:}" ;
+
+typedef struct {
+    PyObject_HEAD
+    logRecord *records ;
+    Py_ssize_t capacity ;
+    Py_ssize_t count ;        // records complete, published by the sampler
+    unsigned long dropped ;   // samples lost on a full log
+    int sonarEvery ;          // ping every n-th sample, 0: never
+    unsigned long samples ;
+    initio_rate *rate ;
+    initio_rateStats last ;   // of the last sampling run
+    struct timespec start ;
+    Py_ssize_t exports ;      // buffers exported
+} SensorLog ;
+
+static BOOL sample (void *arg)
+{
+    SensorLog *log = arg ;
+    Py_ssize_t n = log->count ;  // only the sampler advances count
+    struct timespec ts ;
+    logRecord *r ;
+    int left, right ;
+
+    if (n >= log->capacity)
+    {
+        __atomic_add_fetch (&log->dropped, 1, __ATOMIC_RELAXED) ;
+        return TRUE ;
+    }
+    r = &log->records[n] ;
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    r->time = (ts.tv_sec - log->start.tv_sec) + (ts.tv_nsec - log->start.tv_nsec) * 1e-9 ;
+    r->sense = (initio_IrLeft () ? INITIO_SENSE_IRLEFT : 0)
+             | (initio_IrRight () ? INITIO_SENSE_IRRIGHT : 0)
+             | (initio_IrLineLeft () ? INITIO_SENSE_LINELEFT : 0)
+             | (initio_IrLineRight () ? INITIO_SENSE_LINERIGHT : 0)
+             | (initio_wheelSensorLeft () ? INITIO_SENSE_WHEELLEFT : 0)
+             | (initio_wheelSensorRight () ? INITIO_SENSE_WHEELRIGHT : 0) ;
+    r->sonar = (log->sonarEvery > 0 && log->samples % log->sonarEvery == 0) ? (int32_t)initio_UsGetDistance () : -1 ;
+    r->pulsesLeft = initio_WheelCountLeft () ;
+    r->pulsesRight = initio_WheelCountRight () ;
+    initio_GetMotors (&left, &right) ;
+    r->left = left ;
+    r->right = right ;
+    log->samples++ ;
+    __atomic_store_n (&log->count, n + 1, __ATOMIC_RELEASE) ;
+    return TRUE ;
+}
+
+static int SensorLog_init (SensorLog *log, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = { "capacity", "sonarEvery", NULL } ;
+    Py_ssize_t capacity ;
+    int sonarEvery = 0 ;
+
+    if (!PyArg_ParseTupleAndKeywords (args, kwds, "n|i", kwlist, &capacity, &sonarEvery))
+        return -1 ;
+    if (capacity < 1 || sonarEvery < 0)
+    {
+        PyErr_SetString (PyExc_ValueError, "capacity must be positive, sonarEvery not negative") ;
+        return -1 ;
+    }
+    if (log->records != NULL)
+    {
+        PyErr_SetString (PyExc_RuntimeError, "SensorLog already initialised") ;
+        return -1 ;
+    }
+    log->records = PyMem_RawCalloc (capacity, sizeof(logRecord)) ;
+    if (log->records == NULL)
+    {
+        PyErr_NoMemory () ;
+        return -1 ;
+    }
+    log->capacity = capacity ;
+    log->sonarEvery = sonarEvery ;
+    return 0 ;
+}
+
+static void stopSampling (SensorLog *log)
+{
+    initio_rate *rate = log->rate ;
+
+    if (rate != NULL)
+    {
+        log->rate = NULL ;
+        NOGIL (initio_RateStop (rate, &log->last)) ;
+    }
+}
+
+static void SensorLog_dealloc (SensorLog *log)
+{
+    stopSampling (log) ;
+    PyMem_RawFree (log->records) ;
+    Py_TYPE (log)->tp_free ((PyObject *)log) ;
+}
+
+static PyObject *SensorLog_start (SensorLog *log, PyObject *args)
+{
+    double hz ;
+
+    if (!PyArg_ParseTuple (args, "d", &hz))
+        return NULL ;
+    if (log->records == NULL)
+    {
+        PyErr_SetString (PyExc_RuntimeError, "SensorLog not initialised") ;
+        return NULL ;
+    }
+    if (hz <= 0)
+    {
+        PyErr_SetString (PyExc_ValueError, "hz must be positive") ;
+        return NULL ;
+    }
+    if (log->rate != NULL)
+    {
+        PyErr_SetString (PyExc_RuntimeError, "SensorLog already sampling") ;
+        return NULL ;
+    }
+    if (log->count == 0)
+        clock_gettime (CLOCK_MONOTONIC, &log->start) ;
+    log->rate = initio_RateStart (hz, sample, log) ;
+    if (log->rate == NULL)
+    {
+        // pthread_create reports its error without setting errno
+        PyErr_SetString (PyExc_RuntimeError, "cannot start sampling thread") ;
+        return NULL ;
+    }
+    Py_RETURN_NONE ;
+}
+
+static PyObject *SensorLog_stop (SensorLog *log, PyObject *args)
+{
+    stopSampling (log) ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *SensorLog_clear (SensorLog *log, PyObject *args)
+{
+    if (log->exports > 0)
+    {
+        PyErr_SetString (PyExc_BufferError, "SensorLog has exported buffers") ;
+        return NULL ;
+    }
+    if (log->rate != NULL)
+    {
+        PyErr_SetString (PyExc_RuntimeError, "SensorLog is sampling") ;
+        return NULL ;
+    }
+    log->count = 0 ;
+    log->samples = 0 ;
+    log->dropped = 0 ;
+    Py_RETURN_NONE ;
+}
+
+static PyObject *SensorLog_stats (SensorLog *log, PyObject *args)
+{
+    initio_rateStats s = log->last ;
+
+    if (log->rate != NULL)
+        initio_RateGetStats (log->rate, &s) ;
+    return Py_BuildValue ("{s:n,s:k,s:d,s:k}", "count", __atomic_load_n (&log->count, __ATOMIC_ACQUIRE),
+                          "dropped", __atomic_load_n (&log->dropped, __ATOMIC_RELAXED),
+                          "rateHz", s.rateHz, "overruns", s.overruns) ;
+}
+
+static Py_ssize_t SensorLog_len (SensorLog *log)
+{
+    return __atomic_load_n (&log->count, __ATOMIC_ACQUIRE) ;
+}
+
+// The buffer covers the records complete at the time of the export; the
+// sampler only writes behind them, so views stay valid while it runs.
+// Shape and stride belong to the export (view->internal), as views of
+// different lengths may be alive at once.
+static int SensorLog_getbuffer (SensorLog *log, Py_buffer *view, int flags)
+{
+    Py_ssize_t *dims ;
+
+    if (log->records == NULL)
+    {
+        PyErr_SetString (PyExc_BufferError, "SensorLog not initialised") ;
+        return -1 ;
+    }
+    if (flags & PyBUF_WRITABLE)
+    {
+        PyErr_SetString (PyExc_BufferError, "SensorLog is read-only") ;
+        return -1 ;
+    }
+    dims = PyMem_Malloc (2 * sizeof(Py_ssize_t)) ;
+    if (dims == NULL)
+    {
+        PyErr_NoMemory () ;
+        return -1 ;
+    }
+    dims[0] = SensorLog_len (log) ;
+    dims[1] = sizeof(logRecord) ;
+    view->obj = (PyObject *)log ;
+    Py_INCREF (log) ;
+    view->buf = log->records ;
+    view->len = dims[0] * sizeof(logRecord) ;
+    view->readonly = 1 ;
+    view->itemsize = sizeof(logRecord) ;
+    view->format = (flags & PyBUF_FORMAT) ? logFormat : NULL ;
+    view->ndim = 1 ;
+    view->shape = (flags & PyBUF_ND) ? &dims[0] : NULL ;
+    view->strides = (flags & PyBUF_STRIDES) ? &dims[1] : NULL ;
+    view->suboffsets = NULL ;
+    view->internal = dims ;
+    log->exports++ ;
+    return 0 ;
+}
+
+static void SensorLog_releasebuffer (SensorLog *log, Py_buffer *view)
+{
+    PyMem_Free (view->internal) ;
+    log->exports-- ;
+}
+
+static PyBufferProcs SensorLog_buffer = {
+    .bf_getbuffer = (getbufferproc)SensorLog_getbuffer,
+    .bf_releasebuffer = (releasebufferproc)SensorLog_releasebuffer,
+} ;
+
+static PySequenceMethods SensorLog_sequence = {
+    .sq_length = (lenfunc)SensorLog_len,
+} ;
+
+static PyMethodDef SensorLog_methods[] = {
+    { "start", (PyCFunction)SensorLog_start, METH_VARARGS, "start(hz): samples at hz in a background thread" },
+    { "stop", (PyCFunction)SensorLog_stop, METH_NOARGS, "stop(): stops sampling" },
+    { "clear", (PyCFunction)SensorLog_clear, METH_NOARGS, "clear(): removes all samples" },
+    { "stats", (PyCFunction)SensorLog_stats, METH_NOARGS, "stats(): count, dropped samples and achieved rate" },
+    { NULL }
+} ;
+
+static PyTypeObject SensorLogType = {
+    PyVarObject_HEAD_INIT (NULL, 0)
+    .tp_name = "initio.SensorLog",
+    .tp_doc = "SensorLog(capacity, sonarEvery=0): sensor samples taken in a background thread,\n"
+              "readable through the buffer protocol (e.g. numpy.asarray(log)).",
+    .tp_basicsize = sizeof(SensorLog),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)SensorLog_init,
+    .tp_dealloc = (destructor)SensorLog_dealloc,
+    .tp_methods = SensorLog_methods,
+    .tp_as_buffer = &SensorLog_buffer,
+    .tp_as_sequence = &SensorLog_sequence,
+} ;
+
+// End of Sensor Log
+//======================================================================
+
+
+
+//======================================================================
+// Module
+
+#define FN(name, flags, doc) { #name, py##name, flags, doc }
+
+static PyMethodDef initioMethods[] = {
+    FN(Init, METH_VARARGS, "Init(subsystems=ALL): initialises the robot (initio_InitEx)"),
+    FN(Cleanup, METH_NOARGS, "Cleanup(): motors off, pins to standard values"),
+    FN(Version, METH_NOARGS, "Version(): library version"),
+    FN(IdentifyControlBoard, METH_NOARGS, "IdentifyControlBoard(): PIROCON2 or ROBOHAT"),
+    FN(Stop, METH_NOARGS, "Stop(): stops both motors"),
+    FN(DriveForward, METH_VARARGS, "DriveForward(speed): 0 <= speed <= 100"),
+    FN(DriveReverse, METH_VARARGS, "DriveReverse(speed): 0 <= speed <= 100"),
+    FN(SpinLeft, METH_VARARGS, "SpinLeft(speed): 0 <= speed <= 100"),
+    FN(SpinRight, METH_VARARGS, "SpinRight(speed): 0 <= speed <= 100"),
+    FN(TurnForward, METH_VARARGS, "TurnForward(leftSpeed, rightSpeed)"),
+    FN(TurnReverse, METH_VARARGS, "TurnReverse(leftSpeed, rightSpeed)"),
+    FN(Brake, METH_VARARGS, "Brake(strength): active braking, 0 <= strength <= 100"),
+    FN(SetBrakeHold, METH_VARARGS, "SetBrakeHold(ms): brake time before coasting, 0: until the next command"),
+    FN(SetForwardScale, METH_VARARGS, "SetForwardScale(scale): 0 <= scale <= 1 applied to forward duties"),
+    FN(SetMotors, METH_VARARGS, "SetMotors(left, right): signed duties -100..100"),
+    FN(GetMotors, METH_NOARGS, "GetMotors(): (left, right) signed duties"),
+    FN(GetMotorStats, METH_NOARGS, "GetMotorStats(): dict of motor command statistics"),
+    FN(ResetMotorStats, METH_NOARGS, "ResetMotorStats()"),
+    FN(wheelSensorLeft, METH_NOARGS, "wheelSensorLeft(): level of the left wheel sensor"),
+    FN(wheelSensorRight, METH_NOARGS, "wheelSensorRight(): level of the right wheel sensor"),
+    FN(WheelCountStart, METH_NOARGS, "WheelCountStart(): starts counting wheel pulses"),
+    FN(WheelCountLeft, METH_NOARGS, "WheelCountLeft(): left wheel pulses"),
+    FN(WheelCountRight, METH_NOARGS, "WheelCountRight(): right wheel pulses"),
+    FN(IrLeft, METH_NOARGS, "IrLeft(): left obstacle sensor triggered"),
+    FN(IrRight, METH_NOARGS, "IrRight(): right obstacle sensor triggered"),
+    FN(IrAll, METH_NOARGS, "IrAll(): any obstacle sensor triggered"),
+    FN(IrLineLeft, METH_NOARGS, "IrLineLeft(): left line sensor triggered"),
+    FN(IrLineRight, METH_NOARGS, "IrLineRight(): right line sensor triggered"),
+    FN(UsGetDistance, METH_NOARGS, "UsGetDistance(): distance in cm, 0 == no object (releases the GIL)"),
+    FN(UsSetMaxRange, METH_VARARGS, "UsSetMaxRange(cm): range limit of the sonar, 0 == none"),
+    FN(UsGetMaxRange, METH_NOARGS, "UsGetMaxRange(): range limit of the sonar"),
+    FN(StartServos, METH_NOARGS, "StartServos(): starts servod"),
+    FN(StopServos, METH_NOARGS, "StopServos(): stops servod"),
+    FN(SetServo, METH_VARARGS, "SetServo(servo, degrees): -90 <= degrees <= 90"),
+    { NULL }
+} ;
+
+static struct PyModuleDef initioModule = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "initio",
+    .m_doc = "Python binding of the initio library for the 4tronix initio robot car.",
+    .m_size = -1,
+    .m_methods = initioMethods,
+} ;
+
+PyMODINIT_FUNC PyInit_initio (void)
+{
+    PyObject *m ;
+
+    if (PyType_Ready (&SensorLogType) < 0)
+        return NULL ;
+    m = PyModule_Create (&initioModule) ;
+    if (m == NULL)
+        return NULL ;
+    Py_INCREF (&SensorLogType) ;
+    if (PyModule_AddObject (m, "SensorLog", (PyObject *)&SensorLogType) < 0)
+    {
+        Py_DECREF (&SensorLogType) ;
+        Py_DECREF (m) ;
+        return NULL ;
+    }
+    PyModule_AddIntConstant (m, "PIROCON2", PIROCON2) ;
+    PyModule_AddIntConstant (m, "ROBOHAT", ROBOHAT) ;
+    PyModule_AddIntConstant (m, "MOTORS", INITIO_MOTORS) ;
+    PyModule_AddIntConstant (m, "SERVOS", INITIO_SERVOS) ;
+    PyModule_AddIntConstant (m, "SONAR", INITIO_SONAR) ;
+    PyModule_AddIntConstant (m, "SENSORS", INITIO_SENSORS) ;
+    PyModule_AddIntConstant (m, "ALL", INITIO_ALL) ;
+    PyModule_AddIntConstant (m, "SENSE_IRLEFT", INITIO_SENSE_IRLEFT) ;
+    PyModule_AddIntConstant (m, "SENSE_IRRIGHT", INITIO_SENSE_IRRIGHT) ;
+    PyModule_AddIntConstant (m, "SENSE_LINELEFT", INITIO_SENSE_LINELEFT) ;
+    PyModule_AddIntConstant (m, "SENSE_LINERIGHT", INITIO_SENSE_LINERIGHT) ;
+    PyModule_AddIntConstant (m, "SENSE_WHEELLEFT", INITIO_SENSE_WHEELLEFT) ;
+    PyModule_AddIntConstant (m, "SENSE_WHEELRIGHT", INITIO_SENSE_WHEELRIGHT) ;
+    return m ;
+}
+
+// End of Module
+//======================================================================
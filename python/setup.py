@@ -0,0 +1,35 @@
+#======================================================================
+#
+# Build of the Python binding of the initio library.
+#
+# license: GNU LESSER GENERAL PUBLIC LICENSE
+#          Version 2.1, February 1999
+#          (for details see LICENSE file)
+#
+# Builds against the library in the parent directory (make compile link).
+# Off the robot, build the stub wiringPi first (make stub); it is then
+# linked instead of the installed wiringPi.
+#
+# Usage: python3 setup.py build_ext --inplace   (or: make python)
+#
+#======================================================================
+
+import os
+from setuptools import setup, Extension
+
+top = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+libdirs = [top]
+if os.path.exists(os.path.join(top, 'stub', 'libwiringPi.so')):
+    libdirs.insert(0, os.path.join(top, 'stub'))
+
+setup(
+    name='initio',
+    version='1.0',
+    description='Python binding of the initio library',
+    ext_modules=[Extension('initio', ['initiomodule.c'],
+                           include_dirs=[top, os.path.join(top, 'resources')],
+                           library_dirs=libdirs,
+                           runtime_library_dirs=libdirs,
+                           libraries=['initio', 'wiringPi', 'pthread'],
+                           extra_compile_args=['-Wall', '-Werror'])],
+)
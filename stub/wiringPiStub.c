@@ -0,0 +1,306 @@
+//======================================================================
+//
+// Stub implementation of the wiringPi/softPwm subset used by initio_lib.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+// Build as drop-in replacement for libwiringPi.so (see 'make stub'):
+// gcc -shared -fPIC -o libwiringPi.so -I../resources wiringPiStub.c -lpthread
+//
+//======================================================================
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <wiringPi.h>
+#include <softPwm.h>
+#include "wiringPiStub.h"
+
+#define PULSE_TIME 100  // softPwm pulse unit in us, as in wiringPi
+
+#define SONAR_LATENCY_US 500  // delay between trigger and echo start of HC-SR04
+
+static volatile int pinModes [WIRINGPI_STUB_PINS] ;
+static volatile int pinOutputs [WIRINGPI_STUB_PINS] ;
+static volatile int pinInputs [WIRINGPI_STUB_PINS] ;
+
+static volatile int pwmMarks [WIRINGPI_STUB_PINS] ;
+static volatile int pwmRange [WIRINGPI_STUB_PINS] ;
+static pthread_t pwmThreads [WIRINGPI_STUB_PINS] ;
+static volatile int pwmActive [WIRINGPI_STUB_PINS] ;
+
+static int isrModes [WIRINGPI_STUB_PINS] ;
+static void (*isrFunctions [WIRINGPI_STUB_PINS])(void) ;
+
+static volatile int sonarPin = -1 ;
+static volatile unsigned int sonarDistance = 0 ;
+static volatile uint64_t sonarTrigger = 0 ;   // ns time stamp of last trigger pulse (0 == none)
+
+static wiringPiStub_WriteHook writeHook = NULL ;
+static wiringPiStub_ReadHook readHook = NULL ;
+
+static uint64_t epochNs = 0 ;
+
+static pthread_mutex_t stubMutex = PTHREAD_MUTEX_INITIALIZER ;
+
+static int validPin (int pin)
+{
+    return (pin >= 0 && pin < WIRINGPI_STUB_PINS) ;
+}
+
+
+//======================================================================
+// Stub Control Functions
+
+uint64_t wiringPiStub_NowNs (void)
+{
+    struct timespec ts ;
+    clock_gettime (CLOCK_MONOTONIC, &ts) ;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec ;
+}
+
+void wiringPiStub_SetWriteHook (wiringPiStub_WriteHook hook)
+{
+    writeHook = hook ;
+}
+
+void wiringPiStub_SetReadHook (wiringPiStub_ReadHook hook)
+{
+    readHook = hook ;
+}
+
+void wiringPiStub_SetInput (int pin, int value)
+{
+    int old, mode ;
+    void (*isr)(void) ;
+
+    if (!validPin (pin)) return ;
+    pthread_mutex_lock (&stubMutex) ;
+    old = pinInputs[pin] ;
+    pinInputs[pin] = (value != 0) ;
+    mode = isrModes[pin] ;
+    isr = isrFunctions[pin] ;
+    pthread_mutex_unlock (&stubMutex) ;
+
+    // deliver the interrupt synchronously, like a very fast edge detector would
+    if (isr != NULL && old != (value != 0))
+    {
+        if ((mode == INT_EDGE_BOTH) ||
+            (mode == INT_EDGE_RISING && value) ||
+            (mode == INT_EDGE_FALLING && !value))
+            isr () ;
+    }
+}
+
+int wiringPiStub_GetOutput (int pin)
+{
+    return validPin (pin) ? pinOutputs[pin] : 0 ;
+}
+
+int wiringPiStub_GetPwm (int pin)
+{
+    return (validPin (pin) && pwmActive[pin]) ? pwmMarks[pin] : -1 ;
+}
+
+void wiringPiStub_SetSonar (int pin, unsigned int distance)
+{
+    sonarPin = pin ;
+    sonarDistance = distance ;
+}
+
+// End of Stub Control Functions
+//======================================================================
+
+
+
+//======================================================================
+// Core wiringPi Functions
+
+int wiringPiSetup (void)
+{
+    if (epochNs == 0)
+        epochNs = wiringPiStub_NowNs () ;
+    return 0 ;
+}
+
+int wiringPiSetupSys (void)  { return wiringPiSetup () ; }
+int wiringPiSetupGpio (void) { return wiringPiSetup () ; }
+int wiringPiSetupPhys (void) { return wiringPiSetup () ; }
+
+void pinMode (int pin, int mode)
+{
+    if (validPin (pin)) pinModes[pin] = mode ;
+}
+
+void pullUpDnControl (int pin, int pud)
+{
+    (void)pin ; (void)pud ;
+}
+
+int digitalRead (int pin)
+{
+    int value ;
+
+    if (!validPin (pin)) return LOW ;
+    if (readHook != NULL && (value = readHook (pin)) >= 0)
+        return value ;
+    if (pin == sonarPin && pinModes[pin] == INPUT)
+    {
+        uint64_t t0 = sonarTrigger, now, echoStart, echoUs ;
+        if (t0 == 0 || sonarDistance == 0) return LOW ;
+        now = wiringPiStub_NowNs () ;
+        echoStart = t0 + SONAR_LATENCY_US * 1000ULL ;
+        echoUs = (uint64_t)sonarDistance * 20000 / 344 ; // inverse of the initio conversion
+        return (now >= echoStart && now < echoStart + echoUs * 1000ULL) ;
+    }
+    if (pinModes[pin] == OUTPUT || pwmActive[pin])
+        return pinOutputs[pin] ;
+    return pinInputs[pin] ;
+}
+
+void digitalWrite (int pin, int value)
+{
+    wiringPiStub_WriteHook hook = writeHook ;
+
+    if (!validPin (pin)) return ;
+    value = (value != 0) ;
+    if (pin == sonarPin && pinOutputs[pin] && !value)
+        sonarTrigger = wiringPiStub_NowNs () ;  // falling edge of trigger pulse
+    if (pinOutputs[pin] == value) return ;
+    pinOutputs[pin] = value ;
+    if (hook != NULL)
+        hook (pin, value, wiringPiStub_NowNs ()) ;
+}
+
+int wiringPiISR (int pin, int mode, void (*function)(void))
+{
+    if (!validPin (pin)) return -1 ;
+    pthread_mutex_lock (&stubMutex) ;
+    isrModes[pin] = mode ;
+    isrFunctions[pin] = function ;
+    pthread_mutex_unlock (&stubMutex) ;
+    return 0 ;
+}
+
+int piHiPri (const int pri)
+{
+    struct sched_param sched = { .sched_priority = pri } ;
+    // needs root on a real system; silently ignored otherwise as in wiringPi
+    return sched_setscheduler (0, SCHED_RR, &sched) ;
+}
+
+// End of Core wiringPi Functions
+//======================================================================
+
+
+
+//======================================================================
+// Timing Functions (same semantics as wiringPi)
+
+void delay (unsigned int howLong)
+{
+    struct timespec ts = { howLong / 1000, (long)(howLong % 1000) * 1000000 } ;
+    nanosleep (&ts, NULL) ;
+}
+
+void delayMicroseconds (unsigned int howLong)
+{
+    if (howLong == 0)
+        return ;
+    else if (howLong < 100)
+    {
+        // wiringPi busy-waits for short delays
+        uint64_t end = wiringPiStub_NowNs () + howLong * 1000ULL ;
+        while (wiringPiStub_NowNs () < end)
+            ;
+    }
+    else
+    {
+        struct timespec ts = { howLong / 1000000, (long)(howLong % 1000000) * 1000 } ;
+        nanosleep (&ts, NULL) ;
+    }
+}
+
+unsigned int millis (void)
+{
+    return (unsigned int)((wiringPiStub_NowNs () - epochNs) / 1000000ULL) ;
+}
+
+unsigned int micros (void)
+{
+    return (unsigned int)((wiringPiStub_NowNs () - epochNs) / 1000ULL) ;
+}
+
+// End of Timing Functions
+//======================================================================
+
+
+
+//======================================================================
+// softPwm Functions
+// Same algorithm as wiringPi: one thread per pin, toggling the pin with
+// delayMicroseconds() in units of PULSE_TIME.
+
+static void *softPwmThread (void *arg)
+{
+    int pin = (int)(intptr_t)arg ;
+    int mark, space ;
+
+    piHiPri (90) ;
+    while (pwmActive[pin])
+    {
+        mark = pwmMarks[pin] ;
+        space = pwmRange[pin] - mark ;
+        if (mark != 0)
+            digitalWrite (pin, HIGH) ;
+        delayMicroseconds (mark * PULSE_TIME) ;
+        if (space != 0)
+            digitalWrite (pin, LOW) ;
+        delayMicroseconds (space * PULSE_TIME) ;
+    }
+    return NULL ;
+}
+
+int softPwmCreate (int pin, int value, int range)
+{
+    if (!validPin (pin) || range <= 0) return -1 ;
+    if (pwmActive[pin]) return -1 ;
+    pinMode (pin, OUTPUT) ;
+    digitalWrite (pin, LOW) ;
+    pwmMarks[pin] = value ;
+    pwmRange[pin] = range ;
+    pwmActive[pin] = 1 ;
+    if (pthread_create (&pwmThreads[pin], NULL, softPwmThread, (void *)(intptr_t)pin) != 0)
+    {
+        pwmActive[pin] = 0 ;
+        return -1 ;
+    }
+    return 0 ;
+}
+
+void softPwmWrite (int pin, int value)
+{
+    if (!validPin (pin)) return ;
+    if (value < 0) value = 0 ;
+    else if (value > pwmRange[pin]) value = pwmRange[pin] ;
+    pwmMarks[pin] = value ;
+}
+
+void softPwmStop (int pin)
+{
+    if (!validPin (pin) || !pwmActive[pin]) return ;
+    pwmActive[pin] = 0 ;
+    pthread_join (pwmThreads[pin], NULL) ;
+    pwmMarks[pin] = 0 ;
+    digitalWrite (pin, LOW) ;
+}
+
+// End of softPwm Functions
+//======================================================================
@@ -0,0 +1,67 @@
+#ifndef _WIRINGPI_STUB_H_
+#define _WIRINGPI_STUB_H_
+//======================================================================
+//
+// Stub implementation of the wiringPi/softPwm subset used by initio_lib.
+// It allows to compile and run the library and its examples on a plain
+// Linux machine: pin levels are kept in memory, softPwm runs the same
+// thread-per-pin algorithm as wiringPi, and the control functions below
+// let a test program drive inputs and observe outputs.
+//
+// license: GNU LESSER GENERAL PUBLIC LICENSE
+//          Version 2.1, February 1999
+//          (for details see LICENSE file)
+//
+//======================================================================
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WIRINGPI_STUB_PINS 64  // highest physical pin number + 1 supported by the stub
+
+// Hook called on every level change written via digitalWrite() (also from the
+// softPwm threads). 'ns' is a CLOCK_MONOTONIC time stamp in nanoseconds.
+typedef void (*wiringPiStub_WriteHook)(int pin, int value, uint64_t ns) ;
+
+// Hook to supply input levels. Returns the level of 'pin', or -1 to fall back
+// to the level set via wiringPiStub_SetInput().
+typedef int (*wiringPiStub_ReadHook)(int pin) ;
+
+// wiringPiStub_SetWriteHook (hook):
+// Installs a hook observing all output level changes (NULL to remove).
+void wiringPiStub_SetWriteHook (wiringPiStub_WriteHook hook) ;
+
+// wiringPiStub_SetReadHook (hook):
+// Installs a hook supplying input levels (NULL to remove).
+void wiringPiStub_SetReadHook (wiringPiStub_ReadHook hook) ;
+
+// wiringPiStub_SetInput (pin, value):
+// Sets the level seen by digitalRead() on an input pin. Triggers a registered
+// wiringPiISR() handler if the level change matches its edge mode.
+void wiringPiStub_SetInput (int pin, int value) ;
+
+// wiringPiStub_GetOutput (pin):
+// Returns the level last written to pin.
+int wiringPiStub_GetOutput (int pin) ;
+
+// wiringPiStub_GetPwm (pin):
+// Returns the duty last written to pin with softPwmWrite(), -1 if no softPwm channel.
+int wiringPiStub_GetPwm (int pin) ;
+
+// wiringPiStub_SetSonar (pin, distance):
+// Simulates an HC-SR04 on the shared trigger/echo pin. After a trigger pulse
+// the pin reads HIGH for the echo time of an object at distance cm (0 == no echo).
+void wiringPiStub_SetSonar (int pin, unsigned int distance) ;
+
+// wiringPiStub_NowNs ():
+// Returns the CLOCK_MONOTONIC time in nanoseconds used for all stub time stamps.
+uint64_t wiringPiStub_NowNs (void) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WIRINGPI_STUB_H_ */